@@ -595,13 +595,13 @@ glfs_mgmt_getspec_cbk(struct rpc_req *req, struct iovec *iov, int count,
         goto out;
     }
 
-    ret = dict_unserialize(rsp.xdata.xdata_val, rsp.xdata.xdata_len, &dict);
+    ret = dict_unserialize_stdalloc(rsp.xdata.xdata_val, rsp.xdata.xdata_len,
+                                    &dict);
     if (ret) {
         gf_log(frame->this->name, GF_LOG_ERROR,
                "failed to unserialize xdata to dictionary");
         goto out;
     }
-    dict->extra_stdfree = rsp.xdata.xdata_val;
 
     /* glusterd2 only */
     ret = dict_get_str(dict, "servers-list", &servers_list);
@@ -741,15 +741,13 @@ glusterfs_handle_translator_op(rpcsvc_request_t *req)
     }
     any = active->first;
     input = dict_new();
-    ret = dict_unserialize(xlator_req.input.input_val,
-                           xlator_req.input.input_len, &input);
+    ret = dict_unserialize_stdalloc(xlator_req.input.input_val,
+                                    xlator_req.input.input_len, &input);
     if (ret < 0) {
         gf_log(this->name, GF_LOG_ERROR,
                "failed to "
                "unserialize req-buffer to dictionary");
         goto out;
-    } else {
-        input->extra_stdfree = xlator_req.input.input_val;
     }
 
     ret = dict_get_int32(input, "count", &count);
@@ -1028,13 +1026,12 @@ glusterfs_handle_svc_attach(rpcsvc_request_t *req)
         goto out;
     }
 
-    ret = dict_unserialize(xlator_req.dict.dict_val, xlator_req.dict.dict_len,
-                           &dict);
+    ret = dict_unserialize_stdalloc(xlator_req.dict.dict_val,
+                                    xlator_req.dict.dict_len, &dict);
     if (ret) {
         gf_smsg(this->name, GF_LOG_WARNING, EINVAL, glusterfsd_msg_42, NULL);
         goto out;
     }
-    dict->extra_stdfree = xlator_req.dict.dict_val;
 
     ret = 0;
 
@@ -2317,13 +2314,13 @@ mgmt_getspec_cbk(struct rpc_req *req, struct iovec *iov, int count,
         goto out;
     }
 
-    ret = dict_unserialize(rsp.xdata.xdata_val, rsp.xdata.xdata_len, &dict);
+    ret = dict_unserialize_stdalloc(rsp.xdata.xdata_val, rsp.xdata.xdata_len,
+                                    &dict);
     if (ret) {
         gf_log(frame->this->name, GF_LOG_ERROR,
                "failed to unserialize xdata to dictionary");
         goto out;
     }
-    dict->extra_stdfree = rsp.xdata.xdata_val;
 
     ret = dict_get_str(dict, "servers-list", &servers_list);
     if (ret) {
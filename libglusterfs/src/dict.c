@@ -18,6 +18,7 @@
 
 #include "glusterfs/dict.h"
 #include "glusterfs/compat.h"
+#include "glusterfs/hashfn.h"
 #include "glusterfs/compat-errno.h"
 #include "glusterfs/statedump.h"
 #include "glusterfs/libglusterfs-messages.h"
@@ -60,21 +61,38 @@ get_new_data()
 
     GF_ATOMIC_INIT(data->refcount, 0);
     data->is_static = _gf_false;
+    data->is_stdalloc = _gf_false;
+    data->borrowed_from = NULL;
 
     return data;
 }
 
+#ifndef GF_DISABLE_MEMPOOL
+GF_STATIC_ASSERT(sizeof(dict_t) + sizeof(pooled_obj_hdr_t) <= 256,
+                 "dict_t does not fit the 256 bytes mem-pool objects");
+#endif
+
 static dict_t *
 get_new_dict_full()
 {
-    dict_t *dict = mem_get0(THIS->ctx->dict_pool);
+    dict_t *dict = mem_get(THIS->ctx->dict_pool);
 
     if (!dict) {
         return NULL;
     }
 
-    dict->free_pair.key = NULL;
+    /* Not zeroing the whole structure on purpose: the inline pairs and keys
+     * are only valid once they are marked as used. */
+    dict->max_count = 0;
+    dict->count = 0;
     dict->totkvlen = 0;
+    GF_ATOMIC_INIT(dict->refcount, 0);
+    dict->members_list = NULL;
+    dict->hash = NULL;
+    dict->hash_size = 0;
+    dict->inline_pairs_used = 0;
+    dict->inline_keys_used = 0;
+    dict->extra_stdfree = NULL;
     LOCK_INIT(&dict->lock);
 
     return dict;
@@ -277,7 +295,9 @@ void
 data_destroy(data_t *data)
 {
     if (data) {
-        if (!data->is_static)
+        if (data->is_stdalloc)
+            free(data->data);
+        else if (!data->is_static)
             GF_FREE(data->data);
 
         data->len = 0xbabababa;
@@ -315,6 +335,182 @@ err_out:
     return NULL;
 }
 
+static uint32_t
+dict_key_hash(const char *key)
+{
+    return SuperFastHash(key, strlen(key));
+}
+
+/* Pairs are taken from the inline array of the dict while there are free
+ * slots, and from the pair pool after that. */
+static data_pair_t *
+dict_pair_get(dict_t *this)
+{
+    int i;
+
+    for (i = 0; i < DICT_INLINE_PAIRS; i++) {
+        if (!(this->inline_pairs_used & (1U << i))) {
+            this->inline_pairs_used |= (1U << i);
+            return &this->inline_pairs[i];
+        }
+    }
+
+    return mem_get(THIS->ctx->dict_pair_pool);
+}
+
+static void
+dict_pair_put(dict_t *this, data_pair_t *pair)
+{
+    if ((pair >= this->inline_pairs) &&
+        (pair < this->inline_pairs + DICT_INLINE_PAIRS)) {
+        this->inline_pairs_used &= ~(1U << (pair - this->inline_pairs));
+    } else {
+        mem_put(pair);
+    }
+}
+
+/* Keys are copied into the inline buffer of the dict while they fit. Space
+ * of deleted keys is reclaimed when they are the last one in the buffer,
+ * or when the dict is cleared. */
+static char *
+dict_key_dup(dict_t *this, const char *key, uint32_t keylen)
+{
+    char *copy;
+
+    if (this->inline_keys_used + keylen + 1 <= DICT_INLINE_KEYS_SIZE) {
+        copy = this->inline_keys + this->inline_keys_used;
+        this->inline_keys_used += keylen + 1;
+    } else {
+        copy = GF_MALLOC(keylen + 1, gf_common_mt_char);
+        if (!copy)
+            return NULL;
+    }
+
+    memcpy(copy, key, keylen);
+    copy[keylen] = '\0';
+
+    return copy;
+}
+
+static void
+dict_key_put(dict_t *this, char *key)
+{
+    size_t len;
+
+    if ((key < this->inline_keys) ||
+        (key >= this->inline_keys + DICT_INLINE_KEYS_SIZE)) {
+        GF_FREE(key);
+        return;
+    }
+
+    len = strlen(key) + 1;
+    if (key + len == this->inline_keys + this->inline_keys_used)
+        this->inline_keys_used -= len;
+}
+
+/* Drops the reference of the dict on a value. A value which points into the
+ * buffer owned by the dict gets its own copy if it is still used elsewhere,
+ * the buffer goes away with the dict. */
+static void
+dict_data_put(dict_t *this, data_t *value)
+{
+    char *copy;
+
+    if ((value->borrowed_from == this) &&
+        (GF_ATOMIC_GET(value->refcount) > 1)) {
+        copy = gf_memdup(value->data, value->len);
+        if (copy) {
+            value->data = copy;
+            value->is_static = _gf_false;
+        } else {
+            gf_msg_callingfn("dict", GF_LOG_WARNING, ENOMEM, LG_MSG_NO_MEMORY,
+                             "failed to copy a shared value, leaking the "
+                             "dict buffer");
+            this->extra_stdfree = NULL;
+        }
+        value->borrowed_from = NULL;
+    }
+
+    data_unref(value);
+}
+
+/* (Re)builds the hash table with twice the current number of buckets. If
+ * the allocation fails the current table, if any, is kept: lookups still
+ * work, only slower. Keys are only hashed once the dict has a table, small
+ * dicts are cheaper to walk. */
+static void
+dict_hash_resize(dict_t *this)
+{
+    data_pair_t **hash;
+    data_pair_t *pair;
+    uint32_t size;
+    uint32_t idx;
+
+    size = this->hash_size ? (this->hash_size * 2) : DICT_HASH_THRESHOLD;
+
+    hash = GF_CALLOC(size, sizeof(*hash), gf_common_mt_dict_hash);
+    if (!hash)
+        return;
+
+    for (pair = this->members_list; pair != NULL; pair = pair->next) {
+        if (!this->hash)
+            pair->key_hash = dict_key_hash(pair->key);
+        idx = pair->key_hash & (size - 1);
+        pair->hash_next = hash[idx];
+        hash[idx] = pair;
+    }
+
+    GF_FREE(this->hash);
+    this->hash = hash;
+    this->hash_size = size;
+}
+
+/* Adds a pair to the member list and the hash table. Has to be called
+ * with this->lock held. */
+static void
+dict_pair_link(dict_t *this, data_pair_t *pair)
+{
+    data_pair_t **bucket;
+
+    pair->next = this->members_list;
+    this->members_list = pair;
+    this->count++;
+
+    if (this->max_count < this->count)
+        this->max_count = this->count;
+
+    if (this->hash) {
+        pair->key_hash = dict_key_hash(pair->key);
+        bucket = &this->hash[pair->key_hash & (this->hash_size - 1)];
+        pair->hash_next = *bucket;
+        *bucket = pair;
+    }
+
+    if ((this->count > DICT_HASH_THRESHOLD) &&
+        (this->count > 2 * this->hash_size))
+        dict_hash_resize(this);
+}
+
+/* Removes a pair from the hash table. The caller removes it from the member
+ * list. Has to be called with this->lock held. */
+static void
+dict_pair_unhash(dict_t *this, data_pair_t *pair)
+{
+    data_pair_t **bucket;
+
+    if (!this->hash)
+        return;
+
+    bucket = &this->hash[pair->key_hash & (this->hash_size - 1)];
+    while (*bucket != NULL) {
+        if (*bucket == pair) {
+            *bucket = pair->hash_next;
+            break;
+        }
+        bucket = &(*bucket)->hash_next;
+    }
+}
+
 /* Always need to be called under lock
  * Always this and key variables are not null -
  * checked by callers.
@@ -323,9 +519,21 @@ static data_pair_t *
 dict_lookup_common(const dict_t *this, const char *key)
 {
     data_pair_t *pair;
+    uint32_t hash;
+
+    if (this->hash) {
+        hash = dict_key_hash(key);
+        pair = this->hash[hash & (this->hash_size - 1)];
+        for (; pair != NULL; pair = pair->hash_next) {
+            if ((pair->key_hash == hash) && !strcmp(pair->key, key))
+                return pair;
+        }
+
+        return NULL;
+    }
 
     for (pair = this->members_list; pair != NULL; pair = pair->next) {
-        if (pair->key && !strcmp(pair->key, key))
+        if (!strcmp(pair->key, key))
             return pair;
     }
 
@@ -382,7 +590,7 @@ dict_set_lk(dict_t *this, char *key, const int key_len, data_t *value,
             data_t *unref_data = pair->value;
             pair->value = data_ref(value);
             this->totkvlen += (value->len - unref_data->len);
-            data_unref(unref_data);
+            dict_data_put(this, unref_data);
             if (key_free)
                 GF_FREE(key);
             /* Indicates duplicate key */
@@ -390,43 +598,28 @@ dict_set_lk(dict_t *this, char *key, const int key_len, data_t *value,
         }
     }
 
-    if (this->free_pair.key) { /* the free_pair is used */
-        pair = mem_get(THIS->ctx->dict_pair_pool);
-        if (!pair) {
-            if (key_free)
-                GF_FREE(key);
-            return -1;
-        }
-    } else { /* assign the pair to the free pair */
-        pair = &this->free_pair;
+    pair = dict_pair_get(this);
+    if (!pair) {
+        if (key_free)
+            GF_FREE(key);
+        return -1;
     }
 
     if (key_free) {
         /* It's ours.  Use it. */
         pair->key = key;
-        key_free = 0;
     } else {
-        pair->key = (char *)GF_MALLOC(keylen + 1, gf_common_mt_char);
+        pair->key = dict_key_dup(this, key, keylen);
         if (!pair->key) {
-            if (pair != &this->free_pair) {
-                mem_put(pair);
-            }
+            dict_pair_put(this, pair);
             return -1;
         }
-        strcpy(pair->key, key);
     }
     pair->value = data_ref(value);
     this->totkvlen += (keylen + 1 + value->len);
 
-    pair->next = this->members_list;
-    this->members_list = pair;
-    this->count++;
-
-    if (key_free)
-        GF_FREE(key);
+    dict_pair_link(this, pair);
 
-    if (this->max_count < this->count)
-        this->max_count = this->count;
     return 0;
 }
 
@@ -534,20 +727,17 @@ dict_deln(dict_t *this, char *key, const int keylen)
     while (pair) {
         if (strcmp(pair->key, key) == 0) {
             this->totkvlen -= pair->value->len;
-            data_unref(pair->value);
+            dict_data_put(this, pair->value);
 
             if (prev)
                 prev->next = pair->next;
             else
                 this->members_list = pair->next;
+            dict_pair_unhash(this, pair);
 
             this->totkvlen -= (keylen + 1);
-            GF_FREE(pair->key);
-            if (pair == &this->free_pair) {
-                this->free_pair.key = NULL;
-            } else {
-                mem_put(pair);
-            }
+            dict_key_put(this, pair->key);
+            dict_pair_put(this, pair);
             this->count--;
             rc = _gf_true;
             break;
@@ -572,16 +762,18 @@ dict_clear_data(dict_t *this)
 
     while (curr != NULL) {
         next = curr->next;
-        data_unref(curr->value);
-        GF_FREE(curr->key);
-        if (curr == &this->free_pair) {
-            this->free_pair.key = NULL;
-        } else {
-            mem_put(curr);
-        }
+        dict_data_put(this, curr->value);
+        dict_key_put(this, curr->key);
+        dict_pair_put(this, curr);
         curr = next;
     }
+    this->members_list = NULL;
     this->count = this->totkvlen = 0;
+
+    GF_FREE(this->hash);
+    this->hash = NULL;
+    this->hash_size = 0;
+    this->inline_keys_used = 0;
 }
 
 static void
@@ -1327,7 +1519,6 @@ dict_reset(dict_t *dict)
     LOCK(&dict->lock);
 
     dict_clear_data(dict);
-    dict->members_list = NULL;
 
     UNLOCK(&dict->lock);
     ret = 0;
@@ -2024,35 +2215,25 @@ _dict_modify_flag(dict_t *this, char *key, int flag, int op)
             else
                 BIT_CLEAR((unsigned char *)(data->data), flag);
 
-            if (this->free_pair.key) { /* the free pair is in use */
-                pair = mem_get0(THIS->ctx->dict_pair_pool);
-                if (!pair) {
-                    gf_smsg("dict", GF_LOG_ERROR, ENOMEM, LG_MSG_NO_MEMORY,
-                            "dict pair", NULL);
-                    ret = -ENOMEM;
-                    goto err;
-                }
-            } else { /* use the free pair */
-                pair = &this->free_pair;
+            pair = dict_pair_get(this);
+            if (!pair) {
+                gf_smsg("dict", GF_LOG_ERROR, ENOMEM, LG_MSG_NO_MEMORY,
+                        "dict pair", NULL);
+                ret = -ENOMEM;
+                goto err;
             }
 
-            pair->key = (char *)GF_MALLOC(strlen(key) + 1, gf_common_mt_char);
+            pair->key = dict_key_dup(this, key, strlen(key));
             if (!pair->key) {
                 gf_smsg("dict", GF_LOG_ERROR, ENOMEM, LG_MSG_NO_MEMORY,
                         "dict pair", NULL);
                 ret = -ENOMEM;
                 goto err;
             }
-            strcpy(pair->key, key);
             pair->value = data_ref(data);
             this->totkvlen += (strlen(key) + 1 + data->len);
 
-            pair->next = this->members_list;
-            this->members_list = pair;
-            this->count++;
-
-            if (this->max_count < this->count)
-                this->max_count = this->count;
+            dict_pair_link(this, pair);
         }
     }
 
@@ -2060,19 +2241,12 @@ _dict_modify_flag(dict_t *this, char *key, int flag, int op)
     return 0;
 
 err:
+    if (pair)
+        dict_pair_put(this, pair);
+
     if (key && this)
         UNLOCK(&this->lock);
 
-    if (pair) {
-        if (pair->key) {
-            GF_FREE(pair->key);
-            pair->key = NULL;
-        }
-        if (pair != &this->free_pair) {
-            mem_put(pair);
-        }
-    }
-
     if (data)
         data_destroy(data);
 
@@ -2402,6 +2576,28 @@ err:
     return ret;
 }
 
+/* Same as dict_set_dynstr(), for a string allocated with malloc(), such as
+ * the ones decoded by XDR. */
+int
+dict_set_dynstr_stdalloc(dict_t *this, char *key, char *str)
+{
+    data_t *data = data_from_dynstr(str);
+    int ret = 0;
+
+    if (!data) {
+        ret = -EINVAL;
+        goto err;
+    }
+    data->is_stdalloc = _gf_true;
+
+    ret = dict_set(this, key, data);
+    if (ret < 0)
+        data_destroy(data);
+
+err:
+    return ret;
+}
+
 /* This function is called only by the volgen for now.
    Check how else you can handle it */
 int
@@ -2860,19 +3056,9 @@ out:
 
 
 
-/**
- * dict_unserialize - unserialize a buffer into a dict
- *
- * @buf:  buf containing serialized dict
- * @size: size of the @buf
- * @fill: dict to fill in
- *
- * @return: success: 0
- *          failure: -errno
- */
-
-int32_t
-dict_unserialize(char *orig_buf, int32_t size, dict_t **fill)
+static int32_t
+dict_unserialize_common(char *orig_buf, int32_t size, dict_t **fill,
+                        gf_boolean_t borrow)
 {
     char *buf = orig_buf;
     int ret = -1;
@@ -2988,9 +3174,15 @@ dict_unserialize(char *orig_buf, int32_t size, dict_t **fill)
             goto out;
         }
         value->len = vallen;
-        value->data = gf_memdup(buf, vallen);
+        if (borrow) {
+            value->data = buf;
+            value->is_static = _gf_true;
+            value->borrowed_from = *fill;
+        } else {
+            value->data = gf_memdup(buf, vallen);
+            value->is_static = _gf_false;
+        }
         value->data_type = GF_DATA_TYPE_STR_OLD;
-        value->is_static = _gf_false;
         buf += vallen;
 
         ret = dict_addn(*fill, key, keylen, value);
@@ -3003,6 +3195,55 @@ out:
     return ret;
 }
 
+/**
+ * dict_unserialize - unserialize a buffer into a dict
+ *
+ * @buf:  buf containing serialized dict
+ * @size: size of the @buf
+ * @fill: dict to fill in
+ *
+ * @return: success: 0
+ *          failure: -errno
+ */
+
+int32_t
+dict_unserialize(char *orig_buf, int32_t size, dict_t **fill)
+{
+    return dict_unserialize_common(orig_buf, size, fill, _gf_false);
+}
+
+/**
+ * dict_unserialize_stdalloc - unserialize a malloc()ed buffer into a dict
+ *
+ * @buf:  buf containing serialized dict, allocated with malloc() (as the
+ *        buffers decoded by XDR are)
+ * @size: size of the @buf
+ * @fill: dict to fill in
+ *
+ * On success the dict owns @buf and frees it in its extra_stdfree, the
+ * values point into it instead of being copied. On failure @buf is still
+ * owned by the caller.
+ *
+ * @return: success: 0
+ *          failure: -errno
+ */
+
+int32_t
+dict_unserialize_stdalloc(char *buf, int32_t size, dict_t **fill)
+{
+    int32_t ret;
+
+    /* A dict only frees one buffer. */
+    if (fill && *fill && (*fill)->extra_stdfree)
+        return dict_unserialize_common(buf, size, fill, _gf_false);
+
+    ret = dict_unserialize_common(buf, size, fill, _gf_true);
+    if (ret == 0)
+        (*fill)->extra_stdfree = buf;
+
+    return ret;
+}
+
 /**
  * dict_allocate_and_serialize - serialize a dictionary into an allocated buffer
  *
@@ -8,6 +8,12 @@
   cases as published by the Free Software Foundation.
 */
 
+#include <sys/socket.h>
+
+#ifdef GF_LINUX_HOST_OS
+#include <sys/syscall.h>
+#endif
+
 #include <glusterfs/gf-io-legacy.h>
 
 #include <glusterfs/globals.h>
@@ -16,6 +22,10 @@
 
 static uint64_t gf_io_legacy_seq;
 
+/* Set when a request of the chain currently being processed by this thread
+ * has failed. Remaining requests of the chain are cancelled. */
+static __thread bool gf_io_legacy_chain_failed = false;
+
 static int32_t
 gf_io_legacy_setup(void)
 {
@@ -79,6 +89,135 @@ gf_io_legacy_callback(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
     return 0;
 }
 
+/* Requests are executed synchronously, so chained requests are always
+ * processed in order. Emulate io_uring behavior and cancel the remaining
+ * requests of a chain if one of them fails. */
+static bool
+gf_io_legacy_chain_check(uint64_t id)
+{
+    if (caa_unlikely(gf_io_legacy_chain_failed)) {
+        gf_io_legacy_chain_failed = (id & GF_IO_ID_FLAG_CHAIN) != 0;
+        gf_io_legacy_cbk(id, -ECANCELED);
+
+        return false;
+    }
+
+    return true;
+}
+
+static void
+gf_io_legacy_chain_cbk(uint64_t id, int32_t res)
+{
+    gf_io_legacy_chain_failed = (res < 0) &&
+                                ((id & GF_IO_ID_FLAG_CHAIN) != 0);
+    gf_io_legacy_cbk(id, res);
+}
+
+static uint64_t
+gf_io_legacy_readv(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    int32_t res;
+
+    if (gf_io_legacy_chain_check(id)) {
+        res = gf_res_errno(
+            sys_preadv(op->rw.fd, op->rw.iov, op->rw.count, op->rw.offset));
+        gf_io_legacy_chain_cbk(id, res);
+    }
+
+    return 0;
+}
+
+static uint64_t
+gf_io_legacy_writev(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    int32_t res;
+
+    if (gf_io_legacy_chain_check(id)) {
+        res = gf_res_errno(
+            sys_pwritev(op->rw.fd, op->rw.iov, op->rw.count, op->rw.offset));
+        gf_io_legacy_chain_cbk(id, res);
+    }
+
+    return 0;
+}
+
+static uint64_t
+gf_io_legacy_fsync(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    int32_t res;
+
+    if (gf_io_legacy_chain_check(id)) {
+        if ((op->fsync.flags & GF_IO_FSYNC_DATASYNC) != 0) {
+            res = gf_res_errno0(sys_fdatasync(op->fsync.fd));
+        } else {
+            res = gf_res_errno0(sys_fsync(op->fsync.fd));
+        }
+        gf_io_legacy_chain_cbk(id, res);
+    }
+
+    return 0;
+}
+
+static uint64_t
+gf_io_legacy_statx(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    int32_t res;
+
+    if (gf_io_legacy_chain_check(id)) {
+#if defined(GF_LINUX_HOST_OS) && defined(SYS_statx)
+        res = gf_res_errno0(syscall(SYS_statx, op->statx.dfd, op->statx.path,
+                                    op->statx.flags, op->statx.mask,
+                                    op->statx.buf));
+#else
+        res = -ENOSYS;
+#endif
+        gf_io_legacy_chain_cbk(id, res);
+    }
+
+    return 0;
+}
+
+static uint64_t
+gf_io_legacy_recv(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    int32_t res;
+
+    if (gf_io_legacy_chain_check(id)) {
+        res = gf_res_errno(recv(op->recv.fd, op->recv.buf, op->recv.size,
+                                op->recv.flags));
+        gf_io_legacy_chain_cbk(id, res);
+    }
+
+    return 0;
+}
+
+static uint64_t
+gf_io_legacy_sendmsg(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    int32_t res;
+
+    if (gf_io_legacy_chain_check(id)) {
+        res = gf_res_errno(
+            sendmsg(op->sendmsg.fd, op->sendmsg.msg, op->sendmsg.flags));
+        gf_io_legacy_chain_cbk(id, res);
+    }
+
+    return 0;
+}
+
+/* Fixed buffers are not needed since nothing is pinned in advance. */
+static int32_t
+gf_io_legacy_buffers_setup(const struct iovec *iov, uint32_t count)
+{
+    return -ENOTSUP;
+}
+
+static int32_t
+gf_io_legacy_buffer_update(uint32_t index, const struct iovec *iov)
+{
+    return -ENOTSUP;
+}
+
 const gf_io_engine_t gf_io_engine_legacy = {
     .name = "legacy",
     .mode = GF_IO_MODE_LEGACY,
@@ -95,5 +234,13 @@ const gf_io_engine_t gf_io_engine_legacy = {
     .flush = gf_io_legacy_flush,
 
     .cancel = gf_io_legacy_cancel,
-    .callback = gf_io_legacy_callback
+    .callback = gf_io_legacy_callback,
+    .readv = gf_io_legacy_readv,
+    .writev = gf_io_legacy_writev,
+    .fsync = gf_io_legacy_fsync,
+    .statx = gf_io_legacy_statx,
+    .recv = gf_io_legacy_recv,
+    .sendmsg = gf_io_legacy_sendmsg,
+    .buffers_setup = gf_io_legacy_buffers_setup,
+    .buffer_update = gf_io_legacy_buffer_update
 };
@@ -34,6 +34,18 @@
  * different operations to cancel a normal operation or a timer. */
 #define GF_IO_URING_FLAG_TIMER GF_IO_ID_FLAG_1
 
+/* Access the last three 64-bit words of an SQE. They were '__pad2[]' in
+ * older kernel headers, but newer ones have reused some of them for other
+ * fields. The last word is not used by the kernel for any of the requests
+ * sent by the engine, so it's used to keep the number of pending SQEs. */
+#define GF_IO_URING_SQE_PAD(_sqe, _idx) (((uint64_t *)(_sqe))[5 + (_idx)])
+
+/* Registration opcodes to manage a sparse table of fixed buffers. They are
+ * defined as an enum in kernel headers, so they can't be checked at compile
+ * time. Kernels not supporting them will return -EINVAL. */
+#define GF_IO_URING_REGISTER_BUFFERS2 15U
+#define GF_IO_URING_REGISTER_BUFFERS_UPDATE 16U
+
 /* Helper macro to define names of bits. */
 #define GF_IO_BITNAME(_prefix, _name) { _prefix##_##_name, #_name }
 
@@ -75,12 +87,34 @@ typedef struct _gf_io_uring_sq {
     size_t sqes_size;
 } gf_io_uring_sq_t;
 
+/* Same layout as 'struct io_uring_rsrc_register'. */
+typedef struct _gf_io_uring_rsrc_register {
+    uint32_t nr;
+    uint32_t flags;
+    uint64_t resv2;
+    uint64_t data;
+    uint64_t tags;
+} gf_io_uring_rsrc_register_t;
+
+/* Same layout as 'struct io_uring_rsrc_update2'. */
+typedef struct _gf_io_uring_rsrc_update {
+    uint32_t offset;
+    uint32_t resv;
+    uint64_t data;
+    uint64_t tags;
+    uint32_t nr;
+    uint32_t resv2;
+} gf_io_uring_rsrc_update_t;
+
 /* Structure to keep io_uring state. */
 typedef struct _gf_io_uring {
     gf_io_uring_sq_t sq;
     gf_io_uring_cq_t cq;
     struct io_uring_params params;
     uint32_t fd;
+
+    /* Set when the table of fixed buffers has been registered. */
+    bool buffers;
 } gf_io_uring_t;
 
 /* Global io_uring state. */
@@ -465,6 +499,9 @@ failed_close:
 static void
 gf_io_uring_cleanup(void)
 {
+    /* Registered buffers are released when the ring is closed. */
+    gf_io_uring.buffers = false;
+
     gf_io_uring_sq_fini();
     gf_io_uring_cq_fini();
 
@@ -614,7 +651,7 @@ static void
 gf_io_uring_sq_commit(uint32_t idx, uint32_t nr)
 {
     cmm_smp_wmb();
-    CMM_STORE_SHARED(gf_io_uring.sq.sqes[idx].__pad2[2], nr);
+    CMM_STORE_SHARED(GF_IO_URING_SQE_PAD(&gf_io_uring.sq.sqes[idx], 2), nr);
 }
 
 /* Read the number of SQ entries to process. */
@@ -623,7 +660,8 @@ gf_io_uring_sq_length(uint32_t idx)
 {
     uint32_t nr;
 
-    nr = (uint32_t)CMM_LOAD_SHARED(gf_io_uring.sq.sqes[idx].__pad2[2]);
+    nr = (uint32_t)CMM_LOAD_SHARED(
+        GF_IO_URING_SQE_PAD(&gf_io_uring.sq.sqes[idx], 2));
     cmm_smp_rmb();
 
     return nr;
@@ -654,7 +692,8 @@ gf_io_uring_sq_consume_shared(uint32_t tail)
     idx = tail & gf_io_uring.sq.mask;
     nr = gf_io_uring_sq_length(idx);
     if (nr != 0) {
-        nr = (uint32_t)uatomic_xchg(&gf_io_uring.sq.sqes[idx].__pad2[2], 0);
+        nr = (uint32_t)uatomic_xchg(
+            &GF_IO_URING_SQE_PAD(&gf_io_uring.sq.sqes[idx], 2), 0);
     }
 
     return nr;
@@ -779,11 +818,19 @@ gf_io_uring_is_available(uint32_t seq)
 static struct io_uring_sqe *
 gf_io_uring_get(uint32_t seq)
 {
+    struct io_uring_sqe *sqe;
+
     while (caa_unlikely(!gf_io_uring_is_available(seq))) {
         gf_io_uring_flush();
     }
 
-    return &gf_io_uring.sq.sqes[seq & gf_io_uring.sq.mask];
+    /* The first word after 'user_data' contains 'buf_index'. It's cleared
+     * here so that requests using fixed buffers can set it before being
+     * committed. */
+    sqe = &gf_io_uring.sq.sqes[seq & gf_io_uring.sq.mask];
+    GF_IO_URING_SQE_PAD(sqe, 0) = 0;
+
+    return sqe;
 }
 
 static uint64_t
@@ -791,9 +838,14 @@ gf_io_uring_common(uint64_t seq, uint64_t id, struct io_uring_sqe *sqe,
                    uint32_t count)
 {
     sqe->user_data = id;
-    sqe->__pad2[0] = sqe->__pad2[1] = 0;
+    GF_IO_URING_SQE_PAD(sqe, 1) = 0;
 
-    if ((id & GF_IO_ID_FLAG_CHAIN) == 0) {
+    /* Chained requests are linked so that the kernel executes them in
+     * order. They are only committed once the last request of the chain
+     * has been prepared. */
+    if ((id & GF_IO_ID_FLAG_CHAIN) != 0) {
+        sqe->flags |= IOSQE_IO_LINK;
+    } else {
         gf_io_uring_sq_commit(seq & gf_io_uring.sq.mask, count);
     }
 
@@ -844,6 +896,166 @@ gf_io_uring_callback(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
     return gf_io_uring_common(seq, id, sqe, count);
 }
 
+static uint64_t
+gf_io_uring_rw(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count,
+               uint8_t opcode, uint8_t opcode_fixed)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+
+    sqe->flags = 0;
+    sqe->ioprio = 0;
+    sqe->fd = op->rw.fd;
+    sqe->off = op->rw.offset;
+    sqe->rw_flags = 0;
+
+    /* A single buffer contained in a registered area doesn't need to be
+     * mapped by the kernel on each request. */
+    if ((op->rw.buf >= 0) && (op->rw.count == 1) && gf_io_uring.buffers) {
+        sqe->opcode = opcode_fixed;
+        sqe->addr = (uintptr_t)op->rw.iov[0].iov_base;
+        sqe->len = op->rw.iov[0].iov_len;
+        sqe->buf_index = op->rw.buf;
+    } else {
+        sqe->opcode = opcode;
+        sqe->addr = (uintptr_t)op->rw.iov;
+        sqe->len = op->rw.count;
+    }
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+static uint64_t
+gf_io_uring_readv(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    return gf_io_uring_rw(seq, id, op, count, IORING_OP_READV,
+                          IORING_OP_READ_FIXED);
+}
+
+static uint64_t
+gf_io_uring_writev(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    return gf_io_uring_rw(seq, id, op, count, IORING_OP_WRITEV,
+                          IORING_OP_WRITE_FIXED);
+}
+
+static uint64_t
+gf_io_uring_fsync(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->flags = 0;
+    sqe->ioprio = 0;
+    sqe->fd = op->fsync.fd;
+    sqe->off = 0;
+    sqe->addr = 0;
+    sqe->len = 0;
+    sqe->fsync_flags = 0;
+    if ((op->fsync.flags & GF_IO_FSYNC_DATASYNC) != 0) {
+        sqe->fsync_flags |= IORING_FSYNC_DATASYNC;
+    }
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+static uint64_t
+gf_io_uring_statx(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+
+    sqe->opcode = IORING_OP_STATX;
+    sqe->flags = 0;
+    sqe->ioprio = 0;
+    sqe->fd = op->statx.dfd;
+    sqe->off = (uintptr_t)op->statx.buf;
+    sqe->addr = (uintptr_t)op->statx.path;
+    sqe->len = op->statx.mask;
+    sqe->statx_flags = op->statx.flags;
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+static uint64_t
+gf_io_uring_recv(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->flags = 0;
+    sqe->ioprio = 0;
+    sqe->fd = op->recv.fd;
+    sqe->off = 0;
+    sqe->addr = (uintptr_t)op->recv.buf;
+    sqe->len = op->recv.size;
+    sqe->msg_flags = op->recv.flags;
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+static uint64_t
+gf_io_uring_sendmsg(uint64_t seq, uint64_t id, gf_io_op_t *op, uint32_t count)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = gf_io_uring_get(seq + count - 1);
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->flags = 0;
+    sqe->ioprio = 0;
+    sqe->fd = op->sendmsg.fd;
+    sqe->off = 0;
+    sqe->addr = (uintptr_t)op->sendmsg.msg;
+    sqe->len = 1;
+    sqe->msg_flags = op->sendmsg.flags;
+
+    return gf_io_uring_common(seq, id, sqe, count);
+}
+
+/* Register a sparse table of fixed buffers. Empty entries can be filled
+ * later using gf_io_uring_buffer_update(). */
+static int32_t
+gf_io_uring_buffers_setup(const struct iovec *iov, uint32_t count)
+{
+    gf_io_uring_rsrc_register_t rsrc;
+    int32_t res;
+
+    memset(&rsrc, 0, sizeof(rsrc));
+    rsrc.nr = count;
+    rsrc.data = (uintptr_t)iov;
+
+    res = gf_res_errno0(io_uring_register(gf_io_uring.fd,
+                                          GF_IO_URING_REGISTER_BUFFERS2,
+                                          &rsrc, sizeof(rsrc)));
+    gf_io_uring.buffers = (res >= 0);
+
+    return res;
+}
+
+/* Replace an entry of the fixed buffers table. An empty iovec releases the
+ * entry. */
+static int32_t
+gf_io_uring_buffer_update(uint32_t index, const struct iovec *iov)
+{
+    gf_io_uring_rsrc_update_t update;
+
+    memset(&update, 0, sizeof(update));
+    update.offset = index;
+    update.data = (uintptr_t)iov;
+    update.nr = 1;
+
+    return gf_res_errno0(io_uring_register(gf_io_uring.fd,
+                                           GF_IO_URING_REGISTER_BUFFERS_UPDATE,
+                                           &update, sizeof(update)));
+}
+
 const gf_io_engine_t gf_io_engine_io_uring = {
     .name = "io_uring",
     .mode = GF_IO_MODE_IO_URING,
@@ -860,5 +1072,13 @@ const gf_io_engine_t gf_io_engine_io_uring = {
     .flush = gf_io_uring_flush,
 
     .cancel = gf_io_uring_cancel,
-    .callback = gf_io_uring_callback
+    .callback = gf_io_uring_callback,
+    .readv = gf_io_uring_readv,
+    .writev = gf_io_uring_writev,
+    .fsync = gf_io_uring_fsync,
+    .statx = gf_io_uring_statx,
+    .recv = gf_io_uring_recv,
+    .sendmsg = gf_io_uring_sendmsg,
+    .buffers_setup = gf_io_uring_buffers_setup,
+    .buffer_update = gf_io_uring_buffer_update
 };
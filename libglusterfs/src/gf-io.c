@@ -28,6 +28,17 @@
 gf_io_t gf_io = {};
 __thread gf_io_worker_t gf_io_worker = {};
 
+/* Table of memory areas registered as fixed buffers. It's kept outside of
+ * 'gf_io' because buffers can be registered before the I/O framework is
+ * started and they must survive engine restarts. */
+static struct {
+    pthread_mutex_t lock;
+    struct iovec iov[GF_IO_BUFFER_COUNT];
+
+    /* Set when the table has been registered into the active engine. */
+    bool active;
+} gf_io_buffers = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
 static const gf_io_engine_t *gf_io_engines[] = {
 #ifdef HAVE_IO_URING
     &gf_io_engine_io_uring,
@@ -442,6 +453,91 @@ gf_io_main(uint32_t workers, gf_io_handlers_t *handlers, void *data)
     return res;
 }
 
+/* Register the current table of fixed buffers into the engine. */
+static void
+gf_io_buffers_start(const gf_io_engine_t *engine)
+{
+    int32_t res;
+
+    pthread_mutex_lock(&gf_io_buffers.lock);
+
+    /* Engines that don't support fixed buffers return -ENOTSUP. Any other
+     * error is not fatal, but it's reported since I/O won't be optimal. */
+    res = engine->buffers_setup(gf_io_buffers.iov, GF_IO_BUFFER_COUNT);
+    if (res != -ENOTSUP) {
+        gf_check("io", GF_LOG_WARNING, "buffers_setup", res);
+    }
+    gf_io_buffers.active = (res >= 0);
+
+    pthread_mutex_unlock(&gf_io_buffers.lock);
+}
+
+/* Stop using fixed buffers. The registration is released by the engine. */
+static void
+gf_io_buffers_stop(void)
+{
+    pthread_mutex_lock(&gf_io_buffers.lock);
+    gf_io_buffers.active = false;
+    pthread_mutex_unlock(&gf_io_buffers.lock);
+}
+
+int32_t
+gf_io_buffer_register(void *base, size_t size)
+{
+    int32_t index, res;
+
+    pthread_mutex_lock(&gf_io_buffers.lock);
+
+    for (index = 0; index < GF_IO_BUFFER_COUNT; index++) {
+        if (gf_io_buffers.iov[index].iov_base == NULL) {
+            break;
+        }
+    }
+    if (caa_unlikely(index >= GF_IO_BUFFER_COUNT)) {
+        res = -ENOSPC;
+        goto done;
+    }
+
+    gf_io_buffers.iov[index].iov_base = base;
+    gf_io_buffers.iov[index].iov_len = size;
+
+    res = index;
+    if (gf_io_buffers.active) {
+        res = gf_io.engine.buffer_update(index, &gf_io_buffers.iov[index]);
+        if (caa_unlikely(res < 0)) {
+            gf_io_buffers.iov[index].iov_base = NULL;
+            gf_io_buffers.iov[index].iov_len = 0;
+        } else {
+            res = index;
+        }
+    }
+
+done:
+    pthread_mutex_unlock(&gf_io_buffers.lock);
+
+    return res;
+}
+
+void
+gf_io_buffer_unregister(int32_t index)
+{
+    if ((index < 0) || (index >= GF_IO_BUFFER_COUNT)) {
+        return;
+    }
+
+    pthread_mutex_lock(&gf_io_buffers.lock);
+
+    gf_io_buffers.iov[index].iov_base = NULL;
+    gf_io_buffers.iov[index].iov_len = 0;
+
+    if (gf_io_buffers.active) {
+        gf_check("io", GF_LOG_WARNING, "buffer_update",
+                 gf_io.engine.buffer_update(index, &gf_io_buffers.iov[index]));
+    }
+
+    pthread_mutex_unlock(&gf_io_buffers.lock);
+}
+
 static int32_t
 gf_io_setup(void)
 {
@@ -512,9 +608,11 @@ gf_io_run(const char *name, gf_io_handlers_t *handlers, void *data)
                      GLFS_STR(engine, engine->name));
 
             gf_io_init(engine, res);
+            gf_io_buffers_start(engine);
 
             res = gf_io_main(res, handlers, data);
 
+            gf_io_buffers_stop();
             engine->cleanup();
 
             if (caa_likely(res >= 0)) {
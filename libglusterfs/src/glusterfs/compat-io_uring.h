@@ -238,4 +238,16 @@
 #define IORING_OP_UNLINKAT         36U
 #endif
 
+/* SQE flags. */
+
+#ifndef IOSQE_IO_LINK
+#define IOSQE_IO_LINK              (1U << 2)
+#endif
+
+/* Operation specific flags. */
+
+#ifndef IORING_FSYNC_DATASYNC
+#define IORING_FSYNC_DATASYNC      (1U << 0)
+#endif
+
 #endif /* __COMPAT_IO_URING_H__ */
@@ -86,18 +86,34 @@ typedef struct _data_pair data_pair_t;
 #define DICT_DATA_HDR_KEY_LEN 4
 #define DICT_DATA_HDR_VAL_LEN 4
 
+/* The first pairs and keys are stored inside the dict_t itself to avoid
+ * allocations. The sizes are bound by the 256 bytes mem-pool objects dict_t
+ * used before, so that long lived dictionaries do not use more memory: they
+ * only cover the first two keys, the pair pool and the heap are used for
+ * the others. */
+#define DICT_INLINE_PAIRS 2
+#define DICT_INLINE_KEYS_SIZE 40
+
+/* Dictionaries with more keys than this also use a hash table to find
+ * them. */
+#define DICT_HASH_THRESHOLD 16
+
 struct _data {
     char *data;
     gf_atomic_t refcount;
     gf_dict_data_type_t data_type;
     uint32_t len;
     uint32_t is_static;
+    uint32_t is_stdalloc; /* data comes from malloc(), not GF_MALLOC() */
+    dict_t *borrowed_from; /* dict whose extra_stdfree buffer has data */
 };
 
 struct _data_pair {
     struct _data_pair *next;
     data_t *value;
     char *key;
+    struct _data_pair *hash_next; /* next pair in the same hash bucket */
+    uint32_t key_hash;
 };
 
 struct _dict {
@@ -108,8 +124,13 @@ struct _dict {
     gf_atomic_t refcount;
     gf_lock_t lock;
     data_pair_t *members_list;
-    data_pair_t free_pair;
+    data_pair_t **hash; /* buckets of the hash table, if used */
     char *extra_stdfree;
+    uint32_t hash_size;
+    uint16_t inline_pairs_used; /* bitmap of used inline_pairs */
+    uint16_t inline_keys_used;  /* bytes used from inline_keys */
+    data_pair_t inline_pairs[DICT_INLINE_PAIRS];
+    char inline_keys[DICT_INLINE_KEYS_SIZE];
 };
 
 typedef gf_boolean_t (*dict_match_t)(dict_t *d, char *k, data_t *v, void *data);
@@ -177,6 +198,9 @@ dict_key_count(dict_t *this);
 int32_t
 dict_unserialize(char *buf, int32_t size, dict_t **fill);
 
+int32_t
+dict_unserialize_stdalloc(char *buf, int32_t size, dict_t **fill);
+
 int32_t
 dict_allocate_and_serialize(dict_t *this, char **buf, u_int *length);
 
@@ -400,6 +424,8 @@ dict_set_dynstr(dict_t *this, char *key, char *str);
 GF_MUST_CHECK int
 dict_set_dynstrn(dict_t *this, char *key, const int keylen, char *str);
 GF_MUST_CHECK int
+dict_set_dynstr_stdalloc(dict_t *this, char *key, char *str);
+GF_MUST_CHECK int
 dict_set_dynstr_with_alloc(dict_t *this, char *key, const char *str);
 GF_MUST_CHECK int
 dict_add_dynstr_with_alloc(dict_t *this, char *key, char *str);
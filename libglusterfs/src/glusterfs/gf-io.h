@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include <pthread.h>
 #include <errno.h>
+#include <sys/uio.h>
 
 #include <urcu/uatomic.h>
 
@@ -84,6 +85,12 @@
 #define GF_IO_HANDLER_TIMEOUT 3
 #define GF_IO_HANDLER_RETRIES 20
 
+/* Flags for the 'fsync' operation. */
+#define GF_IO_FSYNC_DATASYNC (1U << 0)
+
+/* Maximum number of memory areas that can be registered as fixed buffers. */
+#define GF_IO_BUFFER_COUNT 1024
+
 /* Forward declaration of some structures. */
 
 /* Data related to an operation. */
@@ -95,6 +102,13 @@ typedef struct _gf_io_op gf_io_op_t;
 struct _gf_io_request;
 typedef struct _gf_io_request gf_io_request_t;
 
+/* Result buffer of the 'statx' operation. Only used through pointers. */
+struct statx;
+
+/* Message descriptor of the 'sendmsg' operation. Only used through
+ * pointers. */
+struct msghdr;
+
 /* Enumeration of all defined engines. */
 typedef enum _gf_io_mode {
     GF_IO_MODE_LEGACY,
@@ -140,6 +154,7 @@ typedef struct _gf_io_async {
     static int32_t __gf_io_async_##_name(gf_io_op_t *_op)
 
 #define GF_IO_CBK_DECLARE(_name) extern const gf_io_callback_t _name
+#define GF_IO_CBK_DECLARE_STATIC(_name) static const gf_io_callback_t _name
 #define GF_IO_ASYNC_DECLARE(_name) extern const gf_io_async_t _name
 
 #else /* ! DEBUG */
@@ -153,6 +168,7 @@ typedef int32_t (*gf_io_async_t)(gf_io_op_t *op);
 #define GF_IO_ASYNC(_name, _op, _args...) _args int32_t _name(gf_io_op_t *_op)
 
 #define GF_IO_CBK_DECLARE(_name) void _name(gf_io_op_t *, int32_t)
+#define GF_IO_CBK_DECLARE_STATIC(_name) static void _name(gf_io_op_t *, int32_t)
 #define GF_IO_ASYNC_DECLARE(_name) int32_t _name(gf_io_op_t *)
 
 #endif /* DEBUG */
@@ -198,6 +214,73 @@ struct _gf_io_op {
             /* Id of the request to cancel. */
             uint64_t id;
         } cancel;
+
+        struct {
+            /* File descriptor. */
+            int32_t fd;
+
+            /* Number of entries in 'iov'. */
+            uint32_t count;
+
+            /* Buffers to read into or to write from. */
+            const struct iovec *iov;
+
+            /* Offset of the file where the operation starts. */
+            uint64_t offset;
+
+            /* Index of the registered buffer that contains 'iov' or -1. */
+            int32_t buf;
+        } rw;
+
+        struct {
+            /* File descriptor to synchronize. */
+            int32_t fd;
+
+            /* GF_IO_FSYNC_* flags. */
+            uint32_t flags;
+        } fsync;
+
+        struct {
+            /* Directory used to resolve a relative 'path'. */
+            int32_t dfd;
+
+            /* AT_* flags. */
+            int32_t flags;
+
+            /* Path of the entry. */
+            const char *path;
+
+            /* STATX_* fields requested. */
+            uint32_t mask;
+
+            /* Buffer where the result will be stored. */
+            struct statx *buf;
+        } statx;
+
+        struct {
+            /* Socket descriptor. */
+            int32_t fd;
+
+            /* MSG_* flags. */
+            uint32_t flags;
+
+            /* Buffer where received data will be stored. */
+            void *buf;
+
+            /* Size of the buffer. */
+            size_t size;
+        } recv;
+
+        struct {
+            /* Socket descriptor. */
+            int32_t fd;
+
+            /* MSG_* flags. */
+            uint32_t flags;
+
+            /* Message to send. */
+            const struct msghdr *msg;
+        } sendmsg;
     };
 };
 
@@ -287,6 +370,30 @@ typedef struct _gf_io_engine {
     /* Function to call a callback in the background. */
     gf_io_engine_op_t callback;
 
+    /* Function to read from a file into a vector of buffers. */
+    gf_io_engine_op_t readv;
+
+    /* Function to write a vector of buffers into a file. */
+    gf_io_engine_op_t writev;
+
+    /* Function to flush cached data of a file to stable storage. */
+    gf_io_engine_op_t fsync;
+
+    /* Function to get the attributes of a file. */
+    gf_io_engine_op_t statx;
+
+    /* Function to receive data from a socket. */
+    gf_io_engine_op_t recv;
+
+    /* Function to send a message through a socket. */
+    gf_io_engine_op_t sendmsg;
+
+    /* Function to register the whole table of fixed buffers. */
+    int32_t (*buffers_setup)(const struct iovec *iov, uint32_t count);
+
+    /* Function to replace a single entry of the table of fixed buffers. */
+    int32_t (*buffer_update)(uint32_t index, const struct iovec *iov);
+
     /* Mode of operation of the engine. */
     gf_io_mode_t mode;
 } gf_io_engine_t;
@@ -340,6 +447,15 @@ gf_io_mode(void)
 int32_t
 gf_io_run(const char *name, gf_io_handlers_t *handlers, void *data);
 
+/* Register a memory area to be used as a fixed buffer. Returns the index of
+ * the buffer or a negative error code. */
+int32_t
+gf_io_buffer_register(void *base, size_t size);
+
+/* Release a fixed buffer previously registered. */
+void
+gf_io_buffer_unregister(int32_t index);
+
 /* Get the current worker. */
 static inline gf_io_worker_t *
 gf_io_worker_get(void)
@@ -602,4 +718,220 @@ gf_io_async_prepare(gf_io_request_t *req, gf_io_async_t async, void *data,
     gf_io_async_common(&req->op, async, cbk, data);
 }
 
+/* Operations 'readv' and 'writev' */
+
+static inline void
+gf_io_rw_common(gf_io_op_t *op, int32_t fd, const struct iovec *iov,
+                uint32_t count, uint64_t offset)
+{
+    op->rw.fd = fd;
+    op->rw.count = count;
+    op->rw.iov = iov;
+    op->rw.offset = offset;
+    op->rw.buf = -1;
+}
+
+static inline uint64_t
+gf_io_readv(gf_io_callback_t cbk, int32_t fd, const struct iovec *iov,
+            uint32_t count, uint64_t offset, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_rw_common(op, fd, iov, count, offset);
+
+    return gf_io.engine.readv(seq, id, op, 1);
+}
+
+static inline void
+gf_io_readv_prepare(gf_io_request_t *req, gf_io_callback_t cbk, int32_t fd,
+                    const struct iovec *iov, uint32_t count, uint64_t offset,
+                    void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.readv, cbk, data);
+    gf_io_rw_common(&req->op, fd, iov, count, offset);
+}
+
+static inline uint64_t
+gf_io_writev(gf_io_callback_t cbk, int32_t fd, const struct iovec *iov,
+             uint32_t count, uint64_t offset, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_rw_common(op, fd, iov, count, offset);
+
+    return gf_io.engine.writev(seq, id, op, 1);
+}
+
+static inline void
+gf_io_writev_prepare(gf_io_request_t *req, gf_io_callback_t cbk, int32_t fd,
+                     const struct iovec *iov, uint32_t count, uint64_t offset,
+                     void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.writev, cbk, data);
+    gf_io_rw_common(&req->op, fd, iov, count, offset);
+}
+
+static inline void
+gf_io_read_fixed_prepare(gf_io_request_t *req, gf_io_callback_t cbk,
+                         int32_t fd, const struct iovec *iov, uint64_t offset,
+                         int32_t buf, void *data)
+{
+    gf_io_readv_prepare(req, cbk, fd, iov, 1, offset, data);
+    req->op.rw.buf = buf;
+}
+
+static inline void
+gf_io_write_fixed_prepare(gf_io_request_t *req, gf_io_callback_t cbk,
+                          int32_t fd, const struct iovec *iov, uint64_t offset,
+                          int32_t buf, void *data)
+{
+    gf_io_writev_prepare(req, cbk, fd, iov, 1, offset, data);
+    req->op.rw.buf = buf;
+}
+
+/* Operation 'fsync' */
+
+static inline void
+gf_io_fsync_common(gf_io_op_t *op, int32_t fd, uint32_t flags)
+{
+    op->fsync.fd = fd;
+    op->fsync.flags = flags;
+}
+
+static inline uint64_t
+gf_io_fsync(gf_io_callback_t cbk, int32_t fd, uint32_t flags, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_fsync_common(op, fd, flags);
+
+    return gf_io.engine.fsync(seq, id, op, 1);
+}
+
+static inline void
+gf_io_fsync_prepare(gf_io_request_t *req, gf_io_callback_t cbk, int32_t fd,
+                    uint32_t flags, void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.fsync, cbk, data);
+    gf_io_fsync_common(&req->op, fd, flags);
+}
+
+/* Operation 'statx' */
+
+static inline void
+gf_io_statx_common(gf_io_op_t *op, int32_t dfd, const char *path,
+                   int32_t flags, uint32_t mask, struct statx *buf)
+{
+    op->statx.dfd = dfd;
+    op->statx.flags = flags;
+    op->statx.path = path;
+    op->statx.mask = mask;
+    op->statx.buf = buf;
+}
+
+static inline uint64_t
+gf_io_statx(gf_io_callback_t cbk, int32_t dfd, const char *path,
+            int32_t flags, uint32_t mask, struct statx *buf, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_statx_common(op, dfd, path, flags, mask, buf);
+
+    return gf_io.engine.statx(seq, id, op, 1);
+}
+
+static inline void
+gf_io_statx_prepare(gf_io_request_t *req, gf_io_callback_t cbk, int32_t dfd,
+                    const char *path, int32_t flags, uint32_t mask,
+                    struct statx *buf, void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.statx, cbk, data);
+    gf_io_statx_common(&req->op, dfd, path, flags, mask, buf);
+}
+
+/* Operation 'recv' */
+
+static inline void
+gf_io_recv_common(gf_io_op_t *op, int32_t fd, void *buf, size_t size,
+                  uint32_t flags)
+{
+    op->recv.fd = fd;
+    op->recv.flags = flags;
+    op->recv.buf = buf;
+    op->recv.size = size;
+}
+
+static inline uint64_t
+gf_io_recv(gf_io_callback_t cbk, int32_t fd, void *buf, size_t size,
+           uint32_t flags, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_recv_common(op, fd, buf, size, flags);
+
+    return gf_io.engine.recv(seq, id, op, 1);
+}
+
+static inline void
+gf_io_recv_prepare(gf_io_request_t *req, gf_io_callback_t cbk, int32_t fd,
+                   void *buf, size_t size, uint32_t flags, void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.recv, cbk, data);
+    gf_io_recv_common(&req->op, fd, buf, size, flags);
+}
+
+/* Operation 'sendmsg' */
+
+static inline void
+gf_io_sendmsg_common(gf_io_op_t *op, int32_t fd, const struct msghdr *msg,
+                     uint32_t flags)
+{
+    op->sendmsg.fd = fd;
+    op->sendmsg.flags = flags;
+    op->sendmsg.msg = msg;
+}
+
+static inline uint64_t
+gf_io_sendmsg(gf_io_callback_t cbk, int32_t fd, const struct msghdr *msg,
+              uint32_t flags, void *data)
+{
+    gf_io_op_t *op;
+    uint64_t seq, id;
+
+    seq = gf_io_reserve(1);
+    id = gf_io_get(seq);
+    op = gf_io_single_common(id, cbk, data);
+    gf_io_sendmsg_common(op, fd, msg, flags);
+
+    return gf_io.engine.sendmsg(seq, id, op, 1);
+}
+
+static inline void
+gf_io_sendmsg_prepare(gf_io_request_t *req, gf_io_callback_t cbk, int32_t fd,
+                      const struct msghdr *msg, uint32_t flags, void *data)
+{
+    gf_io_prepare_common(req, gf_io.engine.sendmsg, cbk, data);
+    gf_io_sendmsg_common(&req->op, fd, msg, flags);
+}
+
 #endif /* __GF_IO_H__ */
@@ -202,6 +202,11 @@ enum gf_internal_fop_indicator {
 
 #define GLUSTERFS_WRITE_IS_APPEND "glusterfs.write-is-append"
 #define GLUSTERFS_WRITE_UPDATE_ATOMIC "glusterfs.write-update-atomic"
+/* xattrop (GF_XATTROP_ADD_ARRAY) keys to apply on the fd before a writev,
+ * carried in the writev xdata with this prefix; the brick acknowledges with
+ * GLUSTERFS_WRITE_PRE_XATTROP_DONE in the reply xdata. */
+#define GLUSTERFS_WRITE_PRE_XATTROP "glusterfs.write-pre-xattrop."
+#define GLUSTERFS_WRITE_PRE_XATTROP_DONE "glusterfs.write-pre-xattrop-done"
 #define GLUSTERFS_OPEN_FD_COUNT "glusterfs.open-fd-count"
 #define GLUSTERFS_ACTIVE_FD_COUNT "glusterfs.open-active-fd-count"
 #define GLUSTERFS_INODELK_COUNT "glusterfs.inodelk-count"
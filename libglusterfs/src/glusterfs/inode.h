@@ -18,6 +18,8 @@
 #define LOOKUP_NOT_NEEDED 2
 
 #define DEFAULT_INODE_MEMPOOL_ENTRIES 32 * 1024
+/* Number of independently locked shards of the inode and dentry hashes. */
+#define INODE_TABLE_SHARDS 64
 #define INODE_PATH_FMT "<gfid:%s>"
 struct _inode_table;
 typedef struct _inode_table inode_table_t;
@@ -32,6 +34,14 @@ typedef struct _dentry dentry_t;
 #include "glusterfs/compat-uuid.h"
 #include "glusterfs/fd.h"
 
+/* Locks of a group of hash buckets. Bucket 'i' of each hash table belongs
+ * to shard 'i % INODE_TABLE_SHARDS'. Changing a bucket requires the table
+ * lock and the write lock of its shard. Lookups only need the read lock. */
+struct _inode_table_shard {
+    pthread_rwlock_t inode_lock;  /* for inode_hash */
+    pthread_rwlock_t dentry_lock; /* for name_hash */
+};
+
 struct _inode_table {
     pthread_mutex_t lock;
     size_t dentry_hashsize; /* Number of buckets for dentry hash*/
@@ -42,6 +52,7 @@ struct _inode_table {
     uint32_t lru_limit;     /* maximum LRU cache size */
     struct list_head *inode_hash; /* buckets for inode hash table */
     struct list_head *name_hash;  /* buckets for dentry hash table */
+    struct _inode_table_shard *shards; /* locks for the hash tables */
     struct list_head active; /* list of inodes currently active (in an fop) */
     uint32_t active_size;    /* count of inodes in active list */
     struct list_head lru;    /* list of inodes recently used.
@@ -93,10 +104,10 @@ struct _inode_ctx {
         uint64_t value2;
         void *ptr2;
     };
-    int ref; /* This is for debugging inode ref leaks,
-                basically helps in identifying the xlator
-                causing th ref leak, it is printed in
-                statedump */
+    gf_atomic_int32_t ref; /* This is for debugging inode ref leaks,
+                              basically helps in identifying the xlator
+                              causing th ref leak, it is printed in
+                              statedump */
 };
 
 struct _inode {
@@ -107,7 +118,9 @@ struct _inode {
     gf_atomic_t kids;
     uint32_t fd_count;            /* Open fd count */
     uint32_t active_fd_count;     /* Active open fd count */
-    uint32_t ref;                 /* reference count on this inode */
+    gf_atomic_uint32_t ref;       /* reference count on this inode. It
+                                     only changes from or to 0 with the
+                                     table lock held */
     ia_type_t ia_type;            /* what kind of file */
     struct list_head fd_list;     /* list of open files on this inode */
     struct list_head dentry_list; /* list of directory entries for this inode */
@@ -89,6 +89,7 @@ struct iobuf_arena {
     int active_cnt;
     int passive_cnt;
     int max_active; /* max active buffers at a given time */
+    int32_t io_index; /* fixed buffer registered for mem_base or -1 */
 };
 
 struct iobuf_pool {
@@ -158,6 +159,10 @@ size_t
 iobuf_size(struct iobuf *iobuf);
 size_t
 iobref_size(struct iobref *iobref);
+int32_t
+iobuf_io_index(struct iobuf *iobuf);
+int32_t
+iobref_io_index(struct iobref *iobref, const struct iovec *iov);
 void
 iobuf_stats_dump(struct iobuf_pool *iobuf_pool);
 
@@ -14,6 +14,8 @@
 #include <inttypes.h>
 #include <time.h>
 
+#include "glusterfs/atomic.h"
+
 typedef struct _gf_latency {
     uint64_t min;   /* min time for the call (nanoseconds) */
     uint64_t max;   /* max time for the call (nanoseconds) */
@@ -30,4 +32,25 @@ gf_latency_reset(gf_latency_t *lat);
 void
 gf_latency_update(gf_latency_t *lat, struct timespec *begin,
                   struct timespec *end);
+
+/* Histogram of recent latencies, in power of 2 buckets of microseconds.
+ * Counts are halved every GF_LATENCY_HIST_DECAY samples, so that old
+ * samples weigh less and less. */
+#define GF_LATENCY_HIST_BUCKETS 32
+#define GF_LATENCY_HIST_DECAY 1024
+#define GF_LATENCY_HIST_MIN_SAMPLES 64
+
+typedef struct _gf_latency_hist {
+    gf_atomic_t count[GF_LATENCY_HIST_BUCKETS];
+    gf_atomic_t samples;
+} gf_latency_hist_t;
+
+void
+gf_latency_hist_init(gf_latency_hist_t *hist);
+
+void
+gf_latency_hist_add(gf_latency_hist_t *hist, uint64_t usec);
+
+uint64_t
+gf_latency_hist_percentile(gf_latency_hist_t *hist, uint32_t percent);
 #endif /* __LATENCY_H__ */
@@ -294,7 +294,7 @@ typedef struct per_thread_pool_list {
 
     /*
      * There's really more than one pool, but the actual number is hidden
-     * in the implementation code so we just make it a single-element array
+     * in the implementation code so we just make it a flexible array
      * here.
      */
     per_thread_pool_t pools[];
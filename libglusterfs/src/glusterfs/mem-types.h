@@ -118,6 +118,7 @@ enum gf_common_mem_types_ {
     gf_common_volfile_t,
     gf_common_mt_server_cmdline_t, /* used only in one location */
     gf_common_mt_latency_t,
+    gf_common_mt_dict_hash,
     gf_common_mt_end,
 };
 #endif
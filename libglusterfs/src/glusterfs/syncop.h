@@ -22,6 +22,16 @@
 #define SYNCENV_PROC_MIN 2
 #define SYNCPROC_IDLE_TIME 600
 
+/* Number of finished synctask stacks a syncenv keeps for reuse. */
+#define SYNCENV_STACK_POOL 32
+
+/* On these platforms synctasks are switched by hand instead of with
+ * swapcontext(), which saves and restores the signal mask with a system
+ * call each time. */
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define SYNCTASK_FAST_SWITCH 1
+#endif
+
 /*
  * Flags for syncopctx valid elements
  */
@@ -68,6 +78,8 @@ struct synctask {
     struct synccond *synccond;
     void *opaque;
     void *stack;
+    size_t stacksize;
+    void *sp; /* saved stack pointer, with SYNCTASK_FAST_SWITCH */
     synctask_state_t state;
     int woken;
     int slept;
@@ -120,6 +132,7 @@ struct syncproc {
 #endif
 
     ucontext_t sched;
+    void *sched_sp; /* saved stack pointer, with SYNCTASK_FAST_SWITCH */
     struct syncenv *env;
     struct synctask *current;
 };
@@ -144,6 +157,10 @@ struct syncenv {
 
     size_t stacksize;
 
+    /* guarded stacks of env->stacksize, ready to be reused */
+    void *stacks[SYNCENV_STACK_POOL];
+    int stack_count;
+
     int destroy; /* FLAG to mark syncenv is in destroy mode
                     so that no more synctasks are accepted*/
 };
@@ -17,6 +17,26 @@
 
 typedef void (*gf_timer_cbk_t)(void *);
 
+/* Timers are kept in hierarchical timing wheels: a root wheel with one slot
+ * per tick, and GF_TIMER_LEVELS coarser wheels that are cascaded down into
+ * it as time advances. Timers further away than the last wheel can reach
+ * are parked in its farthest slot and re-cascaded until they are due. */
+#define GF_TIMER_TICK_NS 1000000 /* 1ms */
+#define GF_TIMER_ROOT_BITS 8
+#define GF_TIMER_ROOT_SIZE (1 << GF_TIMER_ROOT_BITS)
+#define GF_TIMER_ROOT_MASK (GF_TIMER_ROOT_SIZE - 1)
+#define GF_TIMER_LEVEL_BITS 6
+#define GF_TIMER_LEVEL_SIZE (1 << GF_TIMER_LEVEL_BITS)
+#define GF_TIMER_LEVEL_MASK (GF_TIMER_LEVEL_SIZE - 1)
+#define GF_TIMER_LEVELS 3
+
+/* Each shard is a complete set of wheels with its own lock, so that timers
+ * can be added and cancelled concurrently. */
+#define GF_TIMER_SHARD_BITS 3
+#define GF_TIMER_SHARDS (1 << GF_TIMER_SHARD_BITS)
+
+struct _gf_timer_shard;
+
 struct _gf_timer {
     union {
         struct list_head list;
@@ -29,11 +49,25 @@ struct _gf_timer {
     gf_timer_cbk_t callbk;
     void *data;
     xlator_t *xl;
+    struct _gf_timer_shard *shard;
+    uint64_t expires; /* in ticks of the registry */
     gf_boolean_t fired;
+    gf_boolean_t sync; /* run the callback in a synctask */
+};
+
+struct _gf_timer_shard {
+    pthread_mutex_t lock;
+    uint64_t tick; /* next tick to be processed */
+    uint64_t count;
+    struct list_head root[GF_TIMER_ROOT_SIZE];
+    struct list_head level[GF_TIMER_LEVELS][GF_TIMER_LEVEL_SIZE];
 };
 
 struct _gf_timer_registry {
-    struct list_head active;
+    struct _gf_timer_shard shards[GF_TIMER_SHARDS];
+    glusterfs_ctx_t *ctx;
+    struct timespec base; /* start of tick 0 */
+    gf_atomic_uint64_t wakeup; /* tick the timer thread sleeps until */
     pthread_mutex_t lock;
     pthread_cond_t cond;
     pthread_t th;
@@ -41,12 +75,20 @@ struct _gf_timer_registry {
 };
 
 typedef struct _gf_timer gf_timer_t;
+typedef struct _gf_timer_shard gf_timer_shard_t;
 typedef struct _gf_timer_registry gf_timer_registry_t;
 
 gf_timer_t *
 gf_timer_call_after(glusterfs_ctx_t *ctx, struct timespec delta,
                     gf_timer_cbk_t cbk, void *data);
 
+/* Same as gf_timer_call_after(), but the callback is run from a synctask on
+ * ctx->env instead of the timer thread, so that a slow callback does not
+ * delay the other timers. */
+gf_timer_t *
+gf_timer_call_after_sync(glusterfs_ctx_t *ctx, struct timespec delta,
+                         gf_timer_cbk_t cbk, void *data);
+
 int32_t
 gf_timer_call_cancel(glusterfs_ctx_t *ctx, gf_timer_t *event);
 
@@ -179,15 +179,10 @@ hash_gfid(uuid_t uuid, int mod)
     return ((uuid[15] + (uuid[14] << 8)) % mod);
 }
 
-static void
-__dentry_hash(dentry_t *dentry, const int hash)
+static struct _inode_table_shard *
+inode_table_shard(inode_table_t *table, const int hash)
 {
-    inode_table_t *table = NULL;
-
-    table = dentry->inode->table;
-
-    list_del_init(&dentry->hash);
-    list_add(&dentry->hash, &table->name_hash[hash]);
+    return &table->shards[hash % INODE_TABLE_SHARDS];
 }
 
 static int
@@ -199,7 +194,39 @@ __is_dentry_hashed(dentry_t *dentry)
 static void
 __dentry_unhash(dentry_t *dentry)
 {
-    list_del_init(&dentry->hash);
+    inode_table_t *table = NULL;
+    struct _inode_table_shard *shard = NULL;
+
+    if (!__is_dentry_hashed(dentry))
+        return;
+
+    table = dentry->inode->table;
+    shard = inode_table_shard(
+        table, hash_dentry(dentry->parent, dentry->name, table->dentry_hashsize));
+
+    pthread_rwlock_wrlock(&shard->dentry_lock);
+    {
+        list_del_init(&dentry->hash);
+    }
+    pthread_rwlock_unlock(&shard->dentry_lock);
+}
+
+static void
+__dentry_hash(dentry_t *dentry, const int hash)
+{
+    inode_table_t *table = NULL;
+    struct _inode_table_shard *shard = NULL;
+
+    table = dentry->inode->table;
+    shard = inode_table_shard(table, hash);
+
+    __dentry_unhash(dentry);
+
+    pthread_rwlock_wrlock(&shard->dentry_lock);
+    {
+        list_add(&dentry->hash, &table->name_hash[hash]);
+    }
+    pthread_rwlock_unlock(&shard->dentry_lock);
 }
 
 static void
@@ -301,25 +328,44 @@ __is_dentry_cyclic(dentry_t *dentry)
     return ret;
 }
 
-static void
-__inode_unhash(inode_t *inode)
-{
-    list_del_init(&inode->hash);
-}
-
 static int
 __is_inode_hashed(inode_t *inode)
 {
     return !list_empty(&inode->hash);
 }
 
+static void
+__inode_unhash(inode_t *inode)
+{
+    inode_table_t *table = inode->table;
+    struct _inode_table_shard *shard = NULL;
+
+    if (!__is_inode_hashed(inode))
+        return;
+
+    shard = inode_table_shard(table,
+                              hash_gfid(inode->gfid, table->inode_hashsize));
+
+    pthread_rwlock_wrlock(&shard->inode_lock);
+    {
+        list_del_init(&inode->hash);
+    }
+    pthread_rwlock_unlock(&shard->inode_lock);
+}
+
 static void
 __inode_hash(inode_t *inode, const int hash)
 {
     inode_table_t *table = inode->table;
+    struct _inode_table_shard *shard = inode_table_shard(table, hash);
+
+    __inode_unhash(inode);
 
-    list_del_init(&inode->hash);
-    list_add(&inode->hash, &table->inode_hash[hash]);
+    pthread_rwlock_wrlock(&shard->inode_lock);
+    {
+        list_add(&inode->hash, &table->inode_hash[hash]);
+    }
+    pthread_rwlock_unlock(&shard->inode_lock);
 }
 
 static dentry_t *
@@ -488,6 +534,7 @@ __inode_unref(inode_t *inode, bool clear)
     int index = 0;
     xlator_t *this = NULL;
     uint64_t nlookup = 0;
+    uint32_t ref = 0;
 
     /*
      * Root inode should always be in active list of inode table. So unrefs
@@ -501,7 +548,7 @@ __inode_unref(inode_t *inode, bool clear)
      * as __inode_unref is called after acquiding
      * the inode table's lock.
      */
-    if (inode->table->cleanup_started && !inode->ref)
+    if (inode->table->cleanup_started && !GF_ATOMIC_GET(inode->ref))
         /*
          * There is a good chance that, the inode
          * on which unref came has already been
@@ -538,16 +585,16 @@ __inode_unref(inode_t *inode, bool clear)
         inode->table->invalidate_size--;
         __inode_activate(inode);
     }
-    GF_ASSERT(inode->ref);
+    GF_ASSERT(GF_ATOMIC_GET(inode->ref));
 
-    --inode->ref;
+    ref = GF_ATOMIC_DEC(inode->ref);
 
     index = __inode_get_xl_index(inode, this);
     if (index >= 0) {
-        inode->_ctx[index].ref--;
+        GF_ATOMIC_DEC(inode->_ctx[index].ref);
     }
 
-    if (!inode->ref && !inode->in_invalidate_list) {
+    if (!ref && !inode->in_invalidate_list) {
         inode->table->active_size--;
 
         nlookup = GF_ATOMIC_GET(inode->nlookup);
@@ -579,10 +626,10 @@ __inode_ref(inode_t *inode, bool is_invalidate)
      * in inode table increases which is wrong. So just keep the ref
      * count as 1 always
      */
-    if (__is_root_gfid(inode->gfid) && inode->ref)
+    if (__is_root_gfid(inode->gfid) && GF_ATOMIC_GET(inode->ref))
         return inode;
 
-    if (!inode->ref) {
+    if (!GF_ATOMIC_GET(inode->ref)) {
         if (inode->in_invalidate_list) {
             inode->in_invalidate_list = false;
             inode->table->invalidate_size--;
@@ -601,15 +648,73 @@ __inode_ref(inode_t *inode, bool is_invalidate)
         }
     }
 
-    inode->ref++;
+    GF_ATOMIC_INC(inode->ref);
 
     index = __inode_get_xl_index(inode, this);
     if (index >= 0)
-        inode->_ctx[index].ref++;
+        GF_ATOMIC_INC(inode->_ctx[index].ref);
 
     return inode;
 }
 
+/*
+ * The reference count of an inode only goes from 0 to 1 and from 1 to 0
+ * with the table lock held, because these transitions move the inode
+ * between lists. All other changes don't modify the state of the inode in
+ * the table, so they are done atomically without taking the table lock.
+ */
+
+/* Take a reference on an inode that is already referenced. Returns false
+ * if the inode has no references and the table lock is required. The caller
+ * must guarantee that the inode is not destroyed meanwhile. */
+static bool
+inode_ref_active(inode_t *inode)
+{
+    uint32_t ref = 0;
+    int index = 0;
+
+    do {
+        ref = GF_ATOMIC_GET(inode->ref);
+        if (ref == 0)
+            return false;
+
+        /* Same as in __inode_ref() */
+        if (__is_root_gfid(inode->gfid))
+            return true;
+    } while (!GF_ATOMIC_CMP_SWAP(inode->ref, ref, ref + 1));
+
+    index = __inode_get_xl_index(inode, THIS);
+    if (index >= 0)
+        GF_ATOMIC_INC(inode->_ctx[index].ref);
+
+    return true;
+}
+
+/* Release a reference of an inode if it's not the last one. Returns false
+ * if the table lock is required. */
+static bool
+inode_unref_active(inode_t *inode)
+{
+    uint32_t ref = 0;
+    int index = 0;
+
+    /* Same as in __inode_unref() */
+    if (__is_root_gfid(inode->gfid))
+        return true;
+
+    do {
+        ref = GF_ATOMIC_GET(inode->ref);
+        if (ref <= 1)
+            return false;
+    } while (!GF_ATOMIC_CMP_SWAP(inode->ref, ref, ref - 1));
+
+    index = __inode_get_xl_index(inode, THIS);
+    if (index >= 0)
+        GF_ATOMIC_DEC(inode->_ctx[index].ref);
+
+    return true;
+}
+
 inode_t *
 inode_unref(inode_t *inode)
 {
@@ -618,6 +723,10 @@ inode_unref(inode_t *inode)
     if (!inode)
         return NULL;
 
+    /* Nothing to prune if the inode is still referenced. */
+    if (inode_unref_active(inode))
+        return inode;
+
     table = inode->table;
 
     pthread_mutex_lock(&table->lock);
@@ -639,6 +748,9 @@ inode_ref(inode_t *inode)
     if (!inode)
         return NULL;
 
+    if (inode_ref_active(inode))
+        return inode;
+
     table = inode->table;
 
     pthread_mutex_lock(&table->lock);
@@ -756,15 +868,19 @@ static inode_t *
 __inode_ref_reduce_by_n(inode_t *inode, uint64_t nref)
 {
     uint64_t nlookup = 0;
+    uint32_t ref = 0;
+    uint32_t new_ref = 0;
 
-    GF_ASSERT(inode->ref >= nref);
-
-    inode->ref -= nref;
+    /* Other threads may be taking or releasing references without the
+     * table lock. */
+    do {
+        ref = GF_ATOMIC_GET(inode->ref);
+        GF_ASSERT(ref >= nref);
 
-    if (!nref)
-        inode->ref = 0;
+        new_ref = nref ? ref - nref : 0;
+    } while (!GF_ATOMIC_CMP_SWAP(inode->ref, ref, new_ref));
 
-    if (!inode->ref) {
+    if (!new_ref) {
         inode->table->active_size--;
 
         nlookup = GF_ATOMIC_GET(inode->nlookup);
@@ -827,7 +943,27 @@ inode_grep(inode_table_t *table, inode_t *parent, const char *name)
     }
 
     int hash = hash_dentry(parent, name, table->dentry_hashsize);
+    struct _inode_table_shard *shard = inode_table_shard(table, hash);
+    bool found = false;
+
+    /* The dentry can't be unhashed, and its inode destroyed, while the
+     * shard is locked. */
+    pthread_rwlock_rdlock(&shard->dentry_lock);
+    {
+        dentry = __dentry_grep(table, parent, name, hash);
+        if (dentry && dentry->inode) {
+            found = true;
+            if (inode_ref_active(dentry->inode))
+                inode = dentry->inode;
+        }
+    }
+    pthread_rwlock_unlock(&shard->dentry_lock);
+
+    if (!found || inode)
+        return inode;
 
+    /* The inode is not referenced. It needs to be moved out of the lru
+     * list. */
     pthread_mutex_lock(&table->lock);
     {
         dentry = __dentry_grep(table, parent, name, hash);
@@ -903,8 +1039,9 @@ inode_grep_for_gfid(inode_table_t *table, inode_t *parent, const char *name,
     }
 
     int hash = hash_dentry(parent, name, table->dentry_hashsize);
+    struct _inode_table_shard *shard = inode_table_shard(table, hash);
 
-    pthread_mutex_lock(&table->lock);
+    pthread_rwlock_rdlock(&shard->dentry_lock);
     {
         dentry = __dentry_grep(table, parent, name, hash);
         if (dentry) {
@@ -916,7 +1053,7 @@ inode_grep_for_gfid(inode_table_t *table, inode_t *parent, const char *name,
             }
         }
     }
-    pthread_mutex_unlock(&table->lock);
+    pthread_rwlock_unlock(&shard->dentry_lock);
 
     return ret;
 }
@@ -967,7 +1104,27 @@ inode_find(inode_table_t *table, uuid_t gfid)
     }
 
     int hash = hash_gfid(gfid, table->inode_hashsize);
+    struct _inode_table_shard *shard = inode_table_shard(table, hash);
+    bool found = false;
+
+    /* The inode can't be unhashed, and destroyed, while the shard is
+     * locked. */
+    pthread_rwlock_rdlock(&shard->inode_lock);
+    {
+        inode = __inode_find(table, gfid, hash);
+        if (inode) {
+            found = true;
+            if (!inode_ref_active(inode))
+                inode = NULL;
+        }
+    }
+    pthread_rwlock_unlock(&shard->inode_lock);
+
+    if (!found || inode)
+        return inode;
 
+    /* The inode is not referenced. It needs to be moved out of the lru
+     * list. */
     pthread_mutex_lock(&table->lock);
     {
         inode = __inode_find(table, gfid, hash);
@@ -1788,6 +1945,16 @@ inode_table_with_invalidator(uint32_t lru_limit, xlator_t *xl,
         INIT_LIST_HEAD(&new->name_hash[i]);
     }
 
+    new->shards = GF_CALLOC(INODE_TABLE_SHARDS, sizeof(*new->shards),
+                            gf_common_mt_inode_table_t);
+    if (!new->shards)
+        goto out;
+
+    for (i = 0; i < INODE_TABLE_SHARDS; i++) {
+        pthread_rwlock_init(&new->shards[i].inode_lock, NULL);
+        pthread_rwlock_init(&new->shards[i].dentry_lock, NULL);
+    }
+
     INIT_LIST_HEAD(&new->active);
     INIT_LIST_HEAD(&new->lru);
     INIT_LIST_HEAD(&new->purge);
@@ -1811,6 +1978,9 @@ out:
         if (new) {
             GF_FREE(new->inode_hash);
             GF_FREE(new->name_hash);
+            GF_FREE(new->shards);
+            if (new->fd_mem_pool)
+                mem_pool_destroy(new->fd_mem_pool);
             if (new->dentry_pool)
                 mem_pool_destroy(new->dentry_pool);
             if (new->inode_pool)
@@ -1925,6 +2095,7 @@ void
 inode_table_destroy(inode_table_t *inode_table)
 {
     inode_t *trav = NULL;
+    int i = 0;
 
     if (inode_table == NULL)
         return;
@@ -1993,7 +2164,7 @@ inode_table_destroy(inode_table_t *inode_table)
                                  LG_MSG_REF_COUNT,
                                  "Active inode(%p) with refcount"
                                  "(%d) found during cleanup",
-                                 trav, trav->ref);
+                                 trav, GF_ATOMIC_GET(trav->ref));
             inode_forget_atomic(trav, 0);
             __inode_ref_reduce_by_n(trav, 0);
         }
@@ -2004,6 +2175,11 @@ inode_table_destroy(inode_table_t *inode_table)
 
     GF_FREE(inode_table->inode_hash);
     GF_FREE(inode_table->name_hash);
+    for (i = 0; i < INODE_TABLE_SHARDS; i++) {
+        pthread_rwlock_destroy(&inode_table->shards[i].inode_lock);
+        pthread_rwlock_destroy(&inode_table->shards[i].dentry_lock);
+    }
+    GF_FREE(inode_table->shards);
     if (inode_table->dentry_pool)
         mem_pool_destroy(inode_table->dentry_pool);
     if (inode_table->inode_pool)
@@ -2491,7 +2667,7 @@ inode_dump(inode_t *inode, char *prefix)
         gf_proc_dump_write("nlookup", "%" PRIu64, nlookup);
         gf_proc_dump_write("fd-count", "%u", inode->fd_count);
         gf_proc_dump_write("active-fd-count", "%u", inode->active_fd_count);
-        gf_proc_dump_write("ref", "%u", inode->ref);
+        gf_proc_dump_write("ref", "%u", GF_ATOMIC_GET(inode->ref));
         gf_proc_dump_write("invalidate-sent", "%d", inode->invalidate_sent);
         gf_proc_dump_write("ia_type", "%d", inode->ia_type);
         gf_proc_dump_write("kids", "%" PRId64, GF_ATOMIC_GET(inode->kids));
@@ -2509,7 +2685,7 @@ inode_dump(inode_t *inode, char *prefix)
             for (i = 0; i < inode->table->ctxcount; i++) {
                 inode_ctx[i] = inode->_ctx[i];
                 xl = inode_ctx[i].xl_key;
-                ref = inode_ctx[i].ref;
+                ref = GF_ATOMIC_GET(inode_ctx[i].ref);
                 if (ref != 0 && xl) {
                     gf_proc_dump_build_key(key, "ref_by_xl:", "%s", xl->name);
                     gf_proc_dump_write(key, "%d", ref);
@@ -2609,7 +2785,7 @@ inode_dump_to_dict(inode_t *inode, char *prefix, dict_t *dict)
         goto out;
 
     snprintf(key, sizeof(key), "%s.ref", prefix);
-    ret = dict_set_uint32(dict, key, inode->ref);
+    ret = dict_set_uint32(dict, key, GF_ATOMIC_GET(inode->ref));
     if (ret)
         goto out;
 
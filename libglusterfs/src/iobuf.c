@@ -11,6 +11,7 @@
 #include "glusterfs/iobuf.h"
 #include "glusterfs/statedump.h"
 #include "glusterfs/libglusterfs-messages.h"
+#include "glusterfs/gf-io.h"
 
 /*
   TODO: implement destroy margins and prefetching of arenas
@@ -120,6 +121,8 @@ __iobuf_arena_destroy(struct iobuf_arena *iobuf_arena)
 
     __iobuf_arena_destroy_iobufs(iobuf_arena);
 
+    gf_io_buffer_unregister(iobuf_arena->io_index);
+
     if (iobuf_arena->mem_base && iobuf_arena->mem_base != MAP_FAILED)
         munmap(iobuf_arena->mem_base, iobuf_arena->arena_size);
 
@@ -146,6 +149,7 @@ __iobuf_arena_alloc(struct iobuf_pool *iobuf_pool, size_t page_size,
     INIT_LIST_HEAD(&iobuf_arena->passive_list);
     INIT_LIST_HEAD(&iobuf_arena->active_list);
     iobuf_arena->iobuf_pool = iobuf_pool;
+    iobuf_arena->io_index = -1;
 
     rounded_size = gf_iobuf_get_pagesize(page_size, &index);
 
@@ -168,6 +172,16 @@ __iobuf_arena_alloc(struct iobuf_pool *iobuf_pool, size_t page_size,
         goto err;
     }
 
+    /* Smaller requests never use the arenas (see iobuf_get2()), so only
+     * the ones used for big requests are registered as fixed buffers. If
+     * registration fails, I/O will simply map the pages on each request. */
+    if (rounded_size > USE_IOBUF_POOL_IF_SIZE_GREATER_THAN) {
+        iobuf_arena->io_index = gf_io_buffer_register(iobuf_arena->mem_base,
+                                                      iobuf_arena->arena_size);
+        if (iobuf_arena->io_index < 0)
+            iobuf_arena->io_index = -1;
+    }
+
     iobuf_pool->arena_cnt++;
 
     return iobuf_arena;
@@ -290,6 +304,7 @@ iobuf_create_stdalloc_arena(struct iobuf_pool *iobuf_pool)
     INIT_LIST_HEAD(&iobuf_arena->active_list);
 
     iobuf_arena->iobuf_pool = iobuf_pool;
+    iobuf_arena->io_index = -1;
 
     iobuf_arena->page_size = 0x7fffffff;
 
@@ -975,6 +990,59 @@ out:
     return size;
 }
 
+int32_t
+iobuf_io_index(struct iobuf *iobuf)
+{
+    int32_t index = -1;
+
+    GF_VALIDATE_OR_GOTO("iobuf", iobuf, out);
+
+    if (iobuf->iobuf_arena)
+        index = iobuf->iobuf_arena->io_index;
+
+out:
+    return index;
+}
+
+/* Find the fixed buffer that completely contains 'iov', if any. */
+int32_t
+iobref_io_index(struct iobref *iobref, const struct iovec *iov)
+{
+    struct iobuf_arena *iobuf_arena = NULL;
+    char *base = NULL;
+    char *ptr = NULL;
+    int32_t index = -1;
+    int i = 0;
+
+    GF_VALIDATE_OR_GOTO("iobuf", iobref, out);
+    GF_VALIDATE_OR_GOTO("iobuf", iov, out);
+
+    ptr = iov->iov_base;
+
+    LOCK(&iobref->lock);
+    {
+        for (i = 0; i < iobref->used; i++) {
+            if (!iobref->iobrefs[i])
+                continue;
+
+            iobuf_arena = iobref->iobrefs[i]->iobuf_arena;
+            if (!iobuf_arena || (iobuf_arena->io_index < 0))
+                continue;
+
+            base = iobuf_arena->mem_base;
+            if ((ptr >= base) &&
+                (ptr + iov->iov_len <= base + iobuf_arena->arena_size)) {
+                index = iobuf_arena->io_index;
+                break;
+            }
+        }
+    }
+    UNLOCK(&iobref->lock);
+
+out:
+    return index;
+}
+
 void
 iobuf_info_dump(struct iobuf *iobuf, const char *key_prefix)
 {
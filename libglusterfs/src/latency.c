@@ -82,3 +82,88 @@ gf_frame_latency_update(call_frame_t *frame)
     lat = &frame->this->stats[frame->op].latencies;
     gf_latency_update(lat, &frame->begin, &frame->end);
 }
+
+void
+gf_latency_hist_init(gf_latency_hist_t *hist)
+{
+    int i = 0;
+
+    for (i = 0; i < GF_LATENCY_HIST_BUCKETS; i++) {
+        GF_ATOMIC_INIT(hist->count[i], 0);
+    }
+    GF_ATOMIC_INIT(hist->samples, 0);
+}
+
+void
+gf_latency_hist_add(gf_latency_hist_t *hist, uint64_t usec)
+{
+    uint64_t half = 0;
+    int bucket = 0;
+    int i = 0;
+
+    /* Bucket 0 is [0, 2) usecs, bucket n is [2^n, 2^(n+1)) */
+    if (usec > 1) {
+        bucket = 63 - __builtin_clzll(usec);
+        if (bucket >= GF_LATENCY_HIST_BUCKETS) {
+            bucket = GF_LATENCY_HIST_BUCKETS - 1;
+        }
+    }
+
+    GF_ATOMIC_INC(hist->count[bucket]);
+
+    if ((GF_ATOMIC_INC(hist->samples) % GF_LATENCY_HIST_DECAY) == 0) {
+        /* Not atomic as a whole, but losing a few samples here is fine */
+        for (i = 0; i < GF_LATENCY_HIST_BUCKETS; i++) {
+            half = GF_ATOMIC_GET(hist->count[i]) / 2;
+            if (half) {
+                GF_ATOMIC_SUB(hist->count[i], half);
+            }
+        }
+    }
+}
+
+/* Returns the latency, in microseconds, below which 'percent' % of the
+ * recent samples are, or 0 if there are not enough samples yet. */
+uint64_t
+gf_latency_hist_percentile(gf_latency_hist_t *hist, uint32_t percent)
+{
+    uint64_t count[GF_LATENCY_HIST_BUCKETS];
+    uint64_t total = 0;
+    uint64_t target = 0;
+    uint64_t seen = 0;
+    uint64_t low = 0;
+    uint64_t high = 0;
+    int i = 0;
+
+    for (i = 0; i < GF_LATENCY_HIST_BUCKETS; i++) {
+        count[i] = GF_ATOMIC_GET(hist->count[i]);
+        total += count[i];
+    }
+
+    if (total < GF_LATENCY_HIST_MIN_SAMPLES) {
+        return 0;
+    }
+
+    target = (total * percent + 99) / 100;
+
+    for (i = 0; i < GF_LATENCY_HIST_BUCKETS; i++) {
+        if (seen + count[i] >= target) {
+            break;
+        }
+        seen += count[i];
+    }
+    if (i == GF_LATENCY_HIST_BUCKETS) {
+        i--;
+    }
+
+    /* Assume the samples are spread evenly inside the bucket */
+    low = i ? (1ULL << i) : 0;
+    high = 2ULL << i;
+    if (!count[i]) {
+        return high;
+    }
+
+    low += ((high - low) * (target - seen)) / count[i];
+
+    return low ? low : 1;
+}
@@ -23,6 +23,82 @@
 #include <valgrind/valgrind.h>
 #endif
 
+#include <sys/mman.h>
+
+#ifdef SYNCTASK_FAST_SWITCH
+/* Pushes the callee-saved registers on the current stack, stores the stack
+ * pointer in *from, then loads 'to' as the stack pointer and pops the
+ * registers of the context saved there. The layout of a saved context is
+ * what synctask_stack_prepare() builds for a new task. */
+void
+gf_synctask_switch(void **from, void *to);
+
+#if defined(__x86_64__)
+__asm__(".text\n"
+        ".p2align 4\n"
+        ".globl gf_synctask_switch\n"
+        ".hidden gf_synctask_switch\n"
+        ".type gf_synctask_switch, @function\n"
+        "gf_synctask_switch:\n"
+        "    pushq %rbp\n"
+        "    pushq %rbx\n"
+        "    pushq %r12\n"
+        "    pushq %r13\n"
+        "    pushq %r14\n"
+        "    pushq %r15\n"
+        "    subq $8, %rsp\n"
+        "    stmxcsr (%rsp)\n"
+        "    fnstcw 4(%rsp)\n"
+        "    movq %rsp, (%rdi)\n"
+        "    movq %rsi, %rsp\n"
+        "    ldmxcsr (%rsp)\n"
+        "    fldcw 4(%rsp)\n"
+        "    addq $8, %rsp\n"
+        "    popq %r15\n"
+        "    popq %r14\n"
+        "    popq %r13\n"
+        "    popq %r12\n"
+        "    popq %rbx\n"
+        "    popq %rbp\n"
+        "    ret\n"
+        ".size gf_synctask_switch, .-gf_synctask_switch\n");
+#elif defined(__aarch64__)
+__asm__(".text\n"
+        ".p2align 4\n"
+        ".globl gf_synctask_switch\n"
+        ".hidden gf_synctask_switch\n"
+        ".type gf_synctask_switch, %function\n"
+        "gf_synctask_switch:\n"
+        "    sub sp, sp, #160\n"
+        "    stp x19, x20, [sp, #0]\n"
+        "    stp x21, x22, [sp, #16]\n"
+        "    stp x23, x24, [sp, #32]\n"
+        "    stp x25, x26, [sp, #48]\n"
+        "    stp x27, x28, [sp, #64]\n"
+        "    stp x29, x30, [sp, #80]\n"
+        "    stp d8, d9, [sp, #96]\n"
+        "    stp d10, d11, [sp, #112]\n"
+        "    stp d12, d13, [sp, #128]\n"
+        "    stp d14, d15, [sp, #144]\n"
+        "    mov x2, sp\n"
+        "    str x2, [x0]\n"
+        "    mov sp, x1\n"
+        "    ldp x19, x20, [sp, #0]\n"
+        "    ldp x21, x22, [sp, #16]\n"
+        "    ldp x23, x24, [sp, #32]\n"
+        "    ldp x25, x26, [sp, #48]\n"
+        "    ldp x27, x28, [sp, #64]\n"
+        "    ldp x29, x30, [sp, #80]\n"
+        "    ldp d8, d9, [sp, #96]\n"
+        "    ldp d10, d11, [sp, #112]\n"
+        "    ldp d12, d13, [sp, #128]\n"
+        "    ldp d14, d15, [sp, #144]\n"
+        "    add sp, sp, #160\n"
+        "    ret\n"
+        ".size gf_synctask_switch, .-gf_synctask_switch\n");
+#endif
+#endif /* SYNCTASK_FAST_SWITCH */
+
 int
 syncopctx_setfsuid(void *uid)
 {
@@ -285,10 +361,14 @@ synctask_yield(struct synctask *task, struct timespec *delta)
                                    task->proc->sched.uc_stack.ss_size);
 #endif
 
+#ifdef SYNCTASK_FAST_SWITCH
+    gf_synctask_switch(&task->sp, task->proc->sched_sp);
+#else
     if (swapcontext(&task->ctx, &task->proc->sched) < 0) {
         gf_msg("syncop", GF_LOG_ERROR, errno, LG_MSG_SWAPCONTEXT_FAILED,
                "swapcontext failed");
     }
+#endif
 
 #ifdef HAVE_ASAN_API
     __sanitizer_finish_switch_fiber(task->proc->fake_stack, NULL, NULL);
@@ -391,13 +471,137 @@ synctask_wrap(void)
     synctask_yield(task, NULL);
 }
 
+static size_t
+synctask_stack_size(size_t size)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+
+    return (size + page - 1) & ~(page - 1);
+}
+
+/* Stacks are mapped with an inaccessible page below them, so that an
+ * overflow faults instead of silently corrupting the neighbouring memory. */
+static void *
+synctask_stack_alloc(size_t size)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    char *base = NULL;
+
+#ifdef MAP_STACK
+    flags |= MAP_STACK;
+#endif
+
+    size = synctask_stack_size(size);
+    base = mmap(NULL, size + page, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (base == MAP_FAILED) {
+        gf_msg("syncop", GF_LOG_ERROR, errno, LG_MSG_NO_MEMORY,
+               "failed to map a synctask stack of %zu bytes", size);
+        return NULL;
+    }
+
+    if (mprotect(base, page, PROT_NONE) != 0) {
+        gf_msg("syncop", GF_LOG_ERROR, errno, LG_MSG_NO_MEMORY,
+               "failed to set up a synctask stack guard page");
+        munmap(base, size + page);
+        return NULL;
+    }
+
+    return base + page;
+}
+
+static void
+synctask_stack_free(void *stack, size_t size)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+
+    munmap((char *)stack - page, synctask_stack_size(size) + page);
+}
+
+static void *
+synctask_stack_get(struct syncenv *env, size_t size)
+{
+    void *stack = NULL;
+
+    if (size == env->stacksize) {
+        pthread_mutex_lock(&env->mutex);
+        {
+            if (env->stack_count > 0)
+                stack = env->stacks[--env->stack_count];
+        }
+        pthread_mutex_unlock(&env->mutex);
+    }
+
+    if (!stack)
+        stack = synctask_stack_alloc(size);
+
+    return stack;
+}
+
+/* Gives the stack of a finished task back to its syncenv. This must run
+ * while the syncenv is still around, i.e. from its processor threads. */
+static void
+synctask_stack_put(struct synctask *task)
+{
+    struct syncenv *env = task->env;
+    void *stack = task->stack;
+
+    if (!stack)
+        return;
+
+    task->stack = NULL;
+
+#ifdef HAVE_VALGRIND_API
+    VALGRIND_STACK_DEREGISTER(task->stackid);
+#endif
+
+    if (task->stacksize == env->stacksize) {
+        pthread_mutex_lock(&env->mutex);
+        {
+            if (env->stack_count < SYNCENV_STACK_POOL) {
+                env->stacks[env->stack_count++] = stack;
+                stack = NULL;
+            }
+        }
+        pthread_mutex_unlock(&env->mutex);
+    }
+
+    if (stack)
+        synctask_stack_free(stack, task->stacksize);
+}
+
+#ifdef SYNCTASK_FAST_SWITCH
+/* Lays out a new stack so that switching to it enters synctask_wrap(), as
+ * if it had been called from a function with a NULL return address. */
+static void *
+synctask_stack_prepare(void *stack, size_t size)
+{
+    void **sp = (void **)(((uintptr_t)stack + size) & ~(uintptr_t)15);
+
+#if defined(__x86_64__)
+    *--sp = NULL;
+    *--sp = (void *)synctask_wrap;
+    sp -= 6; /* rbp, rbx, r12 - r15 */
+    memset(sp, 0, 6 * sizeof(*sp));
+    /* default MXCSR and x87 control word */
+    *--sp = (void *)(uintptr_t)(0x1f80ULL | (0x037fULL << 32));
+#elif defined(__aarch64__)
+    sp -= 20; /* x19 - x30, d8 - d15 */
+    memset(sp, 0, 20 * sizeof(*sp));
+    sp[11] = (void *)synctask_wrap; /* x30 */
+#endif
+
+    return sp;
+}
+#endif /* SYNCTASK_FAST_SWITCH */
+
 void
 synctask_destroy(struct synctask *task)
 {
     if (!task)
         return;
 
-    GF_FREE(task->stack);
+    synctask_stack_put(task);
 
     if (task->opframe && (task->opframe != task->frame))
         STACK_DESTROY(task->opframe->root);
@@ -411,16 +615,15 @@ synctask_destroy(struct synctask *task)
     __tsan_destroy_fiber(task->tsan.fiber);
 #endif
 
-#ifdef HAVE_VALGRIND_API
-    VALGRIND_STACK_DEREGISTER(task->stackid);
-#endif
-
     GF_FREE(task);
 }
 
 void
 synctask_done(struct synctask *task)
 {
+    /* The joiner may only destroy the task after the syncenv is gone. */
+    synctask_stack_put(task);
+
     if (task->synccbk) {
         synctask_destroy(task);
         return;
@@ -503,27 +706,28 @@ synctask_create(struct syncenv *env, size_t stacksize, synctask_fn_t fn,
     INIT_LIST_HEAD(&newtask->all_tasks);
     INIT_LIST_HEAD(&newtask->waitq);
 
+#ifndef SYNCTASK_FAST_SWITCH
     if (getcontext(&newtask->ctx) < 0) {
         gf_msg("syncop", GF_LOG_ERROR, errno, LG_MSG_GETCONTEXT_FAILED,
                "getcontext failed");
         goto err;
     }
+#endif
 
-    if (stacksize <= 0) {
-        newtask->stack = GF_CALLOC(1, env->stacksize, gf_common_mt_syncstack);
-        newtask->ctx.uc_stack.ss_size = env->stacksize;
-    } else {
-        newtask->stack = GF_CALLOC(1, stacksize, gf_common_mt_syncstack);
-        newtask->ctx.uc_stack.ss_size = stacksize;
-    }
-
+    newtask->stacksize = stacksize ? stacksize : env->stacksize;
+    newtask->stack = synctask_stack_get(env, newtask->stacksize);
     if (!newtask->stack) {
         goto err;
     }
 
     newtask->ctx.uc_stack.ss_sp = newtask->stack;
+    newtask->ctx.uc_stack.ss_size = newtask->stacksize;
 
+#ifdef SYNCTASK_FAST_SWITCH
+    newtask->sp = synctask_stack_prepare(newtask->stack, newtask->stacksize);
+#else
     makecontext(&newtask->ctx, (void (*)(void))synctask_wrap, 0);
+#endif
 
 #ifdef HAVE_TSAN_API
     newtask->tsan.fiber = __tsan_create_fiber(0);
@@ -553,7 +757,7 @@ synctask_create(struct syncenv *env, size_t stacksize, synctask_fn_t fn,
     return newtask;
 err:
     if (newtask) {
-        GF_FREE(newtask->stack);
+        synctask_stack_put(newtask);
         if (newtask->opframe && (newtask->opframe != newtask->frame))
             STACK_DESTROY(newtask->opframe->root);
         GF_FREE(newtask);
@@ -719,10 +923,14 @@ synctask_switchto(struct synctask *task)
                                    task->ctx.uc_stack.ss_size);
 #endif
 
+#ifdef SYNCTASK_FAST_SWITCH
+    gf_synctask_switch(&task->proc->sched_sp, task->sp);
+#else
     if (swapcontext(&task->proc->sched, &task->ctx) < 0) {
         gf_msg("syncop", GF_LOG_ERROR, errno, LG_MSG_SWAPCONTEXT_FAILED,
                "swapcontext failed");
     }
+#endif
 
 #ifdef HAVE_ASAN_API
     __sanitizer_finish_switch_fiber(task->fake_stack, NULL, NULL);
@@ -847,6 +1055,9 @@ syncenv_destroy(struct syncenv *env)
     pthread_mutex_destroy(&env->mutex);
     pthread_cond_destroy(&env->cond);
 
+    while (env->stack_count > 0)
+        synctask_stack_free(env->stacks[--env->stack_count], env->stacksize);
+
     GF_FREE(env);
 
     return;
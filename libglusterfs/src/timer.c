@@ -12,20 +12,196 @@
 #include "glusterfs/logging.h"
 #include "glusterfs/globals.h"
 #include "glusterfs/timespec.h"
+#include "glusterfs/syncop.h"
 #include "glusterfs/libglusterfs-messages.h"
 
+#define GF_TIMER_NEVER UINT64_MAX
+
 /* fwd decl */
 static gf_timer_registry_t *
 gf_timer_registry_init(glusterfs_ctx_t *);
 
-gf_timer_t *
-gf_timer_call_after(glusterfs_ctx_t *ctx, struct timespec delta,
-                    gf_timer_cbk_t callbk, void *data)
+static uint64_t
+gf_timer_tick(gf_timer_registry_t *reg, struct timespec *ts)
+{
+    return (TS((*ts)) - TS(reg->base)) / GF_TIMER_TICK_NS;
+}
+
+static gf_timer_shard_t *
+gf_timer_shard_get(gf_timer_registry_t *reg, gf_timer_t *event)
+{
+    uint64_t hash = (uintptr_t)event * 0x9E3779B97F4A7C15ULL;
+
+    return &reg->shards[hash >> (64 - GF_TIMER_SHARD_BITS)];
+}
+
+static void
+__gf_timer_shard_add(gf_timer_shard_t *shard, gf_timer_t *event)
+{
+    struct list_head *vec = NULL;
+    uint64_t expires = event->expires;
+    uint64_t idx = 0;
+    int level = 0;
+    int shift = 0;
+
+    /* Already due: fire it with the next tick processed. */
+    if (expires < shard->tick)
+        expires = shard->tick;
+
+    idx = expires - shard->tick;
+    if (idx < GF_TIMER_ROOT_SIZE) {
+        vec = &shard->root[expires & GF_TIMER_ROOT_MASK];
+        goto out;
+    }
+
+    for (level = 0; level < GF_TIMER_LEVELS; level++) {
+        shift = GF_TIMER_ROOT_BITS + (level + 1) * GF_TIMER_LEVEL_BITS;
+        if (idx < (1ULL << shift))
+            break;
+    }
+
+    if (level == GF_TIMER_LEVELS) {
+        level = GF_TIMER_LEVELS - 1;
+        expires = shard->tick + (1ULL << shift) - 1;
+    }
+
+    shift = GF_TIMER_ROOT_BITS + level * GF_TIMER_LEVEL_BITS;
+    vec = &shard->level[level][(expires >> shift) & GF_TIMER_LEVEL_MASK];
+
+out:
+    list_add_tail(&event->list, vec);
+}
+
+/* The timer thread does not advance a shard without timers, bring it up
+ * to the current tick first so that the event lands in the right wheel
+ * and the next run does not walk all the ticks since the last timer. */
+static void
+__gf_timer_shard_insert(gf_timer_shard_t *shard, gf_timer_t *event,
+                        uint64_t now)
+{
+    if (!shard->count && (shard->tick < now))
+        shard->tick = now;
+
+    __gf_timer_shard_add(shard, event);
+    shard->count++;
+}
+
+static int
+__gf_timer_shard_cascade(gf_timer_shard_t *shard, int level)
+{
+    struct list_head list;
+    gf_timer_t *event = NULL;
+    gf_timer_t *tmp = NULL;
+    int shift = GF_TIMER_ROOT_BITS + level * GF_TIMER_LEVEL_BITS;
+    int idx = (shard->tick >> shift) & GF_TIMER_LEVEL_MASK;
+
+    INIT_LIST_HEAD(&list);
+    list_splice_init(&shard->level[level][idx], &list);
+
+    list_for_each_entry_safe(event, tmp, &list, list)
+    {
+        list_del(&event->list);
+        __gf_timer_shard_add(shard, event);
+    }
+
+    return idx;
+}
+
+/* Moves every timer of the shard that is due at or before 'now' to
+ * 'expired', marking them as fired. */
+static void
+__gf_timer_shard_run(gf_timer_shard_t *shard, uint64_t now,
+                     struct list_head *expired)
+{
+    struct list_head *vec = NULL;
+    gf_timer_t *event = NULL;
+    int level = 0;
+
+    while (shard->tick <= now) {
+        if (!shard->count) {
+            shard->tick = now + 1;
+            break;
+        }
+
+        vec = &shard->root[shard->tick & GF_TIMER_ROOT_MASK];
+        if (!(shard->tick & GF_TIMER_ROOT_MASK)) {
+            for (level = 0; level < GF_TIMER_LEVELS; level++) {
+                if (__gf_timer_shard_cascade(shard, level))
+                    break;
+            }
+        }
+
+        list_for_each_entry(event, vec, list)
+        {
+            event->fired = _gf_true;
+            shard->count--;
+        }
+        list_append_init(vec, expired);
+
+        shard->tick++;
+    }
+}
+
+/* Earliest tick at which the shard needs to be looked at again: either the
+ * first non-empty slot of the root wheel, or the first cascade that moves
+ * timers down from a non-empty slot. Empty cascades are skipped. */
+static uint64_t
+__gf_timer_shard_next(gf_timer_shard_t *shard)
+{
+    uint64_t next = GF_TIMER_NEVER;
+    uint64_t tick = 0;
+    int level = 0;
+    int shift = 0;
+    int idx = 0;
+    int i = 0;
+
+    if (!shard->count)
+        return GF_TIMER_NEVER;
+
+    for (tick = shard->tick; tick < shard->tick + GF_TIMER_ROOT_SIZE;
+         tick++) {
+        if (!list_empty(&shard->root[tick & GF_TIMER_ROOT_MASK])) {
+            next = tick;
+            break;
+        }
+    }
+
+    /* Slot 'idx' of a level is cascaded at 'tick', the following ones one
+     * slot width apart. Once the level wraps, the next one cascades. */
+    tick = (shard->tick + GF_TIMER_ROOT_MASK) & ~(uint64_t)GF_TIMER_ROOT_MASK;
+    for (level = 0; (level < GF_TIMER_LEVELS) && (tick < next); level++) {
+        shift = GF_TIMER_ROOT_BITS + level * GF_TIMER_LEVEL_BITS;
+        idx = (tick >> shift) & GF_TIMER_LEVEL_MASK;
+
+        for (i = 0; i < GF_TIMER_LEVEL_SIZE; i++) {
+            if (list_empty(&shard->level[level][i]))
+                continue;
+            if (i >= idx) {
+                next = min(next, tick + ((uint64_t)(i - idx) << shift));
+                break;
+            }
+            /* cascaded after this level wraps, look again by then */
+            next = min(next, tick + ((uint64_t)(GF_TIMER_LEVEL_SIZE - idx)
+                                     << shift));
+        }
+
+        if (idx)
+            tick += (uint64_t)(GF_TIMER_LEVEL_SIZE - idx) << shift;
+    }
+
+    return next;
+}
+
+static gf_timer_t *
+gf_timer_add(glusterfs_ctx_t *ctx, struct timespec delta,
+             gf_timer_cbk_t callbk, void *data, gf_boolean_t sync)
 {
     gf_timer_registry_t *reg = NULL;
+    gf_timer_shard_t *shard = NULL;
     gf_timer_t *event = NULL;
-    gf_timer_t *trav = NULL;
+    uint64_t expires = 0;
     uint64_t at = 0;
+    uint64_t now = 0;
 
     if ((ctx == NULL) || (ctx->cleanup_started)) {
         gf_msg_callingfn("timer", GF_LOG_ERROR, EINVAL, LG_MSG_INVALID_ARG,
@@ -47,31 +223,62 @@ gf_timer_call_after(glusterfs_ctx_t *ctx, struct timespec delta,
         return NULL;
     }
     timespec_now(&event->at);
+    now = gf_timer_tick(reg, &event->at);
     timespec_adjust_delta(&event->at, delta);
-    at = TS(event->at);
     event->callbk = callbk;
     event->data = data;
     event->xl = THIS;
-    pthread_mutex_lock(&reg->lock);
+    event->sync = sync;
+
+    /* Round up, a timer must never fire early. */
+    at = TS(event->at) - TS(reg->base);
+    expires = (at + GF_TIMER_TICK_NS - 1) / GF_TIMER_TICK_NS;
+    event->expires = expires;
+
+    shard = gf_timer_shard_get(reg, event);
+    event->shard = shard;
+
+    pthread_mutex_lock(&shard->lock);
     {
-        list_for_each_entry_reverse(trav, &reg->active, list)
+        __gf_timer_shard_insert(shard, event, now);
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    /* Only wake the timer thread when it would otherwise sleep past this
+     * timer. The event itself may already be gone at this point. */
+    if (expires < GF_ATOMIC_GET(reg->wakeup)) {
+        pthread_mutex_lock(&reg->lock);
         {
-            if (TS(trav->at) < at)
-                break;
-        }
-        list_add(&event->list, &trav->list);
-        if (&trav->list == &reg->active) {
-            pthread_cond_signal(&reg->cond);
+            if (expires < GF_ATOMIC_GET(reg->wakeup)) {
+                GF_ATOMIC_INIT(reg->wakeup, expires);
+                pthread_cond_signal(&reg->cond);
+            }
         }
+        pthread_mutex_unlock(&reg->lock);
     }
-    pthread_mutex_unlock(&reg->lock);
+
     return event;
 }
 
+gf_timer_t *
+gf_timer_call_after(glusterfs_ctx_t *ctx, struct timespec delta,
+                    gf_timer_cbk_t callbk, void *data)
+{
+    return gf_timer_add(ctx, delta, callbk, data, _gf_false);
+}
+
+gf_timer_t *
+gf_timer_call_after_sync(glusterfs_ctx_t *ctx, struct timespec delta,
+                         gf_timer_cbk_t callbk, void *data)
+{
+    return gf_timer_add(ctx, delta, callbk, data, _gf_true);
+}
+
 int32_t
 gf_timer_call_cancel(glusterfs_ctx_t *ctx, gf_timer_t *event)
 {
     gf_timer_registry_t *reg = NULL;
+    gf_timer_shard_t *shard = NULL;
     gf_boolean_t fired = _gf_false;
 
     if (ctx == NULL || event == NULL) {
@@ -100,15 +307,18 @@ gf_timer_call_cancel(glusterfs_ctx_t *ctx, gf_timer_t *event)
         return -1;
     }
 
-    pthread_mutex_lock(&reg->lock);
+    shard = event->shard;
+
+    pthread_mutex_lock(&shard->lock);
     {
         fired = event->fired;
         if (fired)
             goto unlock;
         list_del(&event->list);
+        shard->count--;
     }
 unlock:
-    pthread_mutex_unlock(&reg->lock);
+    pthread_mutex_unlock(&shard->lock);
 
     if (!fired) {
         GF_FREE(event);
@@ -117,53 +327,139 @@ unlock:
     return -1;
 }
 
+static int
+gf_timer_sync_fn(void *opaque)
+{
+    gf_timer_t *event = opaque;
+
+    event->callbk(event->data);
+
+    return 0;
+}
+
+static int
+gf_timer_sync_done(int ret, call_frame_t *frame, void *opaque)
+{
+    GF_FREE(opaque);
+
+    return 0;
+}
+
+static void
+gf_timer_fire(gf_timer_registry_t *reg, gf_timer_t *event)
+{
+    xlator_t *old_THIS = NULL;
+    int ret = -1;
+
+    if (event->xl) {
+        old_THIS = THIS;
+        THIS = event->xl;
+    }
+
+    /* The synctask inherits THIS from us. Without a syncenv, or if the
+     * task can't be created, the callback runs here. */
+    if (event->sync && reg->ctx->env)
+        ret = synctask_new(reg->ctx->env, gf_timer_sync_fn, gf_timer_sync_done,
+                           NULL, event);
+    if (ret) {
+        event->callbk(event->data);
+        GF_FREE(event);
+    }
+
+    if (old_THIS) {
+        THIS = old_THIS;
+    }
+}
+
 static void *
 gf_timer_proc(void *data)
 {
     gf_timer_registry_t *reg = data;
+    gf_timer_shard_t *shard = NULL;
     gf_timer_t *event = NULL;
     gf_timer_t *tmp = NULL;
-    xlator_t *old_THIS = NULL;
+    struct list_head expired;
+    struct timespec now;
+    uint64_t next = 0;
+    uint64_t tick = 0;
+    int i = 0;
+    int j = 0;
+
+    INIT_LIST_HEAD(&expired);
 
     pthread_mutex_lock(&reg->lock);
 
     while (!reg->fin) {
-        if (list_empty(&reg->active)) {
-            pthread_cond_wait(&reg->cond, &reg->lock);
-        } else {
-            struct timespec now;
-
-            timespec_now(&now);
-            event = list_first_entry(&reg->active, gf_timer_t, list);
-            if (TS(now) < TS(event->at)) {
-                now = event->at;
-                pthread_cond_timedwait(&reg->cond, &reg->lock, &now);
-            } else {
-                event->fired = _gf_true;
+        timespec_now(&now);
+        tick = gf_timer_tick(reg, &now);
+
+        for (i = 0; i < GF_TIMER_SHARDS; i++) {
+            shard = &reg->shards[i];
+            pthread_mutex_lock(&shard->lock);
+            {
+                __gf_timer_shard_run(shard, tick, &expired);
+            }
+            pthread_mutex_unlock(&shard->lock);
+        }
+
+        if (!list_empty(&expired)) {
+            pthread_mutex_unlock(&reg->lock);
+
+            list_for_each_entry_safe(event, tmp, &expired, list)
+            {
                 list_del_init(&event->list);
+                gf_timer_fire(reg, event);
+            }
 
-                pthread_mutex_unlock(&reg->lock);
+            pthread_mutex_lock(&reg->lock);
+            continue;
+        }
 
-                old_THIS = NULL;
-                if (event->xl) {
-                    old_THIS = THIS;
-                    THIS = event->xl;
-                }
-                event->callbk(event->data);
-                GF_FREE(event);
-                if (old_THIS) {
-                    THIS = old_THIS;
-                }
+        /* Until the shards have been scanned, anyone adding a timer has to
+         * take reg->lock and compare against the final value. */
+        GF_ATOMIC_INIT(reg->wakeup, GF_TIMER_NEVER);
 
-                pthread_mutex_lock(&reg->lock);
+        next = GF_TIMER_NEVER;
+        for (i = 0; i < GF_TIMER_SHARDS; i++) {
+            shard = &reg->shards[i];
+            pthread_mutex_lock(&shard->lock);
+            {
+                tick = __gf_timer_shard_next(shard);
             }
+            pthread_mutex_unlock(&shard->lock);
+            if (tick < next)
+                next = tick;
+        }
+
+        GF_ATOMIC_INIT(reg->wakeup, next);
+
+        if (next == GF_TIMER_NEVER) {
+            pthread_cond_wait(&reg->cond, &reg->lock);
+        } else {
+            next = TS(reg->base) + next * GF_TIMER_TICK_NS;
+            now.tv_sec = next / 1000000000;
+            now.tv_nsec = next % 1000000000;
+            pthread_cond_timedwait(&reg->cond, &reg->lock, &now);
         }
     }
 
     /* Do not call gf_timer_call_cancel(),
      * it will lead to deadlock
      */
-    list_for_each_entry_safe(event, tmp, &reg->active, list)
+    for (i = 0; i < GF_TIMER_SHARDS; i++) {
+        shard = &reg->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        for (j = 0; j < GF_TIMER_ROOT_SIZE; j++)
+            list_splice_init(&shard->root[j], &expired);
+        for (j = 0; j < GF_TIMER_LEVELS * GF_TIMER_LEVEL_SIZE; j++)
+            list_splice_init(&shard->level[j / GF_TIMER_LEVEL_SIZE]
+                                          [j % GF_TIMER_LEVEL_SIZE],
+                             &expired);
+        shard->count = 0;
+        pthread_mutex_unlock(&shard->lock);
+    }
+
+    list_for_each_entry_safe(event, tmp, &expired, list)
     {
         list_del(&event->list);
         /* TODO Possible resource leak
@@ -181,11 +477,26 @@ gf_timer_proc(void *data)
     return NULL;
 }
 
+static void
+gf_timer_shard_init(gf_timer_shard_t *shard)
+{
+    int i = 0;
+    int j = 0;
+
+    pthread_mutex_init(&shard->lock, NULL);
+    for (i = 0; i < GF_TIMER_ROOT_SIZE; i++)
+        INIT_LIST_HEAD(&shard->root[i]);
+    for (i = 0; i < GF_TIMER_LEVELS; i++)
+        for (j = 0; j < GF_TIMER_LEVEL_SIZE; j++)
+            INIT_LIST_HEAD(&shard->level[i][j]);
+}
+
 static gf_timer_registry_t *
 gf_timer_registry_init(glusterfs_ctx_t *ctx)
 {
     gf_timer_registry_t *reg = NULL;
     int ret = -1;
+    int i = 0;
     pthread_condattr_t attr;
 
     LOCK(&ctx->lock);
@@ -200,12 +511,16 @@ gf_timer_registry_init(glusterfs_ctx_t *ctx)
             UNLOCK(&ctx->lock);
             goto out;
         }
-        ctx->timer = reg;
+        reg->ctx = ctx;
+        timespec_now(&reg->base);
+        for (i = 0; i < GF_TIMER_SHARDS; i++)
+            gf_timer_shard_init(&reg->shards[i]);
+        GF_ATOMIC_INIT(reg->wakeup, GF_TIMER_NEVER);
         pthread_mutex_init(&reg->lock, NULL);
         pthread_condattr_init(&attr);
         pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
         pthread_cond_init(&reg->cond, &attr);
-        INIT_LIST_HEAD(&reg->active);
+        ctx->timer = reg;
     }
     UNLOCK(&ctx->lock);
     ret = gf_thread_create(&reg->th, NULL, gf_timer_proc, reg, "timer");
@@ -223,6 +538,7 @@ gf_timer_registry_destroy(glusterfs_ctx_t *ctx)
 {
     pthread_t thr_id;
     gf_timer_registry_t *reg = NULL;
+    int i = 0;
 
     if (ctx == NULL)
         return;
@@ -250,6 +566,8 @@ gf_timer_registry_destroy(glusterfs_ctx_t *ctx)
 
     pthread_cond_destroy(&reg->cond);
     pthread_mutex_destroy(&reg->lock);
+    for (i = 0; i < GF_TIMER_SHARDS; i++)
+        pthread_mutex_destroy(&reg->shards[i].lock);
 
     GF_FREE(reg);
 }
@@ -0,0 +1,300 @@
+/*
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "glusterfs/glusterfs.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/dict.h"
+#include "glusterfs/mem-pool.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <string.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+#define KEYS 100
+
+/*
+ * Helper functions
+ */
+static int
+helper_ctx_init(void **state)
+{
+    glusterfs_ctx_t *ctx = NULL;
+
+    ctx = glusterfs_ctx_new();
+    assert_non_null(ctx);
+    assert_int_equal(glusterfs_globals_init(ctx), 0);
+    THIS->ctx = ctx;
+
+    mem_pools_init();
+    ctx->dict_pool = mem_pool_new(dict_t, 32);
+    ctx->dict_pair_pool = mem_pool_new(data_pair_t, 512);
+    ctx->dict_data_pool = mem_pool_new(data_t, 512);
+    assert_non_null(ctx->dict_pool);
+    assert_non_null(ctx->dict_pair_pool);
+    assert_non_null(ctx->dict_data_pool);
+
+    return 0;
+}
+
+static void
+helper_key(char *key, size_t size, int i)
+{
+    snprintf(key, size, "trusted.unittest.key-%d", i);
+}
+
+/* Checks that the keys of [first, last) are in the dict with their value,
+ * and that the others are not. */
+static void
+helper_check_keys(dict_t *dict, int first, int last)
+{
+    char key[64];
+    int32_t value = 0;
+    int i = 0;
+
+    for (i = 0; i < KEYS; i++) {
+        helper_key(key, sizeof(key), i);
+        if ((i >= first) && (i < last)) {
+            assert_int_equal(dict_get_int32(dict, key, &value), 0);
+            assert_int_equal(value, i);
+        } else {
+            assert_null(dict_get(dict, key));
+        }
+    }
+
+    assert_int_equal(dict->count, last - first);
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_dict_inline_storage(void **state)
+{
+    dict_t *dict = NULL;
+    char *str = NULL;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    /* The first pairs and keys do not allocate. */
+    assert_int_equal(dict_set_str(dict, "k1", "v1"), 0);
+    assert_int_equal(dict_set_str(dict, "k2", "v2"), 0);
+    assert_int_equal(dict->inline_pairs_used, 3);
+    assert_int_equal(dict->inline_keys_used, 6);
+
+    /* Then the pair pool and the heap take over. */
+    assert_int_equal(dict_set_str(dict, "k3", "v3"), 0);
+    assert_int_equal(dict_set_str(dict, "a-key-longer-than-the-inline-buffer-"
+                                        "of-the-dict",
+                                  "v4"),
+                     0);
+    assert_int_equal(dict->count, 4);
+
+    /* Deleting the last inline key gives its space back. */
+    assert_int_equal(dict->inline_keys_used, 9);
+    dict_del(dict, "k3");
+    assert_int_equal(dict->inline_keys_used, 6);
+    dict_del(dict, "k2");
+    assert_int_equal(dict->inline_keys_used, 3);
+    assert_int_equal(dict->inline_pairs_used & 2, 0);
+
+    assert_int_equal(dict_set_str(dict, "k5", "v5"), 0);
+    assert_int_equal(dict_get_str(dict, "k1", &str), 0);
+    assert_string_equal(str, "v1");
+    assert_int_equal(dict_get_str(dict, "k5", &str), 0);
+    assert_string_equal(str, "v5");
+    assert_int_equal(dict_get_str(dict, "a-key-longer-than-the-inline-buffer-"
+                                        "of-the-dict",
+                                  &str),
+                     0);
+    assert_string_equal(str, "v4");
+    assert_null(dict_get(dict, "k2"));
+    assert_int_equal(dict->count, 3);
+
+    /* A reset dict starts over from its inline storage. */
+    assert_int_equal(dict_reset(dict), 0);
+    assert_int_equal(dict->count, 0);
+    assert_int_equal(dict->inline_pairs_used, 0);
+    assert_int_equal(dict->inline_keys_used, 0);
+    assert_int_equal(dict_set_str(dict, "k1", "v1"), 0);
+    assert_int_equal(dict->inline_pairs_used, 1);
+
+    dict_unref(dict);
+}
+
+static void
+test_dict_hash_table(void **state)
+{
+    dict_t *dict = NULL;
+    char key[64];
+    int i = 0;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    for (i = 0; i < DICT_HASH_THRESHOLD; i++) {
+        helper_key(key, sizeof(key), i);
+        assert_int_equal(dict_set_int32(dict, key, i), 0);
+    }
+    assert_null(dict->hash);
+
+    for (; i < KEYS; i++) {
+        helper_key(key, sizeof(key), i);
+        assert_int_equal(dict_set_int32(dict, key, i), 0);
+    }
+    assert_non_null(dict->hash);
+    assert_true(dict->hash_size * 2 >= KEYS);
+    helper_check_keys(dict, 0, KEYS);
+
+    /* Replacing a value does not add a key. */
+    helper_key(key, sizeof(key), 7);
+    assert_int_equal(dict_set_int32(dict, key, 7), 0);
+    assert_int_equal(dict->count, KEYS);
+
+    for (i = 0; i < KEYS / 2; i++) {
+        helper_key(key, sizeof(key), i);
+        dict_del(dict, key);
+    }
+    helper_check_keys(dict, KEYS / 2, KEYS);
+
+    dict_unref(dict);
+}
+
+static void
+test_dict_copy_serialize(void **state)
+{
+    dict_t *dict = NULL;
+    dict_t *copy = NULL;
+    dict_t *unser = NULL;
+    char *buf = NULL;
+    u_int len = 0;
+    char key[64];
+    int i = 0;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    for (i = 0; i < KEYS; i++) {
+        helper_key(key, sizeof(key), i);
+        assert_int_equal(dict_set_int32(dict, key, i), 0);
+    }
+
+    copy = dict_copy_with_ref(dict, NULL);
+    assert_non_null(copy);
+    helper_check_keys(copy, 0, KEYS);
+
+    assert_int_equal(dict_allocate_and_serialize(dict, &buf, &len), 0);
+    unser = dict_new();
+    assert_non_null(unser);
+    assert_int_equal(dict_unserialize(buf, len, &unser), 0);
+    helper_check_keys(unser, 0, KEYS);
+
+    GF_FREE(buf);
+    dict_unref(unser);
+    dict_unref(copy);
+    dict_unref(dict);
+}
+
+/* Returns true if the value of the key points into [buf, buf + len). */
+static gf_boolean_t
+helper_in_buf(dict_t *dict, char *key, uintptr_t buf, u_int len)
+{
+    data_t *data = dict_get(dict, key);
+
+    assert_non_null(data);
+
+    return ((uintptr_t)data->data >= buf) &&
+           ((uintptr_t)data->data < buf + len);
+}
+
+static void
+test_dict_unserialize_stdalloc(void **state)
+{
+    dict_t *dict = NULL;
+    dict_t *unser = NULL;
+    dict_t *copy = NULL;
+    data_t *kept = NULL;
+    char *buf = NULL;
+    char *sbuf = NULL;
+    uintptr_t base = 0;
+    u_int len = 0;
+    char key[64];
+    int i = 0;
+
+    dict = dict_new();
+    assert_non_null(dict);
+    for (i = 0; i < KEYS; i++) {
+        helper_key(key, sizeof(key), i);
+        assert_int_equal(dict_set_int32(dict, key, i), 0);
+    }
+    assert_int_equal(dict_allocate_and_serialize(dict, &buf, &len), 0);
+    dict_unref(dict);
+
+    /* The buffer must come from malloc(), as the ones decoded by XDR. */
+    sbuf = malloc(len);
+    assert_non_null(sbuf);
+    memcpy(sbuf, buf, len);
+    GF_FREE(buf);
+    base = (uintptr_t)sbuf;
+
+    /* The values point into the buffer, which the dict now owns. */
+    unser = dict_new();
+    assert_non_null(unser);
+    assert_int_equal(dict_unserialize_stdalloc(sbuf, len, &unser), 0);
+    assert_ptr_equal(unser->extra_stdfree, sbuf);
+    helper_check_keys(unser, 0, KEYS);
+    for (i = 0; i < KEYS; i++) {
+        helper_key(key, sizeof(key), i);
+        assert_true(helper_in_buf(unser, key, base, len));
+    }
+
+    /* Values still used elsewhere get their own copy when the dict drops
+     * them, not before. */
+    copy = dict_copy_with_ref(unser, NULL);
+    assert_non_null(copy);
+    helper_key(key, sizeof(key), 0);
+    kept = data_ref(dict_get(unser, key));
+    assert_true(helper_in_buf(copy, key, base, len));
+
+    helper_key(key, sizeof(key), 1);
+    dict_del(unser, key);
+    assert_false(helper_in_buf(copy, key, base, len));
+    helper_key(key, sizeof(key), 2);
+    assert_true(helper_in_buf(copy, key, base, len));
+
+    dict_unref(unser);
+    for (i = 0; i < KEYS; i++) {
+        helper_key(key, sizeof(key), i);
+        assert_false(helper_in_buf(copy, key, base, len));
+    }
+    helper_check_keys(copy, 0, KEYS);
+    assert_int_equal(data_to_int32(kept), 0);
+    assert_null(kept->borrowed_from);
+
+    data_unref(kept);
+    dict_unref(copy);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest libglusterfs_dict_tests[] = {
+        cmocka_unit_test(test_dict_inline_storage),
+        cmocka_unit_test(test_dict_hash_table),
+        cmocka_unit_test(test_dict_copy_serialize),
+        cmocka_unit_test(test_dict_unserialize_stdalloc),
+    };
+
+    return cmocka_run_group_tests(libglusterfs_dict_tests, helper_ctx_init,
+                                  NULL);
+}
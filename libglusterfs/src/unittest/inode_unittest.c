@@ -0,0 +1,294 @@
+/*
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "glusterfs/glusterfs.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/inode.h"
+#include "glusterfs/mem-pool.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <string.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+#define INODES 512
+#define THREADS 8
+#define OPS 20000
+
+static xlator_t inode_xl;
+static struct xlator_cbks inode_cbks;
+
+struct inode_test {
+    inode_table_t *table;
+    uuid_t gfid[INODES];
+    /* Lookups each inode is known to hold. inode->nlookup is never lower. */
+    uint64_t lookups[INODES];
+};
+
+struct inode_worker {
+    pthread_t thread;
+    struct inode_test *test;
+    unsigned int seed;
+};
+
+/*
+ * Helper functions
+ */
+static int
+helper_ctx_init(void **state)
+{
+    glusterfs_ctx_t *ctx = NULL;
+
+    ctx = glusterfs_ctx_new();
+    assert_non_null(ctx);
+    assert_int_equal(glusterfs_globals_init(ctx), 0);
+    THIS->ctx = ctx;
+
+    mem_pools_init();
+
+    inode_xl.name = "inode-unittest";
+    inode_xl.ctx = ctx;
+    inode_xl.cbks = &inode_cbks;
+
+    return 0;
+}
+
+static void
+helper_name(char *name, size_t size, int i)
+{
+    snprintf(name, size, "file-%d", i);
+}
+
+/* Returns a referenced inode for entry 'i', linking a new one if it isn't
+ * in the table. */
+static inode_t *
+helper_get(struct inode_test *test, int i)
+{
+    inode_t *inode = NULL;
+    inode_t *linked = NULL;
+    struct iatt iatt = {
+        0,
+    };
+    char name[32];
+
+    inode = inode_find(test->table, test->gfid[i]);
+    if (inode)
+        return inode;
+
+    inode = inode_new(test->table);
+    assert_non_null(inode);
+
+    gf_uuid_copy(iatt.ia_gfid, test->gfid[i]);
+    iatt.ia_ino = gfid_to_ino(test->gfid[i]);
+    iatt.ia_type = IA_IFREG;
+    helper_name(name, sizeof(name), i);
+
+    /* Another thread may have linked it meanwhile. */
+    linked = inode_link(inode, test->table->root, name, &iatt);
+    assert_non_null(linked);
+    inode_unref(inode);
+
+    return linked;
+}
+
+static void
+helper_forget(struct inode_test *test, int i)
+{
+    inode_t *inode = NULL;
+    uint64_t lookups = 0;
+
+    lookups = __atomic_load_n(&test->lookups[i], __ATOMIC_RELAXED);
+    do {
+        if (lookups == 0)
+            return;
+    } while (!__atomic_compare_exchange_n(&test->lookups[i], &lookups,
+                                          lookups - 1, false, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+
+    /* Still looked up, so it can't have left the table. */
+    inode = inode_find(test->table, test->gfid[i]);
+    assert_non_null(inode);
+
+    inode_forget(inode, 1);
+    inode_unref(inode);
+}
+
+static void *
+helper_worker(void *data)
+{
+    struct inode_worker *worker = data;
+    struct inode_test *test = worker->test;
+    inode_t *inode = NULL;
+    char name[32];
+    int op = 0;
+    int i = 0;
+    int n = 0;
+
+    THIS = &inode_xl;
+
+    for (n = 0; n < OPS; n++) {
+        i = rand_r(&worker->seed) % INODES;
+        op = rand_r(&worker->seed) % 4;
+
+        switch (op) {
+            case 0:
+                inode = helper_get(test, i);
+                inode_lookup(inode);
+                __atomic_add_fetch(&test->lookups[i], 1, __ATOMIC_RELAXED);
+                inode_unref(inode);
+                break;
+            case 1:
+                helper_forget(test, i);
+                break;
+            case 2:
+                helper_name(name, sizeof(name), i);
+                inode = inode_grep(test->table, test->table->root, name);
+                if (inode) {
+                    assert_int_equal(gf_uuid_compare(inode->gfid,
+                                                     test->gfid[i]),
+                                     0);
+                    inode_unref(inode);
+                }
+                break;
+            default:
+                /* Refs and unrefs that don't cross zero. */
+                inode = helper_get(test, i);
+                inode_ref(inode);
+                inode_ref(inode);
+                inode_unref(inode);
+                inode_unref(inode);
+                inode_unref(inode);
+                break;
+        }
+    }
+
+    return NULL;
+}
+
+/* Checks that the lists and their sizes agree, and that only the root is
+ * still referenced. */
+static void
+helper_check_lists(inode_table_t *table)
+{
+    inode_t *inode = NULL;
+    uint32_t active = 0;
+    uint32_t lru = 0;
+
+    pthread_mutex_lock(&table->lock);
+    {
+        list_for_each_entry(inode, &table->active, list)
+        {
+            assert_true(GF_ATOMIC_GET(inode->ref) > 0);
+            assert_false(inode->in_lru_list);
+            assert_ptr_equal(inode, table->root);
+            active++;
+        }
+
+        list_for_each_entry(inode, &table->lru, list)
+        {
+            assert_int_equal(GF_ATOMIC_GET(inode->ref), 0);
+            assert_true(inode->in_lru_list);
+            assert_int_equal(GF_ATOMIC_GET(inode->_ctx[0].ref), 0);
+            lru++;
+        }
+
+        assert_int_equal(active, table->active_size);
+        assert_int_equal(lru, table->lru_size);
+        assert_int_equal(table->purge_size, 0);
+        assert_true(list_empty(&table->purge));
+    }
+    pthread_mutex_unlock(&table->lock);
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_inode_table_concurrent_refs(void **state)
+{
+    struct inode_test *test = NULL;
+    struct inode_worker workers[THREADS];
+    inode_t *inode = NULL;
+    char name[32];
+    int i = 0;
+
+    THIS = &inode_xl;
+
+    test = calloc(1, sizeof(*test));
+    assert_non_null(test);
+
+    /* No lru limit, so that an inode only leaves the table when it loses
+     * its last reference without being looked up. */
+    test->table = inode_table_new(0, &inode_xl, 0, 0);
+    assert_non_null(test->table);
+
+    for (i = 0; i < INODES; i++)
+        gf_uuid_generate(test->gfid[i]);
+
+    for (i = 0; i < THREADS; i++) {
+        workers[i].test = test;
+        workers[i].seed = i + 1;
+        assert_int_equal(pthread_create(&workers[i].thread, NULL,
+                                        helper_worker, &workers[i]),
+                         0);
+    }
+
+    for (i = 0; i < THREADS; i++)
+        pthread_join(workers[i].thread, NULL);
+
+    helper_check_lists(test->table);
+
+    for (i = 0; i < INODES; i++) {
+        inode = inode_find(test->table, test->gfid[i]);
+        if (!inode) {
+            assert_int_equal(test->lookups[i], 0);
+            continue;
+        }
+
+        assert_int_equal(GF_ATOMIC_GET(inode->ref), 1);
+        assert_int_equal(GF_ATOMIC_GET(inode->_ctx[0].ref), 1);
+        assert_int_equal(GF_ATOMIC_GET(inode->nlookup), test->lookups[i]);
+        assert_false(inode->in_lru_list);
+
+        helper_name(name, sizeof(name), i);
+        assert_ptr_equal(inode_grep(test->table, test->table->root, name),
+                         inode);
+        assert_int_equal(GF_ATOMIC_GET(inode->ref), 2);
+        inode_unref(inode);
+
+        inode_unref(inode);
+        assert_true(inode->in_lru_list);
+    }
+
+    helper_check_lists(test->table);
+
+    /* Moving an inode to the lru list prunes it down to the limit. */
+    test->table->lru_limit = 1;
+    inode = helper_get(test, 0);
+    inode_unref(inode);
+
+    helper_check_lists(test->table);
+    assert_int_equal(test->table->lru_size, 1);
+
+    free(test);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest libglusterfs_inode_tests[] = {
+        cmocka_unit_test(test_inode_table_concurrent_refs),
+    };
+
+    return cmocka_run_group_tests(libglusterfs_inode_tests, helper_ctx_init,
+                                  NULL);
+}
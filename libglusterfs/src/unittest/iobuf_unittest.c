@@ -0,0 +1,203 @@
+/*
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "glusterfs/glusterfs.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/iobuf.h"
+#include "glusterfs/mem-pool.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <string.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+/* Page sizes of the arenas registered as fixed buffers. Each arena of the
+ * 1 MiB class holds two pages. */
+#define SIZE_256K (256 * 1024)
+#define SIZE_1M (1024 * 1024)
+
+/*
+ * Helper functions
+ */
+static int
+helper_ctx_init(void **state)
+{
+    glusterfs_ctx_t *ctx = NULL;
+
+    ctx = glusterfs_ctx_new();
+    assert_non_null(ctx);
+    assert_int_equal(glusterfs_globals_init(ctx), 0);
+    THIS->ctx = ctx;
+
+    mem_pools_init();
+
+    return 0;
+}
+
+static int32_t
+helper_iov_index(struct iobref *iobref, void *base, size_t len)
+{
+    struct iovec iov = {
+        .iov_base = base,
+        .iov_len = len,
+    };
+
+    return iobref_io_index(iobref, &iov);
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_iobuf_arena_registration(void **state)
+{
+    struct iobuf_pool *pool = NULL;
+    struct iobuf *small = NULL;
+    struct iobuf *huge = NULL;
+    struct iobuf *mid = NULL;
+    struct iobuf *big[3];
+    int32_t first = 0;
+    int32_t index = 0;
+    int32_t grown = 0;
+
+    pool = iobuf_pool_new();
+    assert_non_null(pool);
+
+    /* Requests up to 128 KiB and above the biggest arena don't use
+     * registered memory. */
+    small = iobuf_get2(pool, 4096);
+    assert_non_null(small);
+    assert_int_equal(iobuf_io_index(small), -1);
+
+    huge = iobuf_get2(pool, 2 * SIZE_1M);
+    assert_non_null(huge);
+    assert_int_equal(iobuf_io_index(huge), -1);
+
+    mid = iobuf_get2(pool, SIZE_256K);
+    assert_non_null(mid);
+    first = iobuf_io_index(mid);
+    assert_true(first >= 0);
+
+    big[0] = iobuf_get2(pool, SIZE_1M);
+    big[1] = iobuf_get2(pool, SIZE_1M);
+    assert_non_null(big[0]);
+    assert_non_null(big[1]);
+    index = iobuf_io_index(big[0]);
+    assert_true(index >= 0);
+    assert_true(index != first);
+    assert_int_equal(iobuf_io_index(big[1]), index);
+
+    /* The first 1 MiB arena is full, a new one is registered. */
+    big[2] = iobuf_get2(pool, SIZE_1M);
+    assert_non_null(big[2]);
+    grown = iobuf_io_index(big[2]);
+    assert_true(grown >= 0);
+    assert_true((grown != first) && (grown != index));
+
+    /* Once the first arena has a free page again, the new arena is
+     * destroyed when its last buffer is released, and its entry becomes
+     * free for the next arena. */
+    iobuf_unref(big[1]);
+    iobuf_unref(big[2]);
+
+    big[1] = iobuf_get2(pool, SIZE_1M);
+    assert_int_equal(iobuf_io_index(big[1]), index);
+    big[2] = iobuf_get2(pool, SIZE_1M);
+    assert_int_equal(iobuf_io_index(big[2]), grown);
+
+    iobuf_unref(small);
+    iobuf_unref(huge);
+    iobuf_unref(mid);
+    iobuf_unref(big[0]);
+    iobuf_unref(big[1]);
+    iobuf_unref(big[2]);
+
+    iobuf_pool_destroy(pool);
+
+    /* Destroying the pool released all of its entries. */
+    pool = iobuf_pool_new();
+    assert_non_null(pool);
+
+    mid = iobuf_get2(pool, SIZE_256K);
+    assert_int_equal(iobuf_io_index(mid), first);
+    big[0] = iobuf_get2(pool, SIZE_1M);
+    assert_int_equal(iobuf_io_index(big[0]), index);
+
+    iobuf_unref(mid);
+    iobuf_unref(big[0]);
+
+    iobuf_pool_destroy(pool);
+}
+
+static void
+test_iobref_io_index(void **state)
+{
+    struct iobuf_pool *pool = NULL;
+    struct iobuf_arena *arena = NULL;
+    struct iobref *iobref = NULL;
+    struct iobuf *small = NULL;
+    struct iobuf *big = NULL;
+    char *end = NULL;
+    char local[64];
+    int32_t index = 0;
+
+    pool = iobuf_pool_new();
+    assert_non_null(pool);
+
+    small = iobuf_get2(pool, 4096);
+    big = iobuf_get2(pool, SIZE_1M);
+    assert_non_null(small);
+    assert_non_null(big);
+    index = iobuf_io_index(big);
+    assert_true(index >= 0);
+
+    iobref = iobref_new();
+    assert_non_null(iobref);
+    assert_int_equal(iobref_add(iobref, small), 0);
+
+    /* Nothing registered in the iobref yet. */
+    assert_int_equal(helper_iov_index(iobref, small->ptr, 4096), -1);
+    assert_int_equal(helper_iov_index(iobref, big->ptr, 4096), -1);
+
+    assert_int_equal(iobref_add(iobref, big), 0);
+
+    assert_int_equal(helper_iov_index(iobref, big->ptr, SIZE_1M), index);
+    assert_int_equal(helper_iov_index(iobref, (char *)big->ptr + 512, 4096),
+                     index);
+    assert_int_equal(helper_iov_index(iobref, small->ptr, 4096), -1);
+    assert_int_equal(helper_iov_index(iobref, local, sizeof(local)), -1);
+
+    /* The iovec must be completely inside of the registered memory. */
+    arena = big->iobuf_arena;
+    end = (char *)arena->mem_base + arena->arena_size;
+    assert_int_equal(helper_iov_index(iobref, end - 4096, 4096), index);
+    assert_int_equal(helper_iov_index(iobref, end - 4096, 8192), -1);
+    assert_int_equal(helper_iov_index(iobref, end, 4096), -1);
+
+    iobuf_unref(small);
+    iobuf_unref(big);
+    iobref_unref(iobref);
+
+    iobuf_pool_destroy(pool);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest libglusterfs_iobuf_tests[] = {
+        cmocka_unit_test(test_iobuf_arena_registration),
+        cmocka_unit_test(test_iobref_io_index),
+    };
+
+    return cmocka_run_group_tests(libglusterfs_iobuf_tests, helper_ctx_init,
+                                  NULL);
+}
@@ -0,0 +1,200 @@
+/*
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* The wheels are driven directly through the static helpers, with ticks
+ * chosen by the test instead of the clock. */
+#include "../timer.c"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+/*
+ * Helper functions
+ */
+
+/* Plays the timer thread: sleeps until the tick the shard asks for and
+ * runs it. Every timer must fire on its own tick. Returns the number of
+ * wakeups needed to fire all of them. */
+static int
+helper_shard_drain(gf_timer_shard_t *shard)
+{
+    struct list_head expired;
+    gf_timer_t *event = NULL;
+    gf_timer_t *tmp = NULL;
+    uint64_t next = 0;
+    int wakeups = 0;
+
+    INIT_LIST_HEAD(&expired);
+
+    while (shard->count) {
+        next = __gf_timer_shard_next(shard);
+        assert_true(next != GF_TIMER_NEVER);
+        assert_true(next >= shard->tick);
+
+        __gf_timer_shard_run(shard, next, &expired);
+        wakeups++;
+
+        list_for_each_entry_safe(event, tmp, &expired, list)
+        {
+            assert_true(event->fired);
+            assert_int_equal(event->expires, next);
+            list_del_init(&event->list);
+        }
+    }
+
+    assert_int_equal(__gf_timer_shard_next(shard), GF_TIMER_NEVER);
+
+    return wakeups;
+}
+
+static void
+helper_shard_init(gf_timer_shard_t *shard)
+{
+    memset(shard, 0, sizeof(*shard));
+    gf_timer_shard_init(shard);
+}
+
+static void
+helper_shard_add(gf_timer_shard_t *shard, gf_timer_t *event, uint64_t now,
+                 uint64_t expires)
+{
+    memset(event, 0, sizeof(*event));
+    INIT_LIST_HEAD(&event->list);
+    event->expires = expires;
+    __gf_timer_shard_insert(shard, event, now);
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_gf_timer_wheel_fire_on_time(void **state)
+{
+    gf_timer_shard_t shard;
+    /* every wheel, their edges, and past the last one */
+    uint64_t ticks[] = {0,
+                        1,
+                        255,
+                        256,
+                        257,
+                        511,
+                        1000,
+                        (1 << 14) - 1,
+                        1 << 14,
+                        20000,
+                        1 << 20,
+                        (1 << 20) + 3,
+                        1ULL << 26,
+                        (1ULL << 26) + 12345};
+    gf_timer_t events[sizeof(ticks) / sizeof(ticks[0])];
+    uint64_t start = 0;
+    int i = 0;
+
+    /* from the start of a root wheel round, and from the middle of one */
+    for (start = 0; start <= 1000; start += 1000) {
+        helper_shard_init(&shard);
+        shard.tick = start;
+
+        for (i = 0; i < sizeof(ticks) / sizeof(ticks[0]); i++)
+            helper_shard_add(&shard, &events[i], start, start + ticks[i]);
+        assert_int_equal(shard.count, sizeof(ticks) / sizeof(ticks[0]));
+
+        helper_shard_drain(&shard);
+
+        for (i = 0; i < sizeof(ticks) / sizeof(ticks[0]); i++)
+            assert_true(events[i].fired);
+
+        pthread_mutex_destroy(&shard.lock);
+    }
+}
+
+static void
+test_gf_timer_wheel_cascade_wakeups(void **state)
+{
+    gf_timer_shard_t shard;
+    gf_timer_t event;
+    int wakeups = 0;
+
+    helper_shard_init(&shard);
+
+    /* A single timer ~17 minutes away does not wake the thread at every
+     * root wheel round, only when a cascade moves it. */
+    helper_shard_add(&shard, &event, 0, (1 << 20) + 300);
+    wakeups = helper_shard_drain(&shard);
+    assert_true(event.fired);
+    assert_in_range(wakeups, 1, GF_TIMER_LEVELS + 1);
+
+    /* Same with the wheels not aligned to a round. */
+    helper_shard_add(&shard, &event, shard.tick + 1234,
+                     shard.tick + 1234 + (1 << 16));
+    wakeups = helper_shard_drain(&shard);
+    assert_true(event.fired);
+    assert_in_range(wakeups, 1, GF_TIMER_LEVELS + 1);
+
+    pthread_mutex_destroy(&shard.lock);
+}
+
+static void
+test_gf_timer_wheel_idle_shard(void **state)
+{
+    gf_timer_shard_t shard;
+    gf_timer_t event;
+    uint64_t now = 1ULL << 40;
+
+    helper_shard_init(&shard);
+
+    /* The shard was idle since tick 0, the new timer is relative to now. */
+    helper_shard_add(&shard, &event, now, now + 5);
+    assert_int_equal(shard.tick, now);
+    assert_int_equal(__gf_timer_shard_next(&shard), now + 5);
+
+    assert_int_equal(helper_shard_drain(&shard), 1);
+    assert_true(event.fired);
+
+    pthread_mutex_destroy(&shard.lock);
+}
+
+static void
+test_gf_timer_wheel_cancel(void **state)
+{
+    gf_timer_shard_t shard;
+    gf_timer_t events[2];
+
+    helper_shard_init(&shard);
+
+    helper_shard_add(&shard, &events[0], 0, 10);
+    helper_shard_add(&shard, &events[1], 0, 5000);
+
+    /* as gf_timer_call_cancel() does */
+    list_del(&events[0].list);
+    shard.count--;
+
+    helper_shard_drain(&shard);
+    assert_false(events[0].fired);
+    assert_true(events[1].fired);
+
+    pthread_mutex_destroy(&shard.lock);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest libglusterfs_timer_tests[] = {
+        cmocka_unit_test(test_gf_timer_wheel_fire_on_time),
+        cmocka_unit_test(test_gf_timer_wheel_cascade_wakeups),
+        cmocka_unit_test(test_gf_timer_wheel_idle_shard),
+        cmocka_unit_test(test_gf_timer_wheel_cancel),
+    };
+
+    return cmocka_run_group_tests(libglusterfs_timer_tests, NULL, NULL);
+}
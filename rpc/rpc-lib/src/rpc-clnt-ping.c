@@ -53,7 +53,9 @@ __rpc_clnt_rearm_ping_timer(struct rpc_clnt *rpc, gf_timer_cbk_t cbk)
     timeout.tv_nsec = 0;
 
     rpc_clnt_ref(rpc);
-    timer = gf_timer_call_after(rpc->ctx, timeout, cbk, (void *)rpc);
+    /* A ping that fires late makes a healthy server look dead, so it must
+     * not wait behind other timer callbacks. */
+    timer = gf_timer_call_after_sync(rpc->ctx, timeout, cbk, (void *)rpc);
     if (timer == NULL) {
         gf_log(trans->name, GF_LOG_WARNING, "unable to setup ping timer");
 
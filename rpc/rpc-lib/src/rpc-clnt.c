@@ -31,6 +31,7 @@ __saved_frames_get_timedout(struct saved_frames *frames, time_t latest)
         if (tmp->saved_at <= latest) {
             bailout_frame = tmp;
             list_del_init(&bailout_frame->list);
+            list_del_init(&bailout_frame->hash);
             frames->count--;
         }
     }
@@ -52,6 +53,12 @@ _is_lock_fop(struct rpc_req *rpcreq)
             (fop == GFS3_OP_FENTRYLK));
 }
 
+static inline struct list_head *
+__saved_frames_bucket(struct saved_frames *frames, const uint32_t callid)
+{
+    return &frames->hash[callid & (RPC_CLNT_SAVED_FRAMES_HASH - 1)];
+}
+
 static struct saved_frame *
 __saved_frames_put(struct rpc_clnt *rpc_clnt, struct saved_frames *frames,
                    void *frame, struct rpc_req *rpcreq)
@@ -64,6 +71,7 @@ __saved_frames_put(struct rpc_clnt *rpc_clnt, struct saved_frames *frames,
     /* THIS should be saved and set back */
 
     INIT_LIST_HEAD(&saved_frame->list);
+    INIT_LIST_HEAD(&saved_frame->hash);
 
     saved_frame->capital_this = rpc_clnt->owner;
     saved_frame->frame = frame;
@@ -76,6 +84,9 @@ __saved_frames_put(struct rpc_clnt *rpc_clnt, struct saved_frames *frames,
     else
         list_add_tail(&saved_frame->list, &frames->sf.list);
 
+    list_add_tail(&saved_frame->hash,
+                  __saved_frames_bucket(frames, rpcreq->xid));
+
     frames->count++;
 
 out:
@@ -137,8 +148,8 @@ call_bail(void *data)
             /* Ref rpc as it's added to timer event queue */
             rpc_clnt_ref(clnt);
             gf_timer_call_cancel(clnt->ctx, conn->timer);
-            conn->timer = gf_timer_call_after(clnt->ctx, timeout, call_bail,
-                                              (void *)clnt);
+            conn->timer = gf_timer_call_after_sync(clnt->ctx, timeout,
+                                                   call_bail, (void *)clnt);
 
             if (conn->timer == NULL) {
                 gf_log(conn->name, GF_LOG_WARNING,
@@ -214,8 +225,10 @@ __save_frame(struct rpc_clnt *rpc_clnt, call_frame_t *frame,
         timeout.tv_sec = 10;
         timeout.tv_nsec = 0;
         rpc_clnt_ref(rpc_clnt);
-        conn->timer = gf_timer_call_after(rpc_clnt->ctx, timeout, call_bail,
-                                          (void *)rpc_clnt);
+        /* Unwinding the bailed out frames can take long, keep it off the
+         * timer thread. */
+        conn->timer = gf_timer_call_after_sync(rpc_clnt->ctx, timeout,
+                                               call_bail, (void *)rpc_clnt);
     }
 
 out:
@@ -226,6 +239,7 @@ static struct saved_frames *
 saved_frames_new(void)
 {
     struct saved_frames *saved_frames = NULL;
+    int i = 0;
 
     saved_frames = GF_CALLOC(1, sizeof(*saved_frames),
                              gf_common_mt_rpcclnt_savedframe_t);
@@ -236,55 +250,51 @@ saved_frames_new(void)
     INIT_LIST_HEAD(&saved_frames->sf.list);
     INIT_LIST_HEAD(&saved_frames->lk_sf.list);
 
+    for (i = 0; i < RPC_CLNT_SAVED_FRAMES_HASH; i++)
+        INIT_LIST_HEAD(&saved_frames->hash[i]);
+
     return saved_frames;
 }
 
-static struct rpc_req *
-__saved_frame_copy(struct saved_frames *frames, uint32_t callid,
-                   rpc_transport_rsp_t *saved_frame_rsp)
+static struct saved_frame *
+__saved_frame_find(struct saved_frames *frames, const uint32_t callid)
 {
     struct saved_frame *tmp = NULL;
 
-    list_for_each_entry(tmp, &frames->sf.list, list)
+    list_for_each_entry(tmp, __saved_frames_bucket(frames, callid), hash)
     {
-        if (tmp->rpcreq->xid == callid) {
-            memcpy(saved_frame_rsp, &tmp->rsp, sizeof(rpc_transport_rsp_t));
-            return tmp->rpcreq;
-        }
-    }
-
-    list_for_each_entry(tmp, &frames->lk_sf.list, list)
-    {
-        if (tmp->rpcreq->xid == callid) {
-            memcpy(saved_frame_rsp, &tmp->rsp, sizeof(rpc_transport_rsp_t));
-            return tmp->rpcreq;
-        }
+        if (tmp->rpcreq->xid == callid)
+            return tmp;
     }
 
     return NULL;
 }
 
-static struct saved_frame *
-__saved_frame_get(struct saved_frames *frames, const uint32_t callid)
+static struct rpc_req *
+__saved_frame_copy(struct saved_frames *frames, uint32_t callid,
+                   rpc_transport_rsp_t *saved_frame_rsp)
 {
     struct saved_frame *tmp = NULL;
 
-    list_for_each_entry(tmp, &frames->sf.list, list)
-    {
-        if (tmp->rpcreq->xid == callid)
-            goto found;
-    }
+    tmp = __saved_frame_find(frames, callid);
+    if (!tmp)
+        return NULL;
 
-    list_for_each_entry(tmp, &frames->lk_sf.list, list)
-    {
-        if (tmp->rpcreq->xid == callid)
-            goto found;
-    }
+    memcpy(saved_frame_rsp, &tmp->rsp, sizeof(rpc_transport_rsp_t));
+    return tmp->rpcreq;
+}
 
-    return NULL;
+static struct saved_frame *
+__saved_frame_get(struct saved_frames *frames, const uint32_t callid)
+{
+    struct saved_frame *tmp = NULL;
+
+    tmp = __saved_frame_find(frames, callid);
+    if (!tmp)
+        return NULL;
 
-found:
     list_del_init(&tmp->list);
+    list_del_init(&tmp->hash);
     frames->count--;
     THIS = tmp->capital_this;
     return tmp;
@@ -326,6 +336,7 @@ saved_frames_unwind(struct saved_frames *saved_frames)
         rpc_clnt_reply_deinit(rpcreq);
 
         list_del_init(&trav->list);
+        list_del_init(&trav->hash);
         mem_put(trav);
     }
 }
@@ -47,6 +47,12 @@ typedef int (*fop_cbk_fn_t)(struct rpc_req *req, struct iovec *iov, int count,
 
 typedef int (*clnt_fn_t)(call_frame_t *fr, xlator_t *xl, void *args);
 
+/* Outstanding requests are also hashed by xid, so that a reply finds its
+ * frame without walking all of them. xids are handed out sequentially,
+ * hence the low bits alone spread the requests evenly. */
+#define RPC_CLNT_SAVED_FRAMES_HASH_BITS 10
+#define RPC_CLNT_SAVED_FRAMES_HASH (1 << RPC_CLNT_SAVED_FRAMES_HASH_BITS)
+
 struct saved_frame {
     union {
         struct list_head list;
@@ -55,6 +61,7 @@ struct saved_frame {
             struct saved_frame *frame_prev;
         };
     };
+    struct list_head hash;
     void *capital_this;
     void *frame;
     struct rpc_req *rpcreq;
@@ -64,8 +71,9 @@ struct saved_frame {
 
 struct saved_frames {
     int64_t count;
-    struct saved_frame sf;
+    struct saved_frame sf; /* in order of submission, for call_bail */
     struct saved_frame lk_sf;
+    struct list_head hash[RPC_CLNT_SAVED_FRAMES_HASH];
 };
 
 /* Initialized by procnum */
@@ -175,8 +175,26 @@ struct rpc_transport {
 
     uint64_t total_bytes_read;
     uint64_t total_bytes_write;
+    /* Statistics of zero-copy sends, for statedump. */
+    struct {
+        uint64_t sent;      /* sends done with zero-copy */
+        uint64_t copied;    /* zero-copy sends the kernel had to copy */
+        uint64_t fallback;  /* eligible sends done by copying */
+        uint64_t completed; /* messages released after completion */
+        uint64_t lag_total; /* usecs from last send to completion */
+        uint64_t lag_max;
+    } zerocopy;
     uint32_t xid; /* RPC/XID used for callbacks */
     int32_t outstanding_rpc_count;
+    /* Adaptive limit of outstanding requests, protected by 'lock'. */
+    struct {
+        uint64_t base;          /* lowest recent request latency (ns) */
+        uint64_t base_time;     /* when 'base' was measured (ns) */
+        int32_t size;           /* requests accepted before throttling */
+        int32_t acked;          /* completions since the last adjustment */
+        gf_boolean_t congested; /* a delayed completion has been seen */
+        gf_boolean_t throttled; /* no more requests are read */
+    } rpc_window;
 
     struct list_head list;
     void *dl_handle; /* handle of dlopen() */
@@ -196,6 +214,7 @@ struct rpc_transport {
 
 struct rpc_transport_pollin {
     struct rpc_transport *trans;
+    struct rpc_transport_pollin *next; /* next message of the same batch */
     void *private;
     struct iobref *iobref;
     struct iovec vector[MAX_IOVEC];
@@ -73,6 +73,8 @@ typedef struct rpcsvc_state {
     gf_boolean_t addr_namelookup;
     /* determine whether throttling is needed, by default OFF */
     gf_boolean_t throttle;
+    /* adapt the limit of each client to the latency of its requests */
+    gf_boolean_t adaptive_rpc_limit;
     /* Allow insecure ports. */
     gf_boolean_t allow_insecure;
     gf_boolean_t register_portmap;
@@ -210,14 +210,57 @@ rpcsvc_can_outstanding_req_be_ignored(rpcsvc_request_t *req)
     return _gf_false;
 }
 
+/* Adjust the window of a client once per window worth of completed
+ * requests: it's reduced by a quarter if any of them has been delayed and
+ * increased by one request otherwise. Only the time spent waiting to be
+ * dispatched counts, so slow fops don't shrink the window by themselves.
+ * Called with trans->lock held. */
+static void
+__rpcsvc_request_window_update(rpcsvc_request_t *req, int limit)
+{
+    rpc_transport_t *trans = req->trans;
+    uint64_t delay = 0;
+    uint64_t stamp = 0;
+    int32_t min_size = 0;
+
+    delay = gf_tsdiff(&req->arrival, &req->dispatch);
+    stamp = req->dispatch.tv_sec * GF_SEC_IN_NS + req->dispatch.tv_nsec;
+
+    if ((trans->rpc_window.base_time == 0) ||
+        (delay < trans->rpc_window.base) ||
+        (stamp - trans->rpc_window.base_time > RPCSVC_RPC_WINDOW_BASE_TIME)) {
+        trans->rpc_window.base = delay;
+        trans->rpc_window.base_time = stamp;
+    }
+
+    if ((delay > 2 * trans->rpc_window.base) &&
+        (delay - trans->rpc_window.base > RPCSVC_RPC_WINDOW_DELAY))
+        trans->rpc_window.congested = _gf_true;
+
+    if (++trans->rpc_window.acked < trans->rpc_window.size)
+        return;
+
+    min_size = min(RPCSVC_MIN_RPC_WINDOW, limit);
+    if (trans->rpc_window.congested) {
+        trans->rpc_window.size -= trans->rpc_window.size / 4;
+        if (trans->rpc_window.size < min_size)
+            trans->rpc_window.size = min_size;
+    } else if (trans->rpc_window.size < limit) {
+        trans->rpc_window.size++;
+    }
+
+    trans->rpc_window.acked = 0;
+    trans->rpc_window.congested = _gf_false;
+}
+
 int
 rpcsvc_request_outstanding(rpcsvc_request_t *req, int delta)
 {
     int ret = -1;
-    int old_count = 0;
-    int new_count = 0;
+    int count = 0;
     int limit = 0;
     gf_boolean_t throttle = _gf_false;
+    rpc_transport_t *trans = NULL;
 
     if (!req)
         goto out;
@@ -233,29 +276,52 @@ rpcsvc_request_outstanding(rpcsvc_request_t *req, int delta)
         goto out;
     }
 
-    pthread_mutex_lock(&req->trans->lock);
+    trans = req->trans;
+
+    pthread_mutex_lock(&trans->lock);
     {
         limit = req->svc->outstanding_rpc_limit;
-        if (!limit)
-            goto unlock;
 
-        old_count = req->trans->outstanding_rpc_count;
-        req->trans->outstanding_rpc_count += delta;
-        new_count = req->trans->outstanding_rpc_count;
+        trans->outstanding_rpc_count += delta;
+        count = trans->outstanding_rpc_count;
 
-        if (old_count <= limit && new_count > limit)
-            ret = rpc_transport_throttle(req->trans, _gf_true);
+        /* Without an adaptive window, the window is the limit itself. */
+        if (!req->svc->adaptive_rpc_limit || (trans->rpc_window.size == 0) ||
+            (trans->rpc_window.size > limit))
+            trans->rpc_window.size = limit;
 
-        if (old_count > limit && new_count <= limit)
-            ret = rpc_transport_throttle(req->trans, _gf_false);
+        if (limit && req->svc->adaptive_rpc_limit) {
+            if (delta > 0)
+                timespec_now(&req->arrival);
+            else if (req->dispatch.tv_sec != 0)
+                __rpcsvc_request_window_update(req, limit);
+        }
+
+        if (!trans->rpc_window.throttled && limit &&
+            (count > trans->rpc_window.size)) {
+            trans->rpc_window.throttled = _gf_true;
+            ret = rpc_transport_throttle(trans, _gf_true);
+        } else if (trans->rpc_window.throttled &&
+                   (!limit || (count <= trans->rpc_window.size))) {
+            trans->rpc_window.throttled = _gf_false;
+            ret = rpc_transport_throttle(trans, _gf_false);
+        }
     }
-unlock:
-    pthread_mutex_unlock(&req->trans->lock);
+    pthread_mutex_unlock(&trans->lock);
 
 out:
     return ret;
 }
 
+/* Marks the end of the wait of an admitted request, right before its actor
+ * is called or handed to a synctask. */
+static void
+rpcsvc_request_dispatched(rpcsvc_request_t *req)
+{
+    if (req->arrival.tv_sec != 0)
+        timespec_now(&req->dispatch);
+}
+
 /* This needs to change to returning errors, since
  * we need to return RPC specific error messages when some
  * of the pointers below are NULL.
@@ -804,6 +870,7 @@ rpcsvc_handle_rpc_call(rpcsvc_t *svc, rpc_transport_t *trans,
         }
 
         if (req->synctask) {
+            rpcsvc_request_dispatched(req);
             ret = synctask_new(THIS->ctx->env, (synctask_fn_t)actor_fn,
                                rpcsvc_check_and_reply_error, NULL, req);
         } else if (req->ownthread) {
@@ -882,6 +949,7 @@ rpcsvc_handle_rpc_call(rpcsvc_t *svc, rpc_transport_t *trans,
             ret = 0;
         } else {
         noqueue:
+            rpcsvc_request_dispatched(req);
             ret = actor_fn(req);
         }
     }
@@ -2230,6 +2298,7 @@ rpcsvc_request_handler(void *arg)
                 } else {
                     THIS = req->svc->xl;
                     actor = rpcsvc_program_actor(req);
+                    rpcsvc_request_dispatched(req);
                     ret = actor->actor(req);
 
                     if (ret != 0) {
@@ -2657,6 +2726,8 @@ out:
  * If dict_get_int32() for dict-key "rpc.outstanding-rpc-limit" FAILS,
  * it would set the value as "defvalue". Otherwise it would fetch the
  * value and round up to multiple-of-8. defvalue must be +ve.
+ * It also configures rpc.outstanding-rpc-adaptive, which makes the limit
+ * the maximum of a window adapted to the latency of each client.
  *
  * NB: defval or set-value "0" is special which means unlimited/65536.
  */
@@ -2696,6 +2767,9 @@ rpcsvc_set_outstanding_rpc_limit(rpcsvc_t *svc, dict_t *options, int defvalue)
                rpclim);
     }
 
+    svc->adaptive_rpc_limit = dict_get_str_boolean(
+        options, "rpc.outstanding-rpc-adaptive", _gf_true);
+
     return (0);
 }
 
@@ -39,6 +39,15 @@ typedef enum {
 #define RPCSVC_MAX_OUTSTANDING_RPC_LIMIT 65536
 #define RPCSVC_MIN_OUTSTANDING_RPC_LIMIT 0 /* No limit i.e. Unlimited */
 
+/* With rpc.outstanding-rpc-adaptive, the number of requests accepted from a
+ * client is kept between RPCSVC_MIN_RPC_WINDOW and the outstanding-rpc-limit.
+ * It's reduced when requests wait RPCSVC_RPC_WINDOW_DELAY more than the
+ * lowest queueing delay seen in the last RPCSVC_RPC_WINDOW_BASE_TIME before
+ * their actor is called. */
+#define RPCSVC_MIN_RPC_WINDOW 8
+#define RPCSVC_RPC_WINDOW_DELAY (5 * GF_MS_IN_NS)
+#define RPCSVC_RPC_WINDOW_BASE_TIME (10ULL * GF_SEC_IN_NS)
+
 #define GF_RPCSVC "rpc-service"
 #define RPCSVC_THREAD_STACK_SIZE ((size_t)(1024 * GF_UNIT_KB))
 
@@ -252,6 +261,13 @@ struct rpcsvc_request {
      * start time.
      */
     struct timespec begin;
+
+    /* Times when the request has been accounted as outstanding and when
+     * its actor has been called. The delay between both adapts the window
+     * of the client.
+     */
+    struct timespec arrival;
+    struct timespec dispatch;
 };
 
 #define rpcsvc_request_program(req) ((rpcsvc_program_t *)((req)->prog))
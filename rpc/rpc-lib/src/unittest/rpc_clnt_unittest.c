@@ -0,0 +1,278 @@
+/*
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* The saved frames helpers are static. They are driven directly on a
+ * client that is never connected. */
+#include "../rpc-clnt.c"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+#define FRAMES 16
+
+static xlator_t rpc_xl;
+static struct rpc_clnt rpc;
+static rpc_clnt_prog_t fop_prog = {
+    .progname = "unittest",
+    .prognum = GLUSTER_FOP_PROGRAM,
+    .progver = GLUSTER_FOP_VERSION,
+};
+
+static int unwound;
+
+/*
+ * Helper functions
+ */
+static int
+helper_init(void **state)
+{
+    glusterfs_ctx_t *ctx = NULL;
+
+    ctx = glusterfs_ctx_new();
+    assert_non_null(ctx);
+    assert_int_equal(glusterfs_globals_init(ctx), 0);
+    THIS->ctx = ctx;
+
+    mem_pools_init();
+
+    rpc_xl.name = "rpc-unittest";
+    rpc_xl.ctx = ctx;
+
+    rpc.owner = &rpc_xl;
+    rpc.ctx = ctx;
+    rpc.conn.name = "rpc-unittest";
+    rpc.reqpool = mem_pool_new(struct rpc_req, FRAMES);
+    rpc.saved_frames_pool = mem_pool_new(struct saved_frame, FRAMES);
+    assert_non_null(rpc.reqpool);
+    assert_non_null(rpc.saved_frames_pool);
+
+    return 0;
+}
+
+static int
+helper_cbk(struct rpc_req *req, struct iovec *iov, int count, void *myframe)
+{
+    assert_int_equal(req->rpc_status, -1);
+    assert_null(iov);
+    unwound++;
+
+    return 0;
+}
+
+static struct saved_frame *
+helper_put(struct saved_frames *frames, uint32_t xid, int procnum,
+           time_t saved_at)
+{
+    struct saved_frame *saved_frame = NULL;
+    struct rpc_req *req = NULL;
+
+    req = mem_get0(rpc.reqpool);
+    assert_non_null(req);
+    req->conn = &rpc.conn;
+    req->prog = &fop_prog;
+    req->procnum = procnum;
+    req->cbkfn = helper_cbk;
+    req->xid = xid;
+
+    saved_frame = __saved_frames_put(&rpc, frames, req, req);
+    assert_non_null(saved_frame);
+    saved_frame->saved_at = saved_at;
+
+    return saved_frame;
+}
+
+static void
+helper_put_back(struct saved_frame *saved_frame)
+{
+    assert_true(list_empty(&saved_frame->list));
+    assert_true(list_empty(&saved_frame->hash));
+
+    rpc_clnt_reply_deinit(saved_frame->rpcreq);
+    mem_put(saved_frame);
+}
+
+/* Checks that the frames of 'list' are the 'count' first ones of 'expect',
+ * in that order. */
+static void
+helper_check_list(struct saved_frame *head, struct saved_frame **expect,
+                  int count)
+{
+    struct saved_frame *trav = NULL;
+    int i = 0;
+
+    list_for_each_entry(trav, &head->list, list)
+    {
+        assert_true(i < count);
+        assert_ptr_equal(trav, expect[i]);
+        i++;
+    }
+    assert_int_equal(i, count);
+}
+
+static void
+helper_check_empty(struct saved_frames *frames)
+{
+    int i = 0;
+
+    assert_int_equal(frames->count, 0);
+    assert_true(list_empty(&frames->sf.list));
+    assert_true(list_empty(&frames->lk_sf.list));
+    for (i = 0; i < RPC_CLNT_SAVED_FRAMES_HASH; i++)
+        assert_true(list_empty(&frames->hash[i]));
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_saved_frames_xid_collisions(void **state)
+{
+    struct saved_frames *frames = NULL;
+    struct saved_frame *saved[4];
+    struct saved_frame *found = NULL;
+    uint32_t xid[4] = {
+        5,
+        5 + RPC_CLNT_SAVED_FRAMES_HASH,
+        5 + 2 * RPC_CLNT_SAVED_FRAMES_HASH,
+        6,
+    };
+    int i = 0;
+
+    frames = saved_frames_new();
+    assert_non_null(frames);
+
+    /* The first three share a bucket. */
+    for (i = 0; i < 4; i++)
+        saved[i] = helper_put(frames, xid[i], GFS3_OP_READ, gf_time());
+    assert_int_equal(frames->count, 4);
+
+    for (i = 0; i < 4; i++)
+        assert_ptr_equal(__saved_frame_find(frames, xid[i]), saved[i]);
+    assert_null(__saved_frame_find(frames, 5 + 3 * RPC_CLNT_SAVED_FRAMES_HASH));
+    assert_null(__saved_frame_find(frames, 7));
+
+    /* Taking the frame out of the middle of the bucket leaves the others
+     * reachable, in both lists. */
+    found = __saved_frame_get(frames, xid[1]);
+    assert_ptr_equal(found, saved[1]);
+    assert_ptr_equal(THIS, &rpc_xl);
+    assert_int_equal(frames->count, 3);
+    assert_null(__saved_frame_find(frames, xid[1]));
+    assert_ptr_equal(__saved_frame_find(frames, xid[0]), saved[0]);
+    assert_ptr_equal(__saved_frame_find(frames, xid[2]), saved[2]);
+    helper_put_back(found);
+
+    saved[1] = saved[2];
+    saved[2] = saved[3];
+    helper_check_list(&frames->sf, saved, 3);
+    assert_true(list_empty(&frames->lk_sf.list));
+
+    for (i = 0; i < 3; i++) {
+        found = __saved_frame_get(frames, saved[i]->rpcreq->xid);
+        assert_ptr_equal(found, saved[i]);
+        helper_put_back(found);
+    }
+    assert_null(__saved_frame_get(frames, xid[0]));
+
+    helper_check_empty(frames);
+    saved_frames_destroy(frames);
+}
+
+static void
+test_saved_frames_bail_out(void **state)
+{
+    struct saved_frames *frames = NULL;
+    struct saved_frame *fops[3];
+    struct saved_frame *lock = NULL;
+    struct saved_frame *found = NULL;
+    time_t now = gf_time();
+    int i = 0;
+
+    frames = saved_frames_new();
+    assert_non_null(frames);
+
+    fops[0] = helper_put(frames, 1, GFS3_OP_READ, now - 100);
+    lock = helper_put(frames, 2, GFS3_OP_INODELK, now - 100);
+    fops[1] = helper_put(frames, 3, GFS3_OP_WRITE, now - 50);
+    fops[2] = helper_put(frames, 4, GFS3_OP_STAT, now);
+
+    /* Lock requests may wait for long, they are kept apart. */
+    helper_check_list(&frames->sf, fops, 3);
+    helper_check_list(&frames->lk_sf, &lock, 1);
+    assert_ptr_equal(__saved_frame_find(frames, 2), lock);
+
+    /* Frames are bailed out in order of submission, until the first one
+     * that hasn't timed out. */
+    for (i = 0; i < 2; i++) {
+        found = __saved_frames_get_timedout(frames, now - 10);
+        assert_ptr_equal(found, fops[i]);
+        assert_null(__saved_frame_find(frames, found->rpcreq->xid));
+        helper_put_back(found);
+    }
+    assert_null(__saved_frames_get_timedout(frames, now - 10));
+    assert_int_equal(frames->count, 2);
+
+    /* The lock request is never bailed out. */
+    found = __saved_frames_get_timedout(frames, now + 100);
+    assert_ptr_equal(found, fops[2]);
+    helper_put_back(found);
+    assert_null(__saved_frames_get_timedout(frames, now + 100));
+
+    assert_int_equal(frames->count, 1);
+    assert_ptr_equal(__saved_frame_find(frames, 2), lock);
+
+    found = __saved_frame_get(frames, 2);
+    assert_ptr_equal(found, lock);
+    helper_put_back(found);
+
+    helper_check_empty(frames);
+    saved_frames_destroy(frames);
+}
+
+static void
+test_saved_frames_unwind(void **state)
+{
+    struct saved_frames *frames = NULL;
+    time_t now = gf_time();
+    int i = 0;
+
+    frames = saved_frames_new();
+    assert_non_null(frames);
+
+    for (i = 0; i < FRAMES / 2; i++) {
+        helper_put(frames, i * RPC_CLNT_SAVED_FRAMES_HASH,
+                   (i & 1) ? GFS3_OP_FINODELK : GFS3_OP_READ, now);
+    }
+    assert_int_equal(frames->count, FRAMES / 2);
+
+    /* All frames, lock requests included, are unwound with an error and
+     * unlinked from both lists. */
+    unwound = 0;
+    saved_frames_unwind(frames);
+    assert_int_equal(unwound, FRAMES / 2);
+
+    helper_check_empty(frames);
+    saved_frames_destroy(frames);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest rpc_clnt_tests[] = {
+        cmocka_unit_test(test_saved_frames_xid_collisions),
+        cmocka_unit_test(test_saved_frames_bail_out),
+        cmocka_unit_test(test_saved_frames_unwind),
+    };
+
+    return cmocka_run_group_tests(rpc_clnt_tests, helper_init, NULL);
+}
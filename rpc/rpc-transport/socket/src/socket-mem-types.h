@@ -16,6 +16,8 @@
 typedef enum gf_sock_mem_types_ {
     gf_sock_connect_error_state_t = gf_common_mt_end + 1,
     gf_sock_mt_lock_array,
+    gf_sock_mt_uring_rx,
+    gf_sock_mt_uring_tx,
     gf_sock_mt_end
 } gf_sock_mem_types_t;
 
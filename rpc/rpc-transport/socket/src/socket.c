@@ -15,6 +15,10 @@
 #include <glusterfs/compat-errno.h>
 #include "socket-mem-types.h"
 
+#ifdef HAVE_IO_URING
+#include <glusterfs/gf-io.h>
+#endif
+
 /* ugly #includes below */
 #include "protocol-common.h"
 #include "glusterfs4-xdr.h"
@@ -27,6 +31,10 @@
 #include <netinet/tcp.h>
 #endif
 
+#ifdef GF_SOCKET_ZEROCOPY
+#include <linux/errqueue.h>
+#endif
+
 #include <errno.h>
 #include <rpc/xdr.h>
 #include <sys/ioctl.h>
@@ -72,6 +80,12 @@ typedef int
 SSL_trinary_func(SSL *, void *, int);
 static int
 ssl_setup_connection_params(rpc_transport_t *this);
+#ifdef HAVE_IO_URING
+static gf_boolean_t
+socket_uring_enabled(socket_private_t *priv);
+static int
+__socket_uring_send(rpc_transport_t *this);
+#endif
 
 #define __socket_proto_reset_pending(priv)                                     \
     do {                                                                       \
@@ -537,6 +551,28 @@ ssl_teardown_connection(socket_private_t *priv)
     priv->use_ssl = _gf_false;
 }
 
+#ifdef HAVE_IO_URING
+/* Serve data already received through io_uring. It behaves like a read on a
+ * non-blocking socket, so EAGAIN is returned when there's no more data. */
+static ssize_t
+__socket_uring_readv(struct socket_uring_rx *rx, struct iovec *opvector,
+                     int opcount)
+{
+    int ret = 0;
+
+    if (rx->pos >= rx->len) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    ret = iov_load(opvector, IOV_MIN(opcount), rx->buf + rx->pos,
+                   rx->len - rx->pos);
+    rx->pos += ret;
+
+    return ret;
+}
+#endif
+
 static ssize_t
 __socket_ssl_readv(rpc_transport_t *this, struct iovec *opvector, int opcount)
 {
@@ -552,6 +588,10 @@ __socket_ssl_readv(rpc_transport_t *this, struct iovec *opvector, int opcount)
         ret = ssl_read_one(priv, opvector->iov_base, opvector->iov_len);
     } else {
         gf_log(this->name, GF_LOG_TRACE, "***** reading over non-SSL");
+#ifdef HAVE_IO_URING
+        if (priv->uring.rx != NULL)
+            return __socket_uring_readv(priv->uring.rx, opvector, opcount);
+#endif
         ret = sys_readv(sock, opvector, IOV_MIN(opcount));
     }
 
@@ -662,10 +702,71 @@ __does_socket_rwv_error_need_logging(socket_private_t *priv, int write)
  * > 0 = incomplete
  */
 
+#ifdef GF_SOCKET_ZEROCOPY
+/* Enable zero-copy sends on the socket. It's done the first time it's
+ * needed so that connections not sending big messages are not affected. */
+static int32_t
+__socket_zc_setup(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    int on = 1;
+
+    if (priv->zc.state == 0) {
+        if (setsockopt(priv->sock, SOL_SOCKET, SO_ZEROCOPY, &on,
+                       sizeof(on)) == 0) {
+            priv->zc.state = 1;
+        } else {
+            gf_log(this->name, GF_LOG_WARNING,
+                   "failed to enable zero-copy on socket %d (%s). Messages "
+                   "will be copied",
+                   priv->sock, strerror(errno));
+            priv->zc.state = -1;
+        }
+    }
+
+    return priv->zc.state;
+}
+
+/* Write a vector using MSG_ZEROCOPY. The buffers must not be modified nor
+ * released until the kernel reports the completion of the send through the
+ * error queue. If zero-copy can't be used, the data is copied as usual. */
+static ssize_t
+__socket_zc_writev(rpc_transport_t *this, struct iovec *vector, int count)
+{
+    socket_private_t *priv = this->private;
+    struct msghdr msg = {
+        0,
+    };
+    ssize_t ret;
+
+    if (__socket_zc_setup(this) > 0) {
+        msg.msg_iov = vector;
+        msg.msg_iovlen = count;
+
+        ret = sendmsg(priv->sock, &msg, MSG_ZEROCOPY);
+        if (ret >= 0) {
+            /* Each successful send gets a new id. */
+            priv->zc.next++;
+            this->zerocopy.sent++;
+
+            return ret;
+        }
+
+        /* ENOBUFS means that the socket has too many pinned pages. */
+        if (errno != ENOBUFS)
+            return ret;
+    }
+
+    this->zerocopy.fallback++;
+
+    return sys_writev(priv->sock, vector, count);
+}
+#endif
+
 static int
 __socket_rwv(rpc_transport_t *this, struct iovec *vector, int count,
              struct iovec **pending_vector, int *pending_count, size_t *bytes,
-             int write)
+             int write, gf_boolean_t zerocopy)
 {
     socket_private_t *priv = NULL;
     int sock = -1;
@@ -709,7 +810,13 @@ __socket_rwv(rpc_transport_t *this, struct iovec *vector, int count,
                 ret = ssl_write_one(priv, opvector->iov_base,
                                     opvector->iov_len);
             } else {
-                ret = sys_writev(sock, opvector, IOV_MIN(opcount));
+#ifdef GF_SOCKET_ZEROCOPY
+                if (zerocopy)
+                    ret = __socket_zc_writev(this, opvector,
+                                             IOV_MIN(opcount));
+                else
+#endif
+                    ret = sys_writev(sock, opvector, IOV_MIN(opcount));
             }
 
             if ((ret == 0) || ((ret < 0) && (errno == EAGAIN))) {
@@ -807,15 +914,16 @@ __socket_readv(rpc_transport_t *this, struct iovec *vector, int count,
                struct iovec **pending_vector, int *pending_count, size_t *bytes)
 {
     return __socket_rwv(this, vector, count, pending_vector, pending_count,
-                        bytes, 0);
+                        bytes, 0, _gf_false);
 }
 
 static int
 __socket_writev(rpc_transport_t *this, struct iovec *vector, int count,
-                struct iovec **pending_vector, int *pending_count)
+                struct iovec **pending_vector, int *pending_count,
+                gf_boolean_t zerocopy)
 {
     return __socket_rwv(this, vector, count, pending_vector, pending_count,
-                        NULL, 1);
+                        NULL, 1, zerocopy);
 }
 
 static int
@@ -1155,6 +1263,28 @@ __socket_reset(rpc_transport_t *this)
 
     memset(&priv->incoming, 0, sizeof(priv->incoming));
 
+#ifdef HAVE_IO_URING
+    if (priv->uring.rx != NULL) {
+        if (priv->uring.rx->parked) {
+            GF_FREE(priv->uring.rx);
+        } else {
+            /* The pending recv keeps a reference to the socket, so closing
+             * it is not enough to complete the request. The callback will
+             * release the context. */
+            priv->uring.rx->closed = _gf_true;
+            shutdown(priv->sock, SHUT_RDWR);
+        }
+        priv->uring.rx = NULL;
+    }
+    priv->uring.gen++;
+#endif
+
+#ifdef GF_SOCKET_ZEROCOPY
+    /* Zero-copy ids are per socket. */
+    priv->zc.next = 0;
+    priv->zc.state = 0;
+#endif
+
     gf_event_unregister_close(this->ctx->event_pool, priv->sock, priv->idx);
     if (priv->use_ssl && priv->ssl_ssl) {
         SSL_clear(priv->ssl_ssl);
@@ -1278,6 +1408,20 @@ __socket_ioq_entry_free(struct ioq *entry)
     GF_FREE(entry);
 }
 
+static void
+__socket_zc_flush(socket_private_t *priv)
+{
+#ifdef GF_SOCKET_ZEROCOPY
+    struct ioq *entry = NULL;
+    struct ioq *tmp = NULL;
+
+    list_for_each_entry_safe(entry, tmp, &priv->zc.pending, list)
+    {
+        __socket_ioq_entry_free(entry);
+    }
+#endif
+}
+
 static void
 __socket_ioq_flush(socket_private_t *priv)
 {
@@ -1288,22 +1432,224 @@ __socket_ioq_flush(socket_private_t *priv)
         if (entry)
             __socket_ioq_entry_free(entry);
     }
+
+    __socket_zc_flush(priv);
+}
+
+/* Release an entry that has been completely written. If it has been sent
+ * with zero-copy, the kernel may still be using its buffers, so it's kept
+ * until all its sends are completed. */
+static void
+__socket_ioq_entry_release(socket_private_t *priv, struct ioq *entry)
+{
+#ifdef GF_SOCKET_ZEROCOPY
+    if (entry->zc_done != entry->zc_count) {
+        list_move_tail(&entry->list, &priv->zc.pending);
+        return;
+    }
+#endif
+
+    __socket_ioq_entry_free(entry);
 }
 
 static int
 __socket_ioq_churn_entry(rpc_transport_t *this, struct ioq *entry,
                          gf_boolean_t free_entry)
 {
+#ifdef GF_SOCKET_ZEROCOPY
+    socket_private_t *priv = this->private;
+    uint32_t id = priv->zc.next;
+#endif
     int ret;
 
     ret = __socket_writev(this, entry->pending_vector, entry->pending_count,
-                          &entry->pending_vector, &entry->pending_count);
+                          &entry->pending_vector, &entry->pending_count,
+                          entry->zerocopy);
+
+#ifdef GF_SOCKET_ZEROCOPY
+    if (priv->zc.next != id) {
+        /* Sends of the same entry always get consecutive ids. */
+        if (entry->zc_count == 0)
+            entry->zc_first = id;
+        entry->zc_count += priv->zc.next - id;
+        timespec_now(&entry->zc_time);
+    }
+#endif
 
     if (ret == 0) {
         /* current entry was completely written */
         GF_ASSERT(entry->pending_count == 0);
         if (free_entry)
-            __socket_ioq_entry_free(entry);
+            __socket_ioq_entry_release(this->private, entry);
+    }
+
+    return ret;
+}
+
+#ifdef GF_SOCKET_ZEROCOPY
+/* Account the completion of zero-copy sends with ids from 'lo' to 'hi' on
+ * the entry. Ids are 32-bit counters that can wrap. */
+static void
+__socket_zc_complete_entry(struct ioq *entry, uint32_t lo, uint32_t hi)
+{
+    uint32_t i;
+
+    for (i = 0; i < entry->zc_count; i++) {
+        if ((uint32_t)(entry->zc_first + i - lo) <= (uint32_t)(hi - lo))
+            entry->zc_done++;
+    }
+}
+
+static void
+__socket_zc_complete(rpc_transport_t *this, uint32_t lo, uint32_t hi,
+                     gf_boolean_t copied)
+{
+    socket_private_t *priv = this->private;
+    struct ioq *entry = NULL;
+    struct ioq *tmp = NULL;
+    struct timespec now;
+    uint64_t lag;
+
+    if (copied) {
+        /* The kernel had to copy the data anyway (for example on loopback
+         * connections). Zero-copy is only overhead here, so stop using it. */
+        this->zerocopy.copied += hi - lo + 1;
+        if (priv->zc.state > 0) {
+            gf_log(this->name, GF_LOG_DEBUG,
+                   "zero-copy sends are being copied on socket %d. "
+                   "Disabling zero-copy",
+                   priv->sock);
+            priv->zc.state = -1;
+        }
+    }
+
+    timespec_now(&now);
+
+    list_for_each_entry_safe(entry, tmp, &priv->zc.pending, list)
+    {
+        __socket_zc_complete_entry(entry, lo, hi);
+        if (entry->zc_done != entry->zc_count)
+            continue;
+
+        lag = gf_tsdiff(&entry->zc_time, &now) / 1000;
+        this->zerocopy.completed++;
+        this->zerocopy.lag_total += lag;
+        if (lag > this->zerocopy.lag_max)
+            this->zerocopy.lag_max = lag;
+
+        __socket_ioq_entry_free(entry);
+    }
+
+    /* The entry being written may have completed some of its sends. */
+    if (!list_empty(&priv->ioq))
+        __socket_zc_complete_entry(priv->ioq_next, lo, hi);
+}
+
+/* Process the zero-copy completion notifications queued in the error queue
+ * of the socket. Returns true if any notification has been found. */
+static gf_boolean_t
+socket_zc_reap(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct sock_extended_err *serr = NULL;
+    struct cmsghdr *cmsg = NULL;
+    struct msghdr msg;
+    char control[CMSG_SPACE(sizeof(*serr)) + 64];
+    gf_boolean_t found = _gf_false;
+
+    pthread_mutex_lock(&priv->out_lock);
+    {
+        if (priv->zc.state == 0)
+            goto unlock;
+
+        for (;;) {
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            if (recvmsg(priv->sock, &msg, MSG_ERRQUEUE) < 0)
+                break;
+
+            for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+                 cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if (!((cmsg->cmsg_level == SOL_IP) &&
+                      (cmsg->cmsg_type == IP_RECVERR)) &&
+                    !((cmsg->cmsg_level == SOL_IPV6) &&
+                      (cmsg->cmsg_type == IPV6_RECVERR)))
+                    continue;
+
+                serr = (struct sock_extended_err *)CMSG_DATA(cmsg);
+                if ((serr->ee_errno != 0) ||
+                    (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY))
+                    continue;
+
+                __socket_zc_complete(
+                    this, serr->ee_info, serr->ee_data,
+                    (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+                found = _gf_true;
+            }
+        }
+    }
+unlock:
+    pthread_mutex_unlock(&priv->out_lock);
+
+    return found;
+}
+#endif
+
+/* Write the pending data of as many queued entries as possible with a
+ * single writev, releasing the ones that are completely written. Entries
+ * sent with zero-copy are not gathered. */
+static int
+__socket_ioq_churn_gather(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct iovec vector[GF_SOCKET_WRITE_IOV];
+    struct iovec *pending_vector = NULL;
+    struct ioq *entry = NULL;
+    struct ioq *tmp = NULL;
+    size_t size = 0;
+    int pending_count = 0;
+    int count = 0;
+    int ret = -1;
+
+    list_for_each_entry(entry, &priv->ioq, list)
+    {
+        if (entry->zerocopy ||
+            (count + entry->pending_count > GF_SOCKET_WRITE_IOV))
+            break;
+
+        memcpy(&vector[count], entry->pending_vector,
+               sizeof(struct iovec) * entry->pending_count);
+        count += entry->pending_count;
+    }
+
+    size = iov_length(vector, count);
+
+    ret = __socket_writev(this, vector, count, &pending_vector,
+                          &pending_count, _gf_false);
+    if (ret < 0)
+        return ret;
+
+    size -= iov_length(pending_vector, pending_count);
+
+    list_for_each_entry_safe(entry, tmp, &priv->ioq, list)
+    {
+        while (entry->pending_count > 0) {
+            if (size < entry->pending_vector->iov_len) {
+                entry->pending_vector->iov_base += size;
+                entry->pending_vector->iov_len -= size;
+                break;
+            }
+            size -= entry->pending_vector->iov_len;
+            entry->pending_vector++;
+            entry->pending_count--;
+        }
+
+        if (entry->pending_count > 0)
+            break;
+
+        __socket_ioq_entry_release(priv, entry);
     }
 
     return ret;
@@ -1322,7 +1668,12 @@ __socket_ioq_churn(rpc_transport_t *this)
         /* pick next entry */
         entry = priv->ioq_next;
 
-        ret = __socket_ioq_churn_entry(this, entry, _gf_true);
+        /* Several small messages, like the replies to a batch of requests,
+         * are sent together. */
+        if (!entry->zerocopy && (entry->next != (struct ioq *)&priv->ioq))
+            ret = __socket_ioq_churn_gather(this);
+        else
+            ret = __socket_ioq_churn_entry(this, entry, _gf_true);
 
         if (ret != 0)
             break;
@@ -2344,22 +2695,86 @@ out:
     return ret;
 }
 
+/* Messages submitted while the transport is corked are only queued. They
+ * are sent together, with as few writes as possible, once it's uncorked. */
+static void
+socket_cork(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+
+    pthread_mutex_lock(&priv->out_lock);
+    {
+        priv->cork++;
+    }
+    pthread_mutex_unlock(&priv->out_lock);
+}
+
+static void
+socket_uncork(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    int ret = 0;
+
+    pthread_mutex_lock(&priv->out_lock);
+    {
+        if ((--priv->cork > 0) || (priv->connected != 1) ||
+            list_empty(&priv->ioq))
+            goto unlock;
+
+#ifdef HAVE_IO_URING
+        if (socket_uring_enabled(priv) && (__socket_uring_send(this) == 0))
+            goto unlock;
+#endif
+
+        ret = __socket_ioq_churn(this);
+        if (ret > 0) {
+            /* continue writing on POLLOUT */
+            priv->idx = gf_event_select_on(this->ctx->event_pool, priv->sock,
+                                           priv->idx, -1, 1);
+        } else if (ret < 0) {
+            gf_log(this->name, GF_LOG_TRACE,
+                   "__socket_ioq_churn returned -1; "
+                   "disconnecting socket");
+            __socket_disconnect(this);
+        }
+    }
+unlock:
+    pthread_mutex_unlock(&priv->out_lock);
+}
+
 static void
 socket_event_poll_in_async(gf_async_t *async)
 {
     rpc_transport_pollin_t *pollin;
+    rpc_transport_pollin_t *next;
     rpc_transport_t *this;
     socket_private_t *priv;
+    gf_boolean_t batch;
 
     pollin = caa_container_of(async, rpc_transport_pollin_t, async);
     this = pollin->trans;
     priv = this->private;
 
-    rpc_transport_notify(this, RPC_TRANSPORT_MSG_RECEIVED, pollin);
+    /* The replies generated while a batch of requests is processed are
+     * sent together at the end. */
+    batch = priv->is_server && (pollin->next != NULL);
+    if (batch)
+        socket_cork(this);
 
-    rpc_transport_unref(this);
+    do {
+        next = pollin->next;
 
-    rpc_transport_pollin_destroy(pollin);
+        rpc_transport_notify(this, RPC_TRANSPORT_MSG_RECEIVED, pollin);
+
+        rpc_transport_pollin_destroy(pollin);
+
+        pollin = next;
+    } while (pollin != NULL);
+
+    if (batch)
+        socket_uncork(this);
+
+    rpc_transport_unref(this);
 
     pthread_mutex_lock(&priv->notify.lock);
     {
@@ -2375,13 +2790,29 @@ static int
 socket_event_poll_in(rpc_transport_t *this, gf_boolean_t notify_handled)
 {
     int ret = -1;
+    int count = 0;
     rpc_transport_pollin_t *pollin = NULL;
+    rpc_transport_pollin_t *last = NULL;
+    rpc_transport_pollin_t *next = NULL;
     socket_private_t *priv = this->private;
     glusterfs_ctx_t *ctx = NULL;
 
     ctx = this->ctx;
 
-    ret = socket_proto_state_machine(this, &pollin);
+    /* Read all the complete records already available, up to the batch
+     * size, so that they are delivered together with a single job. */
+    do {
+        next = NULL;
+        ret = socket_proto_state_machine(this, &next);
+        if (next == NULL)
+            break;
+
+        if (last == NULL)
+            pollin = next;
+        else
+            last->next = next;
+        last = next;
+    } while ((ret >= 0) && (++count < priv->read_batch));
 
     if (pollin) {
         pthread_mutex_lock(&priv->notify.lock);
@@ -2705,6 +3136,351 @@ socket_complete_connection(rpc_transport_t *this)
     return ret;
 }
 
+#ifdef HAVE_IO_URING
+
+/* Check if the io_uring engine can be used for this connection. SSL needs
+ * to read and write through OpenSSL, so it always uses the event loop. */
+static gf_boolean_t
+socket_uring_enabled(socket_private_t *priv)
+{
+    return priv->uring.enabled && !priv->use_ssl &&
+           (gf_io_mode() == GF_IO_MODE_IO_URING);
+}
+
+GF_IO_CBK_DECLARE_STATIC(socket_uring_recv_cbk);
+GF_IO_CBK_DECLARE_STATIC(socket_uring_send_cbk);
+
+/* Post a recv request to fill the staging buffer. Always called with
+ * out_lock held, so that the socket can't be closed meanwhile. */
+static void
+__socket_uring_recv(rpc_transport_t *this, struct socket_uring_rx *rx)
+{
+    socket_private_t *priv = this->private;
+
+    rx->pos = 0;
+    rx->len = 0;
+
+    rpc_transport_ref(this);
+
+    gf_io_recv(socket_uring_recv_cbk, priv->sock, rx->buf, sizeof(rx->buf), 0,
+               rx);
+    gf_io.engine.flush();
+}
+
+/* Switch an established connection to receive data through io_uring.
+ * Returns false if the connection must keep using the event loop. */
+static gf_boolean_t
+socket_uring_start(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct socket_uring_rx *rx = NULL;
+
+    if (!socket_uring_enabled(priv) || (priv->uring.rx != NULL))
+        return _gf_false;
+
+    rx = GF_MALLOC(sizeof(*rx), gf_sock_mt_uring_rx);
+    if (!rx)
+        return _gf_false;
+
+    rx->this = this;
+    rx->closed = _gf_false;
+    rx->parked = _gf_false;
+
+    pthread_mutex_lock(&priv->out_lock);
+    {
+        priv->uring.rx = rx;
+
+        /* From now on the event loop is only used to detect errors. */
+        priv->idx = gf_event_select_on(this->ctx->event_pool, priv->sock,
+                                       priv->idx, 0, -1);
+
+        if (priv->uring.throttle)
+            rx->parked = _gf_true;
+        else
+            __socket_uring_recv(this, rx);
+    }
+    pthread_mutex_unlock(&priv->out_lock);
+
+    gf_log(this->name, GF_LOG_DEBUG, "using io_uring to receive on socket %d",
+           priv->sock);
+
+    return _gf_true;
+}
+
+/* Let the pending recv handle an error detected by the event loop. The
+ * socket is shut down to force the request to complete. */
+static gf_boolean_t
+socket_uring_defer_error(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    gf_boolean_t deferred = _gf_false;
+
+    pthread_mutex_lock(&priv->out_lock);
+    {
+        if ((priv->uring.rx != NULL) && !priv->uring.rx->parked) {
+            __socket_shutdown(this);
+            deferred = _gf_true;
+        }
+    }
+    pthread_mutex_unlock(&priv->out_lock);
+
+    return deferred;
+}
+
+GF_IO_CBK(socket_uring_recv_cbk, op, res, static)
+{
+    struct socket_uring_rx *rx = op->data;
+    rpc_transport_t *this = rx->this;
+    socket_private_t *priv = this->private;
+    gf_boolean_t socket_closed = _gf_false;
+    gf_boolean_t closed = _gf_false;
+    uint32_t pos = 0;
+    int ret = -1;
+
+    THIS = this->xl;
+
+    pthread_mutex_lock(&priv->out_lock);
+    {
+        closed = rx->closed;
+    }
+    pthread_mutex_unlock(&priv->out_lock);
+
+    if (closed) {
+        GF_FREE(rx);
+        goto out;
+    }
+
+    if (res > 0) {
+        rx->len = res;
+
+        /* Process all complete messages. Any partial message is kept in
+         * the state machine, so the buffer is always fully consumed. */
+        do {
+            pos = rx->pos;
+            ret = socket_event_poll_in(this, _gf_false);
+        } while ((ret >= 0) && (rx->pos < rx->len) && (rx->pos != pos));
+
+        if ((ret >= 0) && (rx->pos < rx->len)) {
+            gf_log(this->name, GF_LOG_ERROR,
+                   "unable to process received data on socket %d",
+                   priv->sock);
+            ret = -1;
+        }
+    } else if (res == 0) {
+        gf_log(this->name, GF_LOG_DEBUG, "EOF from peer %s",
+               this->peerinfo.identifier);
+    } else if (__does_socket_rwv_error_need_logging(priv, 0)) {
+        GF_LOG_OCCASIONALLY(priv->log_ctr, this->name, GF_LOG_WARNING,
+                            "recv on %s failed (%s)",
+                            this->peerinfo.identifier, strerror(-res));
+    }
+
+    pthread_mutex_lock(&priv->out_lock);
+    {
+        if (rx->closed) {
+            closed = _gf_true;
+        } else if (ret >= 0) {
+            if (priv->uring.throttle)
+                rx->parked = _gf_true;
+            else
+                __socket_uring_recv(this, rx);
+        } else {
+            /* Detach the context so that the reset doesn't wait for a
+             * request that has already completed. */
+            priv->uring.rx = NULL;
+            closed = _gf_true;
+        }
+    }
+    pthread_mutex_unlock(&priv->out_lock);
+
+    if (ret < 0) {
+        gf_log("transport", GF_LOG_DEBUG, "disconnecting (sock:%d) (non-SSL)",
+               priv->sock);
+
+        socket_closed = socket_event_poll_err(this, priv->gen, priv->idx);
+        if (socket_closed)
+            rpc_transport_unref(this);
+    }
+
+    if (closed)
+        GF_FREE(rx);
+
+out:
+    rpc_transport_unref(this);
+}
+
+/* Resume receiving data after throttling has been disabled. Always called
+ * with out_lock held. */
+static void
+__socket_uring_unthrottle(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct socket_uring_rx *rx = priv->uring.rx;
+
+    if ((rx != NULL) && rx->parked) {
+        rx->parked = _gf_false;
+        __socket_uring_recv(this, rx);
+    }
+}
+
+/* Prepare the message to send as many pending vectors as possible. */
+static void
+socket_uring_tx_prepare(struct socket_uring_tx *tx)
+{
+    struct ioq *entry = NULL;
+    int count = 0;
+
+    list_for_each_entry(entry, &tx->entries, list)
+    {
+        if (count + entry->pending_count > GF_SOCKET_URING_TX_IOV)
+            break;
+
+        memcpy(&tx->iov[count], entry->pending_vector,
+               sizeof(struct iovec) * entry->pending_count);
+        count += entry->pending_count;
+    }
+
+    memset(&tx->msg, 0, sizeof(tx->msg));
+    tx->msg.msg_iov = tx->iov;
+    tx->msg.msg_iovlen = count;
+}
+
+/* Account 'size' bytes as sent, releasing all completed entries. */
+static void
+socket_uring_tx_advance(struct socket_uring_tx *tx, size_t size)
+{
+    struct ioq *entry = NULL;
+    struct ioq *tmp = NULL;
+
+    list_for_each_entry_safe(entry, tmp, &tx->entries, list)
+    {
+        while ((size > 0) && (entry->pending_count > 0)) {
+            if (size >= entry->pending_vector->iov_len) {
+                size -= entry->pending_vector->iov_len;
+                entry->pending_vector++;
+                entry->pending_count--;
+            } else {
+                entry->pending_vector->iov_base += size;
+                entry->pending_vector->iov_len -= size;
+                size = 0;
+            }
+        }
+
+        if (entry->pending_count > 0)
+            break;
+
+        __socket_ioq_entry_free(entry);
+    }
+}
+
+static void
+socket_uring_tx_destroy(struct socket_uring_tx *tx)
+{
+    struct ioq *entry = NULL;
+    struct ioq *tmp = NULL;
+
+    list_for_each_entry_safe(entry, tmp, &tx->entries, list)
+    {
+        __socket_ioq_entry_free(entry);
+    }
+
+    GF_FREE(tx);
+}
+
+/* Send all queued messages with a single request. Only one request is in
+ * flight at any time to keep messages ordered. Always called with out_lock
+ * held. Returns -1 if the messages couldn't be sent. */
+static int
+__socket_uring_send(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct socket_uring_tx *tx = NULL;
+
+    if (priv->uring.tx_busy || list_empty(&priv->ioq))
+        return 0;
+
+    tx = GF_MALLOC(sizeof(*tx), gf_sock_mt_uring_tx);
+    if (!tx)
+        return -1;
+
+    tx->this = this;
+    tx->gen = priv->uring.gen;
+    INIT_LIST_HEAD(&tx->entries);
+    list_splice_init(&priv->ioq, &tx->entries);
+
+    socket_uring_tx_prepare(tx);
+
+    priv->uring.tx_busy = _gf_true;
+    rpc_transport_ref(this);
+
+    gf_io_sendmsg(socket_uring_send_cbk, priv->sock, &tx->msg, MSG_NOSIGNAL,
+                  tx);
+    gf_io.engine.flush();
+
+    return 0;
+}
+
+GF_IO_CBK(socket_uring_send_cbk, op, res, static)
+{
+    struct socket_uring_tx *tx = op->data;
+    rpc_transport_t *this = tx->this;
+    socket_private_t *priv = this->private;
+    gf_boolean_t sent = _gf_false;
+
+    THIS = this->xl;
+
+    pthread_mutex_lock(&priv->out_lock);
+    {
+        if ((tx->gen != priv->uring.gen) || (priv->connected != 1)) {
+            /* The connection has been reset. Pending data is discarded. */
+        } else if ((res > 0) || (res == -EAGAIN) || (res == -EINTR)) {
+            if (res > 0) {
+                this->total_bytes_write += res;
+                socket_uring_tx_advance(tx, res);
+            }
+
+            if (!list_empty(&tx->entries)) {
+                /* Partial send. Continue with the remaining data. */
+                socket_uring_tx_prepare(tx);
+                gf_io_sendmsg(socket_uring_send_cbk, priv->sock, &tx->msg,
+                              MSG_NOSIGNAL, tx);
+                gf_io.engine.flush();
+
+                pthread_mutex_unlock(&priv->out_lock);
+
+                return;
+            }
+
+            sent = list_empty(&priv->ioq);
+        } else {
+            if (__does_socket_rwv_error_need_logging(priv, 1)) {
+                GF_LOG_OCCASIONALLY(priv->log_ctr, this->name, GF_LOG_WARNING,
+                                    "sendmsg on %s failed (%s)",
+                                    this->peerinfo.identifier,
+                                    strerror(-res));
+            }
+            __socket_disconnect(this);
+        }
+
+        priv->uring.tx_busy = _gf_false;
+
+        /* Messages may have been queued for a new connection while the
+         * previous one was being torn down. */
+        if ((priv->connected == 1) && (__socket_uring_send(this) < 0))
+            __socket_disconnect(this);
+    }
+    pthread_mutex_unlock(&priv->out_lock);
+
+    socket_uring_tx_destroy(tx);
+
+    if (sent)
+        rpc_transport_notify(this, RPC_TRANSPORT_MSG_SENT, NULL);
+
+    rpc_transport_unref(this);
+}
+
+#endif /* HAVE_IO_URING */
+
 /* reads rpc_requests during pollin */
 static void
 socket_event_handler(int fd, int idx, int gen, void *data, int poll_in,
@@ -2749,6 +3525,14 @@ socket_event_handler(int fd, int idx, int gen, void *data, int poll_in,
            (priv->is_server ? "server" : "client"), priv->sock, poll_in,
            poll_out, poll_err);
 
+#ifdef GF_SOCKET_ZEROCOPY
+    /* Completions of zero-copy sends are queued in the error queue of the
+     * socket, which is reported as an error. If the socket has a real error
+     * it will be reported again once the event is rearmed. */
+    if (poll_err && socket_zc_reap(this))
+        poll_err = 0;
+#endif
+
     if (!poll_err) {
         if (!socket_is_connected(priv)) {
             gf_log(this->name, GF_LOG_TRACE,
@@ -2786,6 +3570,13 @@ socket_event_handler(int fd, int idx, int gen, void *data, int poll_in,
                priv->sock, ret);
     }
 
+#ifdef HAVE_IO_URING
+    /* Once io_uring takes over, received data is processed by the recv
+     * callback and POLLIN is not reported anymore. */
+    if (!ret && poll_in && !poll_err && socket_uring_start(this))
+        poll_in = 0;
+#endif
+
     if (!ret && poll_in) {
         ret = socket_event_poll_in(this, !poll_err);
         gf_log(this->name, GF_LOG_TRACE,
@@ -2796,6 +3587,13 @@ socket_event_handler(int fd, int idx, int gen, void *data, int poll_in,
     }
 
     if ((ret < 0) || poll_err) {
+#ifdef HAVE_IO_URING
+        /* The event is not rearmed. The recv callback will complete the
+         * disconnection. */
+        if (socket_uring_defer_error(this))
+            goto out;
+#endif
+
         struct sockaddr *sa = SA(&this->peerinfo.sockaddr);
 
         if (priv->is_server &&
@@ -3660,10 +4458,49 @@ socket_submit_outgoing_msg(rpc_transport_t *this, rpc_transport_msg_t *msg)
 
         priv->submit_log = 0;
 
-        if (list_empty(&priv->ioq)) {
+#ifdef HAVE_IO_URING
+        if (socket_uring_enabled(priv)) {
+            list_add_tail(&entry->list, &priv->ioq);
+            if (priv->cork) {
+                ret = 0;
+                goto unlock;
+            }
+            ret = __socket_uring_send(this);
+            if (ret == 0)
+                goto unlock;
+
+            /* Fall back to a regular write if the request can't be sent
+             * through io_uring. */
+            ret = __socket_ioq_churn(this);
+            if (ret > 0) {
+                priv->idx = gf_event_select_on(this->ctx->event_pool,
+                                               priv->sock, priv->idx, -1, 1);
+                ret = 0;
+            }
+            goto unlock;
+        }
+#endif
+
+#ifdef GF_SOCKET_ZEROCOPY
+        /* SSL needs to encrypt the data, so it's always copied. */
+        entry->zerocopy = priv->zc.enabled && !priv->use_ssl &&
+                          (priv->zc.state >= 0) && (msg->iobref != NULL) &&
+                          (iov_length(msg->progpayload,
+                                      msg->progpayloadcount) >=
+                           GF_SOCKET_ZEROCOPY_MIN_SIZE);
+#endif
+
+        if (list_empty(&priv->ioq) && !priv->cork) {
             ret = __socket_ioq_churn_entry(this, entry, _gf_false);
 
             if (ret == 0) { /* current entry was completely written */
+#ifdef GF_SOCKET_ZEROCOPY
+                /* The kernel may still reference the data. */
+                if (entry->zc_done != entry->zc_count) {
+                    list_add_tail(&entry->list, &priv->zc.pending);
+                    goto unlock;
+                }
+#endif
                 free_entry = _gf_true;
             } else if (ret > 0) {
                 need_poll_out = _gf_true;
@@ -3795,7 +4632,16 @@ socket_throttle(rpc_transport_t *this, gf_boolean_t onoff)
          * on a disconnected transport, which breaks epoll's event to
          * registered fd mapping. */
 
-        if (priv->connected == 1)
+#ifdef HAVE_IO_URING
+        /* With io_uring, the recv callback doesn't post new requests while
+         * throttled. */
+        priv->uring.throttle = onoff;
+        if (priv->uring.rx != NULL) {
+            if (!onoff && (priv->connected == 1))
+                __socket_uring_unthrottle(this);
+        } else
+#endif
+            if (priv->connected == 1)
             priv->idx = gf_event_select_on(this->ctx->event_pool, priv->sock,
                                            priv->idx, (int)!onoff, -1);
     }
@@ -3860,6 +4706,12 @@ reconfigure(rpc_transport_t *this, dict_t *options)
                "Reconfigured transport.listen-backlog=%d", priv->backlog);
     }
 
+    if (dict_get_int32_sizen(options, "transport.socket.read-batch",
+                             &(priv->read_batch)) != 0)
+        priv->read_batch = GF_SOCKET_READ_BATCH;
+    gf_log(this->name, GF_LOG_DEBUG,
+           "Reconfigured transport.socket.read-batch=%d", priv->read_batch);
+
     if (priv->keepalive) {
         if (dict_get_int32_sizen(options, "transport.socket.keepalive-time",
                                  &(priv->keepaliveidle)) != 0)
@@ -4306,7 +5158,9 @@ socket_init(rpc_transport_t *this)
     priv->ssl_accepted = _gf_false;
     priv->ssl_connected = _gf_false;
     priv->windowsize = GF_DEFAULT_SOCKET_WINDOW_SIZE;
+    priv->read_batch = GF_SOCKET_READ_BATCH;
     INIT_LIST_HEAD(&priv->ioq);
+    INIT_LIST_HEAD(&priv->zc.pending);
     pthread_mutex_init(&priv->notify.lock, NULL);
     pthread_cond_init(&priv->notify.cond, NULL);
 
@@ -4412,6 +5266,10 @@ socket_init(rpc_transport_t *this)
         priv->backlog = GLUSTERFS_SOCKET_LISTEN_BACKLOG;
     }
 
+    if (dict_get_int32_sizen(this->options, "transport.socket.read-batch",
+                             &(priv->read_batch)) != 0)
+        priv->read_batch = GF_SOCKET_READ_BATCH;
+
     optstr = NULL;
 
     /* Check if socket read failures are to be logged */
@@ -4430,6 +5288,44 @@ socket_init(rpc_transport_t *this)
 
     priv->windowsize = (int)windowsize;
 
+    optstr = NULL;
+    if (dict_get_str_sizen(this->options, "transport.socket.engine",
+                           &optstr) == 0) {
+        if (strcmp(optstr, "uring") == 0) {
+#ifdef HAVE_IO_URING
+            priv->uring.enabled = _gf_true;
+#else
+            gf_log(this->name, GF_LOG_WARNING,
+                   "io_uring support not available; using epoll");
+#endif
+        } else if (strcmp(optstr, "epoll") != 0) {
+            gf_log(this->name, GF_LOG_WARNING,
+                   "'transport.socket.engine' takes only 'epoll' or "
+                   "'uring'; using epoll");
+        }
+    }
+
+    data = dict_get_sizen(this->options, "transport.socket.zerocopy");
+    if (data) {
+        optstr = data_to_str(data);
+
+        if (gf_string2boolean(optstr, &tmp_bool) != 0) {
+            gf_log(this->name, GF_LOG_ERROR,
+                   "'transport.socket.zerocopy' takes only "
+                   "boolean options, not taking any action");
+            tmp_bool = 0;
+        }
+        if (tmp_bool) {
+#ifdef GF_SOCKET_ZEROCOPY
+            priv->zc.enabled = _gf_true;
+            gf_log(this->name, GF_LOG_DEBUG, "enabling zero-copy sends");
+#else
+            gf_log(this->name, GF_LOG_WARNING,
+                   "zero-copy sends are not supported; copying data");
+#endif
+        }
+    }
+
     priv->ssl_enabled = _gf_false;
     if (dict_get_str_sizen(this->options, SSL_ENABLED_OPT, &optstr) == 0) {
         if (gf_string2boolean(optstr, &priv->ssl_enabled) != 0) {
@@ -4556,6 +5452,30 @@ struct volume_options options[] = {
     {.key = {"transport.socket.nodelay"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "1"},
+    {.key = {"transport.socket.engine"},
+     .type = GF_OPTION_TYPE_STR,
+     .value = {"epoll", "uring"},
+     .default_value = "epoll",
+     .description = "Mechanism used to send and receive data on established "
+                    "connections. 'uring' requires the io_uring I/O engine "
+                    "and is not used for SSL connections."},
+    {.key = {"transport.socket.zerocopy"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "Send messages with a big payload (like read replies) "
+                    "without copying it to the kernel (MSG_ZEROCOPY). The "
+                    "buffers are kept until the kernel reports that the "
+                    "data has been sent. Not used for SSL connections nor "
+                    "with the 'uring' engine."},
+    {.key = {"transport.socket.read-batch"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = GF_SOCKET_READ_BATCH_MAX,
+     .default_value = TOSTRING(GF_SOCKET_READ_BATCH),
+     .description = "Maximum number of received messages that are read "
+                    "from the socket and processed together. The replies "
+                    "to a batch of requests are sent with as few writes as "
+                    "possible."},
     {.key = {"transport.socket.keepalive"},
      .type = GF_OPTION_TYPE_BOOL,
      .op_version = {1},
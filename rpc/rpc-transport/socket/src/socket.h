@@ -45,6 +45,16 @@
 #define GF_KEEPALIVE_INTERVAL (2)
 #define GF_KEEPALIVE_COUNT (9)
 
+/* Zero-copy sends (MSG_ZEROCOPY) are only available on Linux. */
+#if defined(GF_LINUX_HOST_OS) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define GF_SOCKET_ZEROCOPY
+#endif
+
+/* Pinning pages and processing the completion notification is more
+ * expensive than copying small messages, so only messages carrying at least
+ * this amount of payload are sent with zero-copy. */
+#define GF_SOCKET_ZEROCOPY_MIN_SIZE (16 * GF_UNIT_KB)
+
 typedef enum {
     SP_STATE_NADA = 0,
     SP_STATE_COMPLETE,
@@ -105,6 +115,14 @@ struct ioq {
     int pending_count;
     struct iobref *iobref;
     uint32_t fraghdr;
+    /* Zero-copy sends of this entry: ids zc_first .. zc_first + zc_count - 1
+     * have been assigned by the kernel and zc_done of them are completed.
+     * The entry can't be released until all of them are completed. */
+    uint32_t zc_first;
+    uint32_t zc_count;
+    uint32_t zc_done;
+    struct timespec zc_time; /* time of the last zero-copy send */
+    gf_boolean_t zerocopy;   /* send the entry using MSG_ZEROCOPY */
     char _pad[4];
 };
 
@@ -160,6 +178,15 @@ struct gf_sock_incoming_frag {
 
 #define GF_SOCKET_RA_MAX 1024
 
+/* Default number of complete records read from the socket before they are
+ * handed to the upper layer, as a single batch (transport.socket.read-batch).
+ */
+#define GF_SOCKET_READ_BATCH 16
+#define GF_SOCKET_READ_BATCH_MAX 256
+
+/* Maximum number of vectors of queued messages sent with a single writev. */
+#define GF_SOCKET_WRITE_IOV 64
+
 struct gf_sock_incoming {
     char *proghdr_base_addr;
     struct iobuf *iobuf;
@@ -183,6 +210,33 @@ struct gf_sock_incoming {
     char _pad[4];
 };
 
+/* Size of the buffer used to receive data through io_uring. */
+#define GF_SOCKET_URING_RX_SIZE (64 * GF_UNIT_KB)
+
+/* Maximum number of vectors sent in a single io_uring request. */
+#define GF_SOCKET_URING_TX_IOV 64
+
+/* Receive context of a connection using the io_uring engine. While a recv
+ * request is pending, the request owns this structure. */
+struct socket_uring_rx {
+    rpc_transport_t *this;
+    uint32_t pos; /* first byte not yet consumed */
+    uint32_t len; /* number of bytes received */
+    gf_boolean_t closed; /* connection reset while recv was pending */
+    gf_boolean_t parked; /* no recv pending because of throttling */
+    char buf[GF_SOCKET_URING_RX_SIZE];
+};
+
+/* Send context of a connection using the io_uring engine. It owns all the
+ * ioq entries being sent until the request completes. */
+struct socket_uring_tx {
+    rpc_transport_t *this;
+    struct list_head entries;
+    uint64_t gen; /* connection generation when the request was sent */
+    struct msghdr msg;
+    struct iovec iov[GF_SOCKET_URING_TX_IOV];
+};
+
 typedef struct {
     union {
         struct list_head ioq;
@@ -216,6 +270,8 @@ typedef struct {
     int32_t idx;
     int32_t gen;
     uint32_t backlog;
+    int32_t read_batch; /* records delivered together to the upper layer */
+    int32_t cork;       /* while > 0, messages are queued but not sent */
     SSL_CTX *ssl_ctx;
     SSL *ssl_ssl;
     char *ssl_own_cert;
@@ -258,6 +314,21 @@ typedef struct {
                             * socket_event_handler() for
                             * newly accepted socket
                             */
+    /* State of the io_uring engine (transport.socket.engine = uring). */
+    struct {
+        struct socket_uring_rx *rx;
+        uint64_t gen;          /* incremented on each connection reset */
+        gf_boolean_t enabled;  /* engine selected in the options */
+        gf_boolean_t tx_busy;  /* a send request is in flight */
+        gf_boolean_t throttle; /* don't receive more data for now */
+    } uring;
+    /* State of zero-copy sends (transport.socket.zerocopy). */
+    struct {
+        struct list_head pending; /* entries waiting for completion */
+        uint32_t next;            /* id of the next zero-copy send */
+        int32_t state; /* 0 = not set up, 1 = active, -1 = not usable */
+        gf_boolean_t enabled;
+    } zc;
     char _pad[4];
 } socket_private_t;
 
@@ -862,20 +862,11 @@ xdr_to_dict(gfx_dict *dict, dict_t **to)
                                       xpair->value.gfx_value_u.value_dbl);
                 break;
             case GF_DATA_TYPE_STR:
-                value = GF_MALLOC(
-                    xpair->value.gfx_value_u.val_string.val_string_len + 1,
-                    gf_common_mt_char);
-                if (!value) {
-                    errno = ENOMEM;
-                    goto out;
-                }
-                memcpy(value,
-                       xpair->value.gfx_value_u.val_string.val_string_val,
-                       xpair->value.gfx_value_u.val_string.val_string_len);
-                value[xpair->value.gfx_value_u.val_string.val_string_len] =
-                    '\0';
-                free(xpair->value.gfx_value_u.val_string.val_string_val);
-                ret = dict_set_dynstr(this, key, value);
+                /* XDR has already allocated and terminated the string, the
+                 * dict frees it. */
+                ret = dict_set_dynstr_stdalloc(
+                    this, key,
+                    xpair->value.gfx_value_u.val_string.val_string_val);
                 break;
             case GF_DATA_TYPE_GFUUID:
                 uuid = GF_MALLOC(sizeof(uuid_t), gf_common_mt_uuid_t);
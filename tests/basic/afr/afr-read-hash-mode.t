@@ -50,6 +50,24 @@ count=`reads_brick_count`
 TEST [ $count -eq 2 ]
 
 # Check that the arbiter did not serve any reads
+arbiter_reads=$($CLI volume top $V0 read brick $H0:$B0/${V0}2|grep FILE|awk '{print $1}')
+TEST [ -z $arbiter_reads ]
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+# read-hash-mode=6
+# A brick without read samples yet is assumed to be as fast as the fastest
+# measured one, so both data bricks get measured and serve reads.
+TEST $CLI volume set $V0 cluster.read-hash-mode 6
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 --volfile-id $V0 $M0
+EXPECT "6" mount_get_option_value $M0 $V0-replicate-0 read-hash-mode
+TEST $CLI volume profile $V0 info clear
+TEST dd if=$M0/FILE of=/dev/null bs=64k iflag=direct
+count=`reads_brick_count`
+TEST [ $count -eq 2 ]
+TEST [ $(mount_get_option_value $M0 $V0-replicate-0 'read_latency_samples\[0\]') -gt 0 ]
+TEST [ $(mount_get_option_value $M0 $V0-replicate-0 'read_latency_samples\[1\]') -gt 0 ]
+EXPECT "0" mount_get_option_value $M0 $V0-replicate-0 'read_latency_samples\[2\]'
+
 arbiter_reads=$($CLI volume top $V0 read brick $H0:$B0/${V0}2|grep FILE|awk '{print $1}')
 TEST [ -z $arbiter_reads ]
 
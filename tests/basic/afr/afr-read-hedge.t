@@ -0,0 +1,65 @@
+#!/bin/bash
+
+# With cluster.read-hedge-percentile set, a read that the brick it was
+# sent to doesn't answer in time is also sent to the other readable brick.
+# A stalled brick then doesn't hold the read until the ping timeout.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function afr_private {
+        mount_get_option_value $M0 $V0-replicate-0 $1
+}
+
+# Direct reads of 4k blocks spread over the file, enough for the latency
+# histogram to give a delay.
+function read_blocks {
+        local i
+
+        for i in $(seq 1 $1); do
+                dd if=$M0/file of=/dev/null bs=4k count=1 skip=$((i % 250)) \
+                   iflag=direct 2>/dev/null || return 1
+        done
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 cluster.choose-local off
+TEST $CLI volume set $V0 cluster.read-subvolume-index 0
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=2
+EXPECT "0" afr_private read-hedge-percentile
+
+# No read is hedged by default.
+TEST read_blocks 100
+EXPECT "0" afr_private read-hedges-sent
+
+TEST $CLI volume set $V0 cluster.read-hedge-percentile 90
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "90" afr_private read-hedge-percentile
+TEST read_blocks 100
+
+# Reads go to the first brick. Stall it, they're answered by the second.
+brick_pid=$(get_brick_pid $V0 $H0 $B0/${V0}0)
+TEST kill -STOP $brick_pid
+TEST timeout 20 dd if=$M0/file of=/dev/null bs=4k count=10 skip=300 \
+        iflag=direct
+TEST kill -CONT $brick_pid
+
+TEST [ $(afr_private read-hedges-sent) -ge 10 ]
+TEST [ $(afr_private read-hedges-won) -ge 10 ]
+TEST cmp $M0/file $B0/${V0}0/file
+TEST cmp $M0/file $B0/${V0}1/file
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,77 @@
+#!/bin/bash
+
+# With cluster.use-compound-fops on, the pre-op of a write transaction is
+# sent in the xdata of the write and done by the index xlator of each
+# brick, instead of as a separate xattrop. Writes that need their own
+# pre-op then cost one round trip less, and a brick missing the write must
+# still be marked pending.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# Calls of the fops matching $1 in the profile info $2, for all bricks.
+function fop_calls {
+        echo "$2" | awk -v fop="$1" \
+             '$NF ~ fop { sum += $(NF - 1) } END { print sum + 0 }'
+}
+
+function write_blocks {
+        dd if=/dev/urandom of=$M0/file bs=4k count=$1 seek=$2 oflag=direct \
+           conv=notrunc 2>/dev/null
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0..2}
+# Without eager locking, every write does its own pre-op and post-op.
+TEST $CLI volume set $V0 cluster.eager-lock off
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+TEST $CLI volume profile $V0 start
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+TEST touch $M0/file
+
+# Separate pre-op and post-op xattrops by default.
+TEST $CLI volume profile $V0 info clear
+TEST write_blocks 50 0
+profile=$($CLI volume profile $V0 info cumulative)
+writes=$(fop_calls "^WRITE$" "$profile")
+xattrops=$(fop_calls "XATTROP$" "$profile")
+TEST [ $writes -ge 150 ]
+TEST [ $xattrops -ge $((2 * writes)) ]
+
+TEST $CLI volume set $V0 cluster.use-compound-fops on
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "on" cat \
+              $M0/.meta/graphs/active/$V0-replicate-0/options/use-compound-fops
+
+# Only the post-op is a separate xattrop now.
+TEST $CLI volume profile $V0 info clear
+TEST write_blocks 50 50
+profile=$($CLI volume profile $V0 info cumulative)
+writes=$(fop_calls "^WRITE$" "$profile")
+xattrops=$(fop_calls "XATTROP$" "$profile")
+TEST [ $writes -ge 150 ]
+TEST [ $xattrops -lt $((3 * writes / 2)) ]
+EXPECT "0" get_pending_heal_count $V0
+
+# A brick that misses writes is marked pending by the others.
+TEST kill_brick $V0 $H0 $B0/${V0}2
+TEST write_blocks 10 100
+EXPECT "1" get_pending_heal_count $V0
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 2
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+TEST cmp $B0/${V0}0/file $B0/${V0}2/file
+TEST cmp $B0/${V0}1/file $B0/${V0}2/file
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,90 @@
+#!/bin/bash
+
+# A rebalance process killed in the middle of the migration is restarted
+# by glusterd and resumes from its checkpoint. Directories are only saved
+# in the checkpoint once their files are migrated, so a new rebalance run
+# afterwards must have nothing left to move.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function rebalance_pid {
+        pgrep -f "volfile-id rebalance/$V0"
+}
+
+function crawler_thread_count {
+        local pid=$(rebalance_pid)
+
+        if [ -z "$pid" ]; then
+                echo 0
+                return
+        fi
+        cat /proc/$pid/task/*/comm 2>/dev/null | grep -c "dhtcrawl"
+}
+
+function rebalance_moved_files {
+        if [ "$(rebalanced_files_field $V0)" -gt 0 ] 2>/dev/null; then
+                echo "Y"
+        fi
+}
+
+function linkto_file_count {
+        find $B0/${V0}* -path '*/.glusterfs' -prune -o -type f -perm -1000 \
+             -print | wc -l
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}{1,2}
+TEST $CLI volume set $V0 cluster.rebal-crawl-threads 3
+TEST $CLI volume set $V0 cluster.rebal-throttle lazy
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+for d in {1..20}; do
+        mkdir $M0/dir$d
+        for f in {1..100}; do
+                dd if=/dev/urandom of=$M0/dir$d/file$f bs=64k count=1 \
+                   2>/dev/null
+        done
+done
+md5file=$(mktemp)
+md5sum $M0/dir*/file* > $md5file
+
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}{3,4}
+TEST $CLI volume rebalance $V0 start
+
+# The extra crawler threads run next to the rebalance main thread.
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "2" crawler_thread_count
+
+# Interrupt the rebalance once some files have moved, as a node crash
+# would. glusterd is stopped first, or it would mark the run failed.
+EXPECT_WITHIN $REBALANCE_TIMEOUT "Y" rebalance_moved_files
+TEST pkill glusterd
+EXPECT_WITHIN $PROCESS_DOWN_TIMEOUT "" pidof glusterd
+TEST pkill -9 -f "volfile-id rebalance/$V0"
+EXPECT_WITHIN $PROCESS_DOWN_TIMEOUT "" rebalance_pid
+TEST [ -f $GLUSTERD_WORKDIR/vols/$V0/rebalance/*.crawl ]
+
+# glusterd restarts the rebalance of the interrupted run.
+TEST glusterd
+TEST pidof glusterd
+EXPECT_WITHIN $REBALANCE_TIMEOUT "completed" rebalance_status_field $V0
+EXPECT "0" rebalance_failed_field $V0
+TEST ! ls $GLUSTERD_WORKDIR/vols/$V0/rebalance/*.crawl
+
+# Every file is on its hashed brick and unchanged.
+EXPECT "0" linkto_file_count
+TEST md5sum -c --quiet $md5file
+
+TEST $CLI volume rebalance $V0 start force
+EXPECT_WITHIN $REBALANCE_TIMEOUT "completed" rebalance_status_field $V0
+EXPECT "0" rebalanced_files_field $V0
+
+rm -f $md5file
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,18 @@
+#!/bin/bash
+
+# ec-bench checks that every combination of fragments that can rebuild the
+# data decodes it back unchanged, for each available cpu extension. Run it
+# quickly over layouts with few and with many fragments.
+
+. $(dirname $0)/../../include.rc
+
+# Built along with the translator, but not installed.
+ECBENCH=$(dirname $0)/../../../xlators/cluster/ec/src/ec-bench
+
+cleanup;
+
+TEST [ -x $ECBENCH ]
+TEST $ECBENCH -l 2:1,4:2,8:4,16:4 -s 4K,64K -t 0.01
+TEST ! $ECBENCH -t 0
+
+cleanup;
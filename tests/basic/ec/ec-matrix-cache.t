@@ -0,0 +1,69 @@
+#!/bin/bash
+
+# disperse.matrix-cache-size limits the number of decoding matrices built
+# when the volume is mounted. A 4+2 volume reads with 15 different masks
+# while up to two bricks are down.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../ec.rc
+
+function matrix_cache_field {
+        local dump=$(generate_mount_statedump $V0)
+
+        sed -n '/\.stats\.matrix_cache\]/,/^$/p' $dump | grep "^$1=" | \
+             cut -d= -f2
+        cleanup_mount_statedump $V0
+}
+
+function mount_volume {
+        TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+        EXPECT_WITHIN $CHILD_UP_TIMEOUT "6" ec_child_up_count $V0 0
+}
+
+cleanup
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 redundancy 2 $H0:$B0/${V0}{0..5}
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume start $V0
+
+mount_volume
+EXPECT "15" matrix_cache_field entries
+
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=4
+md5=$(md5sum $M0/file | awk '{print $1}')
+
+# Degraded reads find their matrix in the cache.
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST kill_brick $V0 $H0 $B0/${V0}3
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "4" ec_child_up_count $V0 0
+EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+TEST [ $(matrix_cache_field hits) -gt 0 ]
+EXPECT "0" matrix_cache_field misses
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume start $V0 force
+
+TEST $CLI volume set $V0 disperse.matrix-cache-size 5
+mount_volume
+EXPECT "5" matrix_cache_field entries
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+# Without the cache every read builds its matrix on demand.
+TEST $CLI volume set $V0 disperse.matrix-cache-size 0
+mount_volume
+EXPECT "0" matrix_cache_field entries
+EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+EXPECT "0" matrix_cache_field hits
+TEST [ $(matrix_cache_field misses) -gt 0 ]
+
+TEST ! $CLI volume set $V0 disperse.matrix-cache-size 4097
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup
@@ -0,0 +1,64 @@
+#!/bin/bash
+
+# With disperse.read-hedge-percentile set, reads measure their latency and
+# arm a timer at that percentile of the recent ones, after which an extra
+# fragment is requested from a brick not used by the read yet.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function ec_hedge_stat {
+        local section="cluster\/disperse\.$V0-disperse-0\.stats\.read_hedge"
+        local dump=$(generate_mount_statedump $V0 $M0)
+
+        sed -n "/^\[$section\]/,/^$/p" $dump | grep "^$1=" | cut -d= -f2
+        rm -f $dump
+}
+
+function read_blocks {
+        local i
+
+        for i in $(seq 1 $1); do
+                dd if=$M0/file of=/dev/null bs=8k count=1 skip=$((i % 250)) \
+                   iflag=direct 2>/dev/null || return 1
+        done
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=2
+TEST cp $B0/data $M0/file
+
+# Reads aren't measured nor hedged by default.
+TEST read_blocks 100
+EXPECT "0" ec_hedge_stat percentile
+EXPECT "0" ec_hedge_stat delay-usecs
+EXPECT "0" ec_hedge_stat sent
+
+TEST $CLI volume set $V0 disperse.read-hedge-percentile 95
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "95" ec_hedge_stat percentile
+TEST read_blocks 100
+TEST [ $(ec_hedge_stat delay-usecs) -gt 0 ]
+
+# Data read through hedged reads is unchanged, also with a brick down.
+TEST drop_cache $M0
+TEST cmp $B0/data $M0/file
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST drop_cache $M0
+TEST cmp $B0/data $M0/file
+
+rm -f $B0/data
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
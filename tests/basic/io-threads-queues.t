@@ -0,0 +1,81 @@
+#!/bin/bash
+
+# performance.iot-queue-count spreads the io-threads requests of a brick
+# over several queues. Everything queued must be served, whatever queue it
+# went to.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function iot_dump_field {
+        local dump=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+
+        sed -n '/^\[performance\/io-threads\./,/^$/p' $dump | \
+             grep "^$1=" | cut -d= -f2
+        rm -f $dump
+}
+
+function iot_queued_requests {
+        local dump=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+
+        grep -c "_priority_queue_length=" $dump
+        rm -f $dump
+}
+
+function fop_load {
+        local pids=""
+
+        for i in {1..16}; do
+                (mkdir $M0/dir$i &&
+                 for f in {1..20}; do
+                         echo $i.$f > $M0/dir$i/file$f
+                         stat $M0/dir$i/file$f
+                 done) >/dev/null 2>&1 &
+                pids="$pids $!"
+        done
+        wait $pids
+}
+
+function check_load {
+        for i in {1..16}; do
+                for f in {1..20}; do
+                        [ "$(cat $M0/dir$i/file$f)" == "$i.$f" ] || return 1
+                done
+        done
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.iot-queue-count 3
+# Few threads per priority, so that requests wait in the queues.
+TEST $CLI volume set $V0 performance.high-prio-threads 1
+TEST $CLI volume set $V0 performance.normal-prio-threads 1
+TEST $CLI volume set $V0 performance.low-prio-threads 1
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+EXPECT "3" iot_dump_field queue_count
+
+TEST fop_load
+TEST check_load
+
+# Nothing is left queued and every thread slot has been given back.
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "0" iot_queued_requests
+EXPECT "0" iot_dump_field current_high_priority_threads
+EXPECT "0" iot_dump_field current_normal_priority_threads
+EXPECT "0" iot_dump_field current_low_priority_threads
+
+# 0 means one queue per CPU, up to 16.
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume set $V0 performance.iot-queue-count 0
+TEST $CLI volume start $V0
+cpus=$(getconf _NPROCESSORS_ONLN)
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "$((cpus < 16 ? cpus : 16))" \
+        iot_dump_field queue_count
+
+cleanup;
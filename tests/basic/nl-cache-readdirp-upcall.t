@@ -0,0 +1,66 @@
+#!/bin/bash
+
+# A listing cached by nl-cache must be dropped when another client changes
+# one of its entries, also after the inode of that entry is forgotten by
+# the client that cached the listing.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function nlc_counter {
+        local dump=$(generate_mount_statedump $V0 $M0)
+
+        grep -a "^$1=" $dump | cut -d= -f2
+        rm -f $dump
+}
+
+# Lists the directory again and tells if it was read from the bricks
+function listing_missed {
+        ls $M0/dir > /dev/null
+        if [ $(nlc_counter readdirp_miss_count) -gt $1 ]; then
+                echo "Y"
+        fi
+}
+
+function list_dir {
+        ls -1 --color=never $M0/dir | tr '\n' ' '
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 group nl-cache
+TEST $CLI volume set $V0 performance.nl-cache-readdirp on
+TEST $CLI volume start $V0
+
+# Inodes in the lru list of M0 are forgotten as soon as the kernel drops
+# them.
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --lru-limit=1 $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1
+
+TEST mkdir $M1/dir
+TEST touch $M1/dir/file{1..3}
+
+EXPECT "file1 file2 file3 " list_dir
+EXPECT "file1 file2 file3 " list_dir
+TEST [ $(nlc_counter readdirp_hit_count) -gt 0 ]
+
+# An unlink names the parent of the forgotten entry.
+TEST drop_cache $M0
+TEST rm -f $M1/dir/file1
+EXPECT_WITHIN $UMOUNT_TIMEOUT "file2 file3 " list_dir
+
+# A change of attributes names only the entry, every listing is dropped.
+EXPECT "file2 file3 " list_dir
+misses=$(nlc_counter readdirp_miss_count)
+TEST drop_cache $M0
+TEST chmod 0600 $M1/dir/file2
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" listing_missed $misses
+EXPECT "file2 file3 " list_dir
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+cleanup;
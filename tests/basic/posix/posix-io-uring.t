@@ -0,0 +1,76 @@
+#!/bin/bash
+
+# With storage.linux-io_uring on, posix sends readv, writev and fsync
+# through the io_uring engine of the brick process. When the process runs
+# another engine, posix falls back to synchronous I/O. Data written
+# through either path must read back unchanged.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function brick_io_uring_fds {
+        local pid=$(get_brick_pid $V0 $H0 $B0/${V0}0)
+
+        ls -l /proc/$pid/fd 2>/dev/null | grep -c "io_uring"
+}
+
+function brick_fallbacks {
+        grep -c "io_uring engine is not active" $brick_log
+}
+
+cleanup;
+
+brick_log=$LOGDIR/bricks/$(echo $B0/${V0}0 | sed 's|^/||; s|/|-|g').log
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume set $V0 storage.linux-io_uring on
+TEST $CLI volume start $V0
+
+if [ $(brick_io_uring_fds) -eq 0 ]; then
+        # No io_uring in this kernel, the brick runs the legacy engine.
+        SKIP_TESTS
+        cleanup
+        exit 0
+fi
+
+# The option can't change while the bricks are running.
+TEST ! $CLI volume set $V0 storage.linux-io_uring off
+EXPECT "0" brick_fallbacks
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+TEST dd if=/dev/urandom of=$B0/data bs=128k count=64
+TEST dd if=$B0/data of=$M0/file bs=128k oflag=direct conv=fsync
+TEST drop_cache $M0
+TEST cmp $B0/data $M0/file
+TEST dd if=$B0/data of=$M0/file bs=4k count=32 skip=100 seek=100 oflag=dsync \
+        conv=notrunc
+TEST drop_cache $M0
+TEST cmp $B0/data $M0/file
+
+# Bricks started by a glusterd running the legacy engine fall back.
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST pkill glusterd
+TEST glusterd --io-engine=legacy
+TEST pidof glusterd
+TEST $CLI volume start $V0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" brick_fallbacks
+EXPECT "0" brick_io_uring_fds
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+TEST cmp $B0/data $M0/file
+TEST dd if=$B0/data of=$M0/file2 bs=128k oflag=direct conv=fsync
+TEST drop_cache $M0
+TEST cmp $B0/data $M0/file2
+
+rm -f $B0/data
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,80 @@
+#!/bin/bash
+
+# With performance.quick-read-cache-compression on, quick-read keeps the
+# cached contents compressed when that saves space, and inflates them on
+# each cached read. The cache must then use less memory for compressible
+# files and still serve their exact contents.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function qr_stat {
+        local dump=$(generate_mount_statedump $V0 $M0)
+
+        sed -n '/^\[xlator\.performance\.quick-read\.priv\]/,/^$/p' $dump | \
+             grep "^$1=" | cut -d= -f2
+        rm -f $dump
+}
+
+# Reads every file through the cache, and checks its content.
+function read_files {
+        local f
+
+        drop_cache $M0
+        for f in $B0/${V0}0/text.* $B0/${V0}0/random.*; do
+                cmp $f $M0/$(basename $f) || return 1
+        done
+}
+
+function mount_volume {
+        $GFS --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 \
+             --attribute-timeout=0 $M0
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.quick-read on
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume start $V0
+
+TEST mount_volume
+for i in {1..20}; do
+        yes "quick-read cached file $i" | head -c 32768 > $M0/text.$i
+done
+for i in {1..4}; do
+        dd if=/dev/urandom of=$M0/random.$i bs=32k count=1 2>/dev/null
+done
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+# Without compression, the cache uses the size of the files.
+TEST mount_volume
+EXPECT "off" qr_stat cache_compression
+TEST read_files
+TEST read_files
+EXPECT "24" qr_stat total_files_cached
+EXPECT "$((24 * 32768))" qr_stat total_file_size
+EXPECT "$((24 * 32768))" qr_stat total_cache_used
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+TEST $CLI volume set $V0 performance.quick-read-cache-compression on
+
+# With it, the text files take a fraction of that, random ones don't
+# shrink and are kept as they are.
+TEST mount_volume
+EXPECT "on" qr_stat cache_compression
+TEST read_files
+hits=$(qr_stat cache-hit)
+TEST read_files
+TEST [ $(qr_stat cache-hit) -gt $hits ]
+EXPECT "24" qr_stat total_files_cached
+EXPECT "$((24 * 32768))" qr_stat total_file_size
+TEST [ $(qr_stat total_cache_used) -ge $((4 * 32768)) ]
+TEST [ $(qr_stat total_cache_used) -lt $((8 * 32768)) ]
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
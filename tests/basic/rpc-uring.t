@@ -0,0 +1,75 @@
+#!/bin/bash
+
+# With client.transport-engine and server.transport-engine set to uring,
+# established connections receive and send through io_uring instead of
+# epoll and readv/writev. Big and small requests must go through unchanged.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function volfile_option {
+        grep -h "option $2 " $GLUSTERD_WORKDIR/vols/$V0/$1 | \
+             awk '{print $3}' | sort -u
+}
+
+function brick_io_uring_fds {
+        local pid=$(get_brick_pid $V0 $H0 $B0/${V0}0)
+
+        ls -l /proc/$pid/fd 2>/dev/null | grep -c "io_uring"
+}
+
+function uring_used {
+        if grep -q "using io_uring to receive on socket" $1; then
+                echo "Y"
+        fi
+}
+
+cleanup;
+
+brick_log=$LOGDIR/bricks/$(echo $B0/${V0}0 | sed 's|^/||; s|/|-|g').log
+mount_log=$(mktemp)
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 client.transport-engine uring
+TEST $CLI volume set $V0 server.transport-engine uring
+TEST $CLI volume set $V0 diagnostics.brick-log-level DEBUG
+EXPECT "uring" volfile_option "$V0.$H0.*.vol" transport.socket.engine
+EXPECT "uring" volfile_option "$V0.tcp-fuse.vol" transport.socket.engine
+TEST ! $CLI volume set $V0 client.transport-engine kqueue
+
+TEST $CLI volume start $V0
+
+if [ $(brick_io_uring_fds) -eq 0 ]; then
+        # No io_uring in this kernel, connections keep using epoll.
+        SKIP_TESTS
+        rm -f $mount_log
+        cleanup
+        exit 0
+fi
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 --log-level=DEBUG \
+          --log-file=$mount_log $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "Y" uring_used $brick_log
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "Y" uring_used $mount_log
+
+# Requests and replies bigger than the staging buffer of a connection.
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=16
+TEST cp $B0/data $M0/file
+TEST drop_cache $M0
+TEST cmp $B0/data $M0/file
+
+# Many small requests in flight at once.
+TEST mkdir $M0/dir
+for i in {1..8}; do
+        (for j in {1..50}; do echo $i.$j > $M0/dir/f.$i.$j; done) &
+done
+wait
+EXPECT "400" echo $(ls $M0/dir | wc -l)
+EXPECT "8.50" cat $M0/dir/f.8.50
+
+rm -f $B0/data $mount_log
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,79 @@
+#!/bin/bash
+
+# Requests of a client are read in batches of server.transport-read-batch
+# records, and server.outstanding-rpc-adaptive shrinks the window of a
+# client whose requests wait to be dispatched.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_volfile_option {
+        grep -h "option $1 " $GLUSTERD_WORKDIR/vols/$V0/$V0.$H0.*.vol | \
+             awk '{print $3}'
+}
+
+# Smallest window of the connections of the brick.
+function brick_rpc_window {
+        local dump=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+
+        grep -E "^server\.conn\.[0-9]+\.rpc-window=" $dump | cut -d= -f2 | \
+             sort -n | head -1
+        rm -f $dump
+}
+
+# Parallel synchronous writes queue up behind each other in the brick.
+function write_load {
+        local pids=""
+
+        for i in {1..16}; do
+                dd if=/dev/zero of=$M0/$1.$i bs=4k count=40 oflag=sync \
+                   2>/dev/null &
+                pids="$pids $!"
+        done
+        wait $pids
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 server.outstanding-rpc-limit 64
+TEST $CLI volume set $V0 server.outstanding-rpc-adaptive off
+TEST $CLI volume set $V0 server.transport-read-batch 1
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.iot-pass-through on
+TEST $CLI volume set $V0 delay-gen posix
+TEST $CLI volume set $V0 delay-gen.delay-duration 20000
+TEST $CLI volume set $V0 delay-gen.delay-percentage 100
+TEST $CLI volume set $V0 delay-gen.enable write,fsync
+
+EXPECT "off" brick_volfile_option rpc.outstanding-rpc-adaptive
+EXPECT "1" brick_volfile_option transport.socket.read-batch
+
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+# A fixed window stays at the limit whatever the delays.
+TEST write_load fixed
+EXPECT "64" brick_rpc_window
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume set $V0 server.outstanding-rpc-adaptive on
+TEST $CLI volume set $V0 server.transport-read-batch 64
+EXPECT "on" brick_volfile_option rpc.outstanding-rpc-adaptive
+EXPECT "64" brick_volfile_option transport.socket.read-batch
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+# Requests waiting behind the delayed writes shrink the window.
+TEST write_load adaptive
+TEST [ $(brick_rpc_window) -lt 64 ]
+TEST [ $(brick_rpc_window) -ge 8 ]
+EXPECT "1" eval "md5sum $M0/fixed.* $M0/adaptive.* | awk '{print \$1}' | \
+                sort -u | wc -l"
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
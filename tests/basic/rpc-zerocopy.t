@@ -0,0 +1,74 @@
+#!/bin/bash
+
+# With server.transport-zerocopy on, bricks send big read replies with
+# MSG_ZEROCOPY. Each send is counted in the statedump of the brick, and
+# its buffers are kept until the kernel reports it complete. On loopback
+# the kernel copies the data anyway, and the connection goes back to
+# normal sends after the first completions.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_volfile_option {
+        grep -h "option $1 " $GLUSTERD_WORKDIR/vols/$V0/$V0.$H0.*.vol | \
+             awk '{print $3}'
+}
+
+# Sum of a zero-copy counter over the connections of the brick.
+function brick_zerocopy {
+        local dump=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+
+        grep -E "^server\.conn\.[0-9]+\.zerocopy-$1=" $dump | cut -d= -f2 | \
+             awk '{ sum += $1 } END { print sum + 0 }'
+        rm -f $dump
+}
+
+function zerocopy_completed {
+        if [ $(brick_zerocopy completed) -gt 0 ]; then
+                echo "Y"
+        fi
+}
+
+function read_file {
+        drop_cache $M0
+        dd if=$M0/file of=/dev/null bs=128k iflag=direct 2>/dev/null
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=8
+TEST cp $B0/data $M0/file
+
+# Replies are copied while the option is off.
+TEST read_file
+EXPECT "0" brick_zerocopy sent
+EXPECT "0" brick_zerocopy fallback
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume set $V0 server.transport-zerocopy on
+EXPECT "on" brick_volfile_option transport.socket.zerocopy
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+TEST read_file
+TEST [ $(brick_zerocopy sent) -gt 0 ]
+TEST drop_cache $M0
+TEST cmp $B0/data $M0/file
+
+# The kernel reports the sends complete, their buffers are released.
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" zerocopy_completed
+
+rm -f $B0/data
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
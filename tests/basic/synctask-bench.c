@@ -0,0 +1,234 @@
+/*
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * Micro-benchmark of synctask creation and switching.
+ *
+ *   gcc -O2 -o synctask-bench synctask-bench.c -lglusterfs -lpthread
+ *   ./synctask-bench [tasks [switches]]
+ *
+ * It measures:
+ *  - create: spawning a synctask that returns at once, up to its callback
+ *  - switch: one synctask_yield() of a task that woke itself, i.e. a
+ *            switch to the scheduler and back
+ *
+ * Both are also timed for a hand-rolled equivalent made of calloc()ed
+ * stacks and getcontext()/makecontext()/swapcontext(), which is how
+ * synctasks were run before stacks were pooled and switched by hand.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+#include <glusterfs/glusterfs.h>
+#include <glusterfs/globals.h>
+#include <glusterfs/syncop.h>
+
+#define BENCH_TASKS 100000
+#define BENCH_SWITCHES 1000000
+
+static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bench_cond = PTHREAD_COND_INITIALIZER;
+static int bench_pending;
+static int bench_switches;
+
+static uint64_t
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int
+bench_nop(void *opaque)
+{
+    return 0;
+}
+
+static int
+bench_done(int ret, call_frame_t *frame, void *opaque)
+{
+    pthread_mutex_lock(&bench_mutex);
+    if (--bench_pending == 0)
+        pthread_cond_signal(&bench_cond);
+    pthread_mutex_unlock(&bench_mutex);
+
+    return 0;
+}
+
+static int
+bench_yield(void *opaque)
+{
+    struct synctask *task = synctask_get();
+    int i;
+
+    for (i = 0; i < bench_switches; i++) {
+        synctask_wake(task);
+        synctask_yield(task, NULL);
+    }
+
+    return 0;
+}
+
+static double
+bench_synctask_create(struct syncenv *env, call_frame_t *frame, int count)
+{
+    uint64_t start;
+    int i;
+
+    bench_pending = count;
+
+    start = bench_now();
+    for (i = 0; i < count; i++) {
+        if (synctask_new(env, bench_nop, bench_done, frame, NULL) != 0) {
+            fprintf(stderr, "synctask_new failed\n");
+            exit(1);
+        }
+    }
+
+    pthread_mutex_lock(&bench_mutex);
+    while (bench_pending > 0)
+        pthread_cond_wait(&bench_cond, &bench_mutex);
+    pthread_mutex_unlock(&bench_mutex);
+
+    return (double)(bench_now() - start) / count;
+}
+
+static double
+bench_synctask_switch(struct syncenv *env, call_frame_t *frame, int count)
+{
+    uint64_t start;
+
+    bench_switches = count;
+
+    start = bench_now();
+    if (synctask_new(env, bench_yield, NULL, frame, NULL) != 0) {
+        fprintf(stderr, "synctask_new failed\n");
+        exit(1);
+    }
+
+    return (double)(bench_now() - start) / count;
+}
+
+static ucontext_t ref_main;
+static ucontext_t ref_task;
+
+static void
+ref_nop(void)
+{
+}
+
+static void
+ref_yield(void)
+{
+    int i;
+
+    for (i = 0; i < bench_switches; i++)
+        swapcontext(&ref_task, &ref_main);
+}
+
+static double
+bench_ucontext_create(int count)
+{
+    uint64_t start;
+    void *stack;
+    int i;
+
+    start = bench_now();
+    for (i = 0; i < count; i++) {
+        stack = calloc(1, SYNCENV_DEFAULT_STACKSIZE);
+        getcontext(&ref_task);
+        ref_task.uc_stack.ss_sp = stack;
+        ref_task.uc_stack.ss_size = SYNCENV_DEFAULT_STACKSIZE;
+        ref_task.uc_link = &ref_main;
+        makecontext(&ref_task, ref_nop, 0);
+        swapcontext(&ref_main, &ref_task);
+        free(stack);
+    }
+
+    return (double)(bench_now() - start) / count;
+}
+
+static double
+bench_ucontext_switch(int count)
+{
+    uint64_t start;
+    void *stack;
+    int i;
+
+    bench_switches = count;
+    stack = calloc(1, SYNCENV_DEFAULT_STACKSIZE);
+    getcontext(&ref_task);
+    ref_task.uc_stack.ss_sp = stack;
+    ref_task.uc_stack.ss_size = SYNCENV_DEFAULT_STACKSIZE;
+    ref_task.uc_link = &ref_main;
+    makecontext(&ref_task, ref_yield, 0);
+
+    start = bench_now();
+    for (i = 0; i <= count; i++)
+        swapcontext(&ref_main, &ref_task);
+    start = bench_now() - start;
+
+    free(stack);
+
+    return (double)start / count;
+}
+
+int
+main(int argc, char *argv[])
+{
+    glusterfs_ctx_t *ctx = NULL;
+    struct syncenv *env = NULL;
+    call_stack_t root = {
+        0,
+    };
+    call_frame_t frame = {
+        0,
+    };
+    int tasks = BENCH_TASKS;
+    int switches = BENCH_SWITCHES;
+
+    if (argc > 1)
+        tasks = atoi(argv[1]);
+    if (argc > 2)
+        switches = atoi(argv[2]);
+    if ((tasks <= 0) || (switches <= 0)) {
+        fprintf(stderr, "usage: %s [tasks [switches]]\n", argv[0]);
+        return 1;
+    }
+
+    ctx = glusterfs_ctx_new();
+    if (!ctx || glusterfs_globals_init(ctx))
+        return 1;
+    THIS->ctx = ctx;
+
+    /* One processor, so that switches are not spread over threads. */
+    env = syncenv_new(0, 1, 1);
+    if (!env)
+        return 1;
+
+    frame.root = &root;
+    frame.this = THIS;
+
+    printf("%-10s %14s %14s\n", "", "synctask", "ucontext");
+    printf("%-10s %11.1f ns %11.1f ns\n", "create",
+           bench_synctask_create(env, &frame, tasks),
+           bench_ucontext_create(tasks));
+    printf("%-10s %11.1f ns %11.1f ns\n", "switch",
+           bench_synctask_switch(env, &frame, switches),
+           bench_ucontext_switch(switches));
+
+    syncenv_destroy(env);
+
+    return 0;
+}
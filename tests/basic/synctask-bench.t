@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# Synctasks are created on pooled stacks and switched without the signal
+# mask system calls of ucontext. Both must be cheaper than the calloc()ed
+# stacks and swapcontext() synctasks were built on before.
+
+. $(dirname $0)/../include.rc
+
+function bench_faster {
+        awk -v op=$1 '$1 == op { if ($2 < $4) print "Y"; else print "N" }' \
+            $benchout
+}
+
+cleanup;
+
+benchout=$(mktemp)
+
+TEST build_tester $(dirname $0)/synctask-bench.c -lglusterfs -lpthread
+$(dirname $0)/synctask-bench 20000 200000 > $benchout
+TEST [ $? -eq 0 ]
+cat $benchout
+
+EXPECT "Y" bench_faster create
+EXPECT "Y" bench_faster switch
+
+rm -f $benchout
+cleanup_tester $(dirname $0)/synctask-bench
+
+cleanup;
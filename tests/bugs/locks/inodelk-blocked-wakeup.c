@@ -0,0 +1,283 @@
+/*
+ * Checks the wakeup of inodelks that are blocked by the starvation rule.
+ *
+ *   A holds [0, 10]
+ *   B waits for [5, 20] on A
+ *   C waits for [15, 30] on B, which has been queued before
+ *
+ * When A unlocks, B is granted and C must keep waiting, now on the granted
+ * B. C is granted once B unlocks.
+ *
+ * Then the same queue is built again, with B taken by another process.
+ * When that process dies, B leaves the queue without being granted, and C
+ * must be granted while A is still held.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include <glusterfs/api/glfs.h>
+#include <glusterfs/api/glfs-handles.h>
+#include <glusterfs/xlator.h>
+#include <glusterfs/syncop.h>
+
+#define DOMAIN "blocked-wakeup"
+
+/* Private gfapi symbol. */
+xlator_t *
+glfs_active_subvol(glfs_t *fs);
+
+struct waiter {
+    pthread_t thread;
+    xlator_t *subvol;
+    loc_t *loc;
+    uint64_t owner;
+    off_t start;
+    off_t len;
+    int ret;
+    int done;
+};
+
+static int
+take_lock(xlator_t *subvol, loc_t *loc, uint64_t owner, int cmd, short type,
+          off_t start, off_t len)
+{
+    struct gf_flock flock = {
+        0,
+    };
+    gf_lkowner_t lkowner;
+
+    set_lk_owner_from_uint64(&lkowner, owner);
+    syncopctx_setfslkowner(&lkowner);
+
+    flock.l_type = type;
+    flock.l_whence = SEEK_SET;
+    flock.l_start = start;
+    flock.l_len = len;
+
+    return syncop_inodelk(subvol, DOMAIN, loc, cmd, &flock, NULL, NULL);
+}
+
+static void *
+waiter_run(void *data)
+{
+    struct waiter *w = data;
+
+    THIS = w->subvol;
+
+    w->ret = take_lock(w->subvol, w->loc, w->owner, F_SETLKW, F_WRLCK,
+                       w->start, w->len);
+    __atomic_store_n(&w->done, 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+static void
+waiter_start(struct waiter *w, xlator_t *subvol, loc_t *loc)
+{
+    w->subvol = subvol;
+    w->loc = loc;
+    w->ret = -1;
+    w->done = 0;
+
+    pthread_create(&w->thread, NULL, waiter_run, w);
+}
+
+static int
+waiter_done(struct waiter *w, int seconds)
+{
+    while (seconds-- > 0) {
+        if (__atomic_load_n(&w->done, __ATOMIC_ACQUIRE))
+            return 1;
+        sleep(1);
+    }
+
+    return __atomic_load_n(&w->done, __ATOMIC_ACQUIRE);
+}
+
+static glfs_t *
+file_open(const char *volfile, const char *logfile, loc_t *loc)
+{
+    glfs_t *fs = NULL;
+    glfs_fd_t *fd = NULL;
+    struct glfs_object *obj = NULL;
+    xlator_t *subvol = NULL;
+    struct stat st;
+
+    fs = glfs_new("inodelk-blocked-wakeup");
+    if (!fs || glfs_set_volfile(fs, volfile) ||
+        glfs_set_logging(fs, logfile, 7) || glfs_init(fs)) {
+        fprintf(stderr, "glfs initialization failed\n");
+        return NULL;
+    }
+
+    fd = glfs_creat(fs, "/file", O_RDWR, 0644);
+    if (!fd) {
+        fprintf(stderr, "glfs_creat failed\n");
+        return NULL;
+    }
+    glfs_close(fd);
+
+    obj = glfs_h_lookupat(fs, NULL, "/file", &st, 0);
+    if (!obj) {
+        fprintf(stderr, "glfs_h_lookupat failed\n");
+        return NULL;
+    }
+
+    subvol = glfs_active_subvol(fs);
+    THIS = subvol;
+
+    loc->inode = inode_new(subvol->itable);
+    glfs_h_extract_handle(obj, loc->gfid, GFAPI_HANDLE_LENGTH);
+
+    return fs;
+}
+
+/* Takes B from its own connection and waits to be killed. */
+static int
+run_b(const char *volfile, const char *logfile)
+{
+    loc_t loc = {
+        0,
+    };
+    glfs_t *fs = NULL;
+
+    fs = file_open(volfile, logfile, &loc);
+    if (!fs)
+        return 1;
+
+    take_lock(glfs_active_subvol(fs), &loc, 2, F_SETLKW, F_WRLCK, 5, 16);
+
+    for (;;)
+        pause();
+
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    glfs_t *fs = NULL;
+    xlator_t *subvol = NULL;
+    loc_t loc = {
+        0,
+    };
+    struct waiter b = {
+        .owner = 2,
+        .start = 5,
+        .len = 16,
+    };
+    struct waiter c = {
+        .owner = 3,
+        .start = 15,
+        .len = 16,
+    };
+    pid_t pid = 0;
+
+    if (argc == 4 && strcmp(argv[3], "b") == 0)
+        return run_b(argv[1], argv[2]);
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <volfile> <logfile>\n", argv[0]);
+        return 1;
+    }
+
+    fs = file_open(argv[1], argv[2], &loc);
+    if (!fs)
+        return 1;
+    subvol = glfs_active_subvol(fs);
+
+    /* B is granted when A unlocks, C when B unlocks. */
+    if (take_lock(subvol, &loc, 1, F_SETLK, F_WRLCK, 0, 11) != 0) {
+        fprintf(stderr, "A: lock failed\n");
+        return 1;
+    }
+
+    waiter_start(&b, subvol, &loc);
+    sleep(2);
+    waiter_start(&c, subvol, &loc);
+    sleep(2);
+
+    if (b.done || c.done) {
+        fprintf(stderr, "waiters have not been blocked\n");
+        return 1;
+    }
+
+    if (take_lock(subvol, &loc, 1, F_SETLK, F_UNLCK, 0, 11) != 0) {
+        fprintf(stderr, "A: unlock failed\n");
+        return 1;
+    }
+
+    if (!waiter_done(&b, 10) || (b.ret != 0)) {
+        fprintf(stderr, "B has not been granted\n");
+        return 1;
+    }
+
+    if (waiter_done(&c, 3)) {
+        fprintf(stderr, "C has been granted while B is held\n");
+        return 1;
+    }
+
+    if (take_lock(subvol, &loc, 2, F_SETLK, F_UNLCK, 5, 16) != 0) {
+        fprintf(stderr, "B: unlock failed\n");
+        return 1;
+    }
+
+    if (!waiter_done(&c, 10) || (c.ret != 0)) {
+        fprintf(stderr, "C has not been granted\n");
+        return 1;
+    }
+
+    pthread_join(b.thread, NULL);
+    pthread_join(c.thread, NULL);
+
+    if (take_lock(subvol, &loc, 3, F_SETLK, F_UNLCK, 15, 16) != 0) {
+        fprintf(stderr, "C: unlock failed\n");
+        return 1;
+    }
+
+    /* C is granted when B goes away, while A is still held. */
+    if (take_lock(subvol, &loc, 1, F_SETLK, F_WRLCK, 0, 11) != 0) {
+        fprintf(stderr, "A: lock failed\n");
+        return 1;
+    }
+
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "fork failed\n");
+        return 1;
+    }
+    if (pid == 0) {
+        execl(argv[0], argv[0], argv[1], argv[2], "b", NULL);
+        _exit(1);
+    }
+
+    /* Leave time for the other process to connect and queue B. */
+    sleep(5);
+    waiter_start(&c, subvol, &loc);
+    sleep(2);
+
+    if (c.done) {
+        fprintf(stderr, "C has not been blocked\n");
+        return 1;
+    }
+
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+
+    if (!waiter_done(&c, 10) || (c.ret != 0)) {
+        fprintf(stderr, "C has not been granted after B went away\n");
+        return 1;
+    }
+
+    printf("OK\n");
+
+    /* The locks are released when the connection is closed. */
+    return 0;
+}
@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# An inodelk blocked behind a queued lock must keep waiting once that lock
+# is granted, and must be granted when it leaves the queue without being
+# granted, e.g. when its client disconnects.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/brick0
+TEST $CLI volume start $V0
+
+logdir=`gluster --print-logdir`
+volfile=$(dirname $0)/inodelk-blocked-wakeup.vol
+
+cat > $volfile <<EOF2
+volume client
+    type protocol/client
+    option remote-host $H0
+    option remote-subvolume $B0/brick0
+    option transport-type socket
+end-volume
+EOF2
+
+TEST build_tester $(dirname $0)/inodelk-blocked-wakeup.c -lgfapi -lglusterfs \
+                  -lpthread
+EXPECT "OK" $(dirname $0)/inodelk-blocked-wakeup $volfile \
+                                      $logdir/inodelk-blocked-wakeup.log
+
+cleanup_tester $(dirname $0)/inodelk-blocked-wakeup
+cleanup_tester $volfile
+
+cleanup;
@@ -2246,6 +2246,117 @@ afr_least_latency_times_pending_reads_child(afr_private_t *priv,
     return child;
 }
 
+static gf_boolean_t
+afr_read_child_is_ejected(afr_private_t *priv, int child)
+{
+    gf_boolean_t ejected = _gf_false;
+
+    if (priv->read_ejected_child != child)
+        return _gf_false;
+
+    LOCK(&priv->lock);
+    {
+        if (priv->read_ejected_child == child) {
+            if (gf_time() < priv->read_ejected_until) {
+                ejected = _gf_true;
+            } else {
+                priv->read_ejected_child = -1;
+            }
+        }
+    }
+    UNLOCK(&priv->lock);
+
+    if (!ejected) {
+        /* Measure it again from scratch once it is back */
+        LOCK(&priv->read_stats[child].lock);
+        {
+            priv->read_stats[child].samples = 0;
+            priv->read_stats[child].ewma = 0;
+        }
+        UNLOCK(&priv->read_stats[child].lock);
+    }
+
+    return ejected;
+}
+
+/* A child without samples yet is assumed to be as fast as 'prior', so it
+ * gets measured, while the reads it already has in flight keep all of them
+ * from going to it before the first one completes. */
+static int64_t
+afr_read_child_score(afr_private_t *priv, int child, int64_t prior)
+{
+    int64_t pending_read = 0;
+    int64_t ewma = prior;
+
+    if (priv->read_stats[child].samples)
+        ewma = priv->read_stats[child].ewma;
+
+    pending_read = GF_ATOMIC_GET(priv->pending_reads[child]);
+
+    return (pending_read + 1) * (ewma + 1);
+}
+
+/* Picks two readable children at random and returns the one with the lower
+ * score, ie the expected service time of a new read given the reads it
+ * already has in flight. Comparing only two random children instead of
+ * looking for the best one keeps all the clients from rushing to the same
+ * brick each time its score improves. */
+static int
+afr_adaptive_latency_child(afr_private_t *priv, unsigned char *readable)
+{
+    int candidates[priv->child_count];
+    int64_t prior = -1;
+    int count = 0;
+    int first = 0;
+    int second = 0;
+    int i = 0;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (AFR_IS_ARBITER_BRICK(priv, i) || !readable[i])
+            continue;
+        candidates[count++] = i;
+    }
+
+    if (count > 1) {
+        /* Drop the ejected child, if any, while there are others */
+        for (i = 0; i < count; i++) {
+            if (afr_read_child_is_ejected(priv, candidates[i])) {
+                candidates[i] = candidates[--count];
+                break;
+            }
+        }
+    }
+
+    if (count == 0)
+        return -1;
+    if (count == 1)
+        return candidates[0];
+
+    first = random() % count;
+    second = random() % (count - 1);
+    if (second >= first)
+        second++;
+
+    first = candidates[first];
+    second = candidates[second];
+
+    /* The fastest measured child is the prior of the unmeasured ones. */
+    for (i = 0; i < count; i++) {
+        if (!priv->read_stats[candidates[i]].samples)
+            continue;
+        if ((prior < 0) || (priv->read_stats[candidates[i]].ewma < prior))
+            prior = priv->read_stats[candidates[i]].ewma;
+    }
+    if (prior < 0)
+        prior = 0;
+
+    if (afr_read_child_score(priv, second, prior) <
+        afr_read_child_score(priv, first, prior))
+        return second;
+
+    return first;
+}
+
 static int
 afr_hash_child(afr_read_subvol_args_t *args, afr_private_t *priv,
                unsigned char *readable)
@@ -2292,6 +2403,9 @@ afr_hash_child(afr_read_subvol_args_t *args, afr_private_t *priv,
         case AFR_READ_POLICY_LOAD_LATENCY_HYBRID:
             child = afr_least_latency_times_pending_reads_child(priv, readable);
             break;
+        case AFR_READ_POLICY_ADAPTIVE_LATENCY:
+            child = afr_adaptive_latency_child(priv, readable);
+            break;
     }
 
     return child;
@@ -5642,6 +5756,12 @@ afr_priv_dump(xlator_t *this)
                            GF_ATOMIC_GET(priv->pending_reads[i]));
         sprintf(key, "child_latency[%d]", i);
         gf_proc_dump_write(key, "%" PRId64, priv->child_latency[i]);
+        sprintf(key, "read_latency_usec[%d]", i);
+        gf_proc_dump_write(key, "%" PRId64, priv->read_stats[i].ewma);
+        sprintf(key, "read_latency_samples[%d]", i);
+        gf_proc_dump_write(key, "%" PRIu64, priv->read_stats[i].samples);
+        sprintf(key, "read_ejections[%d]", i);
+        gf_proc_dump_write(key, "%" PRIu64, priv->read_stats[i].ejections);
         sprintf(key, "halo_child_up[%d]", i);
         gf_proc_dump_write(key, "%d", priv->halo_child_up[i]);
     }
@@ -5656,6 +5776,13 @@ afr_priv_dump(xlator_t *this)
                        priv->background_self_heal_count);
     gf_proc_dump_write("healers", "%d", priv->healers);
     gf_proc_dump_write("read-hash-mode", "%d", priv->hash_mode);
+    gf_proc_dump_write("read-ejected-child", "%d", priv->read_ejected_child);
+    gf_proc_dump_write("read-hedge-percentile", "%u",
+                       priv->read_hedge_percentile);
+    gf_proc_dump_write("read-hedges-sent", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(priv->read_hedges_sent));
+    gf_proc_dump_write("read-hedges-won", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(priv->read_hedges_won));
     gf_proc_dump_write("use-anonymous-inode", "%d", priv->use_anon_inode);
     if (priv->quorum_count == AFR_QUORUM_AUTO) {
         gf_proc_dump_write("quorum-type", "auto");
@@ -6641,6 +6768,11 @@ afr_priv_destroy(afr_private_t *priv)
     }
 
     GF_FREE(priv->pending_reads);
+    if (priv->read_stats) {
+        for (i = 0; i < priv->child_count; i++)
+            LOCK_DESTROY(&priv->read_stats[i].lock);
+        GF_FREE(priv->read_stats);
+    }
     GF_FREE(priv->local);
     GF_FREE(priv->pending_key);
     GF_FREE(priv->children);
@@ -1724,6 +1724,263 @@ afr_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     return 0;
 }
 
+/* A readv that may also be sent to a second child if the first one takes
+ * longer than most recent reads. Each read is wound from its own copy of
+ * the frame, so that the one that loses can still be answered after the
+ * readv has been unwound. */
+typedef struct afr_read_hedge {
+    call_frame_t *frame; /* readv to answer, NULL once answered */
+    xlator_t *this;
+    gf_lock_t lock;
+    gf_timer_t *timer;
+    fd_t *fd;
+    dict_t *xdata;
+    size_t size;
+    off_t offset;
+    uint32_t flags;
+    struct timespec start[2];
+    int subvol[2];
+    int legs;   /* reads wound */
+    int failed; /* reads that failed */
+    int refs;
+    gf_boolean_t timed; /* read latencies are accounted */
+} afr_read_hedge_t;
+
+static void
+afr_read_hedge_unref(afr_read_hedge_t *hedge)
+{
+    int refs = 0;
+
+    LOCK(&hedge->lock);
+    {
+        refs = --hedge->refs;
+    }
+    UNLOCK(&hedge->lock);
+
+    if (refs)
+        return;
+
+    fd_unref(hedge->fd);
+    if (hedge->xdata)
+        dict_unref(hedge->xdata);
+    LOCK_DESTROY(&hedge->lock);
+    GF_FREE(hedge);
+}
+
+static int
+afr_readv_hedge_cbk(call_frame_t *leg_frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                    int32_t count, struct iatt *buf, struct iobref *iobref,
+                    dict_t *xdata)
+{
+    afr_read_hedge_t *hedge = NULL;
+    afr_private_t *priv = NULL;
+    afr_local_t *local = NULL;
+    call_frame_t *frame = NULL;
+    gf_timer_t *timer = NULL;
+    struct timespec now;
+    int leg = (long)cookie;
+
+    hedge = leg_frame->local;
+    leg_frame->local = NULL;
+    priv = this->private;
+
+    timespec_now(&now);
+    gf_latency_hist_add(&priv->read_hist,
+                        gf_tsdiff(&hedge->start[leg], &now) / 1000);
+    if (hedge->timed)
+        afr_read_latency_add(this, hedge->subvol[leg], &hedge->start[leg]);
+    afr_pending_read_decrement(priv, hedge->subvol[leg]);
+
+    LOCK(&hedge->lock);
+    {
+        /* The first good answer wins. Errors are only reported once no
+         * other read can answer. */
+        if (hedge->frame &&
+            ((op_ret >= 0) || (++hedge->failed == hedge->legs))) {
+            frame = hedge->frame;
+            hedge->frame = NULL;
+            timer = hedge->timer;
+            hedge->timer = NULL;
+        }
+    }
+    UNLOCK(&hedge->lock);
+
+    if (timer && (gf_timer_call_cancel(this->ctx, timer) == 0))
+        afr_read_hedge_unref(hedge);
+
+    if (frame) {
+        local = frame->local;
+        if (op_ret < 0) {
+            local->op_ret = -1;
+            local->op_errno = op_errno;
+
+            afr_read_txn_continue(frame, this, hedge->subvol[leg]);
+        } else {
+            if (leg > 0)
+                GF_ATOMIC_INC(priv->read_hedges_won);
+
+            AFR_STACK_UNWIND(readv, frame, op_ret, op_errno, vector, count,
+                             buf, iobref, xdata);
+        }
+    }
+
+    STACK_DESTROY(leg_frame->root);
+    afr_read_hedge_unref(hedge);
+
+    return 0;
+}
+
+static void
+afr_read_hedge_wind(afr_read_hedge_t *hedge, call_frame_t *leg_frame, int leg)
+{
+    afr_private_t *priv = hedge->this->private;
+    int subvol = hedge->subvol[leg];
+
+    /* The first read was counted when the read txn wound it */
+    if (leg > 0)
+        afr_pending_read_increment(priv, subvol);
+    timespec_now(&hedge->start[leg]);
+
+    STACK_WIND_COOKIE(leg_frame, afr_readv_hedge_cbk, (void *)(long)leg,
+                      priv->children[subvol],
+                      priv->children[subvol]->fops->readv, hedge->fd,
+                      hedge->size, hedge->offset, hedge->flags, hedge->xdata);
+}
+
+/* The readable child, other than the one already read from, with the least
+ * reads in flight */
+static int
+afr_read_hedge_subvol(afr_private_t *priv, afr_local_t *local, int first)
+{
+    int64_t pending = 0;
+    int64_t least = 0;
+    int subvol = -1;
+    int i = 0;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if ((i == first) || !local->readable[i] || !priv->child_up[i] ||
+            local->read_attempted[i] || AFR_IS_ARBITER_BRICK(priv, i))
+            continue;
+
+        pending = GF_ATOMIC_GET(priv->pending_reads[i]);
+        if ((subvol < 0) || (pending < least)) {
+            least = pending;
+            subvol = i;
+        }
+    }
+
+    return subvol;
+}
+
+static void
+afr_read_hedge_timeout(void *data)
+{
+    afr_read_hedge_t *hedge = data;
+    afr_private_t *priv = NULL;
+    afr_local_t *local = NULL;
+    call_frame_t *leg_frame = NULL;
+    int subvol = -1;
+
+    priv = hedge->this->private;
+
+    LOCK(&hedge->lock);
+    {
+        hedge->timer = NULL;
+        /* The readv can't be unwound while the lock is held */
+        if (hedge->frame && (hedge->legs == 1)) {
+            local = hedge->frame->local;
+            subvol = afr_read_hedge_subvol(priv, local, hedge->subvol[0]);
+            if (subvol >= 0)
+                leg_frame = copy_frame(hedge->frame);
+            if (leg_frame) {
+                local->read_attempted[subvol] = 1;
+                hedge->subvol[1] = subvol;
+                hedge->legs++;
+                hedge->refs++;
+                leg_frame->local = hedge;
+            }
+        }
+    }
+    UNLOCK(&hedge->lock);
+
+    if (leg_frame) {
+        GF_ATOMIC_INC(priv->read_hedges_sent);
+        afr_read_hedge_wind(hedge, leg_frame, 1);
+    }
+
+    afr_read_hedge_unref(hedge);
+}
+
+static int
+afr_readv_hedged_wind(call_frame_t *frame, xlator_t *this, int subvol)
+{
+    afr_read_hedge_t *hedge = NULL;
+    afr_local_t *local = NULL;
+    afr_private_t *priv = NULL;
+    call_frame_t *leg_frame = NULL;
+    struct timespec delay = {
+        0,
+    };
+    uint64_t usecs = 0;
+
+    local = frame->local;
+    priv = this->private;
+
+    hedge = GF_CALLOC(1, sizeof(*hedge), gf_afr_mt_read_hedge_t);
+    if (!hedge)
+        return -1;
+
+    leg_frame = copy_frame(frame);
+    if (!leg_frame) {
+        GF_FREE(hedge);
+        return -1;
+    }
+
+    LOCK_INIT(&hedge->lock);
+    hedge->frame = frame;
+    hedge->this = this;
+    hedge->fd = fd_ref(local->fd);
+    if (local->xdata_req)
+        hedge->xdata = dict_ref(local->xdata_req);
+    hedge->size = local->cont.readv.size;
+    hedge->offset = local->cont.readv.offset;
+    hedge->flags = local->cont.readv.flags;
+    hedge->subvol[0] = subvol;
+    hedge->legs = 1;
+    hedge->refs = 1;
+    leg_frame->local = hedge;
+
+    /* Each read is accounted when it returns, not when the readv is
+     * unwound: the read that answers is not always the one to
+     * local->read_subvol, and the other one may still be in flight. */
+    hedge->timed = (local->read_start.tv_sec || local->read_start.tv_nsec);
+    local->read_start.tv_sec = 0;
+    local->read_start.tv_nsec = 0;
+    local->read_subvol = -1;
+
+    usecs = gf_latency_hist_percentile(&priv->read_hist,
+                                       priv->read_hedge_percentile);
+    if (usecs && (AFR_COUNT(local->readable, priv->child_count) > 1)) {
+        delay.tv_sec = usecs / 1000000;
+        delay.tv_nsec = (usecs % 1000000) * 1000;
+
+        /* Keep the timer from firing before it's known */
+        LOCK(&hedge->lock);
+        {
+            hedge->timer = gf_timer_call_after(this->ctx, delay,
+                                               afr_read_hedge_timeout, hedge);
+            if (hedge->timer)
+                hedge->refs++;
+        }
+        UNLOCK(&hedge->lock);
+    }
+
+    afr_read_hedge_wind(hedge, leg_frame, 0);
+
+    return 0;
+}
+
 static int
 afr_readv_wind(call_frame_t *frame, xlator_t *this, int subvol)
 {
@@ -1739,6 +1996,10 @@ afr_readv_wind(call_frame_t *frame, xlator_t *this, int subvol)
         return 0;
     }
 
+    if (priv->read_hedge_percentile &&
+        (afr_readv_hedged_wind(frame, this, subvol) == 0))
+        return 0;
+
     STACK_WIND_COOKIE(
         frame, afr_readv_cbk, (void *)(long)subvol, priv->children[subvol],
         priv->children[subvol]->fops->readv, local->fd, local->cont.readv.size,
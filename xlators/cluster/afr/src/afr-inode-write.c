@@ -351,6 +351,8 @@ afr_writev_wind_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     int child_index = (long)cookie;
     int call_count;
 
+    afr_compound_pre_op_check(frame, this, child_index, op_ret, xdata);
+
     call_count = afr_inode_write_fill(frame, this, child_index, op_ret,
                                       op_errno, prebuf, postbuf, xdata);
 
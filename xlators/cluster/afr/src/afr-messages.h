@@ -63,7 +63,8 @@ GLFS_MSGID(
     AFR_MSG_LK_HEAL_DOM, AFR_MSG_NEW_BRICK, AFR_MSG_SPLIT_BRAIN_SET_FAILED,
     AFR_MSG_SPLIT_BRAIN_DETERMINE_FAILED, AFR_MSG_HEALER_SPAWN_FAILED,
     AFR_MSG_ADD_CRAWL_EVENT_FAILED, AFR_MSG_NULL_DEREF, AFR_MSG_SET_PEND_XATTR,
-    AFR_MSG_INTERNAL_ATTR);
+    AFR_MSG_INTERNAL_ATTR, AFR_MSG_READ_CHILD_EJECTED,
+    AFR_MSG_COMPOUND_FOP_UNSUPPORTED);
 
 #define AFR_MSG_DICT_GET_FAILED_STR "Dict get failed"
 #define AFR_MSG_DICT_SET_FAILED_STR "Dict set failed"
@@ -29,6 +29,115 @@ afr_pending_read_decrement(afr_private_t *priv, int child_index)
     GF_ATOMIC_DEC(priv->pending_reads[child_index]);
 }
 
+/* Ejects 'child' from read selection for a while if its read latency is
+ * an outlier compared to the fastest other child. Only one child is
+ * ejected at a time, so that a replica never loses more than one source
+ * for reads this way. */
+static void
+afr_read_outlier_check(xlator_t *this, int child, int64_t ewma)
+{
+    afr_private_t *priv = NULL;
+    afr_read_stats_t *stats = NULL;
+    int64_t best = -1;
+    int i = 0;
+
+    priv = this->private;
+
+    if (priv->read_ejected_child >= 0) {
+        return;
+    }
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (i == child || !priv->child_up[i] || AFR_IS_ARBITER_BRICK(priv, i))
+            continue;
+
+        stats = &priv->read_stats[i];
+        if (stats->samples < AFR_READ_OUTLIER_MIN_SAMPLES)
+            continue;
+
+        if (best < 0 || stats->ewma < best)
+            best = stats->ewma;
+    }
+
+    if ((best < 0) || (ewma < AFR_READ_OUTLIER_MIN_USEC) ||
+        (ewma <= best * priv->read_outlier_factor)) {
+        return;
+    }
+
+    LOCK(&priv->lock);
+    {
+        if (priv->read_ejected_child < 0) {
+            priv->read_ejected_child = child;
+            priv->read_ejected_until = gf_time() +
+                                       priv->read_outlier_eject_time;
+            priv->read_stats[child].ejections++;
+        } else {
+            child = -1;
+        }
+    }
+    UNLOCK(&priv->lock);
+
+    if (child >= 0) {
+        gf_msg(this->name, GF_LOG_INFO, 0, AFR_MSG_READ_CHILD_EJECTED,
+               "Not reading from %s for %u seconds, its read latency "
+               "(%" PRId64 " usecs) is too high compared to %" PRId64
+               " usecs",
+               priv->children[child]->name, priv->read_outlier_eject_time,
+               ewma, best);
+    }
+}
+
+/* Accounts the service time of a read wound to 'child' at 'start'. */
+void
+afr_read_latency_add(xlator_t *this, int child, struct timespec *start)
+{
+    afr_private_t *priv = NULL;
+    afr_read_stats_t *stats = NULL;
+    struct timespec now;
+    int64_t sample = 0;
+    int64_t ewma = 0;
+    uint64_t samples = 0;
+
+    priv = this->private;
+    if (child < 0 || child >= priv->child_count)
+        return;
+
+    timespec_now(&now);
+    sample = gf_tsdiff(start, &now) / 1000;
+
+    stats = &priv->read_stats[child];
+    LOCK(&stats->lock);
+    {
+        if (stats->samples == 0) {
+            stats->ewma = sample;
+        } else {
+            stats->ewma += (sample - stats->ewma) / AFR_READ_EWMA_WEIGHT;
+        }
+        samples = ++stats->samples;
+        ewma = stats->ewma;
+    }
+    UNLOCK(&stats->lock);
+
+    if (priv->read_outlier_factor &&
+        (samples >= AFR_READ_OUTLIER_MIN_SAMPLES)) {
+        afr_read_outlier_check(this, child, ewma);
+    }
+}
+
+/* Accounts the service time of the read that was wound to
+ * local->read_subvol. */
+void
+afr_read_latency_update(xlator_t *this, afr_local_t *local)
+{
+    if (!local->read_start.tv_sec && !local->read_start.tv_nsec)
+        return;
+
+    afr_read_latency_add(this, local->read_subvol, &local->read_start);
+
+    local->read_start.tv_sec = 0;
+    local->read_start.tv_nsec = 0;
+}
+
 void
 afr_read_txn_wind(call_frame_t *frame, xlator_t *this, int subvol)
 {
@@ -38,9 +147,14 @@ afr_read_txn_wind(call_frame_t *frame, xlator_t *this, int subvol)
     local = frame->local;
     priv = this->private;
 
+    afr_read_latency_update(this, local);
     afr_pending_read_decrement(priv, local->read_subvol);
     local->read_subvol = subvol;
     afr_pending_read_increment(priv, subvol);
+    if ((priv->hash_mode == AFR_READ_POLICY_ADAPTIVE_LATENCY) &&
+        (subvol >= 0)) {
+        timespec_now(&local->read_start);
+    }
     local->readfn(frame, this, subvol);
 }
 
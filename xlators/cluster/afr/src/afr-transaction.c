@@ -584,7 +584,7 @@ afr_transaction_perform_fop(call_frame_t *frame, xlator_t *this)
         }
     }
 
-    if (local->pre_op_compat)
+    if (local->pre_op_compat && !local->transaction.compound_pre_op)
         /* old mode, pre-op was done as afr_changelog_do()
            just now, before OP */
         afr_changelog_pre_op_update(frame, this);
@@ -1902,6 +1902,75 @@ afr_init_optimistic_changelog_for_txn(xlator_t *this, afr_local_t *local)
     return;
 }
 
+static int
+afr_compound_pre_op_fill(dict_t *d, char *k, data_t *v, void *data)
+{
+    dict_t *xdata = data;
+    char key[4096];
+    int keylen;
+
+    keylen = snprintf(key, sizeof(key), "%s%s", GLUSTERFS_WRITE_PRE_XATTROP,
+                      k);
+    if (keylen >= sizeof(key))
+        return -1;
+
+    return dict_setn(xdata, key, keylen, v);
+}
+
+/* Move the pre-op xattrop into the xdata of the write; the brick applies it
+ * before writing and acknowledges it in the reply. Arbiter configurations
+ * need the on-disk changelog before the fop is wound, so they always use a
+ * separate pre-op. */
+static gf_boolean_t
+afr_changelog_pre_op_compound(call_frame_t *frame, xlator_t *this,
+                              dict_t *xdata_req)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = frame->local;
+
+    if (!priv->use_compound_fops || priv->compound_fops_unsupported)
+        return _gf_false;
+
+    if (local->op != GF_FOP_WRITE || !local->xdata_req || priv->arbiter_count ||
+        priv->thin_arbiter_count)
+        return _gf_false;
+
+    if (dict_foreach(xdata_req, afr_compound_pre_op_fill, local->xdata_req)) {
+        dict_foreach_fnmatch(local->xdata_req, GLUSTERFS_WRITE_PRE_XATTROP "*",
+                             dict_remove_foreach_fn, NULL);
+        return _gf_false;
+    }
+
+    local->transaction.compound_pre_op = _gf_true;
+    return _gf_true;
+}
+
+void
+afr_compound_pre_op_check(call_frame_t *frame, xlator_t *this, int child_index,
+                          int op_ret, dict_t *xdata)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = frame->local;
+
+    if (!local->transaction.compound_pre_op || op_ret < 0)
+        return;
+
+    if (xdata && dict_get_sizen(xdata, GLUSTERFS_WRITE_PRE_XATTROP_DONE))
+        return;
+
+    /* The brick wrote the data without marking the pre-op: make the post-op
+     * account the write as failed on it, and stop piggybacking. */
+    afr_transaction_fop_failed(frame, this, child_index);
+
+    if (!priv->compound_fops_unsupported) {
+        priv->compound_fops_unsupported = _gf_true;
+        gf_msg(this->name, GF_LOG_WARNING, 0, AFR_MSG_COMPOUND_FOP_UNSUPPORTED,
+               "%s does not support pre-op along with writes, disabling "
+               "use-compound-fops",
+               priv->children[child_index]->name);
+    }
+}
+
 int
 afr_changelog_pre_op(call_frame_t *frame, xlator_t *this)
 {
@@ -1993,6 +2062,9 @@ afr_changelog_pre_op(call_frame_t *frame, xlator_t *this)
     if (pre_nop)
         goto next;
 
+    if (afr_changelog_pre_op_compound(frame, this, xdata_req))
+        goto next;
+
     if (!local->pre_op_compat) {
         dict_copy(xdata_req, local->xdata_req);
         goto next;
@@ -2618,7 +2690,7 @@ afr_transaction_resume(call_frame_t *frame, xlator_t *this)
 
     afr_handle_symmetric_errors(frame, this);
 
-    if (!local->pre_op_compat)
+    if (!local->pre_op_compat || local->transaction.compound_pre_op)
         /* new mode, pre-op was done along
            with OP */
         afr_changelog_pre_op_update(frame, this);
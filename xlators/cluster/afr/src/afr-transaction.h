@@ -13,6 +13,10 @@
 
 #include "afr.h"
 
+void
+afr_compound_pre_op_check(call_frame_t *frame, xlator_t *this, int child_index,
+                          int op_ret, dict_t *xdata);
+
 void
 afr_transaction_fop_failed(call_frame_t *frame, xlator_t *this,
                            int child_index);
@@ -45,6 +49,12 @@ afr_pending_read_increment(afr_private_t *priv, int child_index);
 void
 afr_pending_read_decrement(afr_private_t *priv, int child_index);
 
+void
+afr_read_latency_add(xlator_t *this, int child, struct timespec *start);
+
+void
+afr_read_latency_update(xlator_t *this, afr_local_t *local);
+
 call_frame_t *
 afr_transaction_detach_fop_frame(call_frame_t *frame);
 gf_boolean_t
@@ -234,6 +234,15 @@ reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("read-hash-mode", priv->hash_mode, options, uint32, out);
 
+    GF_OPTION_RECONF("read-outlier-factor", priv->read_outlier_factor, options,
+                     uint32, out);
+
+    GF_OPTION_RECONF("read-outlier-eject-time", priv->read_outlier_eject_time,
+                     options, uint32, out);
+
+    GF_OPTION_RECONF("read-hedge-percentile", priv->read_hedge_percentile,
+                     options, uint32, out);
+
     if (read_subvol) {
         index = xlator_subvolume_index(this, read_subvol);
         if (index == -1) {
@@ -258,6 +267,8 @@ reconfigure(xlator_t *this, dict_t *options)
     }
 
     GF_OPTION_RECONF("pre-op-compat", priv->pre_op_compat, options, bool, out);
+    GF_OPTION_RECONF("use-compound-fops", priv->use_compound_fops, options,
+                     bool, out);
     GF_OPTION_RECONF("locking-scheme", locking_scheme, options, str, out);
     priv->granular_locks = (strcmp(locking_scheme, "granular") == 0);
     GF_OPTION_RECONF("full-lock", priv->full_lock, options, bool, out);
@@ -495,6 +506,28 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("read-hash-mode", priv->hash_mode, uint32, out);
 
+    priv->read_stats = GF_CALLOC(sizeof(*priv->read_stats), priv->child_count,
+                                 gf_afr_mt_read_stats_t);
+    if (!priv->read_stats) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    for (i = 0; i < priv->child_count; i++)
+        LOCK_INIT(&priv->read_stats[i].lock);
+    priv->read_ejected_child = -1;
+
+    GF_OPTION_INIT("read-outlier-factor", priv->read_outlier_factor, uint32,
+                   out);
+
+    GF_OPTION_INIT("read-outlier-eject-time", priv->read_outlier_eject_time,
+                   uint32, out);
+
+    GF_OPTION_INIT("read-hedge-percentile", priv->read_hedge_percentile, uint32,
+                   out);
+    gf_latency_hist_init(&priv->read_hist);
+    GF_ATOMIC_INIT(priv->read_hedges_sent, 0);
+    GF_ATOMIC_INIT(priv->read_hedges_won, 0);
+
     priv->favorite_child = -1;
 
     GF_OPTION_INIT("favorite-child-policy", fav_child_policy, str, out);
@@ -544,6 +577,7 @@ init(xlator_t *this)
                    out);
 
     GF_OPTION_INIT("pre-op-compat", priv->pre_op_compat, bool, out);
+    GF_OPTION_INIT("use-compound-fops", priv->use_compound_fops, bool, out);
     GF_OPTION_INIT("locking-scheme", locking_scheme, str, out);
     priv->granular_locks = (strcmp(locking_scheme, "granular") == 0);
     GF_OPTION_INIT("full-lock", priv->full_lock, bool, out);
@@ -845,7 +879,7 @@ struct volume_options options[] = {
     {.key = {"read-hash-mode"},
      .type = GF_OPTION_TYPE_INT,
      .min = 0,
-     .max = 5,
+     .max = 6,
      .default_value = "1",
      .op_version = {2},
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
@@ -861,7 +895,46 @@ struct volume_options options[] = {
          "3 = brick having the least outstanding read requests.\n"
          "4 = brick having the least network ping latency.\n"
          "5 = Hybrid mode between 3 and 4, ie least value among "
-         "network-latency multiplied by outstanding-read-requests."},
+         "network-latency multiplied by outstanding-read-requests.\n"
+         "6 = better of two bricks picked at random, by their average "
+         "read service time multiplied by outstanding-read-requests. "
+         "Bricks whose reads are much slower than the others are "
+         "skipped for a while (see read-outlier-factor)."},
+    {.key = {"read-outlier-factor"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 100,
+     .default_value = "4",
+     .op_version = {GD_OP_VERSION_11_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "With read-hash-mode 6, a brick whose average read "
+                    "service time is more than this many times the one of "
+                    "the fastest brick is not read from for "
+                    "read-outlier-eject-time seconds. 0 disables it."},
+    {.key = {"read-outlier-eject-time"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 3600,
+     .default_value = "10",
+     .op_version = {GD_OP_VERSION_11_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "Number of seconds a brick is not read from once its "
+                    "read latency is found too high (see "
+                    "read-outlier-factor)."},
+    {.key = {"read-hedge-percentile"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 99,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_11_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "If a read has not been answered after this percentile "
+                    "of the latency of recent reads, it is also sent to "
+                    "another readable brick and the first good answer is "
+                    "used. 0 disables it."},
     {
         .key = {"choose-local"},
         .type = GF_OPTION_TYPE_BOOL,
@@ -1336,8 +1409,11 @@ struct volume_options options[] = {
      .op_version = {GD_OP_VERSION_3_8_4},
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
      .tags = {"replicate"},
-     .description = "This option exists only for backward compatibility "
-                    "and configuring it doesn't have any effect"},
+     .description = "Send the pre-op changelog of a write transaction "
+                    "along with the write itself, saving one round trip "
+                    "per brick. Bricks which do not acknowledge it are "
+                    "treated as failed for that write and the option is "
+                    "turned off for the client."},
     {.key = {"use-anonymous-inode"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "no",
@@ -40,6 +40,10 @@
 #define AFR_HALO_MAX_LATENCY 99999
 #define AFR_ANON_DIR_PREFIX ".glusterfs-anonymous-inode"
 
+#define AFR_READ_EWMA_WEIGHT 8 /* a new sample counts for 1/8 */
+#define AFR_READ_OUTLIER_MIN_SAMPLES 16
+#define AFR_READ_OUTLIER_MIN_USEC 1000
+
 #define PFLAG_PENDING (1 << 0)
 #define PFLAG_SBRAIN (1 << 1)
 
@@ -111,8 +115,18 @@ typedef enum {
     AFR_READ_POLICY_LESS_LOAD,
     AFR_READ_POLICY_LEAST_LATENCY,
     AFR_READ_POLICY_LOAD_LATENCY_HYBRID,
+    AFR_READ_POLICY_ADAPTIVE_LATENCY,
 } afr_read_hash_mode_t;
 
+/* Read service times of a child, as seen by this client. Used by
+ * AFR_READ_POLICY_ADAPTIVE_LATENCY. */
+typedef struct afr_read_stats {
+    gf_lock_t lock;
+    int64_t ewma;      /* usecs, 0 until the first sample */
+    uint64_t samples;  /* since the last ejection */
+    uint64_t ejections;
+} afr_read_stats_t;
+
 typedef enum {
     AFR_FAV_CHILD_NONE,
     AFR_FAV_CHILD_BY_SIZE,
@@ -216,6 +230,15 @@ typedef struct _afr_private {
     gf_boolean_t metadata_splitbrain_forced_heal; /* on/off */
     int read_child;                               /* read-subvolume */
     gf_atomic_t *pending_reads; /*No. of pending read cbks per child.*/
+    afr_read_stats_t *read_stats;
+    uint32_t read_outlier_factor;
+    uint32_t read_outlier_eject_time;
+    int read_ejected_child; /* -1 if none, protected by 'lock' */
+    time_t read_ejected_until;
+    uint32_t read_hedge_percentile; /* 0 disables hedged reads */
+    gf_latency_hist_t read_hist;
+    gf_atomic_t read_hedges_sent;
+    gf_atomic_t read_hedges_won;
 
     gf_timer_t *timer; /* launched when parent up is received */
 
@@ -225,6 +248,8 @@ typedef struct _afr_private {
     gf_boolean_t optimistic_change_log;
     gf_boolean_t eager_lock;
     gf_boolean_t pre_op_compat; /* on/off */
+    gf_boolean_t use_compound_fops;
+    gf_boolean_t compound_fops_unsupported; /* a brick ignored the pre-op */
     uint32_t post_op_delay_secs;
     unsigned int quorum_count;
 
@@ -535,6 +560,7 @@ typedef struct _afr_local {
     dict_t *dict;
 
     int read_subvol; /* Current read subvolume */
+    struct timespec read_start; /* When read_subvol was wound to */
 
     int optimistic_change_log;
 
@@ -843,6 +869,11 @@ typedef struct _afr_local {
         */
         gf_boolean_t inherited;
 
+        /* @compound_pre_op: the pre-op xattrop was sent along with
+           the OP (writev) instead of as a separate fop.
+        */
+        gf_boolean_t compound_pre_op;
+
         /*
           @no_uninherit: flag which indicates that a pre_op_uninherit()
           must _not_ be attempted (and returned as failure) always. This
@@ -1030,9 +1061,11 @@ afr_cleanup_fd_ctx(xlator_t *this, fd_t *fd);
             __local = frame->local;                                            \
             __this = frame->this;                                              \
             afr_handle_inconsistent_fop(frame, &__op_ret, &__op_errno);        \
-            if (__local && __local->is_read_txn)                               \
+            if (__local && __local->is_read_txn) {                             \
+                afr_read_latency_update(__this, __local);                      \
                 afr_pending_read_decrement(__this->private,                    \
                                            __local->read_subvol);              \
+            }                                                                  \
             if (__local && __local->xdata_req &&                               \
                 afr_is_lock_mode_mandatory(__local->xdata_req))                \
                 afr_dom_lock_release(frame);                                   \
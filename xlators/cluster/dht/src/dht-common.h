@@ -75,6 +75,15 @@ struct dht_layout_entry {
 
 typedef struct dht_layout_entry dht_layout_entry_t;
 
+/* Non-empty range of a layout, as kept in the search index. */
+struct dht_layout_range {
+    uint32_t start;
+    uint32_t stop;
+    xlator_t *xlator;
+};
+
+typedef struct dht_layout_range dht_layout_range_t;
+
 struct dht_layout {
     int spread_cnt; /* layout spread count per directory,
                        is controlled by 'setxattr()' with
@@ -99,6 +108,18 @@ struct dht_layout {
     int type;
     gf_atomic_t ref; /* use with dht_conf_t->layout_lock */
     uint32_t search_unhashed;
+    /*
+     * Ranges of 'list' sorted by start, used by dht_layout_search() to
+     * find the hashed subvolume with a binary search instead of walking
+     * the whole list. It's built when the layout is attached to an inode
+     * and lives in the same allocation as the layout. 'index_cnt' is 0
+     * while there's no valid index, so anything changing the ranges of
+     * 'list' must reset it. 'index_zero' is set when some subvolume got
+     * the empty 0-0 range, which only matters for hash value 0.
+     */
+    int index_cnt;
+    gf_boolean_t index_zero;
+    dht_layout_range_t *index;
     dht_layout_entry_t list[];
 };
 typedef struct dht_layout dht_layout_t;
@@ -123,11 +144,23 @@ struct dht_inode_ctx {
 
 typedef struct dht_inode_ctx dht_inode_ctx_t;
 
+/* Stored on disk as the layout type of the directory xattr. */
 typedef enum {
     DHT_HASH_TYPE_DM,
     DHT_HASH_TYPE_DM_USER,
+    /*
+     * Names hashed with Davies-Meyer and then mapped to a bucket with a
+     * jump consistent hash. The range of each subvolume is a set of
+     * buckets, numbered from 1, instead of a range of hash values.
+     * Appending buckets for new subvolumes only moves the names that
+     * land on them.
+     */
+    DHT_HASH_TYPE_JUMP,
 } dht_hashfn_type_t;
 
+/* Buckets given to an average subvolume in a new jump layout. */
+#define DHT_JUMP_BUCKETS 16
+
 typedef enum {
     DHT_INODELK,
     DHT_ENTRYLK,
@@ -409,7 +442,11 @@ typedef struct dht_container {
     gf_dirent_t *df_entry;
     loc_t *parent_loc;
     dict_t *migrate_data;
+    /* Directory of the crawl the entry has been found in. It isn't saved
+     * in the checkpoint until the entry has been processed. */
+    struct gf_defrag_dir *dir;
     int local_subvol_index;
+    int failed; /* the migration of the entry failed */
 } dht_container_t;
 
 typedef struct nodeuuid_info {
@@ -472,6 +509,22 @@ struct gf_defrag_info_ {
     gf_boolean_t stats;
     /* lock migration flag */
     gf_boolean_t lock_migration_enabled;
+
+    /* Directories waiting to be crawled, shared by the crawler threads */
+    pthread_mutex_t crawl_mutex;
+    pthread_cond_t crawl_cond;
+    struct list_head crawl_queue;
+    int32_t crawl_queue_count;
+    /* Crawler threads currently working on a directory */
+    int32_t crawl_busy;
+    int32_t crawl_threads;
+
+    /* Local file where the crawl records the directories whose whole
+     * subtree is done, and the ones loaded from it on start (sorted) */
+    char *checkpoint_path;
+    int checkpoint_fd;
+    uuid_t *checkpoint_done;
+    uint64_t checkpoint_done_cnt;
 };
 
 typedef struct gf_defrag_info_ gf_defrag_info_t;
@@ -581,6 +634,9 @@ struct dht_conf {
     /* Support size-weighted rebalancing (heterogeneous bricks). */
     gf_boolean_t do_weighting;
 
+    /* Layout type given to new and fixed directories. */
+    dht_hashfn_type_t layout_type;
+
     gf_boolean_t randomize_by_gfid;
 
     gf_boolean_t ensure_durability;
@@ -783,6 +839,9 @@ dht_subvol_cnt(xlator_t *this, xlator_t *subvol);
 int
 dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p);
 
+uint32_t
+dht_jump_hash(uint32_t hash, uint32_t buckets);
+
 int
 dht_linkfile_create(call_frame_t *frame, fop_mknod_cbk_t linkfile_cbk,
                     xlator_t *this, xlator_t *tovol, xlator_t *fromvol,
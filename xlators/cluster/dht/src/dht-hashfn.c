@@ -21,6 +21,7 @@ dht_hash_compute_internal(int type, const char *name, const int len,
     switch (type) {
         case DHT_HASH_TYPE_DM:
         case DHT_HASH_TYPE_DM_USER:
+        case DHT_HASH_TYPE_JUMP:
             hash = gf_dm_hashfn(name, len);
             break;
         default:
@@ -82,6 +83,13 @@ dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p)
         return -1;
 
     len = strlen(name) + 1;
+
+    /* Names are only munged when some regex is configured. Skip the lock
+     * and the copy of the name in the common case where none is. */
+    if (!priv->extra_regex_valid && !priv->rsync_regex_valid) {
+        return dht_hash_compute_internal(type, name, len - 1, hash_p);
+    }
+
     rsync_friendly_name = alloca(len);
 
     LOCK(&priv->lock);
@@ -108,3 +116,25 @@ dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p)
     return dht_hash_compute_internal(type, rsync_friendly_name, len - 1,
                                      hash_p);
 }
+
+/* Jump consistent hash (Lamping & Veach). Maps 'hash' to a bucket in
+ * [0, buckets). When the number of buckets grows from n to m, only about
+ * (m - n) / m of the hashes move, and all of them to the new buckets. */
+uint32_t
+dht_jump_hash(uint32_t hash, uint32_t buckets)
+{
+    uint64_t key = hash;
+    int64_t b = -1;
+    int64_t j = 0;
+
+    /* Spread the 32 bits of the name hash over the whole key. */
+    key = (key << 32) | hash;
+
+    while (j < buckets) {
+        b = j;
+        key = key * 2862933555777941757ULL + 1;
+        j = (b + 1) * ((double)(1LL << 31) / (double)((key >> 33) + 1));
+    }
+
+    return b;
+}
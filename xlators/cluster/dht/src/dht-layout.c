@@ -15,7 +15,10 @@
 
 #define layout_entry_size (sizeof((dht_layout_t *)NULL)->list[0])
 
-#define layout_size(cnt) (layout_base_size + (cnt * layout_entry_size))
+#define layout_range_size (sizeof(dht_layout_range_t))
+
+#define layout_size(cnt)                                                       \
+    (layout_base_size + (cnt * (layout_entry_size + layout_range_size)))
 
 dht_layout_t *
 dht_layout_new(xlator_t *this, int cnt)
@@ -35,6 +38,7 @@ dht_layout_new(xlator_t *this, int cnt)
 
     layout->type = DHT_HASH_TYPE_DM;
     layout->cnt = cnt;
+    layout->index = (dht_layout_range_t *)&layout->list[cnt];
 
     if (conf) {
         layout->spread_cnt = conf->dir_spread_cnt;
@@ -61,6 +65,57 @@ dht_layout_get(xlator_t *this, inode_t *inode)
     return layout;
 }
 
+static int
+dht_layout_range_cmp(const void *p, const void *q)
+{
+    const dht_layout_range_t *x = p, *y = q;
+
+    if (x->start < y->start)
+        return -1;
+
+    return (x->start > y->start);
+}
+
+/* Builds the search index of a layout. Overlapping layouts are left without
+ * index since the result of dht_layout_search() for them depends on the
+ * order of the entries. */
+static void
+dht_layout_index(dht_layout_t *layout)
+{
+    dht_layout_range_t *range = NULL;
+    int cnt = 0;
+    int i = 0;
+
+    if (layout->preset || (layout->index_cnt > 0))
+        return;
+
+    layout->index_zero = _gf_false;
+    for (i = 0; i < layout->cnt; i++) {
+        if (layout->list[i].start > layout->list[i].stop) {
+            continue;
+        }
+        if (!layout->list[i].start && !layout->list[i].stop) {
+            layout->index_zero = _gf_true;
+            continue;
+        }
+        range = &layout->index[cnt++];
+        range->start = layout->list[i].start;
+        range->stop = layout->list[i].stop;
+        range->xlator = layout->list[i].xlator;
+    }
+
+    qsort(layout->index, cnt, sizeof(dht_layout_range_t),
+          dht_layout_range_cmp);
+
+    for (i = 1; i < cnt; i++) {
+        if (layout->index[i].start <= layout->index[i - 1].stop) {
+            return;
+        }
+    }
+
+    layout->index_cnt = cnt;
+}
+
 int
 dht_layout_set(xlator_t *this, inode_t *inode, dht_layout_t *layout)
 {
@@ -71,6 +126,10 @@ dht_layout_set(xlator_t *this, inode_t *inode, dht_layout_t *layout)
     if (!conf || !layout)
         goto out;
 
+    /* The index is built before the layout becomes visible through the
+     * inode, so lookups that get it from there never see it half done. */
+    dht_layout_index(layout);
+
     ret = dht_inode_ctx_layout_set(inode, this, layout);
 
 out:
@@ -102,10 +161,61 @@ dht_layout_ref(dht_layout_t *layout)
     return layout;
 }
 
+static xlator_t *
+dht_layout_index_search(dht_layout_t *layout, uint32_t hash)
+{
+    dht_layout_range_t *range = NULL;
+    int low = 0;
+    int high = 0;
+    int mid = 0;
+
+    /* Find the last range starting at or before 'hash'. */
+    low = 0;
+    high = layout->index_cnt;
+    while (high - low > 1) {
+        mid = (low + high) / 2;
+        if (layout->index[mid].start <= hash) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    range = &layout->index[low];
+    if ((range->start <= hash) && (range->stop >= hash)) {
+        return range->xlator;
+    }
+
+    return NULL;
+}
+
+/* Buckets of a jump layout. They are numbered from 1, so this is also
+ * the last bucket. */
+static uint32_t
+dht_layout_jump_buckets(dht_layout_t *layout)
+{
+    uint32_t buckets = 0;
+    int i = 0;
+
+    if (layout->index_cnt > 0) {
+        return layout->index[layout->index_cnt - 1].stop;
+    }
+
+    for (i = 0; i < layout->cnt; i++) {
+        if ((layout->list[i].start <= layout->list[i].stop) &&
+            (layout->list[i].stop > buckets)) {
+            buckets = layout->list[i].stop;
+        }
+    }
+
+    return buckets;
+}
+
 xlator_t *
 dht_layout_search(xlator_t *this, dht_layout_t *layout, const char *name)
 {
     uint32_t hash = 0;
+    uint32_t buckets = 0;
     xlator_t *subvol = NULL;
     int i = 0;
     int ret = 0;
@@ -117,10 +227,26 @@ dht_layout_search(xlator_t *this, dht_layout_t *layout, const char *name)
         goto out;
     }
 
-    for (i = 0; i < layout->cnt; i++) {
-        if (layout->list[i].start <= hash && layout->list[i].stop >= hash) {
-            subvol = layout->list[i].xlator;
-            break;
+    if (layout->type == DHT_HASH_TYPE_JUMP) {
+        buckets = dht_layout_jump_buckets(layout);
+        if (buckets == 0) {
+            gf_smsg(this->name, GF_LOG_WARNING, 0,
+                    DHT_MSG_HASHED_SUBVOL_GET_FAILED, "hash-value=0x%x", hash,
+                    NULL);
+            goto out;
+        }
+        hash = dht_jump_hash(hash, buckets) + 1;
+    }
+
+    if ((layout->index_cnt > 0) && ((hash != 0) || !layout->index_zero)) {
+        subvol = dht_layout_index_search(layout, hash);
+    } else {
+        for (i = 0; i < layout->cnt; i++) {
+            if (layout->list[i].start <= hash &&
+                layout->list[i].stop >= hash) {
+                subvol = layout->list[i].xlator;
+                break;
+            }
         }
     }
 
@@ -263,6 +389,9 @@ dht_disk_layout_merge(xlator_t *this, dht_layout_t *layout, int pos,
             /* Fall through. */
         case DHT_HASH_TYPE_DM:
             break;
+        case DHT_HASH_TYPE_JUMP:
+            layout->type = type;
+            break;
         default:
             gf_smsg(this->name, GF_LOG_CRITICAL, 0, DHT_MSG_INVALID_DISK_LAYOUT,
                     "layout=%d", disk_layout[1], NULL);
@@ -276,6 +405,7 @@ dht_disk_layout_merge(xlator_t *this, dht_layout_t *layout, int pos,
     layout->list[pos].commit_hash = commit_hash;
     layout->list[pos].start = start_off;
     layout->list[pos].stop = stop_off;
+    layout->index_cnt = 0;
 
     gf_msg_trace(this->name, 0,
                  "merged to layout: 0x%x - 0x%x (hash 0x%x, type %d) from %s",
@@ -364,6 +494,8 @@ dht_layout_range_swap(dht_layout_t *layout, int i, int j)
 
     layout->list[j].start = start_swap;
     layout->list[j].stop = stop_swap;
+
+    layout->index_cnt = 0;
 }
 
 gf_boolean_t
@@ -449,9 +581,17 @@ dht_layout_anomalies(xlator_t *this, loc_t *loc, dht_layout_t *layout,
             if (start of the current layout entry < stop + 1 of previous
                 non erroneous layout entry)
                      then it indicates an overlap in the layout
+
+       Ranges of a DHT_HASH_TYPE_JUMP layout are buckets from 1 up to
+       the last one in use, instead of the whole ring of hash values.
     */
-    last_stop = layout->list[0].start - 1;
-    prev_stop = last_stop;
+    if (layout->type == DHT_HASH_TYPE_JUMP) {
+        last_stop = 0;
+        prev_stop = 0;
+    } else {
+        last_stop = layout->list[0].start - 1;
+        prev_stop = last_stop;
+    }
 
     for (i = 0; i < layout->cnt; i++) {
         switch (layout->list[i].err) {
@@ -492,6 +632,10 @@ dht_layout_anomalies(xlator_t *this, loc_t *loc, dht_layout_t *layout,
         prev_stop = layout->list[i].stop;
     }
 
+    if (layout->type == DHT_HASH_TYPE_JUMP) {
+        last_stop = prev_stop;
+    }
+
     if ((last_stop - prev_stop) || is_virgin)
         hole_cnt++;
 
@@ -33,6 +33,7 @@ enum gf_dht_mem_types_ {
     gf_dht_mt_fd_ctx_t,
     gf_dht_ret_cache_t,
     gf_dht_nodeuuids_t,
+    gf_dht_mt_defrag_dir_t,
     gf_dht_mt_end
 };
 #endif
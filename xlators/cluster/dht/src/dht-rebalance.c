@@ -20,6 +20,8 @@
 #define DHT_REBALANCE_BLKSIZE 1048576 /* 1 MB */
 #define MAX_MIGRATE_QUEUE_COUNT 500
 #define MIN_MIGRATE_QUEUE_COUNT 200
+#define MAX_CRAWL_QUEUE_COUNT 1024
+#define GF_DEFRAG_READDIR_SIZE 131072
 #define MAX_REBAL_TYPE_SIZE 16
 #define FILE_CNT_INTERVAL 600       /* 10 mins */
 #define ESTIMATE_START_INTERVAL 600 /* 10 mins */
@@ -39,6 +41,19 @@ static int
 dht_migrate_file(xlator_t *this, loc_t *loc, xlator_t *cached_subvol,
                  xlator_t *hashed_subvol, int flag, int *fop_errno);
 
+/* A directory of the crawl. It's kept until the crawl of all its
+ * subdirectories is over, which 'pending' keeps track of. */
+typedef struct gf_defrag_dir {
+    struct list_head list;
+    struct gf_defrag_dir *parent;
+    gf_atomic_t pending;
+    int failed;
+    loc_t loc;
+} gf_defrag_dir_t;
+
+static void
+gf_defrag_dir_put(gf_defrag_info_t *defrag, gf_defrag_dir_t *dir);
+
 static void
 gf_defrag_free_dir_dfmeta(struct dir_dfmeta *meta, int local_subvols_cnt)
 {
@@ -89,6 +104,16 @@ dht_set_global_defrag_error(gf_defrag_info_t *defrag, int ret)
     return;
 }
 
+static void
+gf_defrag_failure_inc(gf_defrag_info_t *defrag)
+{
+    LOCK(&defrag->lock);
+    {
+        defrag->total_failures++;
+    }
+    UNLOCK(&defrag->lock);
+}
+
 static int
 dht_send_rebalance_event(xlator_t *this, int cmd, gf_defrag_status_t status)
 {
@@ -2689,6 +2714,8 @@ gf_defrag_migrate_single_file(xlator_t *this, dht_container_t *rebal_entry)
 
         ret = 0;
 
+        rebal_entry->failed = 1;
+
         gf_log(this->name, GF_LOG_ERROR, "Child loc build failed");
 
         goto out;
@@ -2731,6 +2758,7 @@ gf_defrag_migrate_single_file(xlator_t *this, dht_container_t *rebal_entry)
                 defrag->total_failures += 1;
             }
             UNLOCK(&defrag->lock);
+            rebal_entry->failed = 1;
         }
 
         ret = 0;
@@ -2810,6 +2838,7 @@ gf_defrag_migrate_single_file(xlator_t *this, dht_container_t *rebal_entry)
                             update_skippedcount = _gf_false;
                         }
                         UNLOCK(&defrag->lock);
+                        rebal_entry->failed = 1;
 
                         break;
                     }
@@ -2855,6 +2884,7 @@ gf_defrag_migrate_single_file(xlator_t *this, dht_container_t *rebal_entry)
                 defrag->total_failures += 1;
             }
             UNLOCK(&defrag->lock);
+            rebal_entry->failed = 1;
         }
 
         ret = gf_defrag_handle_migrate_error(fop_errno, defrag);
@@ -3003,6 +3033,15 @@ gf_defrag_task(void *opaque)
                     goto out;
                 }
 
+                /* The directory can be checkpointed once all its entries
+                 * have been processed. */
+                if (iterator->dir) {
+                    if (iterator->failed) {
+                        iterator->dir->failed = 1;
+                    }
+                    gf_defrag_dir_put(defrag, iterator->dir);
+                }
+
                 gf_defrag_free_container(iterator);
 
                 continue;
@@ -3130,16 +3169,28 @@ gf_defrag_get_entry(xlator_t *this, int i, dht_container_t **container,
             continue;
 
         if (IA_ISDIR(df_entry->d_stat.ia_type)) {
-            defrag->size_processed += df_entry->d_stat.ia_size;
+            LOCK(&defrag->lock);
+            {
+                defrag->size_processed += df_entry->d_stat.ia_size;
+            }
+            UNLOCK(&defrag->lock);
             continue;
         }
 
-        defrag->num_files_lookedup++;
+        LOCK(&defrag->lock);
+        {
+            defrag->num_files_lookedup++;
+        }
+        UNLOCK(&defrag->lock);
 
         if (!list_empty(&defrag->defrag_pattern) &&
             (gf_defrag_pattern_match(defrag, df_entry->d_name,
                                      df_entry->d_stat.ia_size) == _gf_false)) {
-            defrag->size_processed += df_entry->d_stat.ia_size;
+            LOCK(&defrag->lock);
+            {
+                defrag->size_processed += df_entry->d_stat.ia_size;
+            }
+            UNLOCK(&defrag->lock);
             continue;
         }
 
@@ -3224,10 +3275,11 @@ out:
     return ret;
 }
 
-int
-gf_defrag_process_dir(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
-                      dict_t *migrate_data, int *perrno)
+static int
+gf_defrag_process_dir(xlator_t *this, gf_defrag_info_t *defrag,
+                      gf_defrag_dir_t *dir, dict_t *migrate_data, int *perrno)
 {
+    loc_t *loc = &dir->loc;
     int ret = -1;
     dht_conf_t *conf = NULL;
     gf_dirent_t entries;
@@ -3442,6 +3494,11 @@ gf_defrag_process_dir(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                 continue;
             }
 
+            /* The entry keeps its directory out of the checkpoint until
+             * it's migrated. */
+            container->dir = dir;
+            GF_ATOMIC_INC(dir->pending);
+
             /* Q this entry in the dfq */
             pthread_mutex_lock(&defrag->dfq_mutex);
             {
@@ -3479,9 +3536,12 @@ out:
 
     /* It does not matter if it errored out - this number is
      * used to calculate rebalance estimated time to complete.
-     * No locking required as dirs are processed by a single thread.
      */
-    defrag->num_dirs_processed++;
+    LOCK(&defrag->lock);
+    {
+        defrag->num_dirs_processed++;
+    }
+    UNLOCK(&defrag->lock);
     return ret;
 }
 
@@ -3491,6 +3551,7 @@ gf_defrag_settle_hash(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
 {
     int ret;
     dht_conf_t *conf = NULL;
+    dict_t *settle = NULL;
     /*
      * Now we're ready to update the directory commit hash for the volume
      * root, so that hash miscompares and broadcast lookups can stop.
@@ -3513,55 +3574,245 @@ gf_defrag_settle_hash(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
         return 0;
     }
 
-    ret = dict_set_uint32(fix_layout, "new-commit-hash",
-                          defrag->new_commit_hash);
+    /* fix_layout is shared by the crawler threads, so use a copy */
+    settle = dict_copy_with_ref(fix_layout, NULL);
+    if (!settle) {
+        gf_log(this->name, GF_LOG_ERROR, "Failed to copy fix-layout dict");
+        return -1;
+    }
+
+    ret = dict_set_uint32(settle, "new-commit-hash", defrag->new_commit_hash);
     if (ret) {
         gf_log(this->name, GF_LOG_ERROR, "Failed to set new-commit-hash");
-        return -1;
+        ret = -1;
+        goto out;
     }
 
-    ret = syncop_setxattr(this, loc, fix_layout, 0, NULL, NULL);
+    ret = syncop_setxattr(this, loc, settle, 0, NULL, NULL);
     if (ret) {
         gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_LAYOUT_FIX_FAILED,
                "fix layout on %s failed", loc->path);
 
         if (-ret == ENOENT || -ret == ESTALE) {
             /* Dir most likely is deleted */
-            return 0;
+            ret = 0;
+            goto out;
         }
 
-        return -1;
+        ret = -1;
+        goto out;
     }
 
-    /* TBD: find more efficient solution than adding/deleting every time */
-    dict_del(fix_layout, "new-commit-hash");
+out:
+    dict_unref(settle);
 
-    return 0;
+    return ret;
 }
 
 static int
-gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
-                     dict_t *fix_layout, dict_t *migrate_data)
+gf_defrag_checkpoint_cmp(const void *a, const void *b)
+{
+    return memcmp(a, b, sizeof(uuid_t));
+}
+
+/* Opens the checkpoint file of the crawl. If it was left by an interrupted
+ * run of the same rebalance, the directories it lists are loaded so that
+ * their subtrees are not crawled again. Otherwise a new one is started. */
+static void
+gf_defrag_checkpoint_init(xlator_t *this, gf_defrag_info_t *defrag)
+{
+    dht_conf_t *conf = NULL;
+    FILE *fp = NULL;
+    uuid_t *done = NULL;
+    uuid_t *tmp = NULL;
+    uint64_t cnt = 0;
+    uint64_t size = 0;
+    char header[64];
+    char line[64];
+    char *nl = NULL;
+    int len = 0;
+    int fd = -1;
+
+    if (!defrag->checkpoint_path) {
+        return;
+    }
+
+    conf = this->private;
+
+    len = snprintf(header, sizeof(header), "cmd=%d commit-hash=%u\n",
+                   defrag->cmd, conf->vol_commit_hash);
+
+    fp = fopen(defrag->checkpoint_path, "r");
+    if (fp) {
+        if (fgets(line, sizeof(line), fp) && !strcmp(line, header)) {
+            while (fgets(line, sizeof(line), fp)) {
+                nl = strchr(line, '\n');
+                if (!nl) {
+                    /* Last record, cut by an interruption */
+                    break;
+                }
+                *nl = '\0';
+                if (cnt == size) {
+                    size = size ? size * 2 : 1024;
+                    tmp = GF_REALLOC(done, size * sizeof(uuid_t));
+                    if (!tmp) {
+                        cnt = 0;
+                        break;
+                    }
+                    done = tmp;
+                }
+                if (gf_uuid_parse(line, done[cnt]) == 0) {
+                    cnt++;
+                }
+            }
+        }
+        fclose(fp);
+    }
+
+    if (cnt) {
+        qsort(done, cnt, sizeof(uuid_t), gf_defrag_checkpoint_cmp);
+        defrag->checkpoint_done = done;
+        defrag->checkpoint_done_cnt = cnt;
+
+        gf_log(this->name, GF_LOG_INFO,
+               "resuming crawl from %s, %" PRIu64
+               " directories already crawled",
+               defrag->checkpoint_path, cnt);
+
+        fd = sys_open(defrag->checkpoint_path, O_WRONLY | O_APPEND, 0);
+    } else {
+        GF_FREE(done);
+
+        fd = sys_open(defrag->checkpoint_path,
+                      O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if ((fd >= 0) && (sys_write(fd, header, len) != len)) {
+            sys_close(fd);
+            fd = -1;
+        }
+    }
+
+    if (fd < 0) {
+        gf_msg(this->name, GF_LOG_WARNING, errno, 0,
+               "failed to open %s, crawl progress will not be saved",
+               defrag->checkpoint_path);
+    }
+
+    defrag->checkpoint_fd = fd;
+}
+
+static gf_boolean_t
+gf_defrag_checkpoint_done(gf_defrag_info_t *defrag, uuid_t gfid)
+{
+    if (!defrag->checkpoint_done_cnt || gf_uuid_is_null(gfid)) {
+        return _gf_false;
+    }
+
+    return bsearch(gfid, defrag->checkpoint_done, defrag->checkpoint_done_cnt,
+                   sizeof(uuid_t), gf_defrag_checkpoint_cmp) != NULL;
+}
+
+static void
+gf_defrag_checkpoint_add(gf_defrag_info_t *defrag, uuid_t gfid)
+{
+    char line[GF_UUID_BUF_SIZE + 1];
+    int len = 0;
+
+    if ((defrag->checkpoint_fd < 0) || gf_uuid_is_null(gfid)) {
+        return;
+    }
+
+    /* The file is opened with O_APPEND, so records written at the same
+     * time by several crawler threads don't get mixed. */
+    len = snprintf(line, sizeof(line), "%s\n", uuid_utoa(gfid));
+    if (sys_write(defrag->checkpoint_fd, line, len) != len) {
+        gf_msg(defrag->this->name, GF_LOG_WARNING, errno, 0,
+               "failed to save crawl progress in %s",
+               defrag->checkpoint_path);
+    }
+}
+
+/* The checkpoint is only useful until the crawl completes. */
+static void
+gf_defrag_checkpoint_fini(gf_defrag_info_t *defrag)
+{
+    if (defrag->checkpoint_fd >= 0) {
+        sys_close(defrag->checkpoint_fd);
+        defrag->checkpoint_fd = -1;
+    }
+
+    if (defrag->checkpoint_path &&
+        (defrag->defrag_status == GF_DEFRAG_STATUS_COMPLETE)) {
+        sys_unlink(defrag->checkpoint_path);
+    }
+
+    GF_FREE(defrag->checkpoint_done);
+    defrag->checkpoint_done = NULL;
+    defrag->checkpoint_done_cnt = 0;
+
+    GF_FREE(defrag->checkpoint_path);
+    defrag->checkpoint_path = NULL;
+}
+
+static gf_defrag_dir_t *
+gf_defrag_dir_new(gf_defrag_dir_t *parent)
+{
+    gf_defrag_dir_t *dir = NULL;
+
+    dir = GF_CALLOC(1, sizeof(*dir), gf_dht_mt_defrag_dir_t);
+    if (!dir) {
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&dir->list);
+    GF_ATOMIC_INIT(dir->pending, 1);
+
+    if (parent) {
+        dir->parent = parent;
+        GF_ATOMIC_INC(parent->pending);
+    }
+
+    return dir;
+}
+
+/* Called when 'dir', one of its subdirectories or one of its files queued
+ * for migration is done. Once its whole subtree, files included, is done
+ * without errors, it's saved in the checkpoint and released, and its
+ * parent is told. */
+static void
+gf_defrag_dir_put(gf_defrag_info_t *defrag, gf_defrag_dir_t *dir)
+{
+    gf_defrag_dir_t *parent = NULL;
+
+    while (dir && (GF_ATOMIC_DEC(dir->pending) == 0)) {
+        parent = dir->parent;
+
+        if (dir->failed ||
+            (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED)) {
+            if (parent) {
+                parent->failed = 1;
+            }
+        } else if (dir->loc.inode) {
+            gf_defrag_checkpoint_add(defrag, dir->loc.inode->gfid);
+        }
+
+        loc_wipe(&dir->loc);
+        GF_FREE(dir);
+
+        dir = parent;
+    }
+}
+
+/* Looks up a directory, which heals it on bricks where it's missing, and
+ * links its inode. Returns 1 if the directory is gone. */
+static int
+gf_defrag_lookup_dir(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc)
 {
     int ret = -1;
-    loc_t entry_loc = {
-        0,
-    };
-    fd_t *fd = NULL;
-    gf_dirent_t entries;
-    gf_dirent_t *tmp = NULL;
-    gf_dirent_t *entry = NULL;
-    gf_boolean_t free_entries = _gf_false;
-    off_t offset = 0;
     struct iatt iatt = {
         0,
     };
-    struct iatt entry_iatt = {
-        0,
-    };
     inode_t *linked_inode = NULL, *inode = NULL;
     dht_conf_t *conf = NULL;
-    int perrno = 0;
 
     conf = this->private;
     ret = syncop_lookup(this, loc, &iatt, NULL, NULL, NULL);
@@ -3572,21 +3823,20 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                    "Skipping",
                    loc->path);
             if (conf->decommission_subvols_cnt) {
-                defrag->total_failures++;
+                gf_defrag_failure_inc(defrag);
             }
-            ret = 0;
-        } else {
-            gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_DIR_LOOKUP_FAILED,
-                   "lookup failed for:%s", loc->path);
+            return 1;
+        }
 
-            defrag->total_failures++;
+        gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_DIR_LOOKUP_FAILED,
+               "lookup failed for:%s", loc->path);
 
-            if (conf->decommission_in_progress) {
-                defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
-                ret = -1;
-            }
+        gf_defrag_failure_inc(defrag);
+
+        if (conf->decommission_in_progress) {
+            defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
         }
-        goto out;
+        return -1;
     }
 
     linked_inode = inode_link(loc->inode, loc->parent, loc->name, &iatt);
@@ -3595,11 +3845,128 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     loc->inode = linked_inode;
     inode_unref(inode);
 
+    return 0;
+}
+
+static int
+gf_defrag_crawl_dir(xlator_t *this, gf_defrag_info_t *defrag,
+                    gf_defrag_dir_t *dir, dict_t *fix_layout,
+                    dict_t *migrate_data);
+
+/* Queues 'dir' for another crawler thread. If the queue is full, the
+ * caller crawls it itself. */
+static gf_boolean_t
+gf_defrag_crawl_queue(gf_defrag_info_t *defrag, gf_defrag_dir_t *dir)
+{
+    gf_boolean_t queued = _gf_false;
+
+    if (defrag->crawl_threads <= 1) {
+        return _gf_false;
+    }
+
+    pthread_mutex_lock(&defrag->crawl_mutex);
+    {
+        if (defrag->crawl_queue_count < MAX_CRAWL_QUEUE_COUNT) {
+            /* Most recent first, so that the crawl stays depth first and
+             * subtrees get done, and released, early. */
+            list_add(&dir->list, &defrag->crawl_queue);
+            defrag->crawl_queue_count++;
+            pthread_cond_signal(&defrag->crawl_cond);
+            queued = _gf_true;
+        }
+    }
+    pthread_mutex_unlock(&defrag->crawl_mutex);
+
+    return queued;
+}
+
+/* Looks up the subdirectory 'name' of 'parent', then queues it or crawls
+ * it right away. */
+static int
+gf_defrag_crawl_child(xlator_t *this, gf_defrag_info_t *defrag,
+                      gf_defrag_dir_t *parent, char *name, dict_t *fix_layout,
+                      dict_t *migrate_data)
+{
+    gf_defrag_dir_t *dir = NULL;
+    int ret = -1;
+
+    dir = gf_defrag_dir_new(parent);
+    if (!dir) {
+        gf_defrag_failure_inc(defrag);
+        return -1;
+    }
+
+    ret = dht_build_child_loc(this, &dir->loc, &parent->loc, name);
+    if (ret) {
+        gf_log(this->name, GF_LOG_ERROR,
+               "Child loc"
+               " build failed for entry: %s",
+               name);
+
+        gf_defrag_failure_inc(defrag);
+        dir->failed = 1;
+        ret = -1;
+        goto out;
+    }
+
+    /* The subdirectory must be healed to any newly added brick before
+     * the layout of its parent is fixed, so look it up now even if it
+     * will be crawled later. */
+    ret = gf_defrag_lookup_dir(this, defrag, &dir->loc);
+    if (ret) {
+        if (ret < 0) {
+            dir->failed = 1;
+            gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_LAYOUT_FIX_FAILED,
+                   "Fix layout failed for %s", dir->loc.path);
+        } else {
+            ret = 0;
+        }
+        goto out;
+    }
+
+    if (gf_defrag_crawl_queue(defrag, dir)) {
+        return 0;
+    }
+
+    ret = gf_defrag_crawl_dir(this, defrag, dir, fix_layout, migrate_data);
+    if (ret) {
+        dir->failed = 1;
+        gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_LAYOUT_FIX_FAILED,
+               "Fix layout failed for %s", dir->loc.path);
+    }
+
+out:
+    gf_defrag_dir_put(defrag, dir);
+
+    return ret;
+}
+
+/* Fixes the layout of a directory that has already been looked up, and
+ * queues its files for migration. Its subdirectories are handed to other
+ * crawler threads when possible. */
+static int
+gf_defrag_crawl_dir(xlator_t *this, gf_defrag_info_t *defrag,
+                    gf_defrag_dir_t *dir, dict_t *fix_layout,
+                    dict_t *migrate_data)
+{
+    int ret = -1;
+    loc_t *loc = &dir->loc;
+    fd_t *fd = NULL;
+    gf_dirent_t entries;
+    gf_dirent_t *tmp = NULL;
+    gf_dirent_t *entry = NULL;
+    gf_boolean_t free_entries = _gf_false;
+    off_t offset = 0;
+    dht_conf_t *conf = NULL;
+    int perrno = 0;
+
+    conf = this->private;
+
     fd = fd_create(loc->inode, defrag->pid);
     if (!fd) {
         gf_log(this->name, GF_LOG_ERROR, "Failed to create fd");
 
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -3608,7 +3975,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     if (ret) {
         if (-ret == ENOENT || -ret == ESTALE) {
             if (conf->decommission_subvols_cnt) {
-                defrag->total_failures++;
+                gf_defrag_failure_inc(defrag);
             }
             ret = 0;
             goto out;
@@ -3619,7 +3986,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                "err:%d",
                loc->path, -ret);
 
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -3627,12 +3994,14 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     fd_bind(fd);
     INIT_LIST_HEAD(&entries.list);
 
-    while ((ret = syncop_readdir(this, fd, 131072, offset, &entries, NULL,
-                                 NULL)) != 0) {
+    /* readdirp returns the type and gfid of each entry along with its
+     * name, so subdirectories don't need a lookup to be recognized. */
+    while ((ret = syncop_readdirp(this, fd, GF_DEFRAG_READDIR_SIZE, offset,
+                                  &entries, NULL, NULL)) != 0) {
         if (ret < 0) {
             if (-ret == ENOENT || -ret == ESTALE) {
                 if (conf->decommission_subvols_cnt) {
-                    defrag->total_failures++;
+                    gf_defrag_failure_inc(defrag);
                 }
                 ret = 0;
                 goto out;
@@ -3643,7 +4012,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                    "path %s. Aborting fix-layout",
                    loc->path);
 
-            defrag->total_failures++;
+            gf_defrag_failure_inc(defrag);
             ret = -1;
             goto out;
         }
@@ -3664,64 +4033,33 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
             if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
                 continue;
 
-            if ((DT_DIR != entry->d_type) && (DT_UNKNOWN != entry->d_type)) {
+            if ((DT_DIR != entry->d_type) &&
+                ((DT_UNKNOWN != entry->d_type) ||
+                 !IA_ISDIR(entry->d_stat.ia_type))) {
                 continue;
             }
 
-            loc_wipe(&entry_loc);
-
-            ret = dht_build_child_loc(this, &entry_loc, loc, entry->d_name);
-            if (ret) {
-                gf_log(this->name, GF_LOG_ERROR,
-                       "Child loc"
-                       " build failed for entry: %s",
-                       entry->d_name);
-
-                defrag->total_failures++;
-
-                if (conf->decommission_in_progress) {
-                    defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
-
-                    goto out;
-                } else {
-                    continue;
-                }
-            }
-
-            if (DT_UNKNOWN == entry->d_type) {
-                ret = syncop_lookup(this, &entry_loc, &entry_iatt, NULL, NULL,
-                                    NULL);
-                if ((ret == 0) && (entry_iatt.ia_type != IA_IFDIR)) {
-                    continue;
-                }
-                /*If it is directory, gf_defrag_fix_layout() call will again do
-                 * one more lookup. Not optimizing this part as all modern
-                 * filesystems populate entry->d_type. We can optimize it when
-                 * such a filesystem is found.*/
+            if (gf_defrag_checkpoint_done(defrag, entry->d_stat.ia_gfid)) {
+                gf_msg_debug(this->name, 0, "%s/%s already crawled",
+                             loc->path, entry->d_name);
+                continue;
             }
 
-            /* A return value of 2 means, either process_dir or
-             * lookup of a dir failed. Hence, don't commit hash
-             * for the current directory*/
-
-            ret = gf_defrag_fix_layout(this, defrag, &entry_loc, fix_layout,
-                                       migrate_data);
+            ret = gf_defrag_crawl_child(this, defrag, dir, entry->d_name,
+                                        fix_layout, migrate_data);
 
             if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
                 goto out;
             }
 
             if (ret) {
-                gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_LAYOUT_FIX_FAILED,
-                       "Fix layout failed for %s", entry_loc.path);
-
                 if (conf->decommission_in_progress) {
                     defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
 
                     goto out;
                 } else {
                     /* Let's not commit-hash if
-                     * gf_defrag_fix_layout failed*/
+                     * gf_defrag_crawl_dir failed*/
                     continue;
                 }
             }
@@ -3758,7 +4096,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                    "renamed or removed",
                    loc->path);
             if (conf->decommission_subvols_cnt) {
-                defrag->total_failures++;
+                gf_defrag_failure_inc(defrag);
             }
             ret = 0;
             goto out;
@@ -3766,7 +4104,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
             gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_LAYOUT_FIX_FAILED,
                    "Setxattr failed for %s", loc->path);
 
-            defrag->total_failures++;
+            gf_defrag_failure_inc(defrag);
 
             if (conf->decommission_in_progress) {
                 defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
@@ -3777,7 +4115,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     }
 
     if (defrag->cmd != GF_DEFRAG_CMD_START_LAYOUT_FIX) {
-        ret = gf_defrag_process_dir(this, defrag, loc, migrate_data, &perrno);
+        ret = gf_defrag_process_dir(this, defrag, dir, migrate_data, &perrno);
 
         if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
             goto out;
@@ -3788,7 +4126,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                 ret = 0;
                 goto out;
             } else {
-                defrag->total_failures++;
+                gf_defrag_failure_inc(defrag);
 
                 gf_msg(this->name, GF_LOG_ERROR, 0,
                        DHT_MSG_DEFRAG_PROCESS_DIR_FAILED,
@@ -3806,7 +4144,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     gf_msg_trace(this->name, 0, "fix layout called on %s", loc->path);
 
     if (gf_defrag_settle_hash(this, defrag, loc, fix_layout) != 0) {
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
 
         gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_SETTLE_HASH_FAILED,
                "Settle hash failed for %s", loc->path);
@@ -3824,14 +4162,196 @@ out:
     if (free_entries)
         gf_dirent_free(&entries);
 
-    loc_wipe(&entry_loc);
-
     if (fd)
         fd_unref(fd);
 
     return ret;
 }
 
+typedef struct gf_defrag_crawl_args {
+    gf_defrag_info_t *defrag;
+    dict_t *fix_layout;
+    dict_t *migrate_data;
+} gf_defrag_crawl_args_t;
+
+static void *
+gf_defrag_crawl_task(void *opaque)
+{
+    gf_defrag_crawl_args_t *args = opaque;
+    gf_defrag_info_t *defrag = args->defrag;
+    gf_defrag_dir_t *dir = NULL;
+    xlator_t *this = defrag->this;
+    dht_conf_t *conf = this->private;
+    pid_t pid = GF_CLIENT_PID_DEFRAG;
+    gf_lkowner_t lkowner;
+    int ret = 0;
+
+    THIS = this;
+
+    syncopctx_setfspid(&pid);
+    set_lk_owner_from_ptr(&lkowner, &lkowner);
+    syncopctx_setfslkowner(&lkowner);
+
+    while (_gf_true) {
+        pthread_mutex_lock(&defrag->crawl_mutex);
+        {
+            /* An empty queue only means the crawl is done once no other
+             * thread is crawling a directory that could add more. */
+            while (list_empty(&defrag->crawl_queue) && defrag->crawl_busy &&
+                   (defrag->defrag_status == GF_DEFRAG_STATUS_STARTED)) {
+                pthread_cond_wait(&defrag->crawl_cond, &defrag->crawl_mutex);
+            }
+
+            if (list_empty(&defrag->crawl_queue) ||
+                (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED)) {
+                pthread_cond_broadcast(&defrag->crawl_cond);
+                pthread_mutex_unlock(&defrag->crawl_mutex);
+                break;
+            }
+
+            dir = list_first_entry(&defrag->crawl_queue, gf_defrag_dir_t,
+                                   list);
+            list_del_init(&dir->list);
+            defrag->crawl_queue_count--;
+            defrag->crawl_busy++;
+        }
+        pthread_mutex_unlock(&defrag->crawl_mutex);
+
+        ret = gf_defrag_crawl_dir(this, defrag, dir, args->fix_layout,
+                                  args->migrate_data);
+        if (ret) {
+            dir->failed = 1;
+            gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_LAYOUT_FIX_FAILED,
+                   "Fix layout failed for %s", dir->loc.path);
+
+            if (conf->decommission_in_progress) {
+                defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
+            }
+        }
+
+        gf_defrag_dir_put(defrag, dir);
+
+        pthread_mutex_lock(&defrag->crawl_mutex);
+        {
+            if (--defrag->crawl_busy == 0) {
+                pthread_cond_broadcast(&defrag->crawl_cond);
+            }
+        }
+        pthread_mutex_unlock(&defrag->crawl_mutex);
+    }
+
+    return NULL;
+}
+
+/*
+ * Crawls the whole volume starting at 'loc', fixing the layout of every
+ * directory and queueing its files for the migration threads.
+ *
+ * The root directory is crawled by the caller. Subdirectories found by any
+ * crawler are put in a bounded queue shared by the crawler threads, or
+ * crawled right away by the thread that found them when the queue is
+ * full. Each directory stays allocated until its whole subtree is done,
+ * including the migration of the files queued from it, at which point its
+ * gfid is appended to the checkpoint file. A rebalance restarted after an
+ * interruption skips those subtrees.
+ */
+static int
+gf_defrag_crawl(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
+                dict_t *fix_layout, dict_t *migrate_data)
+{
+    gf_defrag_crawl_args_t args = {
+        .defrag = defrag,
+        .fix_layout = fix_layout,
+        .migrate_data = migrate_data,
+    };
+    gf_defrag_dir_t *root = NULL;
+    gf_defrag_dir_t *dir = NULL;
+    pthread_t *tid = NULL;
+    int thread_cnt = 0;
+    int ret = -1;
+    int i = 0;
+
+    gf_defrag_checkpoint_init(this, defrag);
+
+    root = gf_defrag_dir_new(NULL);
+    if (!root) {
+        goto out;
+    }
+
+    if (loc_copy(&root->loc, loc) != 0) {
+        gf_defrag_dir_put(defrag, root);
+        goto out;
+    }
+
+    ret = gf_defrag_lookup_dir(this, defrag, &root->loc);
+    if (ret) {
+        root->failed = 1;
+        gf_defrag_dir_put(defrag, root);
+        ret = (ret < 0) ? -1 : 0;
+        goto out;
+    }
+
+    /* The root counts as being crawled, so that the crawler threads wait
+     * for the subdirectories it will queue. */
+    defrag->crawl_busy = 1;
+
+    if (defrag->crawl_threads > 1) {
+        tid = GF_CALLOC(defrag->crawl_threads, sizeof(pthread_t),
+                        gf_common_mt_pthread_t);
+    }
+
+    /* The caller is one of the crawlers */
+    for (i = 1; tid && (i < defrag->crawl_threads); i++) {
+        if (gf_thread_create(&tid[thread_cnt], NULL, gf_defrag_crawl_task,
+                             &args, "dhtcrawl%d", i & 0x3ff) != 0) {
+            gf_msg(this->name, GF_LOG_WARNING, 0, 0,
+                   "Failed to create crawler thread %d of %d", i,
+                   defrag->crawl_threads - 1);
+            break;
+        }
+        thread_cnt++;
+    }
+
+    if (!thread_cnt) {
+        /* Nobody would pick queued directories up */
+        defrag->crawl_threads = 1;
+    }
+
+    gf_msg_debug(this->name, 0, "crawling with %d threads", thread_cnt + 1);
+
+    ret = gf_defrag_crawl_dir(this, defrag, root, fix_layout, migrate_data);
+    if (ret) {
+        root->failed = 1;
+    }
+    gf_defrag_dir_put(defrag, root);
+
+    pthread_mutex_lock(&defrag->crawl_mutex);
+    {
+        if (--defrag->crawl_busy == 0) {
+            pthread_cond_broadcast(&defrag->crawl_cond);
+        }
+    }
+    pthread_mutex_unlock(&defrag->crawl_mutex);
+
+    for (i = 0; i < thread_cnt; i++) {
+        pthread_join(tid[i], NULL);
+    }
+
+    /* Directories still queued if the rebalance was stopped or failed */
+    while (!list_empty(&defrag->crawl_queue)) {
+        dir = list_first_entry(&defrag->crawl_queue, gf_defrag_dir_t, list);
+        list_del_init(&dir->list);
+        defrag->crawl_queue_count--;
+        dir->failed = 1;
+        gf_defrag_dir_put(defrag, dir);
+    }
+
+out:
+    GF_FREE(tid);
+
+    return ret;
+}
+
 static int
 dht_init_local_subvols_and_nodeuuids(xlator_t *this, dht_conf_t *conf,
                                      loc_t *loc)
@@ -4241,7 +4761,7 @@ gf_defrag_start_crawl(void *data)
     if (ret) {
         gf_log(this->name, GF_LOG_ERROR, "Failed to set %s",
                conf->commithash_xattr_name);
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -4252,7 +4772,7 @@ gf_defrag_start_crawl(void *data)
                "Failed to set commit hash on %s. "
                "Rebalance cannot proceed.",
                loc.path);
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -4265,7 +4785,7 @@ gf_defrag_start_crawl(void *data)
                "Failed to start rebalance:"
                "Failed to set dictionary value: key = %s",
                GF_XATTR_FIX_LAYOUT_KEY);
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -4276,7 +4796,7 @@ gf_defrag_start_crawl(void *data)
     if (ret) {
         gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_REBALANCE_FAILED,
                "fix layout on %s failed", loc.path);
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -4286,7 +4806,7 @@ gf_defrag_start_crawl(void *data)
 
         migrate_data = dict_new();
         if (!migrate_data) {
-            defrag->total_failures++;
+            gf_defrag_failure_inc(defrag);
             ret = -1;
             goto out;
         }
@@ -4294,7 +4814,7 @@ gf_defrag_start_crawl(void *data)
             migrate_data, GF_XATTR_FILE_MIGRATE_KEY,
             (defrag->cmd == GF_DEFRAG_CMD_START_FORCE) ? "force" : "non-force");
         if (ret) {
-            defrag->total_failures++;
+            gf_defrag_failure_inc(defrag);
             ret = -1;
             goto out;
         }
@@ -4322,14 +4842,14 @@ gf_defrag_start_crawl(void *data)
         }
     }
 
-    ret = gf_defrag_fix_layout(this, defrag, &loc, fix_layout, migrate_data);
+    ret = gf_defrag_crawl(this, defrag, &loc, fix_layout, migrate_data);
     if (ret) {
         ret = -1;
         goto out;
     }
 
     if (gf_defrag_settle_hash(this, defrag, &loc, fix_layout) != 0) {
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -4370,6 +4890,10 @@ out:
 
     dht_send_rebalance_event(this, defrag->cmd, defrag->defrag_status);
 
+    gf_defrag_checkpoint_fini(defrag);
+    pthread_cond_destroy(&defrag->crawl_cond);
+    pthread_mutex_destroy(&defrag->crawl_mutex);
+
     GF_FREE(defrag);
     conf->defrag = NULL;
 
@@ -15,6 +15,7 @@
         layout->list[i].start = srt;                                           \
         layout->list[i].stop = srt + chunk - 1;                                \
         layout->list[i].commit_hash = layout->commit_hash;                     \
+        layout->index_cnt = 0;                                                 \
                                                                                \
         gf_msg_trace(this->name, 0,                                            \
                      "gave fix: 0x%x - 0x%x, with commit-hash 0x%x"            \
@@ -31,6 +32,7 @@
             layout->list[cnt].start = 0;                                       \
             layout->list[cnt].stop = 0;                                        \
         }                                                                      \
+        layout->index_cnt = 0;                                                 \
     } while (0)
 
 static int
@@ -38,6 +40,10 @@ dht_selfheal_layout_lock(call_frame_t *frame, dht_layout_t *layout,
                          gf_boolean_t newdir, dht_selfheal_layout_t healer,
                          dht_need_heal_t should_heal);
 
+static void
+dht_selfheal_layout_new_jump(call_frame_t *frame, loc_t *loc,
+                             dht_layout_t *layout, dht_layout_t *old);
+
 static uint32_t
 dht_overlap_calc(dht_layout_t *old, int o, dht_layout_t *new, int n)
 {
@@ -493,6 +499,10 @@ dht_should_fix_layout(call_frame_t *frame, dht_layout_t **inmem,
     if ((*inmem)->commit_hash != (*ondisk)->commit_hash)
         goto out;
 
+    /* Same if the layout type is being changed */
+    if ((*inmem)->type != (*ondisk)->type)
+        goto out;
+
     layout_span = dht_layout_span(*ondisk);
 
     decommissioned_bricks = dht_decommissioned_bricks_in_layout(frame->this,
@@ -1683,6 +1693,12 @@ dht_fix_layout_of_directory(call_frame_t *frame, loc_t *loc,
                 NULL);
     }
 
+    /* Jump layouts keep the buckets of the current subvolumes instead */
+    if (priv->layout_type == DHT_HASH_TYPE_JUMP) {
+        dht_selfheal_layout_new_jump(frame, loc, new_layout, layout);
+        goto done;
+    }
+
     /* First give it a layout as though it is a new directory. This
        ensures rotation to kick in */
     dht_layout_sort_volname(new_layout);
@@ -1732,6 +1748,148 @@ dht_get_chunks_from_xl(xlator_t *parent, xlator_t *child)
     return 0;
 }
 
+/*
+ * Gives the subvolumes of a jump layout their buckets, in proportion to
+ * their size when weighted-rebalance is on. If 'old' is a well-formed
+ * jump layout and none of its subvolumes is going away, they keep their
+ * buckets and only the new subvolumes get buckets, after the last one.
+ * Then only the names that land on the new buckets have to be migrated.
+ * Otherwise all the buckets are given again.
+ */
+static void
+dht_selfheal_layout_new_jump(call_frame_t *frame, loc_t *loc,
+                             dht_layout_t *layout, dht_layout_t *old)
+{
+    xlator_t *this = NULL;
+    dht_conf_t *priv = NULL;
+    dht_layout_entry_t *entry = NULL;
+    gf_boolean_t weight_by_size;
+    gf_boolean_t keep = _gf_false;
+    uint64_t total_size = 0;
+    uint64_t kept_size = 0;
+    uint32_t curr_size = 0;
+    uint32_t holes = 0;
+    uint32_t overlaps = 0;
+    uint32_t buckets = 0;
+    uint32_t count = 0;
+    double per_unit = 0;
+    int bricks_to_use = 0;
+    int bricks_used = 0;
+    int eligible = 0;
+    int start_subvol = 0;
+    int real_i = 0;
+    int i = 0;
+    int j = 0;
+    int err = 0;
+
+    this = frame->this;
+    priv = this->private;
+    weight_by_size = priv->do_weighting;
+
+    bricks_to_use = dht_get_layout_count(this, layout, 1);
+    GF_ASSERT(bricks_to_use > 0);
+
+    for (i = 0; i < layout->cnt; i++) {
+        err = layout->list[i].err;
+        if ((err != -1) && (err != ENOENT)) {
+            continue;
+        }
+        eligible++;
+        curr_size = dht_get_chunks_from_xl(this, layout->list[i].xlator);
+        if (!curr_size) {
+            weight_by_size = _gf_false;
+        }
+        total_size += curr_size;
+    }
+
+    if (old && (old->type == DHT_HASH_TYPE_JUMP)) {
+        dht_layout_anomalies(this, loc, old, &holes, &overlaps, NULL, NULL,
+                             NULL, NULL);
+        keep = !holes && !overlaps;
+    }
+
+    DHT_RESET_LAYOUT_RANGE(layout);
+    layout->type = DHT_HASH_TYPE_JUMP;
+
+    /* First the subvolumes that already have buckets */
+    for (i = 0; keep && (i < old->cnt); i++) {
+        entry = &old->list[i];
+        if (entry->err || (entry->start == entry->stop)) {
+            continue;
+        }
+        for (j = 0; j < layout->cnt; j++) {
+            if (layout->list[j].xlator == entry->xlator) {
+                break;
+            }
+        }
+        err = (j < layout->cnt) ? layout->list[j].err : EINVAL;
+        if ((err != -1) && (err != ENOENT)) {
+            gf_msg_debug(this->name, 0,
+                         "%s leaves the layout of %s, giving all buckets "
+                         "again",
+                         entry->xlator->name, loc->path);
+            keep = _gf_false;
+            break;
+        }
+        DHT_SET_LAYOUT_RANGE(layout, j, entry->start,
+                             entry->stop - entry->start + 1, loc->path);
+        if (entry->stop > buckets) {
+            buckets = entry->stop;
+        }
+        kept_size += weight_by_size
+                         ? dht_get_chunks_from_xl(this, entry->xlator)
+                         : 1;
+        bricks_used++;
+    }
+
+    if (keep && kept_size) {
+        per_unit = (double)buckets / (double)kept_size;
+    } else {
+        if (buckets) {
+            DHT_RESET_LAYOUT_RANGE(layout);
+            buckets = 0;
+            bricks_used = 0;
+        }
+        if (weight_by_size && total_size) {
+            per_unit = ((double)DHT_JUMP_BUCKETS * eligible) /
+                       (double)total_size;
+        } else {
+            weight_by_size = _gf_false;
+            per_unit = DHT_JUMP_BUCKETS;
+        }
+    }
+
+    /* Then the new ones, with buckets appended after the last one */
+    start_subvol = dht_selfheal_layout_alloc_start(this, loc, layout);
+    for (real_i = 0; real_i < layout->cnt; real_i++) {
+        if (bricks_used >= bricks_to_use) {
+            break;
+        }
+        i = (real_i + start_subvol) % layout->cnt;
+        err = layout->list[i].err;
+        if ((err != -1) && (err != ENOENT)) {
+            continue;
+        }
+        if (layout->list[i].start != layout->list[i].stop) {
+            continue;
+        }
+        curr_size = weight_by_size
+                        ? dht_get_chunks_from_xl(this, layout->list[i].xlator)
+                        : 1;
+        /* Two buckets at least, so that start != stop as for any other
+         * subvolume taking part in a layout. */
+        count = per_unit * curr_size + 0.5;
+        if (count < 2) {
+            count = 2;
+        }
+        gf_msg_debug(this->name, 0, "assigning %u buckets to %s", count,
+                     layout->list[i].xlator->name);
+        DHT_SET_LAYOUT_RANGE(layout, i, buckets + 1, count, loc->path);
+        buckets += count;
+        bricks_used++;
+    }
+}
+
 void
 dht_selfheal_layout_new_directory(call_frame_t *frame, loc_t *loc,
                                   dht_layout_t *layout)
@@ -1755,6 +1913,15 @@ dht_selfheal_layout_new_directory(call_frame_t *frame, loc_t *loc,
     priv = this->private;
     weight_by_size = priv->do_weighting;
 
+    if (priv->layout_type == DHT_HASH_TYPE_JUMP) {
+        dht_selfheal_layout_new_jump(frame, loc, layout, NULL);
+        return;
+    }
+
+    if (layout->type == DHT_HASH_TYPE_JUMP) {
+        layout->type = DHT_HASH_TYPE_DM;
+    }
+
     bricks_to_use = dht_get_layout_count(this, layout, 1);
     GF_ASSERT(bricks_to_use > 0);
 
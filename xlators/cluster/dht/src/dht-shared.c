@@ -290,6 +290,16 @@ out:
     return ret;
 }
 
+static dht_hashfn_type_t
+dht_layout_type_from_str(const char *str)
+{
+    if (str && !strcmp(str, "jump")) {
+        return DHT_HASH_TYPE_JUMP;
+    }
+
+    return DHT_HASH_TYPE_DM;
+}
+
 static void
 dht_decommissioned_remove(xlator_t *this, dht_conf_t *conf)
 {
@@ -516,6 +526,9 @@ dht_reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("weighted-rebalance", conf->do_weighting, options, bool,
                      out);
 
+    GF_OPTION_RECONF("layout-type", temp_str, options, str, out);
+    conf->layout_type = dht_layout_type_from_str(temp_str);
+
     GF_OPTION_RECONF("use-readdirp", conf->use_readdirp, options, bool, out);
     ret = 0;
 out:
@@ -698,6 +711,16 @@ dht_init(xlator_t *this)
         pthread_cond_init(&defrag->fc_wakeup_cond, 0);
 
         defrag->global_error = 0;
+
+        pthread_mutex_init(&defrag->crawl_mutex, 0);
+        pthread_cond_init(&defrag->crawl_cond, 0);
+        INIT_LIST_HEAD(&defrag->crawl_queue);
+
+        defrag->checkpoint_fd = -1;
+        if (dict_get_str(this->options, "rebalance-checkpoint", &temp_str) ==
+            0) {
+            defrag->checkpoint_path = gf_strdup(temp_str);
+        }
     }
 
     conf->use_fallocate = 1;
@@ -748,6 +771,8 @@ dht_init(xlator_t *this)
         defrag->lock_migration_enabled = conf->lock_migration_enabled;
 
         GF_OPTION_INIT("rebalance-stats", defrag->stats, bool, err);
+        GF_OPTION_INIT("rebal-crawl-threads", defrag->crawl_threads, int32,
+                       err);
         if (dict_get_str(this->options, "rebalance-filter", &temp_str) == 0) {
             if (gf_defrag_pattern_list_fill(this, defrag, temp_str) == -1) {
                 gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_INVALID_OPTION,
@@ -831,6 +856,9 @@ dht_init(xlator_t *this)
 
     GF_OPTION_INIT("weighted-rebalance", conf->do_weighting, bool, err);
 
+    GF_OPTION_INIT("layout-type", temp_str, str, err);
+    conf->layout_type = dht_layout_type_from_str(temp_str);
+
     conf->lock_pool = mem_pool_new(dht_lock_t, 512);
     if (!conf->lock_pool) {
         gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_INIT_FAILED,
@@ -973,6 +1001,10 @@ struct volume_options dht_options[] = {
         .key = {"node-uuid"},
         .type = GF_OPTION_TYPE_STR,
     },
+    {
+        .key = {"rebalance-checkpoint"},
+        .type = GF_OPTION_TYPE_PATH,
+    },
     {
         .key = {"rebalance-stats"},
         .type = GF_OPTION_TYPE_BOOL,
@@ -1042,6 +1074,21 @@ struct volume_options dht_options[] = {
      .level = OPT_STATUS_BASIC,
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
 
+    {.key = {"layout-type"},
+     .type = GF_OPTION_TYPE_STR,
+     .value = {"range", "jump"},
+     .default_value = "range",
+     .description =
+         "Layout given to new directories and to directories fixed by "
+         "rebalance. 'range' splits the hash space between the bricks. "
+         "'jump' maps names to bricks with a jump consistent hash, so that "
+         "adding bricks only moves the files that go to the new bricks. "
+         "Existing directories change their layout on the next "
+         "fix-layout.",
+     .op_version = {GD_OP_VERSION_11_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
     /* NUFA option */
     {.key = {"local-volume-name"}, .type = GF_OPTION_TYPE_XLATOR},
 
@@ -1060,6 +1107,18 @@ struct volume_options dht_options[] = {
         .op_version = {GD_OP_VERSION_3_6_0},
     },
 
+    {.key = {"rebal-crawl-threads"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 64,
+     .default_value = "4",
+     .description = "Number of threads crawling directories on a node "
+                    "during the rebalance operation. Each thread fixes the "
+                    "layout of a directory and queues its files for the "
+                    "migration threads.",
+     .op_version = {GD_OP_VERSION_11_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"rebal-throttle"},
      .type = GF_OPTION_TYPE_STR,
      .default_value = "normal",
@@ -11,12 +11,6 @@
 #include <glusterfs/xlator.h>
 #include "dht-common.h"
 
-int
-dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p)
-{
-    return 0;
-}
-
 int
 dht_inode_ctx_layout_get(inode_t *inode, xlator_t *this, dht_layout_t **layout)
 {
@@ -56,13 +50,6 @@ _gf_log_callingfn(const char *domain, const char *file, const char *function,
     return 0;
 }
 
-void
-gf_uuid_unparse(const uuid_t uu, char *out)
-{
-    // could call a will-return function here
-    // to place the correct data in *out
-}
-
 int
 _gf_msg(const char *domain, const char *file, const char *function,
         int32_t line, gf_loglevel_t level, int errnum, int trace,
@@ -70,3 +57,11 @@ _gf_msg(const char *domain, const char *file, const char *function,
 {
     return 0;
 }
+
+int
+_gf_smsg(const char *domain, const char *file, const char *function,
+         int32_t line, gf_loglevel_t level, int errnum, int trace,
+         uint64_t msgid, const char *event, ...)
+{
+    return 0;
+}
@@ -33,20 +33,21 @@ helper_xlator_init(uint32_t num_types)
 
     xl = test_calloc(1, sizeof(xlator_t));
     assert_non_null(xl);
-    xl->mem_acct->num_types = num_types;
-    xl->mem_acct = test_calloc(sizeof(struct mem_acct) +
-                               sizeof(struct mem_acct_rec) + num_types);
+    xl->name = "dht-unittest";
+    xl->mem_acct = test_calloc(1, sizeof(struct mem_acct) +
+                                      sizeof(struct mem_acct_rec) * num_types);
     assert_non_null(xl->mem_acct);
+    xl->mem_acct->num_types = num_types;
 
     xl->ctx = test_calloc(1, sizeof(glusterfs_ctx_t));
     assert_non_null(xl->ctx);
 
     for (i = 0; i < num_types; i++) {
-        ret = LOCK_INIT(&(xl->mem_acct.rec[i].lock));
+        ret = LOCK_INIT(&(xl->mem_acct->rec[i].lock));
         assert_false(ret);
     }
 
-    ENSURE(num_types == xl->mem_acct.num_types);
+    ENSURE(num_types == xl->mem_acct->num_types);
     ENSURE(NULL != xl);
 
     return xl;
@@ -57,17 +58,70 @@ helper_xlator_destroy(xlator_t *xl)
 {
     int i, ret;
 
-    for (i = 0; i < xl->mem_acct.num_types; i++) {
-        ret = LOCK_DESTROY(&(xl->mem_acct.rec[i].lock));
+    for (i = 0; i < xl->mem_acct->num_types; i++) {
+        ret = LOCK_DESTROY(&(xl->mem_acct->rec[i].lock));
         assert_int_equal(ret, 0);
     }
 
-    free(xl->mem_acct.rec);
+    free(xl->mem_acct);
     free(xl->ctx);
     free(xl);
     return 0;
 }
 
+/* An xlator with a dht configuration, and 'cnt' subvolumes. */
+static xlator_t *
+helper_dht_init(xlator_t *subvols, int cnt)
+{
+    xlator_t *xl;
+    int i;
+
+    xl = helper_xlator_init(10);
+    xl->private = test_calloc(1, sizeof(dht_conf_t));
+    assert_non_null(xl->private);
+
+    memset(subvols, 0, sizeof(xlator_t) * cnt);
+    for (i = 0; i < cnt; i++) {
+        subvols[i].name = "dht-unittest-subvol";
+    }
+
+    return xl;
+}
+
+static void
+helper_dht_destroy(xlator_t *xl)
+{
+    free(xl->private);
+    helper_xlator_destroy(xl);
+}
+
+static void
+helper_layout_range(dht_layout_t *layout, int i, uint32_t start,
+                    uint32_t stop, xlator_t *subvol)
+{
+    layout->list[i].start = start;
+    layout->list[i].stop = stop;
+    layout->list[i].xlator = subvol;
+    layout->list[i].err = 0;
+}
+
+/* Hashed subvolume of 'name', found by walking the whole layout, as
+ * dht_layout_search() does without index. */
+static xlator_t *
+helper_layout_walk(xlator_t *xl, dht_layout_t *layout, const char *name)
+{
+    uint32_t hash = 0;
+    int i;
+
+    assert_int_equal(dht_hash_compute(xl, layout->type, name, &hash), 0);
+    for (i = 0; i < layout->cnt; i++) {
+        if ((layout->list[i].start <= hash) && (layout->list[i].stop >= hash))
+            return layout->list[i].xlator;
+    }
+
+    return NULL;
+}
+
 /*
  * Unit tests
  */
@@ -116,11 +170,238 @@ test_dht_layout_new(void **state)
     helper_xlator_destroy(xl);
 }
 
+static void
+test_dht_layout_search_boundaries(void **state)
+{
+    xlator_t *xl;
+    xlator_t subvols[4];
+    dht_layout_t *layout;
+    const char *name = "file";
+    uint32_t hash = 0;
+    int i;
+
+    xl = helper_dht_init(subvols, 4);
+    assert_int_equal(dht_hash_compute(xl, DHT_HASH_TYPE_DM, name, &hash), 0);
+    assert_true((hash > 1) && (hash < 0xfffffffe));
+
+    layout = dht_layout_new(xl, 4);
+    assert_non_null(layout);
+
+    /* The hash of the name starts a range, entries are not sorted. */
+    helper_layout_range(layout, 0, hash, 0xfffffffe, &subvols[0]);
+    helper_layout_range(layout, 1, 0, hash - 2, &subvols[1]);
+    helper_layout_range(layout, 2, 0xffffffff, 0xffffffff, &subvols[2]);
+    helper_layout_range(layout, 3, hash - 1, hash - 1, &subvols[3]);
+    assert_int_equal(dht_layout_set(xl, NULL, layout), 0);
+    assert_int_equal(layout->index_cnt, 4);
+    for (i = 1; i < layout->index_cnt; i++) {
+        assert_true(layout->index[i - 1].stop < layout->index[i].start);
+    }
+    assert_ptr_equal(dht_layout_search(xl, layout, name), &subvols[0]);
+
+    /* It ends a range. */
+    helper_layout_range(layout, 0, hash + 1, 0xfffffffe, &subvols[0]);
+    helper_layout_range(layout, 3, hash - 1, hash, &subvols[3]);
+    layout->index_cnt = 0;
+    assert_int_equal(dht_layout_set(xl, NULL, layout), 0);
+    assert_int_equal(layout->index_cnt, 4);
+    assert_ptr_equal(dht_layout_search(xl, layout, name), &subvols[3]);
+
+    /* It's the only value of a range. */
+    helper_layout_range(layout, 3, hash - 1, hash - 1, &subvols[3]);
+    helper_layout_range(layout, 2, hash, hash, &subvols[2]);
+    helper_layout_range(layout, 0, hash + 1, 0xffffffff, &subvols[0]);
+    layout->index_cnt = 0;
+    assert_int_equal(dht_layout_set(xl, NULL, layout), 0);
+    assert_int_equal(layout->index_cnt, 4);
+    assert_ptr_equal(dht_layout_search(xl, layout, name), &subvols[2]);
+
+    /* It falls in a hole between two ranges. */
+    helper_layout_range(layout, 2, hash + 1, hash + 1, &subvols[2]);
+    helper_layout_range(layout, 0, hash + 2, 0xffffffff, &subvols[0]);
+    layout->index_cnt = 0;
+    assert_int_equal(dht_layout_set(xl, NULL, layout), 0);
+    assert_int_equal(layout->index_cnt, 4);
+    assert_null(dht_layout_search(xl, layout, name));
+
+    /* Overlapping ranges keep the first matching entry. */
+    helper_layout_range(layout, 0, 0, 0xffffffff, &subvols[0]);
+    helper_layout_range(layout, 1, hash, hash, &subvols[1]);
+    layout->index_cnt = 0;
+    assert_int_equal(dht_layout_set(xl, NULL, layout), 0);
+    assert_int_equal(layout->index_cnt, 0);
+    assert_ptr_equal(dht_layout_search(xl, layout, name), &subvols[0]);
+
+    free(layout);
+    helper_dht_destroy(xl);
+}
+
+static void
+test_dht_layout_search_index(void **state)
+{
+    xlator_t *xl;
+    xlator_t subvols[7];
+    dht_layout_t *layout;
+    char name[32];
+    uint32_t chunk = 0xffffffff / 5;
+    int i;
+
+    xl = helper_dht_init(subvols, 7);
+    layout = dht_layout_new(xl, 7);
+    assert_non_null(layout);
+
+    /* Five ranges in reverse order, one subvolume with the empty 0-0 range
+     * and one with an error. */
+    for (i = 0; i < 5; i++) {
+        helper_layout_range(layout, 4 - i, i * chunk,
+                            (i == 4) ? 0xffffffff : (i + 1) * chunk - 1,
+                            &subvols[i]);
+    }
+    helper_layout_range(layout, 5, 0, 0, &subvols[5]);
+    helper_layout_range(layout, 6, 0, 0, &subvols[6]);
+    layout->list[6].err = ENOENT;
+
+    assert_int_equal(dht_layout_set(xl, NULL, layout), 0);
+    assert_int_equal(layout->index_cnt, 5);
+    assert_true(layout->index_zero);
+
+    /* The index finds the same subvolume as walking the layout. */
+    for (i = 0; i < 1000; i++) {
+        snprintf(name, sizeof(name), "file-%d", i);
+        assert_ptr_equal(dht_layout_search(xl, layout, name),
+                         helper_layout_walk(xl, layout, name));
+    }
+
+    free(layout);
+    helper_dht_destroy(xl);
+}
+
+static void
+test_dht_layout_search_jump(void **state)
+{
+    xlator_t *xl;
+    xlator_t subvols[3];
+    xlator_t *subvol;
+    dht_layout_t *layout;
+    char name[32];
+    uint32_t hash = 0;
+    uint32_t bucket = 0;
+    int hits[3] = {0, 0, 0};
+    int i;
+
+    xl = helper_dht_init(subvols, 3);
+    layout = dht_layout_new(xl, 3);
+    assert_non_null(layout);
+
+    /* Buckets are numbered from 1, the first and the last one are each
+     * owned by a subvolume of their own. */
+    layout->type = DHT_HASH_TYPE_JUMP;
+    helper_layout_range(layout, 0, 2, 31, &subvols[0]);
+    helper_layout_range(layout, 1, 1, 1, &subvols[1]);
+    helper_layout_range(layout, 2, 32, 32, &subvols[2]);
+    assert_int_equal(dht_layout_set(xl, NULL, layout), 0);
+    assert_int_equal(layout->index_cnt, 3);
+
+    for (i = 0; i < 10000; i++) {
+        snprintf(name, sizeof(name), "file-%d", i);
+        assert_int_equal(dht_hash_compute(xl, layout->type, name, &hash), 0);
+        bucket = dht_jump_hash(hash, 32) + 1;
+        assert_in_range(bucket, 1, 32);
+
+        subvol = dht_layout_search(xl, layout, name);
+        assert_non_null(subvol);
+        if (bucket == 1) {
+            assert_ptr_equal(subvol, &subvols[1]);
+        } else if (bucket == 32) {
+            assert_ptr_equal(subvol, &subvols[2]);
+        } else {
+            assert_ptr_equal(subvol, &subvols[0]);
+        }
+        hits[subvol - subvols]++;
+    }
+
+    /* About 1/32 of the names for each single bucket subvolume. */
+    assert_in_range(hits[1], 10000 / 64, 10000 / 16);
+    assert_in_range(hits[2], 10000 / 64, 10000 / 16);
+
+    free(layout);
+    helper_dht_destroy(xl);
+}
+
+static void
+test_dht_jump_hash_add_brick(void **state)
+{
+    xlator_t *xl;
+    xlator_t subvols[3];
+    xlator_t *before;
+    xlator_t *after;
+    dht_layout_t *layout;
+    char name[32];
+    uint32_t hash = 0;
+    uint32_t bucket = 0;
+    int moved = 0;
+    int i;
+
+    /* Growing from n to m buckets only moves hashes to the new buckets. */
+    for (i = 0; i < 100000; i++) {
+        hash = i * 2654435761U;
+        assert_int_equal(dht_jump_hash(hash, 1), 0);
+        bucket = dht_jump_hash(hash, 32);
+        assert_true(bucket < 32);
+        assert_int_equal(dht_jump_hash(hash, 32), bucket);
+        if (dht_jump_hash(hash, 48) != bucket) {
+            assert_true(dht_jump_hash(hash, 48) >= 32);
+            moved++;
+        }
+    }
+    /* 16 / 48 of them, within 5% */
+    assert_in_range(moved, 100000 / 3 - 5000, 100000 / 3 + 5000);
+
+    /* Same through a layout, when a third brick gets the buckets 33-48. */
+    xl = helper_dht_init(subvols, 3);
+    layout = dht_layout_new(xl, 3);
+    assert_non_null(layout);
+    layout->type = DHT_HASH_TYPE_JUMP;
+
+    moved = 0;
+    for (i = 0; i < 10000; i++) {
+        snprintf(name, sizeof(name), "file-%d", i);
+
+        helper_layout_range(layout, 0, 1, 16, &subvols[0]);
+        helper_layout_range(layout, 1, 17, 32, &subvols[1]);
+        helper_layout_range(layout, 2, 0, 0, &subvols[2]);
+        layout->index_cnt = 0;
+        assert_int_equal(dht_layout_set(xl, NULL, layout), 0);
+        before = dht_layout_search(xl, layout, name);
+        assert_non_null(before);
+        assert_true(before != &subvols[2]);
+
+        helper_layout_range(layout, 2, 33, 48, &subvols[2]);
+        layout->index_cnt = 0;
+        assert_int_equal(dht_layout_set(xl, NULL, layout), 0);
+        after = dht_layout_search(xl, layout, name);
+        assert_non_null(after);
+
+        if (after != before) {
+            assert_ptr_equal(after, &subvols[2]);
+            moved++;
+        }
+    }
+    assert_in_range(moved, 10000 / 3 - 500, 10000 / 3 + 500);
+
+    free(layout);
+    helper_dht_destroy(xl);
+}
+
 int
 main(void)
 {
     const struct CMUnitTest xlator_dht_layout_tests[] = {
-        unit_test(test_dht_layout_new),
+        cmocka_unit_test(test_dht_layout_new),
+        cmocka_unit_test(test_dht_layout_search_boundaries),
+        cmocka_unit_test(test_dht_layout_search_index),
+        cmocka_unit_test(test_dht_layout_search_jump),
+        cmocka_unit_test(test_dht_jump_hash_add_brick),
     };
 
     return cmocka_run_group_tests(xlator_dht_layout_tests, NULL, NULL);
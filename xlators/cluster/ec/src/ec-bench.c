@@ -0,0 +1,457 @@
+/*
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* Micro-benchmark of the encoding and decoding functions of the disperse
+ * translator. It links the matrix, galois field and code generation sources
+ * directly, so no volume is needed. It is built, but not installed, along
+ * with the translator:
+ *
+ *     xlators/cluster/ec/src/ec-bench
+ *
+ * Dynamic code needs the directory GLUSTERFS_LIBEXECDIR to exist. If it
+ * doesn't, the precompiled C code is used and reported as "none". */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <glusterfs/globals.h>
+#include <glusterfs/mem-pool.h>
+#include <glusterfs/logging.h>
+#include <glusterfs/iobuf.h>
+
+#include "ec-method.h"
+#include "ec-code.h"
+
+#define EC_BENCH_DEFAULT_LAYOUTS "2:1,4:2,8:3,8:4,16:4"
+#define EC_BENCH_DEFAULT_SIZES "64K,1M"
+#define EC_BENCH_DEFAULT_EXTENSIONS "none,x64,sse,avx,avx512"
+#define EC_BENCH_DEFAULT_TIME 0.5
+
+typedef struct _ec_bench_result {
+    double seconds;
+    uint64_t cycles;
+    uint64_t bytes;
+} ec_bench_result_t;
+
+typedef struct _ec_bench {
+    double time;
+    gf_boolean_t verbose;
+    uint32_t fragments;
+    uint32_t nodes;
+    uint64_t size;
+    ec_matrix_list_t list;
+    uint8_t *data;
+    uint8_t *blocks;
+    uint8_t *output;
+    void *buffers[3];
+    void *block_list[EC_METHOD_MAX_FRAGMENTS * 2];
+} ec_bench_t;
+
+static uint64_t
+ec_bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static double
+ec_bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+ec_bench_start(ec_bench_result_t *res, double *start, uint64_t *cycles)
+{
+    memset(res, 0, sizeof(*res));
+    *start = ec_bench_now();
+    *cycles = ec_bench_cycles();
+}
+
+static void
+ec_bench_stop(ec_bench_result_t *res, double start, uint64_t cycles)
+{
+    res->cycles += ec_bench_cycles() - cycles;
+    res->seconds += ec_bench_now() - start;
+}
+
+static void
+ec_bench_print(ec_bench_t *bench, const char *ext, const char *op,
+               const char *mask, ec_bench_result_t *res)
+{
+    char cpb[32] = "-";
+
+    if (res->cycles != 0) {
+        snprintf(cpb, sizeof(cpb), "%.3f", (double)res->cycles / res->bytes);
+    }
+
+    printf("%2u+%-2u  %9" PRIu64 "  %-7s %-7s %-10s %8.3f  %8s\n",
+           bench->fragments, bench->nodes - bench->fragments, bench->size,
+           ext, op, mask, res->bytes / res->seconds / 1e9, cpb);
+}
+
+static void
+ec_bench_encode(ec_bench_t *bench, ec_bench_result_t *res)
+{
+    uint64_t cycles;
+    double start;
+    uint32_t i;
+
+    ec_bench_start(res, &start, &cycles);
+    do {
+        /* ec_method_encode() advances the output pointers. */
+        for (i = 0; i < bench->nodes; i++) {
+            bench->block_list[i] = bench->blocks +
+                                   i * (bench->size / bench->fragments);
+        }
+        ec_method_encode(&bench->list, bench->size, bench->data,
+                         bench->block_list);
+        res->bytes += bench->size;
+    } while (ec_bench_now() - start < bench->time);
+    ec_bench_stop(res, start, cycles);
+}
+
+static int32_t
+ec_bench_decode(ec_bench_t *bench, uintptr_t mask, double time,
+                ec_bench_result_t *res)
+{
+    uint32_t rows[EC_METHOD_MAX_FRAGMENTS];
+    void *in[EC_METHOD_MAX_FRAGMENTS];
+    uint64_t fsize, cycles;
+    double start;
+    uint32_t i, pos;
+    int32_t err;
+
+    fsize = bench->size / bench->fragments;
+    pos = 0;
+    for (i = 0; i < bench->nodes; i++) {
+        if ((mask & (1ULL << i)) != 0) {
+            rows[pos] = i + 1;
+            in[pos++] = bench->blocks + i * fsize;
+        }
+    }
+
+    /* The first call builds the decoding matrix. Don't measure it. */
+    err = ec_method_decode(&bench->list, fsize, mask, rows, in,
+                           bench->output);
+    if (err != 0) {
+        return err;
+    }
+    if (memcmp(bench->output, bench->data, bench->size) != 0) {
+        fprintf(stderr, "Decoded data doesn't match for mask %lx\n",
+                (unsigned long)mask);
+        return -EIO;
+    }
+
+    ec_bench_start(res, &start, &cycles);
+    do {
+        ec_method_decode(&bench->list, fsize, mask, rows, in, bench->output);
+        res->bytes += bench->size;
+    } while (ec_bench_now() - start < time);
+    ec_bench_stop(res, start, cycles);
+
+    return 0;
+}
+
+static uintptr_t
+ec_bench_mask_next(uintptr_t mask)
+{
+    uintptr_t low, ripple;
+
+    /* Next integer with the same number of bits set. */
+    low = mask & -mask;
+    ripple = mask + low;
+
+    return ripple | (((mask ^ ripple) >> 2) / low);
+}
+
+static int32_t
+ec_bench_decode_all(ec_bench_t *bench, const char *ext)
+{
+    ec_bench_result_t res, total;
+    uintptr_t mask, first, last;
+    double time, gbps, min, max;
+    uint32_t count;
+    char name[32];
+    int32_t err;
+
+    first = (1ULL << bench->fragments) - 1;
+    last = first << (bench->nodes - bench->fragments);
+
+    count = 0;
+    for (mask = first; mask <= last; mask = ec_bench_mask_next(mask)) {
+        count++;
+    }
+    time = bench->time / count;
+
+    memset(&total, 0, sizeof(total));
+    min = max = 0.0;
+    for (mask = first; mask <= last; mask = ec_bench_mask_next(mask)) {
+        err = ec_bench_decode(bench, mask, time, &res);
+        if (err != 0) {
+            return err;
+        }
+
+        gbps = res.bytes / res.seconds / 1e9;
+        if ((min == 0.0) || (gbps < min)) {
+            min = gbps;
+        }
+        if (gbps > max) {
+            max = gbps;
+        }
+        total.bytes += res.bytes;
+        total.cycles += res.cycles;
+        total.seconds += res.seconds;
+
+        if (bench->verbose) {
+            snprintf(name, sizeof(name), "%lx", (unsigned long)mask);
+            ec_bench_print(bench, ext, "decode", name, &res);
+        }
+    }
+
+    snprintf(name, sizeof(name), "all(%u)", count);
+    ec_bench_print(bench, ext, "decode", name, &total);
+    printf("%37s min %.3f GB/s, max %.3f GB/s\n", "", min, max);
+
+    return 0;
+}
+
+static int32_t
+ec_bench_run(ec_bench_t *bench, const char *ext)
+{
+    ec_bench_result_t res;
+    uint64_t sizes[3];
+    const char *used;
+    uint64_t i;
+    int32_t err;
+
+    memset(&bench->list, 0, sizeof(bench->list));
+    err = ec_method_init(THIS, &bench->list, bench->fragments, bench->nodes,
+                         bench->nodes * 2, EC_METHOD_CACHE_MATRICES, ext);
+    if (err != 0) {
+        fprintf(stderr, "Unable to initialize %u+%u: %s\n", bench->fragments,
+                bench->nodes - bench->fragments, strerror(-err));
+        return err;
+    }
+
+    used = "none";
+    if (bench->list.code->gen != NULL) {
+        used = bench->list.code->gen->name;
+    }
+    if (strcmp(used, ext) != 0) {
+        printf("%2u+%-2u  %9" PRIu64 "  %-7s not available\n",
+               bench->fragments, bench->nodes - bench->fragments, bench->size,
+               ext);
+        goto out;
+    }
+
+    /* Dynamic code uses aligned loads and stores, like the iobufs used by
+     * the translator. */
+    err = -ENOMEM;
+    sizes[0] = sizes[1] = bench->size;
+    sizes[2] = bench->size / bench->fragments * bench->nodes;
+    for (i = 0; i < 3; i++) {
+        bench->buffers[i] = GF_MALLOC(sizes[i] + EC_METHOD_WORD_SIZE,
+                                      gf_common_mt_char);
+        if (bench->buffers[i] == NULL) {
+            goto out;
+        }
+    }
+    bench->data = GF_ALIGN_BUF(bench->buffers[0], EC_METHOD_WORD_SIZE);
+    bench->output = GF_ALIGN_BUF(bench->buffers[1], EC_METHOD_WORD_SIZE);
+    bench->blocks = GF_ALIGN_BUF(bench->buffers[2], EC_METHOD_WORD_SIZE);
+
+    for (i = 0; i < bench->size; i++) {
+        bench->data[i] = random();
+    }
+
+    ec_bench_encode(bench, &res);
+    ec_bench_print(bench, ext, "encode", "-", &res);
+
+    err = ec_bench_decode_all(bench, ext);
+
+out:
+    for (i = 0; i < 3; i++) {
+        GF_FREE(bench->buffers[i]);
+        bench->buffers[i] = NULL;
+    }
+
+    ec_method_fini(&bench->list);
+
+    return err;
+}
+
+static void
+ec_bench_usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-l layouts] [-s sizes] [-e extensions] [-t time] "
+            "[-v]\n"
+            "    -l  comma separated list of fragments:redundancy "
+            "(default " EC_BENCH_DEFAULT_LAYOUTS ")\n"
+            "    -s  comma separated list of data sizes per call, with "
+            "optional K or M suffix (default " EC_BENCH_DEFAULT_SIZES ")\n"
+            "    -e  comma separated list of cpu extensions "
+            "(default " EC_BENCH_DEFAULT_EXTENSIONS ")\n"
+            "    -t  seconds to run each encode and each full decode "
+            "sweep (default %.1f)\n"
+            "    -v  show the result of each decode mask\n",
+            name, EC_BENCH_DEFAULT_TIME);
+}
+
+static int32_t
+ec_bench_parse_size(const char *text, uint64_t *size)
+{
+    char *end;
+
+    *size = strtoull(text, &end, 10);
+    if ((*end == 'K') || (*end == 'k')) {
+        *size *= GF_UNIT_KB;
+        end++;
+    } else if ((*end == 'M') || (*end == 'm')) {
+        *size *= GF_UNIT_MB;
+        end++;
+    }
+
+    return ((*size == 0) || (*end != 0)) ? -1 : 0;
+}
+
+static int32_t
+ec_bench_layouts(ec_bench_t *bench, char *layouts, char *sizes,
+                 char *extensions)
+{
+    char *layout, *size, *ext, *name, *end;
+    char *save1, *save2, *save3;
+    unsigned int fragments, redundancy;
+    uint64_t stripe;
+    int32_t err;
+
+    for (layout = strtok_r(layouts, ",", &save1); layout != NULL;
+         layout = strtok_r(NULL, ",", &save1)) {
+        if ((sscanf(layout, "%u:%u", &fragments, &redundancy) != 2) ||
+            (fragments < 1) || (redundancy >= fragments) ||
+            (fragments + redundancy > EC_METHOD_MAX_FRAGMENTS * 2) ||
+            (fragments > EC_METHOD_MAX_FRAGMENTS)) {
+            fprintf(stderr, "Invalid layout '%s'\n", layout);
+            return -EINVAL;
+        }
+        bench->fragments = fragments;
+        bench->nodes = fragments + redundancy;
+        stripe = EC_METHOD_CHUNK_SIZE * fragments;
+
+        end = gf_strdup(sizes);
+        if (end == NULL) {
+            return -ENOMEM;
+        }
+        for (size = strtok_r(end, ",", &save2); size != NULL;
+             size = strtok_r(NULL, ",", &save2)) {
+            if (ec_bench_parse_size(size, &bench->size) != 0) {
+                fprintf(stderr, "Invalid size '%s'\n", size);
+                GF_FREE(end);
+                return -EINVAL;
+            }
+            /* Data is always processed in full stripes. */
+            bench->size = (bench->size + stripe - 1) / stripe * stripe;
+
+            ext = gf_strdup(extensions);
+            if (ext == NULL) {
+                GF_FREE(end);
+                return -ENOMEM;
+            }
+            for (name = strtok_r(ext, ",", &save3); name != NULL;
+                 name = strtok_r(NULL, ",", &save3)) {
+                err = ec_bench_run(bench, name);
+                if (err != 0) {
+                    GF_FREE(ext);
+                    GF_FREE(end);
+                    return err;
+                }
+            }
+            GF_FREE(ext);
+        }
+        GF_FREE(end);
+    }
+
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    char layouts[256] = EC_BENCH_DEFAULT_LAYOUTS;
+    char *sizes = EC_BENCH_DEFAULT_SIZES;
+    char *extensions = EC_BENCH_DEFAULT_EXTENSIONS;
+    glusterfs_ctx_t *ctx;
+    ec_bench_t bench;
+    int opt;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.time = EC_BENCH_DEFAULT_TIME;
+
+    while ((opt = getopt(argc, argv, "l:s:e:t:vh")) != -1) {
+        switch (opt) {
+            case 'l':
+                snprintf(layouts, sizeof(layouts), "%s", optarg);
+                break;
+            case 's':
+                sizes = optarg;
+                break;
+            case 'e':
+                extensions = optarg;
+                break;
+            case 't':
+                bench.time = atof(optarg);
+                if (bench.time <= 0.0) {
+                    ec_bench_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'v':
+                bench.verbose = _gf_true;
+                break;
+            default:
+                ec_bench_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    /* Allocations use the memory types of the translator, but there's no
+     * translator to account them. */
+    gf_global_mem_acct_enable_set(0);
+
+    ctx = glusterfs_ctx_new();
+    if ((ctx == NULL) || (glusterfs_globals_init(ctx) != 0)) {
+        fprintf(stderr, "Unable to initialize the global context\n");
+        return 1;
+    }
+    THIS->ctx = ctx;
+    mem_pools_init();
+    ctx->logbuf_pool = mem_pool_new(log_buf_t, 256);
+    if ((ctx->logbuf_pool == NULL) || (gf_log_init(ctx, "-", "ec-bench"))) {
+        fprintf(stderr, "Unable to initialize logging\n");
+        return 1;
+    }
+    gf_log_set_loglevel(ctx, GF_LOG_WARNING);
+
+    printf("layout      bytes  ext     op      mask           GB/s  "
+           "cycles/B\n");
+
+    return (ec_bench_layouts(&bench, layouts, sizes, extensions) == 0) ? 0
+                                                                       : 1;
+}
@@ -90,6 +90,41 @@ ec_code_intel_vex(ec_code_intel_t *intel, gf_boolean_t w, gf_boolean_t l,
     }
 }
 
+/* Only 512 bits wide operations without masking on registers 0 to 15 are
+ * supported. */
+static void
+ec_code_intel_evex(ec_code_intel_t *intel, gf_boolean_t w,
+                   ec_code_vex_opcode_t opcode, ec_code_vex_prefix_t prefix,
+                   uint32_t reg)
+{
+    int32_t offset;
+
+    ec_code_intel_rex(intel, w);
+    intel->rex.present = _gf_false;
+
+    intel->vex.bytes = 4;
+    intel->vex.data[0] = 0x62;
+    intel->vex.data[1] = ((intel->rex.r << 7) | (intel->rex.x << 6) |
+                          (intel->rex.b << 5) | opcode) ^
+                         0xF0;
+    intel->vex.data[2] = (intel->rex.w << 7) | ((~reg & 0x0F) << 3) | 0x04 |
+                         prefix;
+    intel->vex.data[3] = 0x48;
+
+    /* EVEX scales 8 bits displacements by the size of the memory operand
+     * (64 bytes). Use a 32 bits displacement if it can't be represented. */
+    if (intel->modrm.present && (intel->modrm.mod == 1)) {
+        offset = (int8_t)intel->offset.data[0];
+        if ((offset & 63) == 0) {
+            intel->offset.value = offset / 64;
+        } else {
+            intel->modrm.mod = 2;
+            intel->offset.bytes = 4;
+            intel->offset.value = offset;
+        }
+    }
+}
+
 static void
 ec_code_intel_modrm_reg(ec_code_intel_t *intel, uint32_t rm, uint32_t reg)
 {
@@ -592,3 +627,84 @@ ec_code_intel_op_xor_m2avx(ec_code_builder_t *builder, ec_code_intel_reg_t base,
 
     ec_code_intel_emit(builder, &intel);
 }
+
+void
+ec_code_intel_op_mov_zmm2zmm(ec_code_builder_t *builder, uint32_t src,
+                             uint32_t dst)
+{
+    ec_code_intel_t intel;
+
+    ec_code_intel_init(&intel);
+
+    ec_code_intel_modrm_reg(&intel, src, dst);
+    ec_code_intel_op_1(&intel, 0x6F, 0);
+    ec_code_intel_evex(&intel, _gf_true, VEX_OPCODE_0F, VEX_PREFIX_66,
+                       VEX_REG_NONE);
+
+    ec_code_intel_emit(builder, &intel);
+}
+
+void
+ec_code_intel_op_mov_zmm2m(ec_code_builder_t *builder, uint32_t src,
+                           ec_code_intel_reg_t base, ec_code_intel_reg_t index,
+                           uint32_t scale, int32_t offset)
+{
+    ec_code_intel_t intel;
+
+    ec_code_intel_init(&intel);
+
+    ec_code_intel_modrm_mem(&intel, src, base, index, scale, offset);
+    ec_code_intel_op_1(&intel, 0x7F, 0);
+    ec_code_intel_evex(&intel, _gf_true, VEX_OPCODE_0F, VEX_PREFIX_F3,
+                       VEX_REG_NONE);
+
+    ec_code_intel_emit(builder, &intel);
+}
+
+void
+ec_code_intel_op_mov_m2zmm(ec_code_builder_t *builder, ec_code_intel_reg_t base,
+                           ec_code_intel_reg_t index, uint32_t scale,
+                           int32_t offset, uint32_t dst)
+{
+    ec_code_intel_t intel;
+
+    ec_code_intel_init(&intel);
+
+    ec_code_intel_modrm_mem(&intel, dst, base, index, scale, offset);
+    ec_code_intel_op_1(&intel, 0x6F, 0);
+    ec_code_intel_evex(&intel, _gf_true, VEX_OPCODE_0F, VEX_PREFIX_F3,
+                       VEX_REG_NONE);
+
+    ec_code_intel_emit(builder, &intel);
+}
+
+void
+ec_code_intel_op_xor_zmm2zmm(ec_code_builder_t *builder, uint32_t src1,
+                             uint32_t src2, uint32_t dst)
+{
+    ec_code_intel_t intel;
+
+    ec_code_intel_init(&intel);
+
+    ec_code_intel_modrm_reg(&intel, src2, dst);
+    ec_code_intel_op_1(&intel, 0xEF, 0);
+    ec_code_intel_evex(&intel, _gf_true, VEX_OPCODE_0F, VEX_PREFIX_66, src1);
+
+    ec_code_intel_emit(builder, &intel);
+}
+
+void
+ec_code_intel_op_xor_m2zmm(ec_code_builder_t *builder, ec_code_intel_reg_t base,
+                           ec_code_intel_reg_t index, uint32_t scale,
+                           int32_t offset, uint32_t src, uint32_t dst)
+{
+    ec_code_intel_t intel;
+
+    ec_code_intel_init(&intel);
+
+    ec_code_intel_modrm_mem(&intel, dst, base, index, scale, offset);
+    ec_code_intel_op_1(&intel, 0xEF, 0);
+    ec_code_intel_evex(&intel, _gf_true, VEX_OPCODE_0F, VEX_PREFIX_66, src);
+
+    ec_code_intel_emit(builder, &intel);
+}
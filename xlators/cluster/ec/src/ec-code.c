@@ -21,6 +21,7 @@
 #include "ec-messages.h"
 #include "ec-code-c.h"
 #include "ec-helpers.h"
+#include "ec-method.h"
 
 #ifdef USE_EC_DYNAMIC_X64
 #include "ec-code-x64.h"
@@ -34,6 +35,10 @@
 #include "ec-code-avx.h"
 #endif
 
+#ifdef USE_EC_DYNAMIC_AVX512
+#include "ec-code-avx512.h"
+#endif
+
 #define EC_CODE_SIZE (1024 * 64)
 #define EC_CODE_ALIGN 4096
 
@@ -41,6 +46,8 @@
 
 #define EC_PROC_BUFFER_SIZE 4096
 
+#define EC_CODE_CHECK_COLUMNS 8
+
 #define PROC_CPUINFO "/proc/cpuinfo"
 
 struct _ec_code_proc;
@@ -57,6 +64,9 @@ struct _ec_code_proc {
 };
 
 static ec_code_gen_t *ec_code_gen_table[] = {
+#ifdef USE_EC_DYNAMIC_AVX512
+    &ec_code_gen_avx512,
+#endif
 #ifdef USE_EC_DYNAMIC_AVX
     &ec_code_gen_avx,
 #endif
@@ -808,6 +818,94 @@ ec_code_release(ec_code_t *code, ec_code_func_t *func)
     }
 }
 
+/* Builds a row of the encoding matrix (see ec_method_matrix_normal()). */
+static void
+ec_code_check_values(ec_gf_t *gf, uint32_t *values, uint32_t *prepared,
+                     uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        values[i] = ec_gf_exp(gf, 3, count - i - 1);
+        prepared[i] = values[i];
+    }
+}
+
+/* Runs the code generated by the selected generator on some data and
+ * compares the result with the precompiled C code. */
+gf_boolean_t
+ec_code_check(ec_code_t *code)
+{
+    uint32_t values[EC_CODE_CHECK_COLUMNS];
+    uint32_t prepared[EC_CODE_CHECK_COLUMNS];
+    void *src[EC_CODE_CHECK_COLUMNS];
+    ec_code_func_t func;
+    uint8_t *buffer, *data, *dst, *ref;
+    uint32_t i, seed;
+    gf_boolean_t ok = _gf_false;
+
+    if (code->gen == NULL) {
+        return _gf_true;
+    }
+
+    buffer = GF_MALLOC(EC_METHOD_CHUNK_SIZE * (EC_CODE_CHECK_COLUMNS + 2) +
+                           EC_METHOD_WORD_SIZE,
+                       gf_common_mt_char);
+    if (buffer == NULL) {
+        return _gf_false;
+    }
+    data = (uint8_t *)(((uintptr_t)buffer + EC_METHOD_WORD_SIZE - 1) &
+                       ~(uintptr_t)(EC_METHOD_WORD_SIZE - 1));
+    dst = data + EC_METHOD_CHUNK_SIZE * EC_CODE_CHECK_COLUMNS;
+    ref = dst + EC_METHOD_CHUNK_SIZE;
+
+    seed = 0x12345678;
+    for (i = 0; i < EC_METHOD_CHUNK_SIZE * EC_CODE_CHECK_COLUMNS; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = seed >> 16;
+    }
+    for (i = 0; i < EC_CODE_CHECK_COLUMNS; i++) {
+        src[i] = data + EC_METHOD_CHUNK_SIZE * i;
+    }
+
+    ec_code_check_values(code->gf, values, prepared, EC_CODE_CHECK_COLUMNS);
+    func.linear = ec_code_build_linear(code, EC_METHOD_WORD_SIZE, values,
+                                       EC_CODE_CHECK_COLUMNS);
+    if (code->gen == NULL) {
+        /* Dynamic code generation failed and has already been disabled. */
+        ok = _gf_true;
+        goto out;
+    }
+    func.linear(dst, data, 0, values, EC_CODE_CHECK_COLUMNS);
+    ec_code_release(code, &func);
+
+    ec_code_c_prepare(code->gf, prepared, EC_CODE_CHECK_COLUMNS);
+    ec_code_c_linear(ref, data, 0, prepared, EC_CODE_CHECK_COLUMNS);
+    if (memcmp(dst, ref, EC_METHOD_CHUNK_SIZE) != 0) {
+        goto out;
+    }
+
+    ec_code_check_values(code->gf, values, prepared, EC_CODE_CHECK_COLUMNS);
+    func.interleaved = ec_code_build_interleaved(
+        code, EC_METHOD_WORD_SIZE, values, EC_CODE_CHECK_COLUMNS);
+    if (code->gen == NULL) {
+        /* Dynamic code generation failed and has already been disabled. */
+        ok = _gf_true;
+        goto out;
+    }
+    func.interleaved(dst, src, 0, values, EC_CODE_CHECK_COLUMNS);
+    ec_code_release(code, &func);
+
+    ec_code_c_prepare(code->gf, prepared, EC_CODE_CHECK_COLUMNS);
+    ec_code_c_interleaved(ref, src, 0, prepared, EC_CODE_CHECK_COLUMNS);
+    ok = (memcmp(dst, ref, EC_METHOD_CHUNK_SIZE) == 0);
+
+out:
+    GF_FREE(buffer);
+
+    return ok;
+}
+
 void
 ec_code_error(ec_code_builder_t *builder, int32_t error)
 {
@@ -34,6 +34,9 @@ ec_code_build_interleaved(ec_code_t *code, uint32_t width, uint32_t *values,
 void
 ec_code_release(ec_code_t *code, ec_code_func_t *func);
 
+gf_boolean_t
+ec_code_check(ec_code_t *code);
+
 void
 ec_code_error(ec_code_builder_t *builder, int32_t error);
 
@@ -952,6 +952,14 @@ ec_combine(ec_cbk_data_t *newcbk, ec_combine_f combine)
 
     LOCK(&fop->lock);
 
+    if (fop->hedge_answered || (__ec_hedge_answer(fop) != NULL)) {
+        /* A hedged read already has all the fragments it needs. This
+         * answer will be released along with the fop. */
+        UNLOCK(&fop->lock);
+
+        return;
+    }
+
     fop->received |= newcbk->mask;
 
     item = fop->cbk_list.prev;
@@ -536,18 +536,132 @@ ec_is_recoverable_error(int32_t op_errno)
     return _gf_false;
 }
 
+static void
+ec_hedge_timeout(void *data)
+{
+    ec_fop_data_t *fop = data;
+    ec_t *ec = fop->xl->private;
+    uint32_t idx = EC_INVALID_INDEX;
+
+    LOCK(&fop->lock);
+
+    fop->hedge_timer = NULL;
+    if (!fop->hedged && (fop->answer == NULL) && (fop->winds > 0)) {
+        idx = ec_child_next(ec, fop, fop->first);
+        if (idx < EC_MAX_NODES) {
+            fop->remaining ^= 1ULL << idx;
+            fop->hedged = _gf_true;
+
+            ec_trace("HEDGE", fop, "idx=%d", idx);
+
+            fop->winds++;
+            fop->refs++;
+        }
+    }
+
+    UNLOCK(&fop->lock);
+
+    if (idx < EC_MAX_NODES) {
+        GF_ATOMIC_INC(ec->stats.hedge.sent);
+        fop->wind(ec, fop, idx);
+    }
+
+    ec_fop_data_release(fop);
+}
+
+/* Prepares a read to request one more fragment if it takes longer than
+ * the configured percentile of recent reads. */
+static void
+ec_hedge_arm(ec_fop_data_t *fop)
+{
+    ec_t *ec = fop->xl->private;
+    struct timespec delay;
+    uint64_t usecs;
+
+    timespec_now(&fop->hedge_start);
+
+    usecs = gf_latency_hist_percentile(&ec->read_hist,
+                                       ec->read_hedge_percentile);
+    if (usecs == 0) {
+        return;
+    }
+
+    delay.tv_sec = usecs / 1000000;
+    delay.tv_nsec = (usecs % 1000000) * 1000;
+
+    LOCK(&fop->lock);
+
+    fop->refs++;
+    fop->hedge_timer = gf_timer_call_after(fop->xl->ctx, delay,
+                                           ec_hedge_timeout, fop);
+    if (fop->hedge_timer == NULL) {
+        fop->refs--;
+    }
+
+    UNLOCK(&fop->lock);
+}
+
+static void
+ec_hedge_done(ec_fop_data_t *fop)
+{
+    ec_t *ec = fop->xl->private;
+    gf_timer_t *timer;
+    struct timespec now;
+
+    timespec_now(&now);
+    gf_latency_hist_add(&ec->read_hist,
+                        gf_tsdiff(&fop->hedge_start, &now) / 1000);
+
+    LOCK(&fop->lock);
+
+    timer = fop->hedge_timer;
+    fop->hedge_timer = NULL;
+
+    UNLOCK(&fop->lock);
+
+    if ((timer != NULL) &&
+        (gf_timer_call_cancel(fop->xl->ctx, timer) == 0)) {
+        ec_fop_data_release(fop);
+    }
+}
+
+/* A hedged read doesn't need more answers once one group has enough
+ * good fragments. Must be called with fop->lock held. */
+ec_cbk_data_t *
+__ec_hedge_answer(ec_fop_data_t *fop)
+{
+    ec_cbk_data_t *cbk;
+
+    if (!fop->hedged || list_empty(&fop->cbk_list)) {
+        return NULL;
+    }
+
+    cbk = list_entry(fop->cbk_list.next, ec_cbk_data_t, list);
+    if ((cbk->op_ret < 0) ||
+        ((cbk->count - gf_bits_count(cbk->mask & fop->healing)) <
+         fop->minimum)) {
+        return NULL;
+    }
+
+    return cbk;
+}
+
 void
 ec_complete(ec_fop_data_t *fop)
 {
     ec_cbk_data_t *cbk = NULL;
     int32_t resume = 0, update = 0;
     int healing_count = 0;
+    uintptr_t good = 0;
 
     LOCK(&fop->lock);
 
     ec_trace("COMPLETE", fop, "");
 
-    if (--fop->winds == 0) {
+    if (fop->hedge_answered) {
+        /* Late answer of a hedged read. The fop has already gone on. */
+        fop->winds--;
+    } else if (--fop->winds == 0) {
         if (fop->answer == NULL) {
             if (!list_empty(&fop->cbk_list)) {
                 cbk = list_entry(fop->cbk_list.next, ec_cbk_data_t, list);
@@ -556,6 +670,7 @@ ec_complete(ec_fop_data_t *fop)
                  * successful on at least fop->minimum good copies*/
                 if ((cbk->count - healing_count) >= fop->minimum) {
                     fop->answer = cbk;
+                    good = cbk->mask;
 
                     update = 1;
                 }
@@ -563,16 +678,31 @@ ec_complete(ec_fop_data_t *fop)
 
             resume = 1;
         }
+    } else if ((cbk = __ec_hedge_answer(fop)) != NULL) {
+        fop->answer = cbk;
+        fop->hedge_answered = _gf_true;
+        /* Bricks that have not answered yet are not known to be bad */
+        good = cbk->mask | ((fop->mask ^ fop->remaining) & ~fop->received);
+
+        update = 1;
+        resume = 1;
     }
 
     UNLOCK(&fop->lock);
 
+    if (resume && (fop->hedge_start.tv_sec != 0)) {
+        if (fop->hedge_answered) {
+            GF_ATOMIC_INC(((ec_t *)fop->xl->private)->stats.hedge.won);
+        }
+        ec_hedge_done(fop);
+    }
+
     /* ec_update_good() locks inode->lock. This may cause deadlocks with
        fop->lock when used in another order. Since ec_update_good() will not
        be called more than once for each fop, it can be called from outside
        the fop->lock locked region. */
     if (update) {
-        ec_update_good(fop, cbk->mask);
+        ec_update_good(fop, good);
     }
 
     if (resume) {
@@ -901,6 +1031,10 @@ ec_dispatch_min(ec_fop_data_t *fop)
                 mask |= 1ULL << idx;
         }
 
+        if ((fop->id == GF_FOP_READ) && (ec->read_hedge_percentile != 0)) {
+            ec_hedge_arm(fop);
+        }
+
         ec_dispatch_mask(fop, mask);
     }
 }
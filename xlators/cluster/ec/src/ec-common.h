@@ -129,6 +129,9 @@ ec_dispatch_one_retry(ec_fop_data_t *fop, ec_cbk_data_t **cbk);
 void
 ec_dispatch_next(ec_fop_data_t *fop, uint32_t idx);
 
+ec_cbk_data_t *
+__ec_hedge_answer(ec_fop_data_t *fop);
+
 void
 ec_complete(ec_fop_data_t *fop);
 
@@ -17,6 +17,7 @@
 #include "ec-code.h"
 #include "ec-method.h"
 #include "ec-helpers.h"
+#include "ec-messages.h"
 
 static void
 ec_method_matrix_normal(ec_gf_t *gf, uint32_t *matrix, uint32_t columns,
@@ -254,6 +255,179 @@ ec_method_matrix_put(ec_matrix_list_t *list, ec_matrix_t *matrix)
     UNLOCK(&list->lock);
 }
 
+static uint32_t
+ec_method_cache_slot(ec_matrix_list_t *list, uintptr_t mask)
+{
+    return (uint32_t)(((uint64_t)mask * 0x9E3779B97F4A7C15ULL) >> 32) &
+           (list->cache_size - 1);
+}
+
+static ec_matrix_t *
+ec_method_cache_lookup(ec_matrix_list_t *list, uintptr_t mask)
+{
+    ec_matrix_t *matrix;
+    uint32_t slot;
+
+    if (list->cache == NULL) {
+        return NULL;
+    }
+
+    slot = ec_method_cache_slot(list, mask);
+    while ((matrix = list->cache[slot]) != NULL) {
+        if (matrix->mask == mask) {
+            return matrix;
+        }
+        slot = (slot + 1) & (list->cache_size - 1);
+    }
+
+    return NULL;
+}
+
+static int32_t
+ec_method_cache_add(ec_matrix_list_t *list, uintptr_t mask)
+{
+    ec_matrix_t *matrix;
+    uint32_t rows[list->columns];
+    uint32_t i, count, slot;
+
+    matrix = GF_MALLOC(sizeof(ec_matrix_t) +
+                           sizeof(ec_matrix_row_t) * list->columns +
+                           sizeof(uint32_t) * list->columns * list->columns,
+                       ec_mt_ec_matrix_t);
+    if (matrix == NULL) {
+        return -ENOMEM;
+    }
+    memset(matrix, 0, sizeof(ec_matrix_t));
+    matrix->values = (uint32_t *)((uintptr_t)matrix + sizeof(ec_matrix_t) +
+                                  sizeof(ec_matrix_row_t) * list->columns);
+
+    count = 0;
+    for (i = 0; i < list->rows; i++) {
+        if ((mask & (1ULL << i)) != 0) {
+            rows[count++] = i + 1;
+        }
+    }
+
+    ec_method_matrix_init(list, matrix, mask, rows, _gf_true);
+
+    slot = ec_method_cache_slot(list, mask);
+    while (list->cache[slot] != NULL) {
+        slot = (slot + 1) & (list->cache_size - 1);
+    }
+    list->cache[slot] = matrix;
+    list->cache_count++;
+
+    return 0;
+}
+
+static void
+ec_method_cache_fini(ec_matrix_list_t *list)
+{
+    uint32_t i;
+
+    if (list->cache == NULL) {
+        return;
+    }
+
+    for (i = 0; i < list->cache_size; i++) {
+        if (list->cache[i] != NULL) {
+            ec_method_matrix_release(list->cache[i]);
+            GF_FREE(list->cache[i]);
+        }
+    }
+
+    GF_FREE(list->cache);
+    list->cache = NULL;
+    list->cache_size = 0;
+    list->cache_count = 0;
+}
+
+static int32_t
+ec_method_cache_fill(ec_matrix_list_t *list, uintptr_t down)
+{
+    uintptr_t mask;
+    uint32_t first, idx, count;
+    int32_t err;
+
+    /* Same selection as ec_dispatch_min() for every possible first brick. */
+    for (first = 0; first < list->rows; first++) {
+        mask = 0;
+        idx = first;
+        count = list->columns;
+        while (count > 0) {
+            if ((down & (1ULL << idx)) == 0) {
+                mask |= 1ULL << idx;
+                count--;
+            }
+            idx = (idx + 1) % list->rows;
+        }
+
+        if (ec_method_cache_lookup(list, mask) != NULL) {
+            continue;
+        }
+        if (list->cache_count >= list->cache_max) {
+            return -ENOSPC;
+        }
+
+        err = ec_method_cache_add(list, mask);
+        if (err != 0) {
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+static int32_t
+ec_method_cache_init(ec_matrix_list_t *list)
+{
+    uint32_t i, j, count, size;
+    int32_t err;
+
+    if (list->cache_max == 0) {
+        return 0;
+    }
+
+    /* Upper bound of the number of different masks that reads can use
+     * when up to two bricks are down. */
+    count = list->rows * (1 + list->rows + list->rows * (list->rows - 1) / 2);
+    if (count > list->cache_max) {
+        count = list->cache_max;
+    }
+    size = 1;
+    while (size < count * 2) {
+        size <<= 1;
+    }
+
+    list->cache = GF_CALLOC(size, sizeof(ec_matrix_t *), ec_mt_ec_matrix_t);
+    if (list->cache == NULL) {
+        return -ENOMEM;
+    }
+    list->cache_size = size;
+
+    /* Most probable masks first, in case there isn't room for all of them
+     * (this only happens with many fragments). */
+    err = ec_method_cache_fill(list, 0);
+    for (i = 0; (err == 0) && (i < list->rows); i++) {
+        err = ec_method_cache_fill(list, 1ULL << i);
+    }
+    if (list->rows - list->columns >= 2) {
+        for (i = 0; (err == 0) && (i < list->rows); i++) {
+            for (j = i + 1; (err == 0) && (j < list->rows); j++) {
+                err = ec_method_cache_fill(list, (1ULL << i) | (1ULL << j));
+            }
+        }
+    }
+    if (err == -ENOSPC) {
+        err = 0;
+    }
+    if (err != 0) {
+        ec_method_cache_fini(list);
+    }
+
+    return err;
+}
+
 static int32_t
 ec_method_setup(xlator_t *xl, ec_matrix_list_t *list, const char *gen)
 {
@@ -280,6 +454,13 @@ ec_method_setup(xlator_t *xl, ec_matrix_list_t *list, const char *gen)
         list->code = NULL;
         goto failed_matrix;
     }
+    if (!ec_code_check(list->code)) {
+        gf_msg(xl->name, GF_LOG_WARNING, 0, EC_MSG_EXTENSION_FAILED,
+               "Self-check of '%s' CPU extensions failed. Not using any cpu "
+               "extensions",
+               list->code->gen->name);
+        list->code->gen = NULL;
+    }
 
     for (i = 0; i < list->rows; i++) {
         values[i] = i + 1;
@@ -298,11 +479,13 @@ failed:
 
 int32_t
 ec_method_init(xlator_t *xl, ec_matrix_list_t *list, uint32_t columns,
-               uint32_t rows, uint32_t max, const char *gen)
+               uint32_t rows, uint32_t max, uint32_t cache_max,
+               const char *gen)
 {
     list->columns = columns;
     list->rows = rows;
     list->max = max;
+    list->cache_max = cache_max;
     list->stripe = EC_METHOD_CHUNK_SIZE * list->columns;
     INIT_LIST_HEAD(&list->lru);
     int32_t err;
@@ -334,10 +517,25 @@ ec_method_init(xlator_t *xl, ec_matrix_list_t *list, uint32_t columns,
         goto failed_gf;
     }
 
+    err = ec_method_cache_init(list);
+    if (err != 0) {
+        goto failed_setup;
+    }
+
+    GF_ATOMIC_INIT(list->cache_hits, 0);
+    GF_ATOMIC_INIT(list->cache_misses, 0);
+
     LOCK_INIT(&list->lock);
 
     return 0;
 
+failed_setup:
+    ec_method_matrix_release(list->encode);
+    GF_FREE(list->encode);
+    list->encode = NULL;
+    ec_code_destroy(list->code);
+    list->code = NULL;
+
 failed_gf:
     ec_gf_destroy(list->gf);
 failed_objects:
@@ -371,6 +569,8 @@ ec_method_fini(ec_matrix_list_t *list)
     if (list->pool) /*Init was successful*/
         LOCK_DESTROY(&list->lock);
 
+    ec_method_cache_fini(list);
+
     ec_method_matrix_release(list->encode);
     GF_FREE(list->encode);
 
@@ -414,10 +614,19 @@ ec_method_decode(ec_matrix_list_t *list, uint64_t size, uintptr_t mask,
     ec_matrix_t *matrix;
     uint64_t pos;
     uint32_t i;
+    gf_boolean_t cached;
+
+    matrix = ec_method_cache_lookup(list, mask);
+    cached = (matrix != NULL);
+    if (cached) {
+        GF_ATOMIC_INC(list->cache_hits);
+    } else {
+        GF_ATOMIC_INC(list->cache_misses);
 
-    matrix = ec_method_matrix_get(list, mask, rows);
-    if (EC_IS_ERR(matrix)) {
-        return EC_GET_ERR(matrix);
+        matrix = ec_method_matrix_get(list, mask, rows);
+        if (EC_IS_ERR(matrix)) {
+            return EC_GET_ERR(matrix);
+        }
     }
     for (pos = 0; pos < size; pos += EC_METHOD_CHUNK_SIZE) {
         for (i = 0; i < matrix->rows; i++) {
@@ -427,7 +636,9 @@ ec_method_decode(ec_matrix_list_t *list, uint64_t size, uintptr_t mask,
         }
     }
 
-    ec_method_matrix_put(list, matrix);
+    if (!cached) {
+        ec_method_matrix_put(list, matrix);
+    }
 
     return 0;
 }
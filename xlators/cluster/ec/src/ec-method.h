@@ -24,13 +24,21 @@
 /* Determines the maximum number of usable elements in the Galois Field */
 #define EC_METHOD_MAX_NODES (EC_GF_SIZE - 1)
 
+/* Default maximum number of decoding matrices built in advance
+ * (disperse.matrix-cache-size). Each row of a matrix has its own dynamic
+ * code, which can be several KB with many fragments. 512 matrices hold all
+ * the masks of an 8+4 volume with up to two bricks down (390). */
+#define EC_METHOD_CACHE_MATRICES 512
+#define EC_METHOD_CACHE_MATRICES_MAX 4096
+
 #define EC_METHOD_WORD_SIZE 64
 
 #define EC_METHOD_CHUNK_SIZE (EC_METHOD_WORD_SIZE * EC_GF_BITS)
 
 int32_t
 ec_method_init(xlator_t *xl, ec_matrix_list_t *list, uint32_t columns,
-               uint32_t rows, uint32_t max, const char *gen);
+               uint32_t rows, uint32_t max, uint32_t cache_max,
+               const char *gen);
 
 void
 ec_method_fini(ec_matrix_list_t *list);
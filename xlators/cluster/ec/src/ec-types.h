@@ -387,6 +387,14 @@ struct _ec_fop_data {
     struct iovec *vector;
     struct iobref *buffers;
     gf_seek_what_t seek;
+
+    /* Hedged reads: an extra fragment is requested from a brick not used
+     * yet if the read takes too long. Protected by 'lock'. */
+    gf_timer_t *hedge_timer;
+    struct timespec hedge_start;
+    gf_boolean_t hedged;
+    gf_boolean_t hedge_answered;
+
     ec_fragment_range_t frag_range; /* This will hold the range of stripes
                                         affected by the fop. */
     char *errstr;                   /*String of fop name, path and gfid
@@ -559,6 +567,15 @@ struct _ec_matrix_list {
     ec_code_t *code;
     ec_matrix_t *encode;
     ec_matrix_t **objects;
+    /* Decoding matrices of the masks used by reads while up to two bricks
+     * are down (at most cache_max of them). Built at init and never
+     * modified afterwards, so it's accessed without taking any lock. */
+    ec_matrix_t **cache;
+    uint32_t cache_size; /* Number of slots. Always a power of 2. */
+    uint32_t cache_count;
+    uint32_t cache_max;
+    gf_atomic_t cache_hits;
+    gf_atomic_t cache_misses;
 };
 
 struct _ec_heal {
@@ -622,6 +639,11 @@ struct _ec_statistics {
                                 files/directories*/
         gf_atomic_t completed; /*Number of heals complted on files/directories*/
     } shd;
+    struct {
+        gf_atomic_t sent; /* Extra fragments requested by slow reads. */
+        gf_atomic_t won;  /* Reads answered without waiting for all
+                             the bricks they were sent to. */
+    } hedge;
 };
 
 struct _ec {
@@ -659,6 +681,8 @@ struct _ec {
     gf_boolean_t parallel_writes;
     uint32_t stripe_cache;
     uint32_t quorum_count;
+    uint32_t read_hedge_percentile; /* 0 disables hedged reads */
+    gf_latency_hist_t read_hist;
     uint32_t background_heals;
     uint32_t heal_wait_qlen;
     uint32_t self_heal_window_size; /* max size of read/writes */
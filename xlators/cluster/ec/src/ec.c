@@ -285,6 +285,8 @@ reconfigure(xlator_t *this, dict_t *options)
                      failed);
     GF_OPTION_RECONF("stripe-cache", ec->stripe_cache, options, uint32, failed);
     GF_OPTION_RECONF("quorum-count", ec->quorum_count, options, uint32, failed);
+    GF_OPTION_RECONF("read-hedge-percentile", ec->read_hedge_percentile,
+                     options, uint32, failed);
     ret = 0;
     if (ec_assign_read_policy(ec, read_policy)) {
         ret = -1;
@@ -711,6 +713,9 @@ ec_statistics_init(ec_t *ec)
     GF_ATOMIC_INIT(ec->stats.stripe_cache.errors, 0);
     GF_ATOMIC_INIT(ec->stats.shd.attempted, 0);
     GF_ATOMIC_INIT(ec->stats.shd.completed, 0);
+    GF_ATOMIC_INIT(ec->stats.hedge.sent, 0);
+    GF_ATOMIC_INIT(ec->stats.hedge.won, 0);
+    gf_latency_hist_init(&ec->read_hist);
 }
 
 static int
@@ -780,6 +785,7 @@ init(xlator_t *this)
     ec_t *ec = NULL;
     char *read_policy = NULL;
     char *extensions = NULL;
+    uint32_t cache_max = 0;
     int32_t err;
     char *read_mask_str = NULL;
 
@@ -833,9 +839,10 @@ init(xlator_t *this)
     }
 
     GF_OPTION_INIT("cpu-extensions", extensions, str, failed);
+    GF_OPTION_INIT("matrix-cache-size", cache_max, uint32, failed);
 
     err = ec_method_init(this, &ec->matrix, ec->fragments, ec->nodes,
-                         ec->nodes * 2, extensions);
+                         ec->nodes * 2, cache_max, extensions);
     if (err != 0) {
         gf_msg(this->name, GF_LOG_ERROR, -err, EC_MSG_MATRIX_FAILED,
                "Failed to initialize matrix management");
@@ -868,6 +875,8 @@ init(xlator_t *this)
     GF_OPTION_INIT("parallel-writes", ec->parallel_writes, bool, failed);
     GF_OPTION_INIT("stripe-cache", ec->stripe_cache, uint32, failed);
     GF_OPTION_INIT("quorum-count", ec->quorum_count, uint32, failed);
+    GF_OPTION_INIT("read-hedge-percentile", ec->read_hedge_percentile, uint32,
+                   failed);
     GF_OPTION_INIT("ec-read-mask", read_mask_str, str, failed);
 
     if (ec_assign_read_mask(ec, read_mask_str))
@@ -1584,6 +1593,29 @@ ec_dump_private(xlator_t *this)
     gf_proc_dump_write("heals-completed", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(ec->stats.shd.completed));
 
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.read_hedge",
+             this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    gf_proc_dump_write("percentile", "%u", ec->read_hedge_percentile);
+    gf_proc_dump_write("delay-usecs", "%" PRIu64,
+                       gf_latency_hist_percentile(&ec->read_hist,
+                                                  ec->read_hedge_percentile));
+    gf_proc_dump_write("sent", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.hedge.sent));
+    gf_proc_dump_write("won", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.hedge.won));
+
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.matrix_cache",
+             this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    gf_proc_dump_write("entries", "%u", ec->matrix.cache_count);
+    gf_proc_dump_write("hits", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->matrix.cache_hits));
+    gf_proc_dump_write("misses", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->matrix.cache_misses));
+
     return 0;
 }
 
@@ -1785,13 +1817,25 @@ struct volume_options options[] = {
                     " that can wait in SHD per subvolume."},
     {.key = {"cpu-extensions"},
      .type = GF_OPTION_TYPE_STR,
-     .value = {"none", "auto", "x64", "sse", "avx"},
+     .value = {"none", "auto", "x64", "sse", "avx", "avx512"},
      .default_value = "auto",
      .op_version = {GD_OP_VERSION_3_9_0},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
      .tags = {"disperse"},
      .description = "force the cpu extensions to be used to accelerate the "
                     "galois field computations."},
+    {.key = {"matrix-cache-size"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = EC_METHOD_CACHE_MATRICES_MAX,
+     .default_value = TOSTRING(EC_METHOD_CACHE_MATRICES),
+     .op_version = {GD_OP_VERSION_11_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "Maximum number of decoding matrices built when the "
+                    "volume is mounted, for reads with up to two bricks "
+                    "down. The most probable ones are built first. Other "
+                    "reads build their matrix on demand. 0 disables it."},
     {.key = {"self-heal-window-size"},
      .type = GF_OPTION_TYPE_INT,
      .min = 1,
@@ -1826,6 +1870,19 @@ struct volume_options options[] = {
      .default_value = "on",
      .description = "This controls if writes can be wound in parallel as long"
                     "as it doesn't modify same stripes"},
+    {.key = {"read-hedge-percentile"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 99,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_11_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "If a read has not been answered after this percentile "
+                    "of the latency of recent reads, an extra fragment is "
+                    "requested from a brick not used by the read yet, and "
+                    "the read completes as soon as enough fragments are "
+                    "received. 0 disables it."},
     {.key = {"stripe-cache"},
      .type = GF_OPTION_TYPE_INT,
      .min = 0, /*Disabling stripe_cache*/
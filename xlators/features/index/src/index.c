@@ -1428,6 +1428,126 @@ out:
     return 0;
 }
 
+struct index_pre_xattrop_args {
+    dict_t *xattr;
+    dict_t *xdata;
+};
+
+static int
+index_pre_xattrop_split(dict_t *d, char *k, data_t *v, void *data)
+{
+    struct index_pre_xattrop_args *args = data;
+
+    if (dict_set(args->xattr, k + SLEN(GLUSTERFS_WRITE_PRE_XATTROP), v))
+        return -1;
+    dict_del(args->xdata, k);
+    return 0;
+}
+
+int32_t
+index_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+    dict_t *rsp = NULL;
+
+    if (op_ret >= 0) {
+        rsp = xdata ? dict_ref(xdata) : dict_new();
+        if (rsp &&
+            dict_set_int32_sizen(rsp, GLUSTERFS_WRITE_PRE_XATTROP_DONE, 1))
+            gf_msg_debug(this->name, 0, "failed to acknowledge pre-op");
+    }
+
+    STACK_UNWIND_STRICT(writev, frame, op_ret, op_errno, prebuf, postbuf,
+                        rsp ? rsp : xdata);
+    if (rsp)
+        dict_unref(rsp);
+    return 0;
+}
+
+int32_t
+index_writev_resume(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                    struct iovec *vector, int32_t count, off_t off,
+                    uint32_t flags, struct iobref *iobref, dict_t *xdata)
+{
+    STACK_WIND(frame, index_writev_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->writev, fd, vector, count, off, flags,
+               iobref, xdata);
+    return 0;
+}
+
+int32_t
+index_pre_xattrop_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, dict_t *xattr,
+                      dict_t *xdata)
+{
+    call_stub_t *stub = cookie;
+
+    if (op_ret < 0) {
+        call_unwind_error(stub, -1, op_errno);
+        return 0;
+    }
+
+    call_resume(stub);
+    return 0;
+}
+
+/* A writev may carry the pre-op changelog of its transaction, saving the
+ * client a separate xattrop round trip. The xattrop goes through
+ * index_fxattrop() so that the gfid is indexed exactly as for a standalone
+ * pre-op, and the write is only performed once the xattrop has succeeded. */
+int32_t
+index_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
+             struct iovec *vector, int32_t count, off_t off, uint32_t flags,
+             struct iobref *iobref, dict_t *xdata)
+{
+    struct index_pre_xattrop_args args = {
+        NULL,
+    };
+    call_stub_t *stub = NULL;
+    int32_t op_errno = ENOMEM;
+    int ret = 0;
+
+    if (!xdata || dict_foreach_fnmatch(xdata, GLUSTERFS_WRITE_PRE_XATTROP "*",
+                                       dict_null_foreach_fn, NULL) <= 0)
+        goto out;
+
+    args.xattr = dict_new();
+    args.xdata = dict_copy_with_ref(xdata, NULL);
+    if (!args.xattr || !args.xdata)
+        goto err;
+
+    ret = dict_foreach_fnmatch(xdata, GLUSTERFS_WRITE_PRE_XATTROP "*",
+                               index_pre_xattrop_split, &args);
+    if (ret < 0)
+        goto err;
+
+    stub = fop_writev_stub(frame, index_writev_resume, fd, vector, count, off,
+                           flags, iobref, args.xdata);
+    if (!stub)
+        goto err;
+
+    STACK_WIND_COOKIE(frame, index_pre_xattrop_cbk, stub, this,
+                      this->fops->fxattrop, fd, GF_XATTROP_ADD_ARRAY,
+                      args.xattr, NULL);
+
+    dict_unref(args.xattr);
+    dict_unref(args.xdata);
+    return 0;
+err:
+    if (args.xattr)
+        dict_unref(args.xattr);
+    if (args.xdata)
+        dict_unref(args.xdata);
+    STACK_UNWIND_STRICT(writev, frame, -1, op_errno, NULL, NULL, NULL);
+    return 0;
+out:
+    STACK_WIND(frame, default_writev_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->writev, fd, vector, count, off, flags,
+               iobref, xdata);
+    return 0;
+}
+
 uint64_t
 index_entry_count(xlator_t *this, char *subdir)
 {
@@ -2669,6 +2789,7 @@ notify(xlator_t *this, int event, void *data, ...)
 struct xlator_fops fops = {
     .xattrop = index_xattrop,
     .fxattrop = index_fxattrop,
+    .writev = index_writev,
 
     // interface functions follow
     .getxattr = index_getxattr,
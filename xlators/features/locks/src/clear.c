@@ -262,7 +262,7 @@ blkd:
 
             bcount++;
             list_del_init(&ilock->client_list);
-            list_del_init(&ilock->blocked_locks);
+            __pl_inodelk_unblock(ilock);
             list_add(&ilock->blocked_locks, &released);
         }
     }
@@ -297,7 +297,7 @@ granted:
 
             gcount++;
             list_del_init(&ilock->client_list);
-            list_del_init(&ilock->list);
+            __delete_inode_lock(ilock);
             list_add(&ilock->list, &released);
         }
     }
@@ -312,7 +312,8 @@ granted:
 
     ret = 0;
 out:
-    grant_blocked_inode_locks(this, pl_inode, dom, &now, pcontend);
+    grant_blocked_inode_locks(this, pl_inode, dom, 0, LLONG_MAX, &now,
+                              pcontend);
     if (pcontend != NULL) {
         inodelk_contention_notify(this, pcontend);
     }
@@ -49,6 +49,9 @@ __allocate_domain(const char *volume)
     INIT_LIST_HEAD(&dom->blocked_entrylks);
     INIT_LIST_HEAD(&dom->inodelk_list);
     INIT_LIST_HEAD(&dom->blocked_inodelks);
+    pl_itree_init(&dom->inodelk_tree);
+    pl_itree_init(&dom->blocked_inodelk_tree);
+    dom->blocked_inodelk_seq = 0;
 
 out:
     if (dom && (NULL == dom->domain)) {
@@ -1504,8 +1507,8 @@ pl_inode_remove_cbk(xlator_t *xl, pl_inode_t *pl_inode, int32_t error)
 
         list_for_each_entry(dom, &pl_inode->dom_list, inode_list)
         {
-            __grant_blocked_inode_locks(xl, pl_inode, &granted, dom, &now,
-                                        &contend);
+            __grant_blocked_inode_locks(xl, pl_inode, &granted, dom, 0,
+                                        LLONG_MAX, &now, &contend);
         }
     }
 
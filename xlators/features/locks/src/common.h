@@ -98,8 +98,8 @@ get_domain(pl_inode_t *pl_inode, const char *volume);
 
 void
 grant_blocked_inode_locks(xlator_t *this, pl_inode_t *pl_inode,
-                          pl_dom_list_t *dom, struct timespec *now,
-                          struct list_head *contend);
+                          pl_dom_list_t *dom, off_t start, off_t end,
+                          struct timespec *now, struct list_head *contend);
 
 void
 inodelk_contention_notify(xlator_t *this, struct list_head *contend);
@@ -107,13 +107,17 @@ inodelk_contention_notify(xlator_t *this, struct list_head *contend);
 void
 __delete_inode_lock(pl_inode_lock_t *lock);
 
+void
+__pl_inodelk_unblock(pl_inode_lock_t *lock);
+
 void
 __pl_inodelk_unref(pl_inode_lock_t *lock);
 
 void
 __grant_blocked_inode_locks(xlator_t *this, pl_inode_t *pl_inode,
                             struct list_head *granted, pl_dom_list_t *dom,
-                            struct timespec *now, struct list_head *contend);
+                            off_t start, off_t end, struct timespec *now,
+                            struct list_head *contend);
 
 void
 unwind_granted_inodes(xlator_t *this, pl_inode_t *pl_inode,
@@ -18,10 +18,32 @@
 #include "clear.h"
 #include "common.h"
 
+struct inodelk_search {
+    xlator_t *this;
+    pl_inode_lock_t *lock;
+    pl_inode_lock_t *conf;
+    struct timespec *now;
+    struct list_head *contend;
+};
+
+struct inodelk_wakeup {
+    pl_inode_lock_t **locks;
+    int count;
+};
+
 void
 __delete_inode_lock(pl_inode_lock_t *lock)
 {
     list_del_init(&lock->list);
+    pl_itree_remove(&lock->node);
+}
+
+/* Remove a lock from the blocked queue of its domain */
+void
+__pl_inodelk_unblock(pl_inode_lock_t *lock)
+{
+    list_del_init(&lock->blocked_locks);
+    pl_itree_remove(&lock->node);
 }
 
 static void
@@ -332,43 +354,73 @@ inodelk_contention_notify(xlator_t *this, struct list_head *contend)
     }
 }
 
+/* Returns true if @l was queued in the blocked list ahead of @lock. A lock
+ * which is not queued yet comes after every queued lock. */
+static int
+inodelk_queued_before(pl_inode_lock_t *l, pl_inode_lock_t *lock)
+{
+    return ((lock->blkd_seq == 0) || (l->blkd_seq < lock->blkd_seq));
+}
+
+static int
+__inodelk_granted_conflict(pl_itree_node_t *node, void *data)
+{
+    struct inodelk_search *search = data;
+    pl_inode_lock_t *l = list_entry(node, pl_inode_lock_t, node);
+
+    if (!inodelk_type_conflict(search->lock, l) ||
+        same_inodelk_owner(search->lock, l))
+        return 0;
+
+    if (search->conf == NULL) {
+        search->conf = l;
+        if (search->contend == NULL) {
+            return 1;
+        }
+    }
+    inodelk_contention_notify_check(search->this, l, search->now,
+                                    search->contend);
+
+    return 0;
+}
+
 /* Determine if lock is grantable or not */
 static pl_inode_lock_t *
 __inodelk_grantable(xlator_t *this, pl_dom_list_t *dom, pl_inode_lock_t *lock,
                     struct timespec *now, struct list_head *contend)
 {
-    pl_inode_lock_t *l = NULL;
-    pl_inode_lock_t *ret = NULL;
+    struct inodelk_search search = {this, lock, NULL, now, contend};
 
-    list_for_each_entry(l, &dom->inodelk_list, list)
-    {
-        if (inodelk_conflict(lock, l) && !same_inodelk_owner(lock, l)) {
-            if (ret == NULL) {
-                ret = l;
-                if (contend == NULL) {
-                    break;
-                }
-            }
-            inodelk_contention_notify_check(this, l, now, contend);
-        }
+    pl_itree_overlaps(&dom->inodelk_tree, lock->fl_start, lock->fl_end,
+                      __inodelk_granted_conflict, &search);
+
+    return search.conf;
+}
+
+static int
+__inodelk_blocked_conflict(pl_itree_node_t *node, void *data)
+{
+    struct inodelk_search *search = data;
+    pl_inode_lock_t *l = list_entry(node, pl_inode_lock_t, node);
+
+    if (inodelk_queued_before(l, search->lock) &&
+        inodelk_type_conflict(search->lock, l)) {
+        search->conf = l;
+        return 1;
     }
 
-    return ret;
+    return 0;
 }
 
 static pl_inode_lock_t *
 __blocked_lock_conflict(pl_dom_list_t *dom, pl_inode_lock_t *lock)
 {
-    pl_inode_lock_t *l = NULL;
+    struct inodelk_search search = {NULL, lock, NULL, NULL, NULL};
 
-    list_for_each_entry(l, &dom->blocked_inodelks, blocked_locks)
-    {
-        if (inodelk_conflict(lock, l)) {
-            return l;
-        }
-    }
+    pl_itree_overlaps(&dom->blocked_inodelk_tree, lock->fl_start,
+                      lock->fl_end, __inodelk_blocked_conflict, &search);
 
-    return NULL;
+    return search.conf;
 }
 
 static int
@@ -384,7 +436,8 @@ __owner_has_lock(pl_dom_list_t *dom, pl_inode_lock_t *newlock)
 
     list_for_each_entry(lock, &dom->blocked_inodelks, blocked_locks)
     {
-        if (same_inodelk_owner(lock, newlock))
+        if (lock != newlock && inodelk_queued_before(lock, newlock) &&
+            same_inodelk_owner(lock, newlock))
             return 1;
     }
 
@@ -399,8 +452,16 @@ __lock_blocked_add(xlator_t *this, pl_dom_list_t *dom, pl_inode_lock_t *lock,
         goto out;
     }
 
+    /* Still queued from an earlier attempt, keep its place. */
+    if (lock->blkd_seq != 0) {
+        goto out;
+    }
+
+    lock->blkd_seq = ++dom->blocked_inodelk_seq;
     lock->blkd_time = gf_time();
     list_add_tail(&lock->blocked_locks, &dom->blocked_inodelks);
+    pl_itree_insert(&dom->blocked_inodelk_tree, &lock->node, lock->fl_start,
+                    lock->fl_end);
 
     gf_msg_trace(this->name, 0,
                  "%s (pid=%d) (lk-owner=%s) %" PRId64
@@ -429,6 +490,7 @@ __lock_inodelk(xlator_t *this, pl_inode_t *pl_inode, pl_inode_lock_t *lock,
 
     ret = pl_inode_remove_inodelk(pl_inode, lock);
     if (ret < 0) {
+        __pl_inodelk_unblock(lock);
         return ret;
     }
     if (ret == 0) {
@@ -459,9 +521,12 @@ __lock_inodelk(xlator_t *this, pl_inode_t *pl_inode, pl_inode_lock_t *lock,
 
         return __lock_blocked_add(this, dom, lock, can_block);
     }
+    __pl_inodelk_unblock(lock);
     __pl_inodelk_ref(lock);
     lock->granted_time = gf_time();
     list_add(&lock->list, &dom->inodelk_list);
+    pl_itree_insert(&dom->inodelk_tree, &lock->node, lock->fl_start,
+                    lock->fl_end);
 
     return 0;
 }
@@ -520,29 +585,91 @@ out:
     return conf;
 }
 
+static int
+__inodelk_wakeup_collect(pl_itree_node_t *node, void *data)
+{
+    struct inodelk_wakeup *wakeup = data;
+
+    wakeup->locks[wakeup->count++] = list_entry(node, pl_inode_lock_t, node);
+
+    return 0;
+}
+
+static int
+inodelk_blkd_seq_cmp(const void *a, const void *b)
+{
+    const pl_inode_lock_t *l1 = *(pl_inode_lock_t *const *)a;
+    const pl_inode_lock_t *l2 = *(pl_inode_lock_t *const *)b;
+
+    if (l1->blkd_seq == l2->blkd_seq)
+        return 0;
+
+    return (l1->blkd_seq < l2->blkd_seq) ? -1 : 1;
+}
+
+static void
+__grant_blocked_inode_lock(xlator_t *this, pl_inode_t *pl_inode,
+                           pl_inode_lock_t *bl, struct list_head *granted,
+                           pl_dom_list_t *dom, struct timespec *now,
+                           struct list_head *contend)
+{
+    bl->status = __lock_inodelk(this, pl_inode, bl, 1, dom, now, contend);
+
+    if (bl->status != -EAGAIN) {
+        list_add_tail(&bl->blocked_locks, granted);
+    }
+}
+
+/* Retry the blocked locks overlapping [start, end], in the order in which
+ * they were queued. This is done when a lock in that range is released,
+ * and when a blocked lock in that range leaves the queue without being
+ * granted (client disconnect, clear-locks). Only the overlapping locks can
+ * have been waiting on it, either because of a conflict or because of the
+ * starvation rule. Granting a lock never unblocks another one: a waiter
+ * that conflicts with a queued lock also conflicts with it once granted.
+ * Locks waiting for an ongoing remove are not range based, so the whole
+ * queue is retried while the inode is locked for removal. */
 void
 __grant_blocked_inode_locks(xlator_t *this, pl_inode_t *pl_inode,
                             struct list_head *granted, pl_dom_list_t *dom,
-                            struct timespec *now, struct list_head *contend)
+                            off_t start, off_t end, struct timespec *now,
+                            struct list_head *contend)
 {
+    struct inodelk_wakeup wakeup = {
+        NULL,
+    };
     pl_inode_lock_t *bl = NULL;
     pl_inode_lock_t *tmp = NULL;
+    int i = 0;
 
-    struct list_head blocked_list;
-
-    INIT_LIST_HEAD(&blocked_list);
-    list_splice_init(&dom->blocked_inodelks, &blocked_list);
-
-    list_for_each_entry_safe(bl, tmp, &blocked_list, blocked_locks)
-    {
-        list_del_init(&bl->blocked_locks);
+    if (dom->blocked_inodelk_tree.count == 0)
+        return;
 
-        bl->status = __lock_inodelk(this, pl_inode, bl, 1, dom, now, contend);
+    if (!pl_inode->is_locked && ((start != 0) || (end != LLONG_MAX)))
+        wakeup.locks = GF_MALLOC(dom->blocked_inodelk_tree.count *
+                                     sizeof(*wakeup.locks),
+                                 gf_common_mt_pointer);
 
-        if (bl->status != -EAGAIN) {
-            list_add_tail(&bl->blocked_locks, granted);
+    if (!wakeup.locks) {
+        list_for_each_entry_safe(bl, tmp, &dom->blocked_inodelks,
+                                 blocked_locks)
+        {
+            __grant_blocked_inode_lock(this, pl_inode, bl, granted, dom, now,
+                                       contend);
         }
+        return;
     }
+
+    pl_itree_overlaps(&dom->blocked_inodelk_tree, start, end,
+                      __inodelk_wakeup_collect, &wakeup);
+    qsort(wakeup.locks, wakeup.count, sizeof(*wakeup.locks),
+          inodelk_blkd_seq_cmp);
+
+    for (i = 0; i < wakeup.count; i++)
+        __grant_blocked_inode_lock(this, pl_inode, wakeup.locks[i], granted,
+                                   dom, now, contend);
+
+    GF_FREE(wakeup.locks);
 }
 
 void
@@ -590,8 +717,8 @@ unwind_granted_inodes(xlator_t *this, pl_inode_t *pl_inode,
 /* Grant all inodelks blocked on a lock */
 void
 grant_blocked_inode_locks(xlator_t *this, pl_inode_t *pl_inode,
-                          pl_dom_list_t *dom, struct timespec *now,
-                          struct list_head *contend)
+                          pl_dom_list_t *dom, off_t start, off_t end,
+                          struct timespec *now, struct list_head *contend)
 {
     struct list_head granted;
 
@@ -599,8 +726,8 @@ grant_blocked_inode_locks(xlator_t *this, pl_inode_t *pl_inode,
 
     pthread_mutex_lock(&pl_inode->mutex);
     {
-        __grant_blocked_inode_locks(this, pl_inode, &granted, dom, now,
-                                    contend);
+        __grant_blocked_inode_locks(this, pl_inode, &granted, dom, start, end,
+                                    now, contend);
     }
     pthread_mutex_unlock(&pl_inode->mutex);
 
@@ -694,7 +821,7 @@ pl_inodelk_client_cleanup(xlator_t *this, pl_ctx_t *ctx)
                     __delete_inode_lock(l);
                     list_add_tail(&l->client_list, &released);
                 } else {
-                    list_del_init(&l->blocked_locks);
+                    __pl_inodelk_unblock(l);
                     list_add_tail(&l->client_list, &unwind);
                 }
             }
@@ -723,7 +850,8 @@ pl_inodelk_client_cleanup(xlator_t *this, pl_ctx_t *ctx)
 
             dom = get_domain(pl_inode, l->volume);
 
-            grant_blocked_inode_locks(this, pl_inode, dom, &now, pcontend);
+            grant_blocked_inode_locks(this, pl_inode, dom, l->fl_start,
+                                      l->fl_end, &now, pcontend);
 
             pthread_mutex_lock(&pl_inode->mutex);
             {
@@ -756,9 +884,13 @@ pl_inode_setlk(xlator_t *this, pl_ctx_t *ctx, pl_inode_t *pl_inode,
     struct list_head wake;
     struct timespec now = {};
     short fl_type;
+    off_t fl_start;
+    off_t fl_end;
 
     lock->pl_inode = pl_inode;
     fl_type = lock->fl_type;
+    fl_start = lock->fl_start;
+    fl_end = lock->fl_end;
 
     priv = this->private;
 
@@ -876,7 +1008,8 @@ pl_inode_setlk(xlator_t *this, pl_ctx_t *ctx, pl_inode_t *pl_inode,
      */
     if ((fl_type == F_UNLCK) && (ret == 0)) {
         inode_unref(pl_inode->inode);
-        grant_blocked_inode_locks(this, pl_inode, dom, &now, pcontend);
+        grant_blocked_inode_locks(this, pl_inode, dom, fl_start, fl_end, &now,
+                                  pcontend);
     }
 
     if (need_inode_unref) {
@@ -1110,15 +1243,7 @@ pl_finodelk(call_frame_t *frame, xlator_t *this, const char *volume, fd_t *fd,
 static int32_t
 __get_inodelk_dom_count(pl_dom_list_t *dom)
 {
-    pl_inode_lock_t *lock = NULL;
-    int32_t count = 0;
-
-    list_for_each_entry(lock, &dom->inodelk_list, list) { count++; }
-    list_for_each_entry(lock, &dom->blocked_inodelks, blocked_locks)
-    {
-        count++;
-    }
-    return count;
+    return dom->inodelk_tree.count + dom->blocked_inodelk_tree.count;
 }
 
 /* Returns the no. of locks (blocked/granted) held on a given domain name
@@ -0,0 +1,220 @@
+/*
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#include <stddef.h>
+
+#include "interval-tree.h"
+
+static int
+itree_height(pl_itree_node_t *node)
+{
+    return node ? node->height : 0;
+}
+
+static void
+itree_update(pl_itree_node_t *node)
+{
+    int lh = itree_height(node->left);
+    int rh = itree_height(node->right);
+
+    node->height = 1 + ((lh > rh) ? lh : rh);
+
+    node->max = node->end;
+    if (node->left && node->left->max > node->max)
+        node->max = node->left->max;
+    if (node->right && node->right->max > node->max)
+        node->max = node->right->max;
+}
+
+/* Nodes are ordered by start; ranges starting at the same offset are ordered
+ * by address so that every node has a unique position in the tree. */
+static int
+itree_cmp(pl_itree_node_t *a, pl_itree_node_t *b)
+{
+    if (a->start != b->start)
+        return (a->start < b->start) ? -1 : 1;
+    if (a != b)
+        return ((uintptr_t)a < (uintptr_t)b) ? -1 : 1;
+    return 0;
+}
+
+static pl_itree_node_t *
+itree_rotate_right(pl_itree_node_t *node)
+{
+    pl_itree_node_t *left = node->left;
+
+    node->left = left->right;
+    left->right = node;
+    itree_update(node);
+    itree_update(left);
+
+    return left;
+}
+
+static pl_itree_node_t *
+itree_rotate_left(pl_itree_node_t *node)
+{
+    pl_itree_node_t *right = node->right;
+
+    node->right = right->left;
+    right->left = node;
+    itree_update(node);
+    itree_update(right);
+
+    return right;
+}
+
+static pl_itree_node_t *
+itree_balance(pl_itree_node_t *node)
+{
+    int balance;
+
+    itree_update(node);
+    balance = itree_height(node->left) - itree_height(node->right);
+
+    if (balance > 1) {
+        if (itree_height(node->left->left) < itree_height(node->left->right))
+            node->left = itree_rotate_left(node->left);
+        return itree_rotate_right(node);
+    }
+
+    if (balance < -1) {
+        if (itree_height(node->right->right) < itree_height(node->right->left))
+            node->right = itree_rotate_right(node->right);
+        return itree_rotate_left(node);
+    }
+
+    return node;
+}
+
+static pl_itree_node_t *
+itree_insert(pl_itree_node_t *root, pl_itree_node_t *node)
+{
+    if (!root)
+        return node;
+
+    if (itree_cmp(node, root) < 0)
+        root->left = itree_insert(root->left, node);
+    else
+        root->right = itree_insert(root->right, node);
+
+    return itree_balance(root);
+}
+
+static pl_itree_node_t *
+itree_remove_min(pl_itree_node_t *root, pl_itree_node_t **min)
+{
+    if (!root->left) {
+        *min = root;
+        return root->right;
+    }
+
+    root->left = itree_remove_min(root->left, min);
+
+    return itree_balance(root);
+}
+
+static pl_itree_node_t *
+itree_remove(pl_itree_node_t *root, pl_itree_node_t *node)
+{
+    pl_itree_node_t *min = NULL;
+    pl_itree_node_t *right = NULL;
+    int cmp;
+
+    if (!root)
+        return NULL;
+
+    cmp = itree_cmp(node, root);
+    if (cmp < 0) {
+        root->left = itree_remove(root->left, node);
+    } else if (cmp > 0) {
+        root->right = itree_remove(root->right, node);
+    } else {
+        if (!root->right)
+            return root->left;
+
+        right = itree_remove_min(root->right, &min);
+        min->left = root->left;
+        min->right = right;
+        root = min;
+    }
+
+    return itree_balance(root);
+}
+
+static int
+itree_overlaps(pl_itree_node_t *node, off_t start, off_t end, pl_itree_fn_t fn,
+               void *data)
+{
+    int ret;
+
+    if (!node || node->max < start)
+        return 0;
+
+    ret = itree_overlaps(node->left, start, end, fn, data);
+    if (ret)
+        return ret;
+
+    /* This node and everything to its right start after the range. */
+    if (node->start > end)
+        return 0;
+
+    if (node->end >= start) {
+        ret = fn(node, data);
+        if (ret)
+            return ret;
+    }
+
+    return itree_overlaps(node->right, start, end, fn, data);
+}
+
+void
+pl_itree_init(pl_itree_t *tree)
+{
+    tree->root = NULL;
+    tree->count = 0;
+}
+
+void
+pl_itree_insert(pl_itree_t *tree, pl_itree_node_t *node, off_t start,
+                off_t end)
+{
+    node->left = NULL;
+    node->right = NULL;
+    node->start = start;
+    node->end = end;
+    node->max = end;
+    node->height = 1;
+    node->tree = tree;
+
+    tree->root = itree_insert(tree->root, node);
+    tree->count++;
+}
+
+void
+pl_itree_remove(pl_itree_node_t *node)
+{
+    pl_itree_t *tree = node->tree;
+
+    if (!tree)
+        return;
+
+    tree->root = itree_remove(tree->root, node);
+    tree->count--;
+
+    node->left = NULL;
+    node->right = NULL;
+    node->tree = NULL;
+}
+
+int
+pl_itree_overlaps(pl_itree_t *tree, off_t start, off_t end, pl_itree_fn_t fn,
+                  void *data)
+{
+    return itree_overlaps(tree->root, start, end, fn, data);
+}
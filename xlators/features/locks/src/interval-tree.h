@@ -0,0 +1,56 @@
+/*
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef __INTERVAL_TREE_H__
+#define __INTERVAL_TREE_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Intrusive interval tree: an AVL tree ordered by range start, where every
+ * node also keeps the largest range end of its subtree so that overlap
+ * searches can skip subtrees which end before the searched range. Callers
+ * provide the serialization (pl_inode->mutex for the lock domains). */
+
+struct pl_itree;
+
+typedef struct pl_itree_node {
+    struct pl_itree_node *left;
+    struct pl_itree_node *right;
+    struct pl_itree *tree; /* tree the node is linked into, NULL if none */
+    off_t start;
+    off_t end; /* inclusive */
+    off_t max; /* largest 'end' in this subtree */
+    int height;
+} pl_itree_node_t;
+
+typedef struct pl_itree {
+    pl_itree_node_t *root;
+    uint32_t count;
+} pl_itree_t;
+
+/* Called for each node overlapping the searched range, in ascending order of
+ * start. A non-zero return stops the search and is returned to the caller.
+ * The tree must not be modified from the callback. */
+typedef int (*pl_itree_fn_t)(pl_itree_node_t *node, void *data);
+
+void
+pl_itree_init(pl_itree_t *tree);
+
+void
+pl_itree_insert(pl_itree_t *tree, pl_itree_node_t *node, off_t start,
+                off_t end);
+
+void
+pl_itree_remove(pl_itree_node_t *node);
+
+int
+pl_itree_overlaps(pl_itree_t *tree, off_t start, off_t end, pl_itree_fn_t fn,
+                  void *data);
+
+#endif /* __INTERVAL_TREE_H__ */
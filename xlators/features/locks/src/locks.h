@@ -13,6 +13,7 @@
 #include <glusterfs/compat-errno.h>
 #include <glusterfs/call-stub.h>
 #include "locks-mem-types.h"
+#include "interval-tree.h"
 
 typedef enum {
     MLK_NONE,
@@ -72,6 +73,10 @@ struct __pl_inode_lock {
     off_t fl_start;
     off_t fl_end;
 
+    /* links the lock into the granted or the blocked tree of its domain */
+    pl_itree_node_t node;
+    uint64_t blkd_seq; /* order in the blocked queue, 0 if never blocked */
+
     const char *volume;
 
     struct gf_flock user_flock; /* the flock supplied by the user */
@@ -117,6 +122,9 @@ struct _pl_dom_list {
     struct list_head blocked_entrylks; /* List of all blocked entrylks */
     struct list_head inodelk_list;     /* List of inode locks */
     struct list_head blocked_inodelks; /* List of all blocked inodelks */
+    pl_itree_t inodelk_tree;           /* granted inodelks by range */
+    pl_itree_t blocked_inodelk_tree;   /* blocked inodelks by range */
+    uint64_t blocked_inodelk_seq;
 };
 typedef struct _pl_dom_list pl_dom_list_t;
 
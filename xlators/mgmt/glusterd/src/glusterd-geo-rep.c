@@ -114,8 +114,8 @@ __glusterd_handle_sys_exec(rpcsvc_request_t *req)
             goto out;
         }
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -124,8 +124,6 @@ __glusterd_handle_sys_exec(rpcsvc_request_t *req)
                      "Unable to decode "
                      "the command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
 
         host_uuid = gf_strdup(uuid_utoa(MY_UUID));
@@ -195,8 +193,8 @@ __glusterd_handle_copy_file(rpcsvc_request_t *req)
             goto out;
         }
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to"
@@ -205,8 +203,6 @@ __glusterd_handle_copy_file(rpcsvc_request_t *req)
                      "Unable to decode "
                      "the command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
 
         host_uuid = gf_strdup(uuid_utoa(MY_UUID));
@@ -279,8 +275,8 @@ __glusterd_handle_gsync_set(rpcsvc_request_t *req)
             goto out;
         }
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -289,8 +285,6 @@ __glusterd_handle_gsync_set(rpcsvc_request_t *req)
                      "Unable to decode "
                      "the command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
 
         host_uuid = gf_strdup(uuid_utoa(MY_UUID));
@@ -1455,15 +1455,13 @@ __glusterd_handle_cli_list_friends(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg("glusterd", GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
                    "unserialize req-buffer to dictionary");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -1515,15 +1513,13 @@ __glusterd_handle_cli_get_volume(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
                    "unserialize req-buffer to dictionary");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -1590,8 +1586,8 @@ __glusterd_handle_cli_uuid_reset(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -1600,8 +1596,6 @@ __glusterd_handle_cli_uuid_reset(rpcsvc_request_t *req)
                      "Unable to decode "
                      "the buffer");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -1710,8 +1704,8 @@ __glusterd_handle_cli_uuid_get(rpcsvc_request_t *req)
             goto out;
         }
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg("glusterd", GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -1720,9 +1714,6 @@ __glusterd_handle_cli_uuid_get(rpcsvc_request_t *req)
                      "Unable to decode "
                      "the buffer");
             goto out;
-
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -1903,8 +1894,8 @@ __glusterd_handle_ganesha_cmd(rpcsvc_request_t *req)
             goto out;
         }
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -1913,8 +1904,6 @@ __glusterd_handle_ganesha_cmd(rpcsvc_request_t *req)
                      "Unable to decode "
                      "the command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -1975,8 +1964,8 @@ __glusterd_handle_reset_volume(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -1985,8 +1974,6 @@ __glusterd_handle_reset_volume(rpcsvc_request_t *req)
                      "Unable to decode "
                      "the command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -2058,8 +2045,8 @@ __glusterd_handle_set_volume(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, errno,
                    GD_MSG_DICT_UNSERIALIZE_FAIL,
@@ -2069,8 +2056,6 @@ __glusterd_handle_set_volume(rpcsvc_request_t *req)
                      "Unable to decode "
                      "the command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -2172,8 +2157,8 @@ __glusterd_handle_sync_volume(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -2182,8 +2167,6 @@ __glusterd_handle_sync_volume(rpcsvc_request_t *req)
                      "Unable to decode the "
                      "command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -2899,15 +2882,13 @@ __glusterd_handle_friend_update(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(friend_req.friends.friends_val,
-                               friend_req.friends.friends_len, &dict);
+        ret = dict_unserialize_stdalloc(friend_req.friends.friends_val,
+                                        friend_req.friends.friends_len, &dict);
         if (ret < 0) {
             gf_msg("glusterd", GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
                    "unserialize req-buffer to dictionary");
             goto out;
-        } else {
-            dict->extra_stdfree = friend_req.friends.friends_val;
         }
     }
 
@@ -3312,8 +3293,8 @@ __glusterd_handle_mount(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(mnt_req.dict.dict_val, mnt_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(mnt_req.dict.dict_val,
+                                        mnt_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg("glusterd", GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -3321,8 +3302,6 @@ __glusterd_handle_mount(rpcsvc_request_t *req)
             rsp.op_ret = -1;
             rsp.op_errno = -EINVAL;
             goto out;
-        } else {
-            dict->extra_stdfree = mnt_req.dict.dict_val;
         }
     }
 
@@ -5183,8 +5162,8 @@ __glusterd_handle_get_vol_opt(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -5193,8 +5172,6 @@ __glusterd_handle_get_vol_opt(rpcsvc_request_t *req)
                      "Unable to decode "
                      "the command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
     ret = glusterd_get_volume_opts(req, dict);
@@ -6244,8 +6221,8 @@ __glusterd_handle_get_state(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -6254,8 +6231,6 @@ __glusterd_handle_get_state(rpcsvc_request_t *req)
                      "Unable to decode"
                      " the command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -1568,16 +1568,14 @@ __server_get_volume_info(rpcsvc_request_t *req)
             goto out;
         }
 
-        ret = dict_unserialize(vol_info_req.dict.dict_val,
-                               vol_info_req.dict.dict_len, &dict);
+        ret = dict_unserialize_stdalloc(vol_info_req.dict.dict_val,
+                                        vol_info_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_smsg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                     NULL);
             op_errno = -ret;
             ret = -1;
             goto out;
-        } else {
-            dict->extra_stdfree = vol_info_req.dict.dict_val;
         }
     }
 
@@ -1720,8 +1718,8 @@ __server_get_snap_info(rpcsvc_request_t *req)
             goto out;
         }
 
-        ret = dict_unserialize(snap_info_req.dict.dict_val,
-                               snap_info_req.dict.dict_len, &dict);
+        ret = dict_unserialize_stdalloc(snap_info_req.dict.dict_val,
+                                        snap_info_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg("glusterd", GF_LOG_ERROR, EINVAL,
                    GD_MSG_DICT_UNSERIALIZE_FAIL,
@@ -1729,8 +1727,6 @@ __server_get_snap_info(rpcsvc_request_t *req)
             op_errno = EINVAL;
             ret = -1;
             goto out;
-        } else {
-            dict->extra_stdfree = snap_info_req.dict.dict_val;
         }
     }
 
@@ -861,12 +861,11 @@ gd_mgmt_v3_pre_validate_cbk_fn(struct rpc_req *req, struct iovec *iov,
         /* Unserialize the dictionary */
         rsp_dict = dict_new();
 
-        ret = dict_unserialize(rsp.dict.dict_val, rsp.dict.dict_len, &rsp_dict);
+        ret = dict_unserialize_stdalloc(rsp.dict.dict_val, rsp.dict.dict_len,
+                                        &rsp_dict);
         if (ret < 0) {
             free(rsp.dict.dict_val);
             goto out;
-        } else {
-            rsp_dict->extra_stdfree = rsp.dict.dict_val;
         }
     }
 
@@ -1221,11 +1220,10 @@ gd_mgmt_v3_brick_op_cbk_fn(struct rpc_req *req, struct iovec *iov, int count,
         /* Unserialize the dictionary */
         rsp_dict = dict_new();
 
-        ret = dict_unserialize(rsp.dict.dict_val, rsp.dict.dict_len, &rsp_dict);
+        ret = dict_unserialize_stdalloc(rsp.dict.dict_val, rsp.dict.dict_len,
+                                        &rsp_dict);
         if (ret < 0) {
             goto out;
-        } else {
-            rsp_dict->extra_stdfree = rsp.dict.dict_val;
         }
     }
 
@@ -1482,12 +1480,11 @@ gd_mgmt_v3_commit_cbk_fn(struct rpc_req *req, struct iovec *iov, int count,
         /* Unserialize the dictionary */
         rsp_dict = dict_new();
 
-        ret = dict_unserialize(rsp.dict.dict_val, rsp.dict.dict_len, &rsp_dict);
+        ret = dict_unserialize_stdalloc(rsp.dict.dict_val, rsp.dict.dict_len,
+                                        &rsp_dict);
         if (ret < 0) {
             free(rsp.dict.dict_val);
             goto out;
-        } else {
-            rsp_dict->extra_stdfree = rsp.dict.dict_val;
         }
     }
 
@@ -1763,12 +1760,11 @@ gd_mgmt_v3_post_commit_cbk_fn(struct rpc_req *req, struct iovec *iov, int count,
         /* Unserialize the dictionary */
         rsp_dict = dict_new();
 
-        ret = dict_unserialize(rsp.dict.dict_val, rsp.dict.dict_len, &rsp_dict);
+        ret = dict_unserialize_stdalloc(rsp.dict.dict_val, rsp.dict.dict_len,
+                                        &rsp_dict);
         if (ret < 0) {
             free(rsp.dict.dict_val);
             goto out;
-        } else {
-            rsp_dict->extra_stdfree = rsp.dict.dict_val;
         }
     }
 
@@ -1233,7 +1233,7 @@ glusterd_op_stage_set_volume(dict_t *dict, char **op_errstr)
         }
 #endif /* HAVE_LIBAIO */
 
-#ifdef HAVE_LIBURING
+#ifdef HAVE_IO_URING
         if (len_strcmp(key, keylen, "storage.linux-io_uring")) {
             if (volinfo && volinfo->status == GLUSTERD_STATUS_STARTED) {
                 snprintf(errstr, sizeof(errstr),
@@ -1244,7 +1244,7 @@ glusterd_op_stage_set_volume(dict_t *dict, char **op_errstr)
                 goto out;
             }
         }
-#endif /* HAVE_LIBURING */
+#endif /* HAVE_IO_URING */
 
         if (len_strcmp(key, keylen, "cluster.granular-entry-heal")) {
             /* For granular entry-heal, if the set command was
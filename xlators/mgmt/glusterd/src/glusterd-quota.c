@@ -183,8 +183,8 @@ __glusterd_handle_quota(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -193,8 +193,6 @@ __glusterd_handle_quota(rpcsvc_request_t *req)
                      "Unable to decode the "
                      "command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -293,6 +293,9 @@ glusterd_handle_defrag_start(glusterd_volinfo_t *volinfo, char *op_errstr,
     runner_add_arg(&runner, "--xlator-option");
     runner_argprintf(&runner, "*dht.commit-hash=%u",
                      volinfo->rebal.commit_hash);
+    runner_add_arg(&runner, "--xlator-option");
+    runner_argprintf(&runner, "*dht.rebalance-checkpoint=%s/%s.crawl",
+                     defrag_path, uuid_utoa(MY_UUID));
     runner_add_arg(&runner, "--socket-file");
     runner_argprintf(&runner, "%s", sockfile);
     runner_add_arg(&runner, "--pid-file");
@@ -1163,15 +1163,14 @@ __glusterd_stage_op_cbk(struct rpc_req *req, struct iovec *iov, int count,
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(rsp.dict.dict_val, rsp.dict.dict_len, &dict);
+        ret = dict_unserialize_stdalloc(rsp.dict.dict_val, rsp.dict.dict_len,
+                                        &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
                    "unserialize rsp-buffer to dictionary");
             event_type = GD_OP_EVENT_RCVD_RJT;
             goto out;
-        } else {
-            dict->extra_stdfree = rsp.dict.dict_val;
         }
     }
 
@@ -1305,15 +1304,14 @@ __glusterd_commit_op_cbk(struct rpc_req *req, struct iovec *iov, int count,
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(rsp.dict.dict_val, rsp.dict.dict_len, &dict);
+        ret = dict_unserialize_stdalloc(rsp.dict.dict_val, rsp.dict.dict_len,
+                                        &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
                    "unserialize rsp-buffer to dictionary");
             event_type = GD_OP_EVENT_RCVD_RJT;
             goto out;
-        } else {
-            dict->extra_stdfree = rsp.dict.dict_val;
         }
     }
 
@@ -2078,16 +2076,14 @@ __glusterd_brick_op_cbk(struct rpc_req *req, struct iovec *iov, int count,
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(rsp.output.output_val, rsp.output.output_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(rsp.output.output_val,
+                                        rsp.output.output_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "Failed to "
                    "unserialize rsp-buffer to dictionary");
             event_type = GD_OP_EVENT_RCVD_RJT;
             goto out;
-        } else {
-            dict->extra_stdfree = rsp.output.output_val;
         }
     }
 
@@ -8714,8 +8714,8 @@ glusterd_handle_snapshot_fn(rpcsvc_request_t *req)
         if (!dict)
             goto out;
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -8726,8 +8726,6 @@ glusterd_handle_snapshot_fn(rpcsvc_request_t *req)
             goto out;
         }
 
-        dict->extra_stdfree = cli_req.dict.dict_val;
-
         host_uuid = gf_strdup(uuid_utoa(MY_UUID));
         if (host_uuid == NULL) {
             snprintf(err_str, sizeof(err_str),
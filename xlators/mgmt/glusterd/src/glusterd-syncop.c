@@ -1390,12 +1390,11 @@ _gd_syncop_stage_op_cbk(struct rpc_req *req, struct iovec *iov, int count,
         /* Unserialize the dictionary */
         rsp_dict = dict_new();
 
-        ret = dict_unserialize(rsp.dict.dict_val, rsp.dict.dict_len, &rsp_dict);
+        ret = dict_unserialize_stdalloc(rsp.dict.dict_val, rsp.dict.dict_len,
+                                        &rsp_dict);
         if (ret < 0) {
             GF_FREE(rsp.dict.dict_val);
             goto out;
-        } else {
-            rsp_dict->extra_stdfree = rsp.dict.dict_val;
         }
     }
 
@@ -1694,12 +1693,11 @@ _gd_syncop_commit_op_cbk(struct rpc_req *req, struct iovec *iov, int count,
         /* Unserialize the dictionary */
         rsp_dict = dict_new();
 
-        ret = dict_unserialize(rsp.dict.dict_val, rsp.dict.dict_len, &rsp_dict);
+        ret = dict_unserialize_stdalloc(rsp.dict.dict_val, rsp.dict.dict_len,
+                                        &rsp_dict);
         if (ret < 0) {
             GF_FREE(rsp.dict.dict_val);
             goto out;
-        } else {
-            rsp_dict->extra_stdfree = rsp.dict.dict_val;
         }
     }
 
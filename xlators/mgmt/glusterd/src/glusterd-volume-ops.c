@@ -96,8 +96,8 @@ __glusterd_handle_create_volume(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -106,8 +106,6 @@ __glusterd_handle_create_volume(rpcsvc_request_t *req)
                      "Unable to decode "
                      "the command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
@@ -702,8 +700,8 @@ __glusterd_handle_cli_heal_volume(rpcsvc_request_t *req)
         /* Unserialize the dictionary */
         dict = dict_new();
 
-        ret = dict_unserialize(cli_req.dict.dict_val, cli_req.dict.dict_len,
-                               &dict);
+        ret = dict_unserialize_stdalloc(cli_req.dict.dict_val,
+                                        cli_req.dict.dict_len, &dict);
         if (ret < 0) {
             gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_DICT_UNSERIALIZE_FAIL,
                    "failed to "
@@ -711,8 +709,6 @@ __glusterd_handle_cli_heal_volume(rpcsvc_request_t *req)
             snprintf(op_errstr, sizeof(op_errstr),
                      "Unable to decode the command");
             goto out;
-        } else {
-            dict->extra_stdfree = cli_req.dict.dict_val;
         }
     }
 
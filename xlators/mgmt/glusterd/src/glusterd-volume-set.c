@@ -691,6 +691,30 @@ out:
     return ret;
 }
 
+static int
+validate_read_hash_mode(glusterd_volinfo_t *volinfo, dict_t *dict, char *key,
+                        char *value, char **op_errstr)
+{
+    int ret = 0;
+    int32_t mode = 0;
+
+    ret = gf_string2int32(value, &mode);
+    if (ret < 0)
+        goto out;
+
+    /* Mode 6 (adaptive latency) is new in 11.0. Older clients would fail
+     * to load the graph with it. */
+    if (mode < 6)
+        goto out;
+
+    ret = glusterd_check_client_op_version_support(
+        volinfo->volname, GD_OP_VERSION_11_0, op_errstr);
+out:
+    gf_msg_debug("glusterd", 0, "Returning %d", ret);
+
+    return ret;
+}
+
 static int
 validate_worm_period(glusterd_volinfo_t *volinfo, dict_t *dict, char *key,
                      char *value, char **op_errstr)
@@ -886,6 +910,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .flags = VOLOPT_FLAG_CLIENT_OPT,
     },
 
+    {
+        .key = "cluster.rebal-crawl-threads",
+        .voltype = "cluster/distribute",
+        .option = "rebal-crawl-threads",
+        .op_version = GD_OP_VERSION_11_0,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+    },
+
     {
         .key = "cluster.lock-migration",
         .voltype = "cluster/distribute",
@@ -923,6 +955,13 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .voltype = "cluster/distribute",
         .op_version = GD_OP_VERSION_3_6_0,
     },
+    {
+        .key = "cluster.layout-type",
+        .voltype = "cluster/distribute",
+        .option = "layout-type",
+        .op_version = GD_OP_VERSION_11_0,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+    },
 
     /* Switch xlator options (Distribute special case) */
     {.key = "cluster.switch",
@@ -954,6 +993,19 @@ struct volopt_map_entry glusterd_volopt_map[] = {
     {.key = "cluster.read-hash-mode",
      .voltype = "cluster/replicate",
      .op_version = 2,
+     .flags = VOLOPT_FLAG_CLIENT_OPT,
+     .validate_fn = validate_read_hash_mode},
+    {.key = "cluster.read-outlier-factor",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_11_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.read-outlier-eject-time",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_11_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.read-hedge-percentile",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_11_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.background-self-heal-count",
      .voltype = "cluster/replicate",
@@ -1255,6 +1307,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "performance/io-threads",
      .option = "pass-through",
      .op_version = GD_OP_VERSION_4_1_0},
+    {.key = "performance.iot-queue-count",
+     .voltype = "performance/io-threads",
+     .option = "queue-count",
+     .op_version = GD_OP_VERSION_11_0},
 
     /* Other perf xlators' options */
     {.key = "performance.io-cache-pass-through",
@@ -1294,6 +1350,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "ctime-invalidation",
      .op_version = GD_OP_VERSION_5_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.quick-read-cache-compression",
+     .voltype = "performance/quick-read",
+     .option = "cache-compression",
+     .op_version = GD_OP_VERSION_11_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "performance.flush-behind",
      .voltype = "performance/write-behind",
      .option = "flush-behind",
@@ -1515,6 +1576,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .op_version = GD_OP_VERSION_3_10_2,
      .value = "9",
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "client.transport-engine",
+     .voltype = "protocol/client",
+     .option = "transport.socket.engine",
+     .op_version = GD_OP_VERSION_11_0,
+     .value = "epoll",
+     .flags = VOLOPT_FLAG_CLIENT_OPT,
+     .description = "Use 'uring' to send and receive data through io_uring "
+                    "instead of epoll and readv/writev."},
     {.key = "client.strict-locks",
      .voltype = "protocol/client",
      .option = "strict-locks",
@@ -1591,6 +1660,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "rpc.outstanding-rpc-limit",
      .type = GLOBAL_DOC,
      .op_version = 3},
+    {.key = "server.outstanding-rpc-adaptive",
+     .voltype = "protocol/server",
+     .option = "rpc.outstanding-rpc-adaptive",
+     .value = "on",
+     .op_version = GD_OP_VERSION_11_0,
+     .description = "Adapt the number of outstanding requests of each "
+                    "client to the time they wait before being processed, "
+                    "up to server.outstanding-rpc-limit."},
     {.key = "server.ssl",
      .voltype = "protocol/server",
      .value = "off",
@@ -1670,6 +1747,35 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .op_version = GD_OP_VERSION_3_10_2,
         .value = "9",
     },
+    {
+        .key = "server.transport-engine",
+        .voltype = "protocol/server",
+        .option = "transport.socket.engine",
+        .op_version = GD_OP_VERSION_11_0,
+        .value = "epoll",
+        .description = "Use 'uring' to send and receive data through "
+                       "io_uring instead of epoll and readv/writev.",
+    },
+    {
+        .key = "server.transport-zerocopy",
+        .voltype = "protocol/server",
+        .option = "transport.socket.zerocopy",
+        .op_version = GD_OP_VERSION_11_0,
+        .value = "off",
+        .description = "Send read replies without copying the data to the "
+                       "kernel (MSG_ZEROCOPY). Only big replies are sent "
+                       "this way.",
+    },
+    {
+        .key = "server.transport-read-batch",
+        .voltype = "protocol/server",
+        .option = "transport.socket.read-batch",
+        .op_version = GD_OP_VERSION_11_0,
+        .value = "16",
+        .description = "Maximum number of requests read from a connection "
+                       "and processed together. Their replies are sent "
+                       "with as few writes as possible.",
+    },
     {
         .key = "transport.listen-backlog",
         .voltype = "protocol/server",
@@ -2781,6 +2887,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/disperse",
      .op_version = GD_OP_VERSION_3_9_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.matrix-cache-size",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_11_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "disperse.self-heal-window-size",
      .voltype = "cluster/disperse",
      .op_version = GD_OP_VERSION_3_11_0,
@@ -2857,6 +2967,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .flags = VOLOPT_FLAG_CLIENT_OPT,
         .op_version = GD_OP_VERSION_3_11_0,
     },
+    {
+        .key = "performance.nl-cache-readdirp",
+        .voltype = "performance/nl-cache",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_11_0,
+    },
+    {
+        .key = "performance.nl-cache-readdirp-limit",
+        .voltype = "performance/nl-cache",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_11_0,
+    },
 
     /* Brick multiplexing options */
     {.key = GLUSTERD_BRICK_MULTIPLEX_KEY,
@@ -2907,6 +3029,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .type = NO_DOC,
      .op_version = GD_OP_VERSION_3_10_1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.read-hedge-percentile",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_11_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "disperse.stripe-cache",
      .voltype = "cluster/disperse",
      .type = NO_DOC,
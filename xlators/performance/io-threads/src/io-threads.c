@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <sys/time.h>
 #include <time.h>
+#include <sched.h>
 #include <glusterfs/locking.h>
 #include "io-threads-messages.h"
 #include <glusterfs/timespec.h>
@@ -29,6 +30,8 @@ static int
 iot_workers_scale(iot_conf_t *conf);
 static int
 __iot_workers_scale(iot_conf_t *conf);
+static void
+iot_queues_fini(iot_conf_t *conf);
 struct volume_options options[];
 
 #define IOT_FOP(name, frame, this, args...)                                    \
@@ -56,14 +59,16 @@ struct volume_options options[];
 static iot_client_ctx_t *
 iot_get_ctx(xlator_t *this, client_t *client)
 {
+    iot_conf_t *conf = this->private;
     iot_client_ctx_t *ctx = NULL;
     iot_client_ctx_t *setted_ctx = NULL;
+    int count = conf->queue_count * GF_FOP_PRI_MAX;
     int i;
 
     if (client_ctx_get(client, this, (void **)&ctx) != 0) {
-        ctx = GF_MALLOC(GF_FOP_PRI_MAX * sizeof(*ctx), gf_iot_mt_client_ctx_t);
+        ctx = GF_MALLOC(count * sizeof(*ctx), gf_iot_mt_client_ctx_t);
         if (ctx) {
-            for (i = 0; i < GF_FOP_PRI_MAX; ++i) {
+            for (i = 0; i < count; ++i) {
                 INIT_LIST_HEAD(&ctx[i].reqs);
                 INIT_LIST_HEAD(&ctx[i].clients);
             }
@@ -78,53 +83,149 @@ iot_get_ctx(xlator_t *this, client_t *client)
     return ctx;
 }
 
+static iot_queue_t *
+iot_get_queue(iot_conf_t *conf)
+{
+    int cpu = -1;
+
+#ifdef GF_LINUX_HOST_OS
+    cpu = sched_getcpu();
+#endif
+    if (cpu < 0)
+        cpu = ((uintptr_t)pthread_self() >> 12) & INT_MAX;
+
+    return &conf->queues[cpu % conf->queue_count];
+}
+
+/* Checks whether any queued request could be served right now, given the
+ * per-priority thread limits. */
+static gf_boolean_t
+iot_work_available(iot_conf_t *conf)
+{
+    iot_fop_data_t *fop_data;
+    int i;
+
+    for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+        fop_data = &conf->fops_data[i];
+        if (GF_ATOMIC_GET(fop_data->queue_sizes) &&
+            (GF_ATOMIC_GET(fop_data->ac_iot_count) < fop_data->ac_iot_limit))
+            return _gf_true;
+    }
+
+    return _gf_false;
+}
+
+/* Wakes up one sleeping worker, preferably one whose home is 'queue'. */
+static void
+iot_wake_worker(iot_conf_t *conf, iot_queue_t *queue)
+{
+    int first = queue - conf->queues;
+    gf_boolean_t woken = _gf_false;
+    int i;
+
+    for (i = 0; (i < conf->queue_count) && !woken; i++) {
+        queue = &conf->queues[(first + i) % conf->queue_count];
+        if (!queue->sleep_count)
+            continue;
+
+        pthread_mutex_lock(&queue->mutex);
+        {
+            if (queue->sleep_count) {
+                pthread_cond_signal(&queue->cond);
+                woken = _gf_true;
+            }
+        }
+        pthread_mutex_unlock(&queue->mutex);
+    }
+}
+
+/* Takes the next request of priority 'pri' from 'queue'. The caller holds
+ * a thread slot of that priority. */
 static call_stub_t *
-__iot_dequeue(iot_conf_t *conf, int *pri)
+__iot_dequeue(iot_conf_t *conf, iot_queue_t *queue, int pri)
 {
     call_stub_t *stub = NULL;
-    int i = 0;
     iot_client_ctx_t *ctx;
+    iot_fop_data_t *fop_data = &conf->fops_data[pri];
+
+    if (list_empty(&queue->clients[pri]))
+        return NULL;
+
+    /* Get the first per-client queue for this priority. */
+    ctx = list_first_entry(&queue->clients[pri], iot_client_ctx_t, clients);
+
+    /* Get the first request on that queue. */
+    stub = list_first_entry(&ctx->reqs, call_stub_t, list);
+    list_del_init(&stub->list);
+    if (list_empty(&ctx->reqs)) {
+        list_del_init(&ctx->clients);
+    } else {
+        list_rotate_left(&queue->clients[pri]);
+    }
+
+    fop_data->queue_marked = _gf_false;
+    GF_ATOMIC_DEC(fop_data->queue_sizes);
+    GF_ATOMIC_DEC(queue->pri_size[pri]);
+    GF_ATOMIC_DEC(conf->queue_size);
+
+    return stub;
+}
+
+/* Serves the highest priority that has queued requests and a free thread
+ * slot. Within a priority the home queue comes first, so a worker steals
+ * from the other queues before it serves a lower priority at home. */
+static call_stub_t *
+iot_dequeue(iot_conf_t *conf, iot_queue_t *home, int *pri)
+{
+    call_stub_t *stub = NULL;
+    iot_queue_t *queue = NULL;
     iot_fop_data_t *fop_data;
+    int first = home - conf->queues;
+    int i;
+    int q;
 
     for (i = 0; i < GF_FOP_PRI_MAX; i++) {
         fop_data = &conf->fops_data[i];
-        if (fop_data->ac_iot_count >= fop_data->ac_iot_limit) {
+        if (!GF_ATOMIC_GET(fop_data->queue_sizes))
             continue;
-        }
 
-        else if (list_empty(&fop_data->clients)) {
+        /* Reserve a slot of this priority, other workers compete for it. */
+        if (GF_ATOMIC_INC(fop_data->ac_iot_count) > fop_data->ac_iot_limit) {
+            GF_ATOMIC_DEC(fop_data->ac_iot_count);
             continue;
         }
 
-        /* Get the first per-client queue for this priority. */
-        ctx = list_first_entry(&fop_data->clients, iot_client_ctx_t, clients);
-        if (list_empty(&ctx->reqs)) {
-            continue;
-        }
+        for (q = 0; q < conf->queue_count; q++) {
+            queue = &conf->queues[(first + q) % conf->queue_count];
+            if (!GF_ATOMIC_GET(queue->pri_size[i]))
+                continue;
 
-        /* Get the first request on that queue. */
-        stub = list_first_entry(&ctx->reqs, call_stub_t, list);
-        list_del_init(&stub->list);
-        if (list_empty(&ctx->reqs)) {
-            list_del_init(&ctx->clients);
-        } else {
-            list_rotate_left(&fop_data->clients);
-        }
+            pthread_mutex_lock(&queue->mutex);
+            {
+                stub = __iot_dequeue(conf, queue, i);
+            }
+            pthread_mutex_unlock(&queue->mutex);
 
-        fop_data->ac_iot_count++;
-        fop_data->queue_marked = _gf_false;
-        fop_data->queue_sizes--;
-        *pri = i;
-        conf->queue_size--;
+            if (stub) {
+                *pri = i;
+                return stub;
+            }
+        }
 
-        return stub;
+        /* Somebody else got the requests first. A worker may have gone
+         * to sleep because of the slot we held. */
+        GF_ATOMIC_DEC(fop_data->ac_iot_count);
+        if (GF_ATOMIC_GET(fop_data->queue_sizes) &&
+            GF_ATOMIC_GET(conf->sleep_count))
+            iot_wake_worker(conf, home);
     }
 
     return NULL;
 }
 
 static void
-__iot_enqueue(iot_conf_t *conf, call_stub_t *stub, int pri)
+__iot_enqueue(iot_conf_t *conf, iot_queue_t *queue, call_stub_t *stub,
+              int pri)
 {
     client_t *client = stub->frame->root->client;
     iot_client_ctx_t *ctx;
@@ -133,23 +234,86 @@ __iot_enqueue(iot_conf_t *conf, call_stub_t *stub, int pri)
     if (client) {
         ctx = iot_get_ctx(conf->this, client);
         if (ctx) {
-            ctx = &ctx[pri];
+            ctx = &ctx[(queue - conf->queues) * GF_FOP_PRI_MAX + pri];
         }
     } else {
         ctx = NULL;
     }
     if (!ctx) {
-        ctx = &fop_data->no_client;
+        ctx = &queue->no_client[pri];
     }
 
     if (list_empty(&ctx->reqs)) {
-        list_add_tail(&ctx->clients, &fop_data->clients);
+        list_add_tail(&ctx->clients, &queue->clients[pri]);
     }
     list_add_tail(&stub->list, &ctx->reqs);
 
-    conf->queue_size++;
+    GF_ATOMIC_INC(queue->pri_size[pri]);
+    GF_ATOMIC_INC(conf->queue_size);
     GF_ATOMIC_INC(conf->stub_cnt);
-    fop_data->queue_sizes++;
+    GF_ATOMIC_INC(fop_data->queue_sizes);
+}
+
+/* Puts the worker to sleep on its home queue until there is something it
+ * can serve. Returns true when the worker should exit. */
+static gf_boolean_t
+iot_worker_wait(iot_conf_t *conf, iot_queue_t *home)
+{
+    struct timespec sleep_till;
+    gf_boolean_t bye = _gf_false;
+    int ret = 0;
+
+    pthread_mutex_lock(&home->mutex);
+    {
+        /* Announce ourselves before checking for work, so that whoever
+         * queues a request or frees a priority slot after the check
+         * knows to wake us up. */
+        home->sleep_count++;
+        GF_ATOMIC_INC(conf->sleep_count);
+
+        while (!iot_work_available(conf)) {
+            if (conf->down) {
+                bye = _gf_true; /*Avoid sleep*/
+                break;
+            }
+
+            clock_gettime(CLOCK_REALTIME_COARSE, &sleep_till);
+            sleep_till.tv_sec += conf->idle_time;
+
+            ret = pthread_cond_timedwait(&home->cond, &home->mutex,
+                                         &sleep_till);
+
+            if (conf->down || ret == ETIMEDOUT) {
+                bye = !iot_work_available(conf);
+                break;
+            }
+        }
+
+        GF_ATOMIC_DEC(conf->sleep_count);
+        home->sleep_count--;
+    }
+    pthread_mutex_unlock(&home->mutex);
+
+    if (!bye)
+        return _gf_false;
+
+    pthread_mutex_lock(&conf->mutex);
+    {
+        if (conf->down || conf->curr_count > IOT_MIN_THREADS) {
+            conf->curr_count--;
+            if (conf->curr_count == 0)
+                pthread_cond_broadcast(&conf->cond);
+            gf_msg_debug(conf->this->name, 0,
+                         "terminated. "
+                         "conf->curr_count=%d",
+                         conf->curr_count);
+        } else {
+            bye = _gf_false;
+        }
+    }
+    pthread_mutex_unlock(&conf->mutex);
+
+    return bye;
 }
 
 static void *
@@ -157,76 +321,43 @@ iot_worker(void *data)
 {
     iot_conf_t *conf = NULL;
     xlator_t *this = NULL;
+    iot_queue_t *home = NULL;
     call_stub_t *stub = NULL;
-    struct timespec sleep_till;
-    int ret = 0;
     int pri = -1;
-    gf_boolean_t bye = _gf_false;
 
     conf = data;
     this = conf->this;
     THIS = this;
 
-    for (;;) {
-        pthread_mutex_lock(&conf->mutex);
-        {
-            if (pri != -1) {
-                conf->fops_data[pri].ac_iot_count--;
-                pri = -1;
-            }
-            while (conf->queue_size == 0) {
-                if (conf->down) {
-                    bye = _gf_true; /*Avoid sleep*/
-                    break;
-                }
-
-                clock_gettime(CLOCK_REALTIME_COARSE, &sleep_till);
-                sleep_till.tv_sec += conf->idle_time;
+    home = &conf->queues[GF_ATOMIC_FETCH_ADD(conf->next_queue, 1) %
+                         conf->queue_count];
 
-                conf->sleep_count++;
-                ret = pthread_cond_timedwait(&conf->cond, &conf->mutex,
-                                             &sleep_till);
-                conf->sleep_count--;
-
-                if (conf->down || ret == ETIMEDOUT) {
-                    bye = _gf_true;
-                    break;
-                }
-            }
-
-            if (bye) {
-                if (conf->down || conf->curr_count > IOT_MIN_THREADS) {
-                    conf->curr_count--;
-                    if (conf->curr_count == 0)
-                        pthread_cond_broadcast(&conf->cond);
-                    gf_msg_debug(conf->this->name, 0,
-                                 "terminated. "
-                                 "conf->curr_count=%d",
-                                 conf->curr_count);
-                } else {
-                    bye = _gf_false;
-                }
-            }
-
-            if (!bye)
-                stub = __iot_dequeue(conf, &pri);
+    for (;;) {
+        if (pri != -1) {
+            GF_ATOMIC_DEC(conf->fops_data[pri].ac_iot_count);
+            /* Requests of this priority may have been held back by the
+             * limit we were occupying. */
+            if (GF_ATOMIC_GET(conf->fops_data[pri].queue_sizes) &&
+                GF_ATOMIC_GET(conf->sleep_count))
+                iot_wake_worker(conf, home);
+            pri = -1;
         }
-        pthread_mutex_unlock(&conf->mutex);
 
-        if (stub) { /* guard against spurious wakeups */
-            if (stub->poison) {
-                gf_log(this->name, GF_LOG_INFO, "Dropping poisoned request %p.",
-                       stub);
-                call_stub_destroy(stub);
-            } else {
-                call_resume(stub);
-            }
-            GF_ATOMIC_DEC(conf->stub_cnt);
+        stub = iot_dequeue(conf, home, &pri);
+        if (!stub) {
+            if (iot_worker_wait(conf, home))
+                break;
+            continue;
         }
-        stub = NULL;
 
-        if (bye)
-            break;
+        if (stub->poison) {
+            gf_log(this->name, GF_LOG_INFO, "Dropping poisoned request %p.",
+                   stub);
+            call_stub_destroy(stub);
+        } else {
+            call_resume(stub);
+        }
+        GF_ATOMIC_DEC(conf->stub_cnt);
     }
 
     return NULL;
@@ -235,17 +366,24 @@ iot_worker(void *data)
 static int
 do_iot_schedule(iot_conf_t *conf, call_stub_t *stub, int pri)
 {
+    iot_queue_t *queue = iot_get_queue(conf);
     int ret = 0;
 
-    pthread_mutex_lock(&conf->mutex);
+    pthread_mutex_lock(&queue->mutex);
     {
-        __iot_enqueue(conf, stub, pri);
+        __iot_enqueue(conf, queue, stub, pri);
 
-        pthread_cond_signal(&conf->cond);
+        if (queue->sleep_count)
+            pthread_cond_signal(&queue->cond);
+    }
+    pthread_mutex_unlock(&queue->mutex);
 
-        ret = __iot_workers_scale(conf);
+    if (GF_ATOMIC_GET(conf->sleep_count)) {
+        if (!queue->sleep_count)
+            iot_wake_worker(conf, queue);
+    } else if (conf->curr_count < conf->max_count) {
+        ret = iot_workers_scale(conf);
     }
-    pthread_mutex_unlock(&conf->mutex);
 
     return ret;
 }
@@ -616,7 +754,8 @@ iot_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, const char *name,
 
         for (i = 0; i < GF_FOP_PRI_MAX; i++) {
             if (dict_set_int32(depths, (char *)fop_pri_to_string(i),
-                               conf->fops_data[i].queue_sizes) != 0) {
+                               GF_ATOMIC_GET(conf->fops_data[i].queue_sizes)) !=
+                0) {
                 dict_unref(depths);
                 depths = NULL;
                 goto unwind_special_getxattr;
@@ -806,7 +945,7 @@ __iot_workers_scale(iot_conf_t *conf)
 
     for (i = 0; i < GF_FOP_PRI_MAX; i++)
         scale += min(conf->fops_data[i].ac_iot_limit,
-                     conf->fops_data[i].queue_sizes);
+                     GF_ATOMIC_GET(conf->fops_data[i].queue_sizes));
 
     if (scale < IOT_MIN_THREADS)
         scale = IOT_MIN_THREADS;
@@ -828,7 +967,8 @@ __iot_workers_scale(iot_conf_t *conf)
             conf->curr_count++;
             gf_msg_debug(conf->this->name, 0,
                          "scaled threads to %d (queue_size=%d/%d)",
-                         conf->curr_count, conf->queue_size, scale);
+                         conf->curr_count, GF_ATOMIC_GET(conf->queue_size),
+                         scale);
         } else {
             break;
         }
@@ -924,7 +1064,8 @@ iot_priv_dump(xlator_t *this)
 
     gf_proc_dump_write("maximum_threads_count", "%d", conf->max_count);
     gf_proc_dump_write("current_threads_count", "%d", conf->curr_count);
-    gf_proc_dump_write("sleep_count", "%d", conf->sleep_count);
+    gf_proc_dump_write("sleep_count", "%d", GF_ATOMIC_GET(conf->sleep_count));
+    gf_proc_dump_write("queue_count", "%d", conf->queue_count);
     gf_proc_dump_write("idle_time", "%ld", conf->idle_time);
     gf_proc_dump_write("stack_size", "%zd", conf->stack_size);
     gf_proc_dump_write("max_high_priority_threads", "%d",
@@ -935,20 +1076,25 @@ iot_priv_dump(xlator_t *this)
                        conf->fops_data[GF_FOP_PRI_LO].ac_iot_limit);
     gf_proc_dump_write("max_least_priority_threads", "%d",
                        conf->fops_data[GF_FOP_PRI_LEAST].ac_iot_limit);
-    gf_proc_dump_write("current_high_priority_threads", "%d",
-                       conf->fops_data[GF_FOP_PRI_HI].ac_iot_count);
-    gf_proc_dump_write("current_normal_priority_threads", "%d",
-                       conf->fops_data[GF_FOP_PRI_NORMAL].ac_iot_count);
-    gf_proc_dump_write("current_low_priority_threads", "%d",
-                       conf->fops_data[GF_FOP_PRI_LO].ac_iot_count);
-    gf_proc_dump_write("current_least_priority_threads", "%d",
-                       conf->fops_data[GF_FOP_PRI_LEAST].ac_iot_count);
+    gf_proc_dump_write(
+        "current_high_priority_threads", "%d",
+        GF_ATOMIC_GET(conf->fops_data[GF_FOP_PRI_HI].ac_iot_count));
+    gf_proc_dump_write(
+        "current_normal_priority_threads", "%d",
+        GF_ATOMIC_GET(conf->fops_data[GF_FOP_PRI_NORMAL].ac_iot_count));
+    gf_proc_dump_write(
+        "current_low_priority_threads", "%d",
+        GF_ATOMIC_GET(conf->fops_data[GF_FOP_PRI_LO].ac_iot_count));
+    gf_proc_dump_write(
+        "current_least_priority_threads", "%d",
+        GF_ATOMIC_GET(conf->fops_data[GF_FOP_PRI_LEAST].ac_iot_count));
     for (i = 0; i < GF_FOP_PRI_MAX; i++) {
-        if (!conf->fops_data[i].queue_sizes)
+        if (!GF_ATOMIC_GET(conf->fops_data[i].queue_sizes))
             continue;
         snprintf(key, sizeof(key), "%s_priority_queue_length",
                  iot_get_pri_meaning(i));
-        gf_proc_dump_write(key, "%d", conf->fops_data[i].queue_sizes);
+        gf_proc_dump_write(key, "%d",
+                           GF_ATOMIC_GET(conf->fops_data[i].queue_sizes));
     }
 
     return 0;
@@ -1063,7 +1209,8 @@ iot_watchdog(void *arg)
             } else {
                 bad_times[i] = 0;
             }
-            fop_data->queue_marked = (fop_data->queue_sizes > 0);
+            fop_data->queue_marked = (GF_ATOMIC_GET(fop_data->queue_sizes) >
+                                      0);
         }
         pthread_mutex_unlock(&priv->mutex);
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
@@ -1114,10 +1261,21 @@ stop_iot_watchdog(xlator_t *this)
     priv->watchdog_running = _gf_false;
 }
 
+/* 0 means one queue per CPU. */
+static int32_t
+iot_queue_count(int32_t count)
+{
+    if (count == 0)
+        count = min(sysconf(_SC_NPROCESSORS_ONLN), IOT_MAX_QUEUES);
+
+    return max(count, 1);
+}
+
 int
 reconfigure(xlator_t *this, dict_t *options)
 {
     iot_conf_t *conf = NULL;
+    int32_t queue_count = 0;
     int ret = -1;
 
     conf = this->private;
@@ -1152,6 +1310,13 @@ reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
 
+    /* The queues are only set up by init(). */
+    GF_OPTION_RECONF("queue-count", queue_count, options, int32, out);
+    if (iot_queue_count(queue_count) != conf->queue_count)
+        gf_smsg(this->name, GF_LOG_WARNING, 0,
+                IO_THREADS_MSG_QUEUE_COUNT_IGNORED, "queue-count=%d",
+                conf->queue_count, "requested=%d", queue_count, NULL);
+
     if (conf->watchdog_secs > 0) {
         start_iot_watchdog(this);
     } else {
@@ -1163,6 +1328,72 @@ out:
     return ret;
 }
 
+static int
+iot_queues_init(iot_conf_t *conf)
+{
+    iot_queue_t *queue = NULL;
+    int ret = 0;
+    int q;
+    int i;
+
+    conf->queues = GF_CALLOC(conf->queue_count, sizeof(*conf->queues),
+                             gf_iot_mt_queue_t);
+    if (!conf->queues) {
+        gf_smsg(conf->this->name, GF_LOG_ERROR, ENOMEM,
+                IO_THREADS_MSG_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+
+    for (q = 0; q < conf->queue_count; q++) {
+        queue = &conf->queues[q];
+        for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+            INIT_LIST_HEAD(&queue->clients[i]);
+            INIT_LIST_HEAD(&queue->no_client[i].reqs);
+            INIT_LIST_HEAD(&queue->no_client[i].clients);
+            GF_ATOMIC_INIT(queue->pri_size[i], 0);
+        }
+
+        if ((ret = pthread_cond_init(&queue->cond, NULL)) != 0) {
+            gf_smsg(conf->this->name, GF_LOG_ERROR, 0,
+                    IO_THREADS_MSG_PTHREAD_INIT_FAILED,
+                    "pthread_cond_init ret=%d", ret, NULL);
+            goto err;
+        }
+
+        if ((ret = pthread_mutex_init(&queue->mutex, NULL)) != 0) {
+            gf_smsg(conf->this->name, GF_LOG_ERROR, 0,
+                    IO_THREADS_MSG_PTHREAD_INIT_FAILED,
+                    "pthread_mutex_init ret=%d", ret, NULL);
+            pthread_cond_destroy(&queue->cond);
+            goto err;
+        }
+    }
+
+    return 0;
+
+err:
+    conf->queue_count = q;
+    iot_queues_fini(conf);
+    return -1;
+}
+
+static void
+iot_queues_fini(iot_conf_t *conf)
+{
+    int q;
+
+    if (!conf->queues)
+        return;
+
+    for (q = 0; q < conf->queue_count; q++) {
+        pthread_cond_destroy(&conf->queues[q].cond);
+        pthread_mutex_destroy(&conf->queues[q].mutex);
+    }
+
+    GF_FREE(conf->queues);
+    conf->queues = NULL;
+}
+
 int
 init(xlator_t *this)
 {
@@ -1232,15 +1463,26 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
 
+    GF_OPTION_INIT("queue-count", conf->queue_count, int32, out);
+    conf->queue_count = iot_queue_count(conf->queue_count);
+
     conf->this = this;
     GF_ATOMIC_INIT(conf->stub_cnt, 0);
+    GF_ATOMIC_INIT(conf->sleep_count, 0);
+    GF_ATOMIC_INIT(conf->queue_size, 0);
+    GF_ATOMIC_INIT(conf->next_queue, 0);
 
     for (i = 0; i < GF_FOP_PRI_MAX; i++) {
-        INIT_LIST_HEAD(&conf->fops_data[i].clients);
-        INIT_LIST_HEAD(&conf->fops_data[i].no_client.reqs);
-        INIT_LIST_HEAD(&conf->fops_data[i].no_client.clients);
+        GF_ATOMIC_INIT(conf->fops_data[i].ac_iot_count, 0);
+        GF_ATOMIC_INIT(conf->fops_data[i].queue_sizes, 0);
     }
 
+    ret = iot_queues_init(conf);
+    if (ret != 0)
+        goto out;
+
+    ret = -1;
+
     if (!this->pass_through) {
         ret = iot_workers_scale(conf);
 
@@ -1261,8 +1503,10 @@ init(xlator_t *this)
 
     ret = 0;
 out:
-    if (ret)
+    if (ret && conf) {
+        iot_queues_fini(conf);
         GF_FREE(conf);
+    }
 
     return ret;
 }
@@ -1270,10 +1514,19 @@ out:
 static void
 iot_exit_threads(iot_conf_t *conf)
 {
+    iot_queue_t *queue = NULL;
+    int i;
+
     pthread_mutex_lock(&conf->mutex);
     {
         conf->down = _gf_true;
         /*Let all the threads know that xl is going down*/
+        for (i = 0; i < conf->queue_count; i++) {
+            queue = &conf->queues[i];
+            pthread_mutex_lock(&queue->mutex);
+            pthread_cond_broadcast(&queue->cond);
+            pthread_mutex_unlock(&queue->mutex);
+        }
         pthread_cond_broadcast(&conf->cond);
         while (conf->curr_count) /*Wait for threads to exit*/
             pthread_cond_wait(&conf->cond, &conf->mutex);
@@ -1348,6 +1601,8 @@ fini(xlator_t *this)
 
     stop_iot_watchdog(this);
 
+    iot_queues_fini(conf);
+
     GF_FREE(conf);
 
     this->private = NULL;
@@ -1374,26 +1629,31 @@ iot_disconnect_cbk(xlator_t *this, client_t *client)
     call_stub_t *next;
     iot_conf_t *conf = this->private;
     iot_client_ctx_t *ctx;
+    iot_queue_t *queue;
+    int q;
 
     if (!conf || !conf->cleanup_disconnected_reqs) {
         goto out;
     }
 
-    pthread_mutex_lock(&conf->mutex);
-    for (i = 0; i < GF_FOP_PRI_MAX; i++) {
-        ctx = &conf->fops_data[i].no_client;
-        list_for_each_entry_safe(curr, next, &ctx->reqs, list)
-        {
-            if (curr->frame->root->client != client) {
-                continue;
+    for (q = 0; q < conf->queue_count; q++) {
+        queue = &conf->queues[q];
+        pthread_mutex_lock(&queue->mutex);
+        for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+            ctx = &queue->no_client[i];
+            list_for_each_entry_safe(curr, next, &ctx->reqs, list)
+            {
+                if (curr->frame->root->client != client) {
+                    continue;
+                }
+                gf_log(this->name, GF_LOG_INFO,
+                       "poisoning %s fop at %p for client %s",
+                       gf_fop_list[curr->fop], curr, client->client_uid);
+                curr->poison = _gf_true;
             }
-            gf_log(this->name, GF_LOG_INFO,
-                   "poisoning %s fop at %p for client %s",
-                   gf_fop_list[curr->fop], curr, client->client_uid);
-            curr->poison = _gf_true;
         }
+        pthread_mutex_unlock(&queue->mutex);
     }
-    pthread_mutex_unlock(&conf->mutex);
 
 out:
     return 0;
@@ -1550,6 +1810,21 @@ struct volume_options options[] = {
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
      .tags = {"io-threads"},
      .description = "Enable/Disable io threads translator"},
+    {.key = {"queue-count"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = IOT_MAX_QUEUES,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_11_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_RANGE,
+     .tags = {"io-threads"},
+     .description = "Number of request queues the worker threads are "
+                    "spread over. Requests are queued on the one of the "
+                    "core they are submitted from. Threads serve their own "
+                    "queue first and take requests of a higher priority "
+                    "from the others. 0 means one per CPU, up to 16. "
+                    "Changes are not applied to a running brick, they "
+                    "take effect when the brick is restarted."},
     {
         .key = {NULL},
     },
@@ -26,6 +26,8 @@
 
 #define IOT_THREAD_STACK_SIZE ((size_t)(256 * 1024))
 
+#define IOT_MAX_QUEUES 16
+
 typedef struct {
     struct list_head reqs;
     struct list_head clients;
@@ -33,25 +35,43 @@ typedef struct {
 
 typedef struct {
     int32_t ac_iot_limit;
-    int32_t ac_iot_count;
-    struct list_head clients;
+    gf_atomic_int32_t ac_iot_count;
+    gf_atomic_int32_t queue_sizes;
+    uint queue_marked;
+} iot_fop_data_t;
+
+/*
+ * Requests are spread over several queues, each with its own lock, so that
+ * submitters running on different cores do not contend with each other.
+ * A request goes to the queue of the core it was submitted from. Workers
+ * always serve the highest priority that has requests and a free thread
+ * slot, whatever queue they are in: they look at their home queue first
+ * and steal from the others rather than serve a lower priority. Per-client
+ * round-robin is kept within each queue, and the per-priority thread limits
+ * are global.
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    /* Queued requests of each priority, read without the lock as a hint. */
+    gf_atomic_int32_t pri_size[GF_FOP_PRI_MAX];
+    int32_t sleep_count;
+    struct list_head clients[GF_FOP_PRI_MAX];
     /*
      * It turns out that there are several ways a frame can get to us
      * without having an associated client (server_first_lookup was the
      * first one I hit).  Instead of trying to update all such callers,
      * we use this to queue them.
      */
-    iot_client_ctx_t no_client;
-    int queue_sizes;
-    uint queue_marked;
-} iot_fop_data_t;
+    iot_client_ctx_t no_client[GF_FOP_PRI_MAX];
+} iot_queue_t;
 
 struct iot_conf {
     pthread_mutex_t mutex;
     int32_t max_count;  /* configured maximum */
     int32_t curr_count; /* actual number of threads running */
-    int32_t sleep_count;
-    int32_t queue_size;
+    gf_atomic_int32_t sleep_count;
+    gf_atomic_int32_t queue_size;
     time_t idle_time; /* in seconds */
     pthread_cond_t cond;
     gf_atomic_t stub_cnt;
@@ -64,6 +84,10 @@ struct iot_conf {
 
     iot_fop_data_t fops_data[GF_FOP_PRI_MAX];
 
+    iot_queue_t *queues;
+    int32_t queue_count;
+    gf_atomic_int32_t next_queue; /* home queue of the next worker */
+
     pthread_attr_t w_attr;
     size_t stack_size;
     pthread_t watchdog_thread;
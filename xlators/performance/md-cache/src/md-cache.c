@@ -118,8 +118,17 @@ struct md_cache {
     gf_boolean_t gen_rollover;
     gf_boolean_t invalidation_rollover;
     gf_lock_t lock;
+    /* Odd while the iatt fields, 'valid' or 'ia_time' are being updated
+     * (always under 'lock'). Lets mdc_inode_iatt_get() copy them without
+     * taking the lock. Those fields are accessed with MDC_IATT_GET() and
+     * MDC_IATT_SET() wherever they can race. */
+    gf_atomic_uint32_t seq;
 };
 
+#define MDC_IATT_GET(_field) __atomic_load_n(&(_field), __ATOMIC_RELAXED)
+#define MDC_IATT_SET(_field, _value)                                           \
+    __atomic_store_n(&(_field), (_value), __ATOMIC_RELAXED)
+
 struct mdc_local {
     loc_t loc;
     loc_t loc2;
@@ -146,6 +155,34 @@ __mdc_inode_ctx_get(xlator_t *this, inode_t *inode, struct md_cache **mdc_p)
     return ret;
 }
 
+/* The ctx is set once in mdc_inode_prep() and only deleted on forget, when
+ * no fop can be using the inode anymore, so the cache hit paths read it
+ * without inode->lock. A ctx being set concurrently is seen as a miss. */
+static struct md_cache *
+mdc_inode_ctx_peek(xlator_t *this, inode_t *inode)
+{
+    struct md_cache *mdc = NULL;
+
+    if (!inode || __mdc_inode_ctx_get(this, inode, &mdc) != 0)
+        return NULL;
+
+    return mdc;
+}
+
+static void
+__mdc_iatt_write_begin(struct md_cache *mdc)
+{
+    GF_ATOMIC_INC(mdc->seq);
+    /* The odd sequence must be visible before any of the new values. */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void
+__mdc_iatt_write_end(struct md_cache *mdc)
+{
+    GF_ATOMIC_INC(mdc->seq);
+}
+
 int
 mdc_inode_ctx_get(xlator_t *this, inode_t *inode, struct md_cache **mdc_p)
 {
@@ -176,7 +213,9 @@ __mdc_inc_generation(xlator_t *this, struct md_cache *mdc)
     if (gen == 0) {
         mdc->gen_rollover = !mdc->gen_rollover;
         gen = GF_ATOMIC_INC(conf->generation);
-        mdc->ia_time = 0;
+        __mdc_iatt_write_begin(mdc);
+        MDC_IATT_SET(mdc->ia_time, 0);
+        __mdc_iatt_write_end(mdc);
         mdc->generation = 0;
     }
 
@@ -349,6 +388,7 @@ mdc_inode_prep(xlator_t *this, inode_t *inode)
         }
 
         LOCK_INIT(&mdc->lock);
+        GF_ATOMIC_INIT(mdc->seq, 0);
 
         ret = __mdc_inode_ctx_set(this, inode, mdc);
         if (ret) {
@@ -414,7 +454,9 @@ is_md_cache_iatt_valid(xlator_t *this, struct md_cache *mdc)
         } else {
             ret = __is_cache_valid(this, mdc->ia_time);
             if (ret == _gf_false) {
-                mdc->ia_time = 0;
+                __mdc_iatt_write_begin(mdc);
+                MDC_IATT_SET(mdc->ia_time, 0);
+                __mdc_iatt_write_end(mdc);
                 mdc->generation = 0;
             }
         }
@@ -424,56 +466,40 @@ is_md_cache_iatt_valid(xlator_t *this, struct md_cache *mdc)
     return ret;
 }
 
-static gf_boolean_t
-is_md_cache_xatt_valid(xlator_t *this, struct md_cache *mdc)
-{
-    gf_boolean_t ret = _gf_true;
-
-    LOCK(&mdc->lock);
-    {
-        ret = __is_cache_valid(this, mdc->xa_time);
-        if (ret == _gf_false)
-            mdc->xa_time = 0;
-    }
-    UNLOCK(&mdc->lock);
-
-    return ret;
-}
-
 void
 mdc_from_iatt(struct md_cache *mdc, struct iatt *iatt)
 {
-    mdc->md_prot = iatt->ia_prot;
-    mdc->md_nlink = iatt->ia_nlink;
-    mdc->md_uid = iatt->ia_uid;
-    mdc->md_gid = iatt->ia_gid;
-    mdc->md_atime = iatt->ia_atime;
-    mdc->md_atime_nsec = iatt->ia_atime_nsec;
-    mdc->md_mtime = iatt->ia_mtime;
-    mdc->md_mtime_nsec = iatt->ia_mtime_nsec;
-    mdc->md_ctime = iatt->ia_ctime;
-    mdc->md_ctime_nsec = iatt->ia_ctime_nsec;
-    mdc->md_rdev = iatt->ia_rdev;
-    mdc->md_size = iatt->ia_size;
-    mdc->md_blocks = iatt->ia_blocks;
+    __atomic_store(&mdc->md_prot, &iatt->ia_prot, __ATOMIC_RELAXED);
+    MDC_IATT_SET(mdc->md_nlink, iatt->ia_nlink);
+    MDC_IATT_SET(mdc->md_uid, iatt->ia_uid);
+    MDC_IATT_SET(mdc->md_gid, iatt->ia_gid);
+    MDC_IATT_SET(mdc->md_atime, iatt->ia_atime);
+    MDC_IATT_SET(mdc->md_atime_nsec, iatt->ia_atime_nsec);
+    MDC_IATT_SET(mdc->md_mtime, iatt->ia_mtime);
+    MDC_IATT_SET(mdc->md_mtime_nsec, iatt->ia_mtime_nsec);
+    MDC_IATT_SET(mdc->md_ctime, iatt->ia_ctime);
+    MDC_IATT_SET(mdc->md_ctime_nsec, iatt->ia_ctime_nsec);
+    MDC_IATT_SET(mdc->md_rdev, iatt->ia_rdev);
+    MDC_IATT_SET(mdc->md_size, iatt->ia_size);
+    MDC_IATT_SET(mdc->md_blocks, iatt->ia_blocks);
 }
 
 void
 mdc_to_iatt(struct md_cache *mdc, struct iatt *iatt)
 {
-    iatt->ia_prot = mdc->md_prot;
-    iatt->ia_nlink = mdc->md_nlink;
-    iatt->ia_uid = mdc->md_uid;
-    iatt->ia_gid = mdc->md_gid;
-    iatt->ia_atime = mdc->md_atime;
-    iatt->ia_atime_nsec = mdc->md_atime_nsec;
-    iatt->ia_mtime = mdc->md_mtime;
-    iatt->ia_mtime_nsec = mdc->md_mtime_nsec;
-    iatt->ia_ctime = mdc->md_ctime;
-    iatt->ia_ctime_nsec = mdc->md_ctime_nsec;
-    iatt->ia_rdev = mdc->md_rdev;
-    iatt->ia_size = mdc->md_size;
-    iatt->ia_blocks = mdc->md_blocks;
+    __atomic_load(&mdc->md_prot, &iatt->ia_prot, __ATOMIC_RELAXED);
+    iatt->ia_nlink = MDC_IATT_GET(mdc->md_nlink);
+    iatt->ia_uid = MDC_IATT_GET(mdc->md_uid);
+    iatt->ia_gid = MDC_IATT_GET(mdc->md_gid);
+    iatt->ia_atime = MDC_IATT_GET(mdc->md_atime);
+    iatt->ia_atime_nsec = MDC_IATT_GET(mdc->md_atime_nsec);
+    iatt->ia_mtime = MDC_IATT_GET(mdc->md_mtime);
+    iatt->ia_mtime_nsec = MDC_IATT_GET(mdc->md_mtime_nsec);
+    iatt->ia_ctime = MDC_IATT_GET(mdc->md_ctime);
+    iatt->ia_ctime_nsec = MDC_IATT_GET(mdc->md_ctime_nsec);
+    iatt->ia_rdev = MDC_IATT_GET(mdc->md_rdev);
+    iatt->ia_size = MDC_IATT_GET(mdc->md_size);
+    iatt->ia_blocks = MDC_IATT_GET(mdc->md_blocks);
 }
 
 static struct md_cache *
@@ -498,8 +524,10 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
     LOCK(&mdc->lock);
     {
         if (!iatt || !iatt->ia_ctime) {
-            mdc->ia_time = 0;
-            mdc->valid = 0;
+            __mdc_iatt_write_begin(mdc);
+            MDC_IATT_SET(mdc->ia_time, 0);
+            MDC_IATT_SET(mdc->valid, _gf_false);
+            __mdc_iatt_write_end(mdc);
 
             gen = __mdc_inc_generation(this, mdc);
             mdc->generation = (gen & 0xffffffff);
@@ -572,13 +600,15 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
 
         if ((mdc->gen_rollover == rollover) &&
             (incident_time >= mdc->generation)) {
+            __mdc_iatt_write_begin(mdc);
             mdc_from_iatt(mdc, iatt);
-            mdc->valid = _gf_true;
+            MDC_IATT_SET(mdc->valid, _gf_true);
             if (update_time) {
-                mdc->ia_time = gf_time();
+                MDC_IATT_SET(mdc->ia_time, gf_time());
                 if (mdc->xa_time && update_xa_time)
                     mdc->xa_time = mdc->ia_time;
             }
+            __mdc_iatt_write_end(mdc);
 
             gf_msg_callingfn(
                 "md-cache", GF_LOG_TRACE, 0, MD_CACHE_MSG_CACHE_UPDATE,
@@ -617,25 +647,35 @@ mdc_inode_iatt_get(xlator_t *this, inode_t *inode, struct iatt *iatt)
 {
     int ret = -1;
     struct md_cache *mdc = NULL;
+    uint32_t seq = 0;
+    gf_boolean_t valid = _gf_false;
+    time_t ia_time = 0;
 
-    if (mdc_inode_ctx_get(this, inode, &mdc) != 0) {
+    mdc = mdc_inode_ctx_peek(this, inode);
+    if (!mdc) {
         gf_msg_trace("md-cache", 0, "mdc_inode_ctx_get failed (%s)",
                      uuid_utoa(inode->gfid));
         goto out;
     }
 
-    if (!is_md_cache_iatt_valid(this, mdc)) {
+    do {
+        seq = GF_ATOMIC_GET(mdc->seq);
+        valid = MDC_IATT_GET(mdc->valid);
+        ia_time = MDC_IATT_GET(mdc->ia_time);
+        mdc_to_iatt(mdc, iatt);
+        /* The copy must be complete before the sequence is checked. */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || (seq != GF_ATOMIC_GET(mdc->seq)));
+
+    if (!valid || !__is_cache_valid(this, ia_time)) {
+        /* Let the locked check reset an expired cache. */
+        if (valid)
+            is_md_cache_iatt_valid(this, mdc);
         gf_msg_trace("md-cache", 0, "iatt cache not valid for (%s)",
                      uuid_utoa(inode->gfid));
         goto out;
     }
 
-    LOCK(&mdc->lock);
-    {
-        mdc_to_iatt(mdc, iatt);
-    }
-    UNLOCK(&mdc->lock);
-
     gf_uuid_copy(iatt->ia_gfid, inode->gfid);
     iatt->ia_ino = gfid_to_ino(inode->gfid);
     iatt->ia_dev = 42;
@@ -810,11 +850,16 @@ out:
     return ret;
 }
 
+/* The cached xattr dict is never modified once it has been published in
+ * mdc->xattr, so that mdc_inode_xatt_get() can hand out references to it.
+ * Updates build a new dict and replace the old one. */
 int
 mdc_inode_xatt_update(xlator_t *this, inode_t *inode, dict_t *dict)
 {
     int ret = -1;
     struct md_cache *mdc = NULL;
+    dict_t *newdict = NULL;
+    dict_t *olddict = NULL;
 
     mdc = mdc_inode_prep(this, inode);
     if (!mdc)
@@ -825,16 +870,32 @@ mdc_inode_xatt_update(xlator_t *this, inode_t *inode, dict_t *dict)
 
     LOCK(&mdc->lock);
     {
-        ret = mdc_dict_update(&mdc->xattr, dict);
+        if (mdc->xattr) {
+            newdict = dict_copy_with_ref(mdc->xattr, NULL);
+            if (!newdict) {
+                UNLOCK(&mdc->lock);
+                goto out;
+            }
+        }
+
+        ret = mdc_dict_update(&newdict, dict);
         if (ret < 0) {
             UNLOCK(&mdc->lock);
             goto out;
         }
+
+        olddict = mdc->xattr;
+        mdc->xattr = newdict;
+        newdict = NULL;
     }
     UNLOCK(&mdc->lock);
 
     ret = 0;
 out:
+    if (newdict)
+        dict_unref(newdict);
+    if (olddict)
+        dict_unref(olddict);
     return ret;
 }
 
@@ -843,6 +904,8 @@ mdc_inode_xatt_unset(xlator_t *this, inode_t *inode, char *name)
 {
     int ret = -1;
     struct md_cache *mdc = NULL;
+    dict_t *newdict = NULL;
+    dict_t *olddict = NULL;
 
     mdc = mdc_inode_prep(this, inode);
     if (!mdc)
@@ -853,35 +916,54 @@ mdc_inode_xatt_unset(xlator_t *this, inode_t *inode, char *name)
 
     LOCK(&mdc->lock);
     {
-        dict_del(mdc->xattr, name);
+        if (mdc->xattr && dict_get(mdc->xattr, name)) {
+            newdict = dict_copy_with_ref(mdc->xattr, NULL);
+            if (newdict) {
+                dict_del(newdict, name);
+                olddict = mdc->xattr;
+                mdc->xattr = newdict;
+            } else {
+                /* Can't drop the key, stop serving the cached xattrs. */
+                mdc->xa_time = 0;
+            }
+        }
     }
     UNLOCK(&mdc->lock);
 
+    if (olddict)
+        dict_unref(olddict);
+
     ret = 0;
 out:
     return ret;
 }
 
+/* Returns a reference to the cached xattrs in '*dict'. The dict is a
+ * snapshot shared with the cache and other readers: callers that need to
+ * modify it must work on a copy (dict_copy_with_ref()). */
 int
 mdc_inode_xatt_get(xlator_t *this, inode_t *inode, dict_t **dict)
 {
     int ret = -1;
     struct md_cache *mdc = NULL;
 
-    if (mdc_inode_ctx_get(this, inode, &mdc) != 0) {
+    mdc = mdc_inode_ctx_peek(this, inode);
+    if (!mdc) {
         gf_msg_trace("md-cache", 0, "mdc_inode_ctx_get failed (%s)",
                      uuid_utoa(inode->gfid));
         goto out;
     }
 
-    if (!is_md_cache_xatt_valid(this, mdc)) {
-        gf_msg_trace("md-cache", 0, "xattr cache not valid for (%s)",
-                     uuid_utoa(inode->gfid));
-        goto out;
-    }
-
     LOCK(&mdc->lock);
     {
+        if (!__is_cache_valid(this, mdc->xa_time)) {
+            mdc->xa_time = 0;
+            UNLOCK(&mdc->lock);
+            gf_msg_trace("md-cache", 0, "xattr cache not valid for (%s)",
+                         uuid_utoa(inode->gfid));
+            goto out;
+        }
+
         ret = 0;
         /* Missing xattr only means no keys were there, i.e
            a negative cache for the "loaded" keys
@@ -953,8 +1035,10 @@ mdc_inode_iatt_invalidate(xlator_t *this, inode_t *inode)
 
     LOCK(&mdc->lock);
     {
-        mdc->ia_time = 0;
-        mdc->valid = _gf_false;
+        __mdc_iatt_write_begin(mdc);
+        MDC_IATT_SET(mdc->ia_time, 0);
+        MDC_IATT_SET(mdc->valid, _gf_false);
+        __mdc_iatt_write_end(mdc);
         mdc->generation = gen;
     }
     UNLOCK(&mdc->lock);
@@ -0,0 +1,351 @@
+/*
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* The cache helpers are static, so they are tested on a single inode with
+ * a hand-built xlator instead of going through the fops. */
+#include "../md-cache.c"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+#define READERS 4
+#define UPDATES 20000
+
+static xlator_t mdc_xl;
+static struct mdc_conf mdc_conf;
+static inode_table_t *mdc_table;
+
+struct mdc_test {
+    inode_t *inode;
+    int hits;
+};
+
+/*
+ * Helper functions
+ */
+static int
+helper_init(void **state)
+{
+    glusterfs_ctx_t *ctx = NULL;
+
+    ctx = glusterfs_ctx_new();
+    assert_non_null(ctx);
+    assert_int_equal(glusterfs_globals_init(ctx), 0);
+    THIS->ctx = ctx;
+
+    mem_pools_init();
+    ctx->dict_pool = mem_pool_new(dict_t, 32);
+    ctx->dict_pair_pool = mem_pool_new(data_pair_t, 512);
+    ctx->dict_data_pool = mem_pool_new(data_t, 512);
+    assert_non_null(ctx->dict_pool);
+    assert_non_null(ctx->dict_pair_pool);
+    assert_non_null(ctx->dict_data_pool);
+
+    mdc_xl.name = "md-cache";
+    mdc_xl.type = "performance/md-cache";
+    mdc_xl.ctx = ctx;
+    mdc_xl.private = &mdc_conf;
+    mdc_xl.cbks = &mdc_cbks;
+    assert_int_equal(xlator_mem_acct_init(&mdc_xl, gf_mdc_mt_end), 0);
+
+    mdc_conf.timeout = 600;
+    mdc_conf.mdc_xattr_str = "user.*";
+    LOCK_INIT(&mdc_conf.lock);
+    GF_ATOMIC_INIT(mdc_conf.generation, 0);
+
+    THIS = &mdc_xl;
+
+    mdc_table = inode_table_new(0, &mdc_xl, 0, 0);
+    assert_non_null(mdc_table);
+
+    return 0;
+}
+
+static inode_t *
+helper_inode_new(void)
+{
+    inode_t *inode = NULL;
+
+    inode = inode_new(mdc_table);
+    assert_non_null(inode);
+    gf_uuid_generate(inode->gfid);
+    inode->ia_type = IA_IFREG;
+
+    assert_non_null(mdc_inode_prep(&mdc_xl, inode));
+
+    return inode;
+}
+
+/* Every field of the iatt carries the same value, so that a read mixing two
+ * updates is noticed. */
+static void
+helper_iatt_fill(struct iatt *iatt, uint32_t value)
+{
+    memset(iatt, 0, sizeof(*iatt));
+    iatt->ia_nlink = value;
+    iatt->ia_uid = value;
+    iatt->ia_gid = value;
+    iatt->ia_atime = value;
+    iatt->ia_atime_nsec = value;
+    iatt->ia_mtime = value;
+    iatt->ia_mtime_nsec = value;
+    iatt->ia_ctime = value;
+    iatt->ia_ctime_nsec = value;
+    iatt->ia_rdev = value;
+    iatt->ia_size = value;
+    iatt->ia_blocks = value;
+}
+
+static void
+helper_iatt_check(struct iatt *iatt)
+{
+    uint64_t value = iatt->ia_size;
+
+    assert_int_equal(iatt->ia_nlink, value);
+    assert_int_equal(iatt->ia_uid, value);
+    assert_int_equal(iatt->ia_gid, value);
+    assert_int_equal(iatt->ia_atime, value);
+    assert_int_equal(iatt->ia_atime_nsec, value);
+    assert_int_equal(iatt->ia_mtime, value);
+    assert_int_equal(iatt->ia_mtime_nsec, value);
+    assert_int_equal(iatt->ia_ctime, value);
+    assert_int_equal(iatt->ia_ctime_nsec, value);
+    assert_int_equal(iatt->ia_rdev, value);
+    assert_int_equal(iatt->ia_blocks, value);
+}
+
+static void *
+helper_iatt_reader(void *data)
+{
+    struct mdc_test *test = data;
+    struct iatt iatt;
+    int hits = 0;
+
+    THIS = &mdc_xl;
+
+    /* Reads until the last update shows up. */
+    do {
+        memset(&iatt, 0, sizeof(iatt));
+        if (mdc_inode_iatt_get(&mdc_xl, test->inode, &iatt) == 0) {
+            helper_iatt_check(&iatt);
+            hits++;
+        }
+    } while (iatt.ia_size != UPDATES);
+
+    __atomic_add_fetch(&test->hits, hits, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+/* The cached xattrs are set together, so a snapshot holding different
+ * values for them has been modified after it was handed out. */
+static void *
+helper_xatt_reader(void *data)
+{
+    struct mdc_test *test = data;
+    dict_t *xattr = NULL;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    int hits = 0;
+
+    THIS = &mdc_xl;
+
+    /* Reads until the last update shows up. */
+    while (a != UPDATES) {
+        xattr = NULL;
+        assert_int_equal(mdc_inode_xatt_get(&mdc_xl, test->inode, &xattr), 0);
+        assert_non_null(xattr);
+
+        assert_int_equal(dict_get_uint32(xattr, "user.a", &a), 0);
+        assert_int_equal(dict_get_uint32(xattr, "user.b", &b), 0);
+        assert_int_equal(a, b);
+
+        dict_unref(xattr);
+        hits++;
+    }
+
+    __atomic_add_fetch(&test->hits, hits, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+static dict_t *
+helper_xattr_new(uint32_t value)
+{
+    dict_t *xattr = NULL;
+
+    xattr = dict_new();
+    assert_non_null(xattr);
+    assert_int_equal(dict_set_uint32(xattr, "user.a", value), 0);
+    assert_int_equal(dict_set_uint32(xattr, "user.b", value), 0);
+
+    return xattr;
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_mdc_iatt_seqlock(void **state)
+{
+    struct mdc_test test = {
+        0,
+    };
+    pthread_t readers[READERS];
+    struct iatt iatt;
+    uint32_t i = 0;
+    int j = 0;
+
+    test.inode = helper_inode_new();
+
+    for (j = 0; j < READERS; j++)
+        assert_int_equal(
+            pthread_create(&readers[j], NULL, helper_iatt_reader, &test), 0);
+
+    /* ctime goes up, so that no update is discarded. */
+    for (i = 1; i <= UPDATES; i++) {
+        helper_iatt_fill(&iatt, i);
+        assert_non_null(mdc_inode_iatt_set(&mdc_xl, test.inode, &iatt, 0));
+    }
+
+    for (j = 0; j < READERS; j++)
+        pthread_join(readers[j], NULL);
+
+    assert_true(test.hits >= READERS);
+
+    assert_int_equal(mdc_inode_iatt_get(&mdc_xl, test.inode, &iatt), 0);
+    helper_iatt_check(&iatt);
+    assert_int_equal(iatt.ia_size, UPDATES);
+
+    /* An invalidated entry is not served. */
+    assert_non_null(mdc_inode_iatt_set(&mdc_xl, test.inode, NULL, 0));
+    assert_int_equal(mdc_inode_iatt_get(&mdc_xl, test.inode, &iatt), -1);
+
+    inode_unref(test.inode);
+}
+
+static void
+test_mdc_xatt_copy_on_write(void **state)
+{
+    inode_t *inode = NULL;
+    dict_t *xattr = NULL;
+    dict_t *update = NULL;
+    dict_t *snap1 = NULL;
+    dict_t *snap2 = NULL;
+    dict_t *snap3 = NULL;
+    dict_t *again = NULL;
+    uint32_t value = 0;
+
+    inode = helper_inode_new();
+
+    xattr = helper_xattr_new(1);
+    /* Not cached, the key doesn't match "user.*". */
+    assert_int_equal(dict_set_uint32(xattr, "trusted.c", 1), 0);
+    assert_int_equal(mdc_inode_xatt_set(&mdc_xl, inode, xattr, NULL), 0);
+    dict_unref(xattr);
+
+    assert_int_equal(mdc_inode_xatt_get(&mdc_xl, inode, &snap1), 0);
+    assert_non_null(snap1);
+    assert_int_equal(snap1->count, 2);
+    assert_null(dict_get(snap1, "trusted.c"));
+
+    /* Hits share the cached dict. */
+    assert_int_equal(mdc_inode_xatt_get(&mdc_xl, inode, &again), 0);
+    assert_ptr_equal(again, snap1);
+    dict_unref(again);
+
+    update = dict_new();
+    assert_non_null(update);
+    assert_int_equal(dict_set_uint32(update, "user.a", 2), 0);
+    assert_int_equal(dict_set_uint32(update, "user.d", 2), 0);
+    assert_int_equal(mdc_inode_xatt_update(&mdc_xl, inode, update), 0);
+    dict_unref(update);
+
+    assert_int_equal(mdc_inode_xatt_get(&mdc_xl, inode, &snap2), 0);
+    assert_true(snap2 != snap1);
+    assert_int_equal(snap2->count, 3);
+    assert_int_equal(dict_get_uint32(snap2, "user.a", &value), 0);
+    assert_int_equal(value, 2);
+    assert_int_equal(dict_get_uint32(snap2, "user.d", &value), 0);
+    assert_int_equal(value, 2);
+
+    assert_int_equal(mdc_inode_xatt_unset(&mdc_xl, inode, "user.b"), 0);
+
+    assert_int_equal(mdc_inode_xatt_get(&mdc_xl, inode, &snap3), 0);
+    assert_true(snap3 != snap2);
+    assert_int_equal(snap3->count, 2);
+    assert_null(dict_get(snap3, "user.b"));
+
+    /* The snapshots handed out before are left as they were. */
+    assert_int_equal(snap1->count, 2);
+    assert_int_equal(dict_get_uint32(snap1, "user.a", &value), 0);
+    assert_int_equal(value, 1);
+    assert_null(dict_get(snap1, "user.d"));
+
+    assert_int_equal(snap2->count, 3);
+    assert_non_null(dict_get(snap2, "user.b"));
+
+    dict_unref(snap1);
+    dict_unref(snap2);
+    dict_unref(snap3);
+
+    inode_unref(inode);
+}
+
+static void
+test_mdc_xatt_concurrent_update(void **state)
+{
+    struct mdc_test test = {
+        0,
+    };
+    pthread_t readers[READERS];
+    dict_t *xattr = NULL;
+    uint32_t i = 0;
+    int j = 0;
+
+    test.inode = helper_inode_new();
+
+    xattr = helper_xattr_new(0);
+    assert_int_equal(mdc_inode_xatt_set(&mdc_xl, test.inode, xattr, NULL), 0);
+    dict_unref(xattr);
+
+    for (j = 0; j < READERS; j++)
+        assert_int_equal(
+            pthread_create(&readers[j], NULL, helper_xatt_reader, &test), 0);
+
+    for (i = 1; i <= UPDATES; i++) {
+        xattr = helper_xattr_new(i);
+        assert_int_equal(mdc_inode_xatt_update(&mdc_xl, test.inode, xattr),
+                         0);
+        dict_unref(xattr);
+    }
+
+    for (j = 0; j < READERS; j++)
+        pthread_join(readers[j], NULL);
+
+    assert_true(test.hits >= READERS);
+
+    inode_unref(test.inode);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest md_cache_tests[] = {
+        cmocka_unit_test(test_mdc_iatt_seqlock),
+        cmocka_unit_test(test_mdc_xatt_copy_on_write),
+        cmocka_unit_test(test_mdc_xatt_concurrent_update),
+    };
+
+    return cmocka_run_group_tests(md_cache_tests, helper_init, NULL);
+}
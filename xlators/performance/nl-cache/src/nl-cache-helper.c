@@ -33,6 +33,13 @@
  *        Freed on receiving upcall(with dentry change flag) or on expiring
  *        timeout of the cache.
  *
+ *      - Directory listing (nl-cache-readdirp): the complete result of a
+ *        readdirp stream that started at offset 0 and reached EOD, with the
+ *        iatts and xattrs of the entries. Later readdirps on any fd of the
+ *        directory are served from it. Freed on any entry operation in the
+ *        directory, on any change to an entry (local fop or upcall), and
+ *        along with the rest of the cache.
+ *
  *   Data structures to store cache?
  *      The cache of any directory is stored in the inode_ctx of the directory.
  *      Negative entries are stored as list of strings.
@@ -201,6 +208,31 @@ nlc_inode_ctx_get(xlator_t *this, inode_t *inode, nlc_ctx_t **nlc_ctx_p)
     return;
 }
 
+static void
+__nlc_free_dirents(xlator_t *this, nlc_ctx_t *nlc_ctx)
+{
+    nlc_conf_t *conf = NULL;
+
+    conf = this->private;
+
+    /* Also fails the fills that are in progress on this directory */
+    nlc_ctx->dirents_gen++;
+
+    if (!(nlc_ctx->state & NLC_DIRENTS_VALID))
+        return;
+
+    gf_dirent_free(&nlc_ctx->dirents);
+    GF_ATOMIC_SUB(conf->dirents_size, nlc_ctx->dirents_size);
+    nlc_ctx->dirents_size = 0;
+
+    if (nlc_ctx->dirents_xdata) {
+        dict_unref(nlc_ctx->dirents_xdata);
+        nlc_ctx->dirents_xdata = NULL;
+    }
+
+    nlc_ctx->state &= ~NLC_DIRENTS_VALID;
+}
+
 static void
 __nlc_inode_clear_entries(xlator_t *this, nlc_ctx_t *nlc_ctx)
 {
@@ -224,6 +256,8 @@ __nlc_inode_clear_entries(xlator_t *this, nlc_ctx_t *nlc_ctx)
             __nlc_free_ne(this, nlc_ctx, ne);
         }
 
+    __nlc_free_dirents(this, nlc_ctx);
+
     nlc_ctx->cache_time = 0;
     nlc_ctx->state = 0;
     GF_ASSERT(nlc_ctx->cache_size == sizeof(*nlc_ctx));
@@ -308,6 +342,7 @@ nlc_inode_ctx_get_set(xlator_t *this, inode_t *inode, nlc_ctx_t **nlc_ctx_p)
         LOCK_INIT(&nlc_ctx->lock);
         INIT_LIST_HEAD(&nlc_ctx->pe);
         INIT_LIST_HEAD(&nlc_ctx->ne);
+        INIT_LIST_HEAD(&nlc_ctx->dirents.list);
 
         ret = __nlc_inode_ctx_timer_start(this, inode, nlc_ctx);
         if (ret < 0)
@@ -383,6 +418,12 @@ nlc_local_wipe(xlator_t *this, nlc_local_t *local)
 
     loc_wipe(&local->loc2);
 
+    if (local->inode)
+        inode_unref(local->inode);
+
+    if (local->fd)
+        fd_unref(local->fd);
+
     GF_FREE(local);
 out:
     return;
@@ -1132,6 +1173,399 @@ out:
     return hit;
 }
 
+static nlc_fd_ctx_t *
+nlc_fd_ctx_get(xlator_t *this, fd_t *fd, gf_boolean_t create)
+{
+    nlc_fd_ctx_t *fd_ctx = NULL;
+    uint64_t value = 0;
+
+    LOCK(&fd->lock);
+    {
+        if (__fd_ctx_get(fd, this, &value) == 0) {
+            fd_ctx = (void *)(uintptr_t)value;
+            goto unlock;
+        }
+
+        if (!create)
+            goto unlock;
+
+        fd_ctx = GF_CALLOC(1, sizeof(*fd_ctx), gf_nlc_mt_nlc_fd_ctx_t);
+        if (!fd_ctx)
+            goto unlock;
+
+        LOCK_INIT(&fd_ctx->lock);
+        INIT_LIST_HEAD(&fd_ctx->entries.list);
+
+        if (__fd_ctx_set(fd, this, (uint64_t)(uintptr_t)fd_ctx) != 0) {
+            LOCK_DESTROY(&fd_ctx->lock);
+            GF_FREE(fd_ctx);
+            fd_ctx = NULL;
+        }
+    }
+unlock:
+    UNLOCK(&fd->lock);
+
+    return fd_ctx;
+}
+
+static void
+__nlc_fd_ctx_reset_fill(nlc_fd_ctx_t *fd_ctx)
+{
+    gf_dirent_free(&fd_ctx->entries);
+    fd_ctx->size = 0;
+    fd_ctx->next_offset = 0;
+    fd_ctx->filling = _gf_false;
+
+    if (fd_ctx->xdata) {
+        dict_unref(fd_ctx->xdata);
+        fd_ctx->xdata = NULL;
+    }
+}
+
+void
+nlc_fd_ctx_destroy(xlator_t *this, fd_t *fd)
+{
+    nlc_fd_ctx_t *fd_ctx = NULL;
+    uint64_t value = 0;
+
+    if (fd_ctx_del(fd, this, &value) != 0 || !value)
+        return;
+
+    fd_ctx = (void *)(uintptr_t)value;
+
+    __nlc_fd_ctx_reset_fill(fd_ctx);
+    LOCK_DESTROY(&fd_ctx->lock);
+    GF_FREE(fd_ctx);
+}
+
+void
+nlc_dir_inval_dirents(xlator_t *this, inode_t *inode)
+{
+    nlc_ctx_t *nlc_ctx = NULL;
+
+    if (!inode)
+        goto out;
+
+    nlc_inode_ctx_get(this, inode, &nlc_ctx);
+    if (!nlc_ctx)
+        goto out;
+
+    LOCK(&nlc_ctx->lock);
+    {
+        __nlc_free_dirents(this, nlc_ctx);
+    }
+    UNLOCK(&nlc_ctx->lock);
+out:
+    return;
+}
+
+/* The iatt (and xattrs) of an entry are part of the listing of its
+ * parent, hence any change to the inode drops that listing. */
+void
+nlc_inode_inval_parent_dirents(xlator_t *this, inode_t *inode)
+{
+    inode_t *parent = NULL;
+
+    parent = inode_parent(inode, NULL, NULL);
+    if (!parent)
+        return;
+
+    nlc_dir_inval_dirents(this, parent);
+    inode_unref(parent);
+}
+
+/* Used when the directory whose listing has a changed entry is not
+ * known. The listings are freed the next time they are looked at. */
+void
+nlc_inval_all_dirents(xlator_t *this)
+{
+    nlc_conf_t *conf = NULL;
+
+    conf = this->private;
+
+    GF_ATOMIC_INC(conf->dirents_epoch);
+}
+
+static void
+nlc_dir_set_dirents(xlator_t *this, inode_t *inode, gf_dirent_t *listing,
+                    size_t size, dict_t *xdata, uint64_t gen, uint64_t epoch)
+{
+    nlc_ctx_t *nlc_ctx = NULL;
+    nlc_conf_t *conf = NULL;
+
+    conf = this->private;
+
+    nlc_inode_ctx_get(this, inode, &nlc_ctx);
+    if (!nlc_ctx)
+        goto out;
+
+    LOCK(&nlc_ctx->lock);
+    {
+        if (!__nlc_is_cache_valid(this, nlc_ctx))
+            goto unlock;
+
+        /* The directory changed while it was being read, or another fd
+         * already cached it. */
+        if ((nlc_ctx->dirents_gen != gen) ||
+            (nlc_ctx->state & NLC_DIRENTS_VALID) ||
+            (GF_ATOMIC_GET(conf->dirents_epoch) != epoch))
+            goto unlock;
+
+        if (GF_ATOMIC_GET(conf->dirents_size) + size > conf->dirents_limit) {
+            gf_msg_trace(this->name, 0,
+                         "not caching listing of %s, limit reached",
+                         uuid_utoa(inode->gfid));
+            goto unlock;
+        }
+
+        list_splice_init(&listing->list, &nlc_ctx->dirents.list);
+        nlc_ctx->dirents_size = size;
+        nlc_ctx->dirents_epoch = epoch;
+        if (xdata)
+            nlc_ctx->dirents_xdata = dict_ref(xdata);
+        GF_ATOMIC_ADD(conf->dirents_size, size);
+        __nlc_set_dir_state(nlc_ctx, NLC_DIRENTS_VALID);
+    }
+unlock:
+    UNLOCK(&nlc_ctx->lock);
+out:
+    return;
+}
+
+void
+nlc_dir_start_fill(xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+    nlc_conf_t *conf = NULL;
+    nlc_ctx_t *nlc_ctx = NULL;
+    nlc_fd_ctx_t *fd_ctx = NULL;
+    uint64_t gen = 0;
+    uint64_t epoch = 0;
+
+    conf = this->private;
+
+    nlc_inode_ctx_get_set(this, fd->inode, &nlc_ctx);
+    if (!nlc_ctx)
+        goto out;
+
+    LOCK(&nlc_ctx->lock);
+    {
+        gen = nlc_ctx->dirents_gen;
+    }
+    UNLOCK(&nlc_ctx->lock);
+    epoch = GF_ATOMIC_GET(conf->dirents_epoch);
+
+    fd_ctx = nlc_fd_ctx_get(this, fd, _gf_true);
+    if (!fd_ctx)
+        goto out;
+
+    LOCK(&fd_ctx->lock);
+    {
+        __nlc_fd_ctx_reset_fill(fd_ctx);
+        fd_ctx->filling = _gf_true;
+        fd_ctx->gen = gen;
+        fd_ctx->epoch = epoch;
+        if (xdata)
+            fd_ctx->xdata = dict_ref(xdata);
+    }
+    UNLOCK(&fd_ctx->lock);
+out:
+    return;
+}
+
+void
+nlc_dir_fill_dirents(xlator_t *this, fd_t *fd, off_t offset, int32_t op_ret,
+                     int32_t op_errno, gf_dirent_t *entries)
+{
+    nlc_conf_t *conf = NULL;
+    nlc_fd_ctx_t *fd_ctx = NULL;
+    gf_dirent_t *entry = NULL;
+    gf_dirent_t *copy = NULL;
+    gf_dirent_t listing;
+    dict_t *xdata = NULL;
+    size_t size = 0;
+    uint64_t gen = 0;
+    uint64_t epoch = 0;
+    gf_boolean_t done = _gf_false;
+
+    conf = this->private;
+    INIT_LIST_HEAD(&listing.list);
+
+    fd_ctx = nlc_fd_ctx_get(this, fd, _gf_false);
+    if (!fd_ctx)
+        goto out;
+
+    LOCK(&fd_ctx->lock);
+    {
+        if (!fd_ctx->filling || (fd_ctx->next_offset != offset))
+            goto unlock;
+
+        if (op_ret < 0 && op_errno != ENOENT)
+            goto abort;
+
+        if (op_ret > 0) {
+            list_for_each_entry(entry, &entries->list, list)
+            {
+                copy = entry_copy(entry);
+                if (!copy)
+                    goto abort;
+
+                /* inodes are looked up again when the listing is
+                 * served, do not pin them meanwhile */
+                if (copy->inode) {
+                    inode_unref(copy->inode);
+                    copy->inode = NULL;
+                }
+
+                list_add_tail(&copy->list, &fd_ctx->entries.list);
+                fd_ctx->size += gf_dirent_size(copy->d_name);
+                fd_ctx->next_offset = entry->d_off;
+            }
+        }
+
+        if (fd_ctx->size > conf->dirents_limit)
+            goto abort;
+
+        if (op_ret > 0 && op_errno != ENOENT)
+            goto unlock;
+
+        /* reached the end of the directory */
+        list_splice_init(&fd_ctx->entries.list, &listing.list);
+        size = fd_ctx->size;
+        gen = fd_ctx->gen;
+        epoch = fd_ctx->epoch;
+        xdata = fd_ctx->xdata;
+        fd_ctx->xdata = NULL;
+        done = _gf_true;
+    abort:
+        __nlc_fd_ctx_reset_fill(fd_ctx);
+    }
+unlock:
+    UNLOCK(&fd_ctx->lock);
+
+    if (done)
+        nlc_dir_set_dirents(this, fd->inode, &listing, size, xdata, gen,
+                            epoch);
+
+    gf_dirent_free(&listing);
+    if (xdata)
+        dict_unref(xdata);
+out:
+    return;
+}
+
+/* Returns the number of entries put in entries, or -1 if the readdirp
+ * can not be served from the cache. */
+int
+nlc_dir_serve_dirents(xlator_t *this, fd_t *fd, size_t size, off_t offset,
+                      dict_t *xdata, gf_dirent_t *entries, int *op_errno)
+{
+    nlc_conf_t *conf = NULL;
+    nlc_ctx_t *nlc_ctx = NULL;
+    nlc_fd_ctx_t *fd_ctx = NULL;
+    gf_dirent_t *entry = NULL;
+    gf_dirent_t *tmp = NULL;
+    gf_dirent_t *copy = NULL;
+    inode_table_t *itable = NULL;
+    size_t filled = 0;
+    int count = -1;
+
+    conf = this->private;
+
+    nlc_inode_ctx_get(this, fd->inode, &nlc_ctx);
+    if (!nlc_ctx)
+        goto out;
+
+    fd_ctx = nlc_fd_ctx_get(this, fd, _gf_true);
+    if (!fd_ctx)
+        goto out;
+
+    LOCK(&nlc_ctx->lock);
+    {
+        if (!(nlc_ctx->state & NLC_DIRENTS_VALID) ||
+            !__nlc_is_cache_valid(this, nlc_ctx))
+            goto unlock;
+
+        if (nlc_ctx->dirents_epoch != GF_ATOMIC_GET(conf->dirents_epoch)) {
+            __nlc_free_dirents(this, nlc_ctx);
+            goto unlock;
+        }
+
+        /* md-cache asks for its xattrs through readdirp, the listing
+         * only has the ones it was read with */
+        if (!are_dicts_equal(nlc_ctx->dirents_xdata, xdata, NULL, NULL, NULL))
+            goto unlock;
+
+        LOCK(&fd_ctx->lock);
+        {
+            if (offset == 0) {
+                entry = list_entry(nlc_ctx->dirents.list.next, gf_dirent_t,
+                                   list);
+            } else if ((fd_ctx->serve_gen == nlc_ctx->dirents_gen) &&
+                       (fd_ctx->serve_offset == offset)) {
+                entry = fd_ctx->serve_next;
+            } else {
+                list_for_each_entry(tmp, &nlc_ctx->dirents.list, list)
+                {
+                    if (tmp->d_off == offset) {
+                        entry = list_entry(tmp->list.next, gf_dirent_t, list);
+                        break;
+                    }
+                }
+            }
+
+            if (!entry)
+                goto unlock_fd;
+
+            count = 0;
+            while (&entry->list != &nlc_ctx->dirents.list) {
+                if (count &&
+                    (filled + gf_dirent_size(entry->d_name) > size))
+                    break;
+
+                copy = entry_copy(entry);
+                if (!copy) {
+                    gf_dirent_free(entries);
+                    count = -1;
+                    goto unlock_fd;
+                }
+
+                list_add_tail(&copy->list, &entries->list);
+                filled += gf_dirent_size(entry->d_name);
+                offset = entry->d_off;
+                count++;
+
+                entry = list_entry(entry->list.next, gf_dirent_t, list);
+            }
+
+            *op_errno = 0;
+            if (&entry->list == &nlc_ctx->dirents.list)
+                *op_errno = ENOENT;
+
+            fd_ctx->serve_gen = nlc_ctx->dirents_gen;
+            fd_ctx->serve_offset = offset;
+            fd_ctx->serve_next = entry;
+        }
+    unlock_fd:
+        UNLOCK(&fd_ctx->lock);
+    }
+unlock:
+    UNLOCK(&nlc_ctx->lock);
+
+    if (count <= 0)
+        goto out;
+
+    /* same as protocol/client does for a readdirp reply */
+    itable = fd->inode->table;
+    list_for_each_entry(copy, &entries->list, list)
+    {
+        copy->inode = inode_find(itable, copy->d_stat.ia_gfid);
+        if (!copy->inode)
+            copy->inode = inode_new(itable);
+    }
+out:
+    return count;
+}
+
 void
 nlc_dump_inodectx(xlator_t *this, inode_t *inode)
 {
@@ -1176,6 +1610,7 @@ nlc_dump_inodectx(xlator_t *this, inode_t *inode)
         gf_proc_dump_write("cache-time", "%ld", nlc_ctx->cache_time);
         gf_proc_dump_write("cache-size", "%zu", nlc_ctx->cache_size);
         gf_proc_dump_write("refd-inodes", "%" PRIu64, nlc_ctx->refd_inodes);
+        gf_proc_dump_write("dirents-size", "%zu", nlc_ctx->dirents_size);
 
         if (IS_PE_VALID(nlc_ctx->state))
             list_for_each_entry_safe(pe, tmp, &nlc_ctx->pe, list)
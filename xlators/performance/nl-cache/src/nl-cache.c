@@ -58,6 +58,19 @@ out:
     return;
 }
 
+static void
+nlc_dentry_op_dirents(call_frame_t *frame, xlator_t *this)
+{
+    nlc_local_t *local = frame->local;
+
+    GF_VALIDATE_OR_GOTO(this->name, local, out);
+
+    nlc_dir_inval_dirents(this, local->loc.parent);
+    nlc_dir_inval_dirents(this, local->loc2.parent);
+out:
+    return;
+}
+
 #define NLC_FOP(_name, _op, loc1, loc2, frame, this, args...)                  \
     do {                                                                       \
         nlc_local_t *__local = NULL;                                           \
@@ -65,7 +78,7 @@ out:
                                                                                \
         conf = this->private;                                                  \
                                                                                \
-        if (!IS_PEC_ENABLED(conf))                                             \
+        if (!IS_PEC_ENABLED(conf) && !IS_RDC_ENABLED(conf))                    \
             goto disabled;                                                     \
                                                                                \
         __local = nlc_local_init(frame, this, _op, loc1, loc2);                \
@@ -92,6 +105,8 @@ out:
                                                                                \
         conf = this->private;                                                  \
                                                                                \
+        if (IS_RDC_ENABLED(conf))                                              \
+            nlc_dentry_op_dirents(frame, this);                                \
         if (op_ret < 0 || !IS_PEC_ENABLED(conf))                               \
             goto out;                                                          \
         nlc_dentry_op(frame, this, multilink);                                 \
@@ -99,6 +114,42 @@ out:
         NLC_STACK_UNWIND(_name, frame, op_ret, op_errno, args);                \
     } while (0)
 
+/* Fops that change the iatt or xattrs of an inode, only tracked to drop
+ * the cached listing of the parent directory. */
+#define NLC_INODE_FOP(_name, _inode, frame, this, args...)                     \
+    do {                                                                       \
+        nlc_local_t *__local = NULL;                                           \
+        nlc_conf_t *conf = NULL;                                               \
+                                                                               \
+        conf = this->private;                                                  \
+                                                                               \
+        if (!IS_RDC_ENABLED(conf))                                             \
+            goto disabled;                                                     \
+                                                                               \
+        __local = nlc_local_init(frame, this, GF_FOP_NULL, NULL, NULL);        \
+        GF_VALIDATE_OR_GOTO(this->name, __local, err);                         \
+        __local->inode = inode_ref(_inode);                                    \
+                                                                               \
+        STACK_WIND(frame, nlc_##_name##_cbk, FIRST_CHILD(this),                \
+                   FIRST_CHILD(this)->fops->_name, args);                      \
+        break;                                                                 \
+    disabled:                                                                  \
+        default_##_name##_resume(frame, this, args);                           \
+        break;                                                                 \
+    err:                                                                       \
+        default_##_name##_failure_cbk(frame, ENOMEM);                          \
+        break;                                                                 \
+    } while (0)
+
+#define NLC_INODE_FOP_CBK(_name, frame, this, op_ret, op_errno, args...)       \
+    do {                                                                       \
+        nlc_local_t *__local = frame->local;                                   \
+                                                                               \
+        if (op_ret >= 0 && __local && __local->inode)                          \
+            nlc_inode_inval_parent_dirents(this, __local->inode);              \
+        NLC_STACK_UNWIND(_name, frame, op_ret, op_errno, args);                \
+    } while (0)
+
 static int32_t
 nlc_rename_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                int32_t op_ret, int32_t op_errno, struct iatt *buf,
@@ -390,14 +441,23 @@ nlc_unlink_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 {
     uint32_t link_count = 0;
     gf_boolean_t multilink = _gf_false;
+    nlc_conf_t *conf = NULL;
+
+    conf = this->private;
 
     if (xdata && !dict_get_uint32(xdata, GET_LINK_COUNT, &link_count)) {
         if (link_count > 1)
             multilink = _gf_true;
     } else {
+        /* The link count is only asked for by the positive entry cache,
+         * the cached listing is dropped regardless. */
+        if (op_ret == 0 && IS_RDC_ENABLED(conf))
+            nlc_dentry_op_dirents(frame, this);
+
         /* Don't touch cache if we don't know enough */
-        gf_msg(this->name, GF_LOG_WARNING, 0, NLC_MSG_DICT_FAILURE,
-               "Failed to get GET_LINK_COUNT from dict");
+        if (IS_PEC_ENABLED(conf))
+            gf_msg(this->name, GF_LOG_WARNING, 0, NLC_MSG_DICT_FAILURE,
+                   "Failed to get GET_LINK_COUNT from dict");
         NLC_STACK_UNWIND(unlink, frame, op_ret, op_errno, preparent, postparent,
                          xdata);
         return 0;
@@ -440,6 +500,312 @@ do_fop:
     return 0;
 }
 
+static int32_t
+nlc_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+               struct iatt *postbuf, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(writev, frame, this, op_ret, op_errno, prebuf, postbuf,
+                      xdata);
+    return 0;
+}
+
+static int32_t
+nlc_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
+           int32_t count, off_t off, uint32_t flags, struct iobref *iobref,
+           dict_t *xdata)
+{
+    NLC_INODE_FOP(writev, fd->inode, frame, this, fd, vector, count, off, flags,
+                  iobref, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_truncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(truncate, frame, this, op_ret, op_errno, prebuf, postbuf,
+                      xdata);
+    return 0;
+}
+
+static int32_t
+nlc_truncate(call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
+             dict_t *xdata)
+{
+    NLC_INODE_FOP(truncate, loc->inode, frame, this, loc, offset, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_ftruncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(ftruncate, frame, this, op_ret, op_errno, prebuf, postbuf,
+                      xdata);
+    return 0;
+}
+
+static int32_t
+nlc_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              dict_t *xdata)
+{
+    NLC_INODE_FOP(ftruncate, fd->inode, frame, this, fd, offset, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_fallocate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(fallocate, frame, this, op_ret, op_errno, prebuf, postbuf,
+                      xdata);
+    return 0;
+}
+
+static int32_t
+nlc_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t keep_size,
+              off_t offset, size_t len, dict_t *xdata)
+{
+    NLC_INODE_FOP(fallocate, fd->inode, frame, this, fd, keep_size, offset, len,
+                  xdata);
+    return 0;
+}
+
+static int32_t
+nlc_discard_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                struct iatt *postbuf, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(discard, frame, this, op_ret, op_errno, prebuf, postbuf,
+                      xdata);
+    return 0;
+}
+
+static int32_t
+nlc_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            size_t len, dict_t *xdata)
+{
+    NLC_INODE_FOP(discard, fd->inode, frame, this, fd, offset, len, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_zerofill_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(zerofill, frame, this, op_ret, op_errno, prebuf, postbuf,
+                      xdata);
+    return 0;
+}
+
+static int32_t
+nlc_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             off_t len, dict_t *xdata)
+{
+    NLC_INODE_FOP(zerofill, fd->inode, frame, this, fd, offset, len, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_setattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+                struct iatt *statpost, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(setattr, frame, this, op_ret, op_errno, statpre, statpost,
+                      xdata);
+    return 0;
+}
+
+static int32_t
+nlc_setattr(call_frame_t *frame, xlator_t *this, loc_t *loc, struct iatt *stbuf,
+            int32_t valid, dict_t *xdata)
+{
+    NLC_INODE_FOP(setattr, loc->inode, frame, this, loc, stbuf, valid, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_fsetattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+                 struct iatt *statpost, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(fsetattr, frame, this, op_ret, op_errno, statpre,
+                      statpost, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_fsetattr(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iatt *stbuf,
+             int32_t valid, dict_t *xdata)
+{
+    NLC_INODE_FOP(fsetattr, fd->inode, frame, this, fd, stbuf, valid, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_setxattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(setxattr, frame, this, op_ret, op_errno, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_setxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *dict,
+             int32_t flags, dict_t *xdata)
+{
+    NLC_INODE_FOP(setxattr, loc->inode, frame, this, loc, dict, flags, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_fsetxattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(fsetxattr, frame, this, op_ret, op_errno, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_fsetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *dict,
+              int32_t flags, dict_t *xdata)
+{
+    NLC_INODE_FOP(fsetxattr, fd->inode, frame, this, fd, dict, flags, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_removexattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(removexattr, frame, this, op_ret, op_errno, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_removexattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
+                const char *name, dict_t *xdata)
+{
+    NLC_INODE_FOP(removexattr, loc->inode, frame, this, loc, name, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_fremovexattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+    NLC_INODE_FOP_CBK(fremovexattr, frame, this, op_ret, op_errno, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_fremovexattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 const char *name, dict_t *xdata)
+{
+    NLC_INODE_FOP(fremovexattr, fd->inode, frame, this, fd, name, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, gf_dirent_t *entries,
+                 dict_t *xdata)
+{
+    nlc_local_t *local = NULL;
+
+    local = frame->local;
+    if (local)
+        nlc_dir_fill_dirents(this, local->fd, local->offset, op_ret, op_errno,
+                             entries);
+
+    NLC_STACK_UNWIND(readdirp, frame, op_ret, op_errno, entries, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+             off_t off, dict_t *xdata)
+{
+    nlc_conf_t *conf = NULL;
+    nlc_local_t *local = NULL;
+    gf_dirent_t entries;
+    int op_errno = 0;
+    int count = 0;
+
+    conf = this->private;
+
+    if (!IS_RDC_ENABLED(conf))
+        goto wind;
+
+    INIT_LIST_HEAD(&entries.list);
+
+    count = nlc_dir_serve_dirents(this, fd, size, off, xdata, &entries,
+                                  &op_errno);
+    if (count >= 0) {
+        GF_ATOMIC_INC(conf->nlc_counter.readdirp_hit);
+        STACK_UNWIND_STRICT(readdirp, frame, count, op_errno, &entries, NULL);
+        gf_dirent_free(&entries);
+        return 0;
+    }
+
+    GF_ATOMIC_INC(conf->nlc_counter.readdirp_miss);
+
+    /* only a stream read from the start can fill the cache */
+    if (off == 0)
+        nlc_dir_start_fill(this, fd, xdata);
+
+    local = nlc_local_init(frame, this, GF_FOP_READDIRP, NULL, NULL);
+    if (!local)
+        goto wind;
+
+    local->fd = fd_ref(fd);
+    local->offset = off;
+
+    STACK_WIND(frame, nlc_readdirp_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readdirp, fd, size, off, xdata);
+    return 0;
+
+wind:
+    STACK_WIND(frame, default_readdirp_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readdirp, fd, size, off, xdata);
+    return 0;
+}
+
+/* Drops the listings an entry that is not in the inode table may be
+ * part of: the ones of the parents named by the upcall, or all of them
+ * when the upcall does not name any. */
+static void
+nlc_inval_dirents_of_gfid(xlator_t *this, inode_table_t *itable,
+                          struct gf_upcall_cache_invalidation *up_ci)
+{
+    inode_t *parent = NULL;
+
+    if (gf_uuid_is_null(up_ci->p_stat.ia_gfid) &&
+        gf_uuid_is_null(up_ci->oldp_stat.ia_gfid)) {
+        nlc_inval_all_dirents(this);
+        return;
+    }
+
+    if (!gf_uuid_is_null(up_ci->p_stat.ia_gfid)) {
+        parent = inode_find(itable, up_ci->p_stat.ia_gfid);
+        nlc_dir_inval_dirents(this, parent);
+        if (parent)
+            inode_unref(parent);
+    }
+
+    if (!gf_uuid_is_null(up_ci->oldp_stat.ia_gfid)) {
+        parent = inode_find(itable, up_ci->oldp_stat.ia_gfid);
+        nlc_dir_inval_dirents(this, parent);
+        if (parent)
+            inode_unref(parent);
+    }
+}
+
 static int32_t
 nlc_invalidate(xlator_t *this, void *data)
 {
@@ -469,10 +835,18 @@ nlc_invalidate(xlator_t *this, void *data)
     itable = ((xlator_t *)this->graph->top)->itable;
     inode = inode_find(itable, up_data->gfid);
     if (!inode) {
+        /* The entry may still be in a listing after its inode is
+         * forgotten */
+        if (IS_RDC_ENABLED(conf))
+            nlc_inval_dirents_of_gfid(this, itable, up_ci);
         ret = -1;
         goto out;
     }
 
+    /* Any change to an entry makes the listing of its parent stale */
+    if (IS_RDC_ENABLED(conf))
+        nlc_inode_inval_parent_dirents(this, inode);
+
     if ((!((up_ci->flags & UP_TIMES) && inode->ia_type == IA_IFDIR)) &&
         (!(up_ci->flags & UP_PARENT_DENTRY_FLAGS))) {
         goto out;
@@ -570,6 +944,13 @@ nlc_forget(xlator_t *this, inode_t *inode)
     return 0;
 }
 
+static int32_t
+nlc_releasedir(xlator_t *this, fd_t *fd)
+{
+    nlc_fd_ctx_destroy(this, fd);
+    return 0;
+}
+
 static int32_t
 nlc_inodectx(xlator_t *this, inode_t *inode)
 {
@@ -610,6 +991,14 @@ nlc_priv_dump(xlator_t *this)
     gf_proc_dump_write("inode_limit", "%" PRIu64, conf->inode_limit);
     gf_proc_dump_write("consumed_inodes", "%" PRId64,
                        GF_ATOMIC_GET(conf->refd_inodes));
+    gf_proc_dump_write("readdirp_hit_count", "%" PRId64,
+                       GF_ATOMIC_GET(conf->nlc_counter.readdirp_hit));
+    gf_proc_dump_write("readdirp_miss_count", "%" PRId64,
+                       GF_ATOMIC_GET(conf->nlc_counter.readdirp_miss));
+    gf_proc_dump_write("readdirp_cache_limit", "%" PRIu64,
+                       conf->dirents_limit);
+    gf_proc_dump_write("consumed_readdirp_cache_size", "%" PRId64,
+                       GF_ATOMIC_GET(conf->dirents_size));
 
     return 0;
 }
@@ -643,6 +1032,14 @@ nlc_dump_metrics(xlator_t *this, int fd)
     dprintf(fd, "%s.inode_limit %" PRIu64 "\n", this->name, conf->inode_limit);
     dprintf(fd, "%s.consumed_inodes %" PRId64 "\n", this->name,
             GF_ATOMIC_GET(conf->refd_inodes));
+    dprintf(fd, "%s.readdirp_hit_count %" PRId64 "\n", this->name,
+            GF_ATOMIC_GET(conf->nlc_counter.readdirp_hit));
+    dprintf(fd, "%s.readdirp_miss_count %" PRId64 "\n", this->name,
+            GF_ATOMIC_GET(conf->nlc_counter.readdirp_miss));
+    dprintf(fd, "%s.readdirp_cache_limit %" PRIu64 "\n", this->name,
+            conf->dirents_limit);
+    dprintf(fd, "%s.consumed_readdirp_cache_size %" PRId64 "\n", this->name,
+            GF_ATOMIC_GET(conf->dirents_size));
 
     return 0;
 }
@@ -682,6 +1079,10 @@ nlc_reconfigure(xlator_t *this, dict_t *options)
                      options, bool, out);
     GF_OPTION_RECONF("nl-cache-limit", conf->cache_size, options, size_uint64,
                      out);
+    GF_OPTION_RECONF("nl-cache-readdirp", conf->readdirp_cache, options, bool,
+                     out);
+    GF_OPTION_RECONF("nl-cache-readdirp-limit", conf->dirents_limit, options,
+                     size_uint64, out);
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
 
 out:
@@ -703,6 +1104,9 @@ nlc_init(xlator_t *this)
     GF_OPTION_INIT("nl-cache-positive-entry", conf->positive_entry_cache, bool,
                    out);
     GF_OPTION_INIT("nl-cache-limit", conf->cache_size, size_uint64, out);
+    GF_OPTION_INIT("nl-cache-readdirp", conf->readdirp_cache, bool, out);
+    GF_OPTION_INIT("nl-cache-readdirp-limit", conf->dirents_limit, size_uint64,
+                   out);
     GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
 
     /* Since the positive entries are stored as list of refs on
@@ -727,6 +1131,10 @@ nlc_init(xlator_t *this)
     GF_ATOMIC_INIT(conf->nlc_counter.pe_inode_cnt, 0);
     GF_ATOMIC_INIT(conf->nlc_counter.ne_inode_cnt, 0);
     GF_ATOMIC_INIT(conf->nlc_counter.nlc_invals, 0);
+    GF_ATOMIC_INIT(conf->nlc_counter.readdirp_hit, 0);
+    GF_ATOMIC_INIT(conf->nlc_counter.readdirp_miss, 0);
+    GF_ATOMIC_INIT(conf->dirents_size, 0);
+    GF_ATOMIC_INIT(conf->dirents_epoch, 0);
 
     INIT_LIST_HEAD(&conf->lru);
     conf->last_child_down = gf_time();
@@ -759,15 +1167,28 @@ struct xlator_fops nlc_fops = {
     .symlink = nlc_symlink,
     .link = nlc_link,
     .unlink = nlc_unlink,
+    .readdirp = nlc_readdirp,
+    .writev = nlc_writev,
+    .truncate = nlc_truncate,
+    .ftruncate = nlc_ftruncate,
+    .fallocate = nlc_fallocate,
+    .discard = nlc_discard,
+    .zerofill = nlc_zerofill,
+    .setattr = nlc_setattr,
+    .fsetattr = nlc_fsetattr,
+    .setxattr = nlc_setxattr,
+    .fsetxattr = nlc_fsetxattr,
+    .removexattr = nlc_removexattr,
+    .fremovexattr = nlc_fremovexattr,
     /* TODO:
     .readdir              = nlc_readdir,
-    .readdirp             = nlc_readdirp,
     .seek                 = nlc_seek,
     .opendir              = nlc_opendir, */
 };
 
 struct xlator_cbks nlc_cbks = {
     .forget = nlc_forget,
+    .releasedir = nlc_releasedir,
 };
 
 struct xlator_dumpops nlc_dumpops = {
@@ -812,6 +1233,29 @@ struct volume_options nlc_options[] = {
         .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
         .description = "Time period after which cache has to be refreshed",
     },
+    {
+        .key = {"nl-cache-readdirp"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "false",
+        .op_version = {GD_OP_VERSION_11_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "Cache the complete listing of a directory, with the "
+                       "attributes of its entries, once it has been read to "
+                       "the end, and serve later readdirp on the directory "
+                       "from memory until it changes. Relies on "
+                       "cache-invalidation for changes made by other clients",
+    },
+    {
+        .key = {"nl-cache-readdirp-limit"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 0,
+        .default_value = "10MB",
+        .op_version = {GD_OP_VERSION_11_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "maximum memory used by the directory listings "
+                       "cached by nl-cache-readdirp, listings are not cached "
+                       "once it is reached",
+    },
     {.key = {"pass-through"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "false",
@@ -20,12 +20,14 @@
 #define NLC_PE_FULL 0x0001
 #define NLC_PE_PARTIAL 0x0002
 #define NLC_NE_VALID 0x0004
+#define NLC_DIRENTS_VALID 0x0008
 
 #define IS_PE_VALID(state)                                                     \
     ((state != NLC_INVALID) && (state & (NLC_PE_FULL | NLC_PE_PARTIAL)))
 #define IS_NE_VALID(state) ((state != NLC_INVALID) && (state & NLC_NE_VALID))
 
 #define IS_PEC_ENABLED(conf) (conf->positive_entry_cache)
+#define IS_RDC_ENABLED(conf) (conf->readdirp_cache)
 #define IS_CACHE_ENABLED(conf) ((!conf->cache_disabled))
 
 #define NLC_STACK_UNWIND(fop, frame, params...)                                \
@@ -80,10 +82,34 @@ struct nlc_ctx {
     nlc_timer_data_t *timer_data;
     size_t cache_size;
     uint64_t refd_inodes;
+    gf_dirent_t dirents;   /* complete listing, see NLC_DIRENTS_VALID */
+    dict_t *dirents_xdata; /* readdirp xdata the listing was read with */
+    size_t dirents_size;
+    uint64_t dirents_gen; /* bumped every time the listing is dropped */
+    uint64_t dirents_epoch; /* conf->dirents_epoch the listing was read in */
     gf_lock_t lock;
 };
 typedef struct nlc_ctx nlc_ctx_t;
 
+/* Per fd state of a directory being read from offset 0, the entries
+ * are collected here until EOD and then handed over to the nlc_ctx of
+ * the directory, unless the directory changed in the meantime. */
+struct nlc_fd_ctx {
+    gf_dirent_t entries;
+    dict_t *xdata;
+    size_t size;
+    off_t next_offset;
+    uint64_t gen;
+    uint64_t epoch;
+    gf_boolean_t filling;
+    /* where the last readdirp served from cache stopped */
+    uint64_t serve_gen;
+    off_t serve_offset;
+    gf_dirent_t *serve_next;
+    gf_lock_t lock;
+};
+typedef struct nlc_fd_ctx nlc_fd_ctx_t;
+
 struct nlc_local {
     loc_t loc;
     loc_t loc2;
@@ -91,6 +117,7 @@ struct nlc_local {
     inode_t *parent;
     fd_t *fd;
     char *linkname;
+    off_t offset;
     glusterfs_fop_t fop;
 };
 typedef struct nlc_local nlc_local_t;
@@ -105,6 +132,8 @@ struct nlc_statistics {
     gf_atomic_t pe_inode_cnt;
     gf_atomic_t ne_inode_cnt;
     gf_atomic_t nlc_invals; /* No. of invalidates received from upcall*/
+    gf_atomic_t readdirp_hit;  /* readdirp served from a cached listing */
+    gf_atomic_t readdirp_miss; /* readdirp sent to the bricks */
 };
 
 struct nlc_conf {
@@ -112,6 +141,11 @@ struct nlc_conf {
     gf_boolean_t positive_entry_cache;
     gf_boolean_t negative_entry_cache;
     gf_boolean_t disable_cache;
+    gf_boolean_t readdirp_cache;
+    uint64_t dirents_limit;
+    gf_atomic_t dirents_size;
+    /* bumped to drop every cached listing at once */
+    gf_atomic_t dirents_epoch;
     uint64_t cache_size;
     gf_atomic_t current_cache_size;
     uint64_t inode_limit;
@@ -170,4 +204,27 @@ nlc_disable_cache(xlator_t *this);
 void
 nlc_lru_prune(xlator_t *this, inode_t *inode);
 
+void
+nlc_dir_inval_dirents(xlator_t *this, inode_t *inode);
+
+void
+nlc_inode_inval_parent_dirents(xlator_t *this, inode_t *inode);
+
+void
+nlc_inval_all_dirents(xlator_t *this);
+
+int
+nlc_dir_serve_dirents(xlator_t *this, fd_t *fd, size_t size, off_t offset,
+                      dict_t *xdata, gf_dirent_t *entries, int *op_errno);
+
+void
+nlc_dir_start_fill(xlator_t *this, fd_t *fd, dict_t *xdata);
+
+void
+nlc_dir_fill_dirents(xlator_t *this, fd_t *fd, off_t offset, int32_t op_ret,
+                     int32_t op_errno, gf_dirent_t *entries);
+
+void
+nlc_fd_ctx_destroy(xlator_t *this, fd_t *fd);
+
 #endif /* __NL_CACHE_H__ */
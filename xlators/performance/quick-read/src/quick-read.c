@@ -9,6 +9,7 @@
 */
 
 #include <math.h>
+#include <zlib.h>
 #include "quick-read.h"
 #include <glusterfs/statedump.h>
 #include "quick-read-messages.h"
@@ -45,6 +46,105 @@ out:
     return;
 }
 
+static inline qr_inode_table_t *
+qr_inode_table_get(qr_private_t *priv, qr_inode_t *qr_inode)
+{
+    uint64_t key = (uint64_t)(uintptr_t)qr_inode;
+
+    key *= 0x9e3779b97f4a7c15ULL;
+
+    return &priv->table[key >> (64 - QR_TABLE_SHARD_BITS)];
+}
+
+static inline uint64_t
+qr_shard_cache_size(qr_conf_t *conf)
+{
+    return conf->cache_size / QR_TABLE_SHARDS;
+}
+
+static uint32_t
+qr_sketch_index(qr_inode_t *qr_inode, int row)
+{
+    static const uint64_t seeds[QR_SKETCH_DEPTH] = {
+        0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+        0xcbf29ce484222325ULL};
+    uint64_t key = (uint64_t)(uintptr_t)qr_inode;
+
+    key = (key ^ (key >> 31)) * seeds[row];
+
+    return (key >> 32) & (QR_SKETCH_WIDTH - 1);
+}
+
+/* To be called with table->lock held */
+static void
+__qr_sketch_record(qr_inode_table_t *table, qr_inode_t *qr_inode)
+{
+    qr_sketch_t *sketch = &table->sketch;
+    uint32_t idx = 0;
+    int row = 0;
+    int i = 0;
+
+    for (row = 0; row < QR_SKETCH_DEPTH; row++) {
+        idx = qr_sketch_index(qr_inode, row);
+        if (sketch->count[row][idx] < QR_SKETCH_MAX)
+            sketch->count[row][idx]++;
+    }
+
+    if (++sketch->additions < QR_SKETCH_SAMPLE)
+        return;
+
+    for (row = 0; row < QR_SKETCH_DEPTH; row++) {
+        for (i = 0; i < QR_SKETCH_WIDTH; i++)
+            sketch->count[row][i] >>= 1;
+    }
+    sketch->additions >>= 1;
+}
+
+/* To be called with table->lock held */
+static uint32_t
+__qr_sketch_estimate(qr_inode_table_t *table, qr_inode_t *qr_inode)
+{
+    uint32_t freq = QR_SKETCH_MAX;
+    uint32_t count = 0;
+    int row = 0;
+
+    for (row = 0; row < QR_SKETCH_DEPTH; row++) {
+        count = table->sketch.count[row][qr_sketch_index(qr_inode, row)];
+        freq = min(freq, count);
+    }
+
+    return freq;
+}
+
+/* To be called with table->lock held. While the shard has room every
+ * content is admitted. Once it is full, new content is only cached if it
+ * has been asked for more often than the entry that would be evicted
+ * first to make room for it, so that a scan over many files read once
+ * does not flush the files that are read all the time. */
+static gf_boolean_t
+__qr_cache_admit(qr_inode_table_t *table, qr_conf_t *conf,
+                 qr_inode_t *qr_inode, size_t len)
+{
+    qr_inode_t *victim = NULL;
+    int index = 0;
+
+    if (table->cache_used + len <= qr_shard_cache_size(conf))
+        return _gf_true;
+
+    for (index = 0; index < conf->max_pri; index++) {
+        if (!list_empty(&table->lru[index])) {
+            victim = list_first_entry(&table->lru[index], qr_inode_t, lru);
+            break;
+        }
+    }
+
+    if (!victim)
+        return _gf_true;
+
+    return (__qr_sketch_estimate(table, qr_inode) >
+            __qr_sketch_estimate(table, victim));
+}
+
 uint64_t
 __qr_get_generation(xlator_t *this, qr_inode_t *qr_inode)
 {
@@ -53,7 +153,7 @@ __qr_get_generation(xlator_t *this, qr_inode_t *qr_inode)
     qr_inode_table_t *table = NULL;
 
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode_table_get(priv, qr_inode);
 
     gen = GF_ATOMIC_INC(priv->generation);
     if (gen == 0) {
@@ -77,11 +177,11 @@ qr_get_generation(xlator_t *this, inode_t *inode)
     qr_private_t *priv = NULL;
 
     priv = this->private;
-    table = &priv->table;
 
     qr_inode = qr_inode_ctx_get(this, inode);
 
     if (qr_inode) {
+        table = qr_inode_table_get(priv, qr_inode);
         LOCK(&table->lock);
         {
             gen = __qr_get_generation(this, qr_inode);
@@ -210,7 +310,8 @@ qr_inode_ctx_get_or_new(xlator_t *this, inode_t *inode)
 
         ret = __qr_inode_ctx_set(this, inode, qr_inode);
         if (ret) {
-            __qr_inode_prune(this, &priv->table, qr_inode, 0);
+            __qr_inode_prune(this, qr_inode_table_get(priv, qr_inode),
+                             qr_inode, 0);
             GF_FREE(qr_inode);
             qr_inode = NULL;
         }
@@ -251,7 +352,7 @@ __qr_inode_register(xlator_t *this, qr_inode_table_t *table,
 
     if (list_empty(&qr_inode->lru))
         /* first time addition of this qr_inode into table */
-        table->cache_used += qr_inode->size;
+        table->cache_used += qr_inode->data_len;
     else
         list_del_init(&qr_inode->lru);
 
@@ -276,7 +377,7 @@ qr_inode_set_priority(xlator_t *this, inode_t *inode, const char *path)
         return;
 
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode_table_get(priv, qr_inode);
     conf = &priv->conf;
 
     if (path)
@@ -306,8 +407,10 @@ __qr_inode_prune_data(xlator_t *this, qr_inode_table_t *table,
     qr_inode->data = NULL;
 
     if (!list_empty(&qr_inode->lru)) {
-        table->cache_used -= qr_inode->size;
+        table->cache_used -= qr_inode->data_len;
         qr_inode->size = 0;
+        qr_inode->data_len = 0;
+        qr_inode->compressed = _gf_false;
 
         list_del_init(&qr_inode->lru);
 
@@ -317,7 +420,7 @@ __qr_inode_prune_data(xlator_t *this, qr_inode_table_t *table,
     memset(&qr_inode->buf, 0, sizeof(qr_inode->buf));
 }
 
-/* To be called with priv->table.lock held */
+/* To be called with table->lock held */
 void
 __qr_inode_prune(xlator_t *this, qr_inode_table_t *table, qr_inode_t *qr_inode,
                  uint64_t gen)
@@ -340,7 +443,7 @@ qr_inode_prune(xlator_t *this, inode_t *inode, uint64_t gen)
         return;
 
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode_table_get(priv, qr_inode);
 
     LOCK(&table->lock);
     {
@@ -349,7 +452,7 @@ qr_inode_prune(xlator_t *this, inode_t *inode, uint64_t gen)
     UNLOCK(&table->lock);
 }
 
-/* To be called with priv->table.lock held */
+/* To be called with table->lock held */
 void
 __qr_cache_prune(xlator_t *this, qr_inode_table_t *table, qr_conf_t *conf)
 {
@@ -361,26 +464,24 @@ __qr_cache_prune(xlator_t *this, qr_inode_table_t *table, qr_conf_t *conf)
         list_for_each_entry_safe(curr, next, &table->lru[index], lru)
         {
             __qr_inode_prune(this, table, curr, 0);
-            if (table->cache_used < conf->cache_size)
+            if (table->cache_used < qr_shard_cache_size(conf))
                 return;
         }
     }
 }
 
 void
-qr_cache_prune(xlator_t *this)
+qr_cache_prune(xlator_t *this, qr_inode_table_t *table)
 {
     qr_private_t *priv = NULL;
     qr_conf_t *conf = NULL;
-    qr_inode_table_t *table = NULL;
 
     priv = this->private;
-    table = &priv->table;
     conf = &priv->conf;
 
     LOCK(&table->lock);
     {
-        if (table->cache_used > conf->cache_size)
+        if (table->cache_used > qr_shard_cache_size(conf))
             __qr_cache_prune(this, table, conf);
     }
     UNLOCK(&table->lock);
@@ -408,19 +509,73 @@ out:
     return content;
 }
 
+/* Replaces *data by a zlib compressed copy of it, if that saves at least
+ * an eighth of the space. Returns _gf_true if *data was replaced. */
+static gf_boolean_t
+qr_content_compress(xlator_t *this, void **data, size_t size,
+                    size_t *data_len)
+{
+    void *out = NULL;
+    void *shrunk = NULL;
+    uLongf len = 0;
+    int ret = 0;
+
+    *data_len = size;
+
+    if (size == 0)
+        return _gf_false;
+
+    len = compressBound(size);
+    out = GF_MALLOC(len, gf_qr_mt_content_t);
+    if (!out)
+        return _gf_false;
+
+    ret = compress2(out, &len, *data, size, Z_BEST_SPEED);
+    if (ret != Z_OK) {
+        gf_msg_debug(this->name, 0, "compression of %zu bytes failed (%d)",
+                     size, ret);
+        GF_FREE(out);
+        return _gf_false;
+    }
+
+    if (len > size - (size >> 3)) {
+        GF_FREE(out);
+        return _gf_false;
+    }
+
+    shrunk = GF_REALLOC(out, len);
+    if (shrunk)
+        out = shrunk;
+
+    GF_FREE(*data);
+    *data = out;
+    *data_len = len;
+
+    return _gf_true;
+}
+
 void
 qr_content_update(xlator_t *this, qr_inode_t *qr_inode, void *data,
                   struct iatt *buf, uint64_t gen)
 {
     qr_private_t *priv = NULL;
+    qr_conf_t *conf = NULL;
     qr_inode_table_t *table = NULL;
     uint32_t rollover = 0;
+    size_t data_len = 0;
+    gf_boolean_t compressed = _gf_false;
 
     rollover = gen >> 32;
     gen = gen & 0xffffffff;
 
     priv = this->private;
-    table = &priv->table;
+    conf = &priv->conf;
+    table = qr_inode_table_get(priv, qr_inode);
+
+    if (conf->compression)
+        compressed = qr_content_compress(this, &data, buf->ia_size, &data_len);
+    else
+        data_len = buf->ia_size;
 
     LOCK(&table->lock);
     {
@@ -431,11 +586,23 @@ qr_content_update(xlator_t *this, qr_inode_t *qr_inode, void *data,
         if ((qr_inode->data == NULL) && (qr_inode->invalidation_time >= gen))
             goto unlock;
 
+        __qr_sketch_record(table, qr_inode);
+
+        /* content already cached is always replaced, new content has to
+         * earn its place */
+        if (!qr_inode->data &&
+            !__qr_cache_admit(table, conf, qr_inode, data_len)) {
+            GF_ATOMIC_INC(priv->qr_counter.admission_rejects);
+            goto unlock;
+        }
+
         __qr_inode_prune(this, table, qr_inode, gen);
 
         qr_inode->data = data;
         data = NULL;
         qr_inode->size = buf->ia_size;
+        qr_inode->data_len = data_len;
+        qr_inode->compressed = compressed;
 
         qr_inode->ia_mtime = buf->ia_mtime;
         qr_inode->ia_mtime_nsec = buf->ia_mtime_nsec;
@@ -453,7 +620,7 @@ unlock:
     if (data)
         GF_FREE(data);
 
-    qr_cache_prune(this);
+    qr_cache_prune(this, table);
 }
 
 gf_boolean_t
@@ -498,7 +665,7 @@ __qr_content_refresh(xlator_t *this, qr_inode_t *qr_inode, struct iatt *buf,
     gen = gen & 0xffffffff;
 
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode_table_get(priv, qr_inode);
     conf = &priv->conf;
 
     /* allow for rollover of frame->root->unique */
@@ -514,6 +681,7 @@ __qr_content_refresh(xlator_t *this, qr_inode_t *qr_inode, struct iatt *buf,
     if (qr_size_fits(conf, buf) && qr_time_equal(conf, qr_inode, buf)) {
         qr_inode->buf = *buf;
         qr_inode->last_refresh = gf_time();
+        __qr_sketch_record(table, qr_inode);
         __qr_inode_register(this, table, qr_inode);
     } else {
         __qr_inode_prune(this, table, qr_inode, gen);
@@ -531,7 +699,7 @@ qr_content_refresh(xlator_t *this, qr_inode_t *qr_inode, struct iatt *buf,
     qr_inode_table_t *table = NULL;
 
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode_table_get(priv, qr_inode);
 
     LOCK(&table->lock);
     {
@@ -714,10 +882,15 @@ qr_readv_cached(call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
     struct iatt buf = {
         0,
     };
+    char *base = NULL;
+    void *blob = NULL;
+    size_t blob_len = 0;
+    size_t inflated = 0;
+    uLongf len = 0;
 
     this = frame->this;
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode_table_get(priv, qr_inode);
 
     LOCK(&table->lock);
     {
@@ -732,7 +905,9 @@ qr_readv_cached(call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
 
         op_ret = min(size, (qr_inode->size - offset));
 
-        iobuf = iobuf_get2(this->ctx->iobuf_pool, op_ret);
+        /* a compressed body can only be inflated as a whole */
+        iobuf = iobuf_get2(this->ctx->iobuf_pool,
+                           qr_inode->compressed ? qr_inode->size : op_ret);
         if (!iobuf) {
             op_ret = -1;
             goto unlock;
@@ -746,18 +921,44 @@ qr_readv_cached(call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
 
         iobref_add(iobref, iobuf);
 
-        memcpy(iobuf->ptr, qr_inode->data + offset, op_ret);
+        if (qr_inode->compressed) {
+            /* inflate a copy after unlocking, so that zlib doesn't hold
+             * up the other inodes of the table */
+            blob_len = qr_inode->data_len;
+            blob = GF_MALLOC(blob_len, gf_qr_mt_content_t);
+            if (!blob) {
+                op_ret = -1;
+                goto unlock;
+            }
+            memcpy(blob, qr_inode->data, blob_len);
+            inflated = qr_inode->size;
+        } else {
+            memcpy(iobuf->ptr, qr_inode->data + offset, op_ret);
+            base = iobuf->ptr;
+        }
 
         buf = qr_inode->buf;
 
         /* bump LRU */
+        __qr_sketch_record(table, qr_inode);
         __qr_inode_register(frame->this, table, qr_inode);
     }
 unlock:
     UNLOCK(&table->lock);
 
+    if ((op_ret >= 0) && blob) {
+        len = inflated;
+        if ((uncompress(iobuf->ptr, &len, blob, blob_len) != Z_OK) ||
+            (len != inflated))
+            op_ret = -1;
+        else
+            base = (char *)iobuf->ptr + offset;
+    }
+
+    GF_FREE(blob);
+
     if (op_ret >= 0) {
-        iov.iov_base = iobuf->ptr;
+        iov.iov_base = base;
         iov.iov_len = op_ret;
 
         GF_ATOMIC_INC(priv->qr_counter.cache_hit);
@@ -1044,8 +1245,10 @@ qr_priv_dump(xlator_t *this)
     qr_inode_table_t *table = NULL;
     uint32_t file_count = 0;
     uint32_t i = 0;
+    uint32_t j = 0;
     qr_inode_t *curr = NULL;
     uint64_t total_size = 0;
+    uint64_t total_used = 0;
     char key_prefix[GF_DUMP_MAX_BUF_LEN];
 
     if (!this) {
@@ -1057,8 +1260,6 @@ qr_priv_dump(xlator_t *this)
     if (!conf)
         return -1;
 
-    table = &priv->table;
-
     gf_proc_dump_build_key(key_prefix, "xlator.performance.quick-read", "priv");
 
     gf_proc_dump_add_section("%s", key_prefix);
@@ -1066,28 +1267,36 @@ qr_priv_dump(xlator_t *this)
     gf_proc_dump_write("max_file_size", "%" PRIu64, conf->max_file_size);
     gf_proc_dump_write("cache_timeout", "%ld", conf->cache_timeout);
 
-    if (!table) {
-        goto out;
-    } else {
-        for (i = 0; i < conf->max_pri; i++) {
-            list_for_each_entry(curr, &table->lru[i], lru)
-            {
-                file_count++;
-                total_size += curr->size;
+    for (j = 0; j < QR_TABLE_SHARDS; j++) {
+        table = &priv->table[j];
+        LOCK(&table->lock);
+        {
+            for (i = 0; i < conf->max_pri; i++) {
+                list_for_each_entry(curr, &table->lru[i], lru)
+                {
+                    file_count++;
+                    total_size += curr->size;
+                }
             }
+            total_used += table->cache_used;
         }
+        UNLOCK(&table->lock);
     }
 
     gf_proc_dump_write("total_files_cached", "%d", file_count);
-    gf_proc_dump_write("total_cache_used", "%" PRIu64, total_size);
+    gf_proc_dump_write("total_file_size", "%" PRIu64, total_size);
+    gf_proc_dump_write("total_cache_used", "%" PRIu64, total_used);
+    gf_proc_dump_write("cache_compression", "%s",
+                       conf->compression ? "on" : "off");
     gf_proc_dump_write("cache-hit", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(priv->qr_counter.cache_hit));
     gf_proc_dump_write("cache-miss", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(priv->qr_counter.cache_miss));
     gf_proc_dump_write("cache-invalidations", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(priv->qr_counter.file_data_invals));
+    gf_proc_dump_write("cache-admission-rejects", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(priv->qr_counter.admission_rejects));
 
-out:
     return 0;
 }
 
@@ -1095,21 +1304,26 @@ static int32_t
 qr_dump_metrics(xlator_t *this, int fd)
 {
     qr_private_t *priv = NULL;
-    qr_inode_table_t *table = NULL;
+    uint64_t cache_used = 0;
+    int i = 0;
 
     priv = this->private;
-    table = &priv->table;
+
+    for (i = 0; i < QR_TABLE_SHARDS; i++)
+        cache_used += priv->table[i].cache_used;
 
     dprintf(fd, "%s.total_files_cached %" PRId64 "\n", this->name,
             GF_ATOMIC_GET(priv->qr_counter.files_cached));
     dprintf(fd, "%s.total_cache_used %" PRId64 "\n", this->name,
-            table->cache_used);
+            cache_used);
     dprintf(fd, "%s.cache-hit %" PRId64 "\n", this->name,
             GF_ATOMIC_GET(priv->qr_counter.cache_hit));
     dprintf(fd, "%s.cache-miss %" PRId64 "\n", this->name,
             GF_ATOMIC_GET(priv->qr_counter.cache_miss));
     dprintf(fd, "%s.cache-invalidations %" PRId64 "\n", this->name,
             GF_ATOMIC_GET(priv->qr_counter.file_data_invals));
+    dprintf(fd, "%s.cache-admission-rejects %" PRId64 "\n", this->name,
+            GF_ATOMIC_GET(priv->qr_counter.admission_rejects));
 
     return 0;
 }
@@ -1197,6 +1411,9 @@ qr_reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("ctime-invalidation", conf->ctime_invalidation, options,
                      bool, out);
 
+    GF_OPTION_RECONF("cache-compression", conf->compression, options, bool,
+                     out);
+
     GF_OPTION_RECONF("cache-size", cache_size_new, options, size_uint64, out);
     if (!check_cache_size_ok(this, cache_size_new)) {
         ret = -1;
@@ -1311,7 +1528,7 @@ out:
 int32_t
 qr_init(xlator_t *this)
 {
-    int32_t ret = -1, i = 0;
+    int32_t ret = -1, i = 0, j = 0;
     qr_private_t *priv = NULL;
     qr_conf_t *conf = NULL;
 
@@ -1335,7 +1552,8 @@ qr_init(xlator_t *this)
         goto out;
     }
 
-    LOCK_INIT(&priv->table.lock);
+    for (j = 0; j < QR_TABLE_SHARDS; j++)
+        LOCK_INIT(&priv->table[j].lock);
     LOCK_INIT(&priv->lock);
     conf = &priv->conf;
 
@@ -1354,6 +1572,8 @@ qr_init(xlator_t *this)
 
     GF_OPTION_INIT("ctime-invalidation", conf->ctime_invalidation, bool, out);
 
+    GF_OPTION_INIT("cache-compression", conf->compression, bool, out);
+
     INIT_LIST_HEAD(&conf->priority_list);
     conf->max_pri = 1;
     if (dict_get(this->options, "priority")) {
@@ -1368,15 +1588,17 @@ qr_init(xlator_t *this)
         conf->max_pri++;
     }
 
-    priv->table.lru = GF_CALLOC(conf->max_pri, sizeof(*priv->table.lru),
-                                gf_common_mt_list_head);
-    if (priv->table.lru == NULL) {
-        ret = -1;
-        goto out;
-    }
+    for (j = 0; j < QR_TABLE_SHARDS; j++) {
+        priv->table[j].lru = GF_CALLOC(
+            conf->max_pri, sizeof(*priv->table[j].lru), gf_common_mt_list_head);
+        if (priv->table[j].lru == NULL) {
+            ret = -1;
+            goto out;
+        }
 
-    for (i = 0; i < conf->max_pri; i++) {
-        INIT_LIST_HEAD(&priv->table.lru[i]);
+        for (i = 0; i < conf->max_pri; i++) {
+            INIT_LIST_HEAD(&priv->table[j].lru[i]);
+        }
     }
 
     ret = 0;
@@ -1386,6 +1608,8 @@ qr_init(xlator_t *this)
     this->private = priv;
 out:
     if ((ret == -1) && priv) {
+        for (j = 0; j < QR_TABLE_SHARDS; j++)
+            GF_FREE(priv->table[j].lru);
         GF_FREE(priv);
     }
 
@@ -1396,21 +1620,26 @@ void
 qr_inode_table_destroy(qr_private_t *priv)
 {
     int i = 0;
+    int j = 0;
     qr_conf_t *conf = NULL;
 
     conf = &priv->conf;
 
-    for (i = 0; i < conf->max_pri; i++) {
-        /* There is a known leak of inodes, hence until
-         * that is fixed, log the assert as warning.
-        GF_ASSERT (list_empty (&priv->table.lru[i]));*/
-        if (!list_empty(&priv->table.lru[i])) {
-            gf_msg("quick-read", GF_LOG_INFO, 0, QUICK_READ_MSG_LRU_NOT_EMPTY,
-                   "quick read inode table lru not empty");
+    for (j = 0; j < QR_TABLE_SHARDS; j++) {
+        for (i = 0; i < conf->max_pri; i++) {
+            /* There is a known leak of inodes, hence until
+             * that is fixed, log the assert as warning.
+            GF_ASSERT (list_empty (&priv->table[j].lru[i]));*/
+            if (!list_empty(&priv->table[j].lru[i])) {
+                gf_msg("quick-read", GF_LOG_INFO, 0,
+                       QUICK_READ_MSG_LRU_NOT_EMPTY,
+                       "quick read inode table lru not empty");
+            }
         }
-    }
 
-    LOCK_DESTROY(&priv->table.lock);
+        GF_FREE(priv->table[j].lru);
+        LOCK_DESTROY(&priv->table[j].lock);
+    }
 
     return;
 }
@@ -1617,6 +1846,17 @@ struct volume_options qr_options[] = {
                        "changes to file data. So, use this only when mtime "
                        "is not reliable",
     },
+    {
+        .key = {"cache-compression"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .op_version = {GD_OP_VERSION_11_0},
+        .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+        .description = "When \"on\", cached file contents are kept zlib "
+                       "compressed (when that saves space) and are inflated "
+                       "on every read served from the cache. This fits more "
+                       "files in cache-size at the cost of CPU.",
+    },
     {.key = {NULL}}};
 
 xlator_api_t xlator_api = {
@@ -28,6 +28,8 @@
 struct qr_inode {
     void *data;
     size_t size;
+    size_t data_len; /* bytes held in data, less than size if compressed */
+    gf_boolean_t compressed;
     int priority;
     uint64_t ia_mtime;
     uint32_t ia_mtime_nsec;
@@ -56,14 +58,36 @@ struct qr_conf {
     int max_pri;
     gf_boolean_t qr_invalidation;
     gf_boolean_t ctime_invalidation;
+    gf_boolean_t compression;
     struct list_head priority_list;
 };
 typedef struct qr_conf qr_conf_t;
 
+/* The cache is split into QR_TABLE_SHARDS independent tables, each with
+ * its own lock, lru lists and a 1/QR_TABLE_SHARDS share of cache-size.
+ * An inode always maps to the same shard (see qr_inode_table_get()). */
+#define QR_TABLE_SHARD_BITS 4
+#define QR_TABLE_SHARDS (1 << QR_TABLE_SHARD_BITS)
+
+/* Count-min sketch used for TinyLFU admission. Counters saturate at
+ * QR_SKETCH_MAX and are all halved after QR_SKETCH_SAMPLE recorded
+ * accesses so that old popularity fades away. */
+#define QR_SKETCH_DEPTH 4
+#define QR_SKETCH_WIDTH 1024
+#define QR_SKETCH_MAX 15
+#define QR_SKETCH_SAMPLE (10 * QR_SKETCH_WIDTH)
+
+struct qr_sketch {
+    uint8_t count[QR_SKETCH_DEPTH][QR_SKETCH_WIDTH];
+    uint32_t additions;
+};
+typedef struct qr_sketch qr_sketch_t;
+
 struct qr_inode_table {
     uint64_t cache_used;
     struct list_head *lru;
     gf_lock_t lock;
+    qr_sketch_t sketch;
 };
 typedef struct qr_inode_table qr_inode_table_t;
 
@@ -72,11 +96,12 @@ struct qr_statistics {
     gf_atomic_t cache_miss;
     gf_atomic_t file_data_invals; /* No. of invalidates received from upcall */
     gf_atomic_t files_cached;
+    gf_atomic_t admission_rejects; /* contents not cached by TinyLFU */
 };
 
 struct qr_private {
     qr_conf_t conf;
-    qr_inode_table_t table;
+    qr_inode_table_t table[QR_TABLE_SHARDS];
     time_t last_child_down;
     gf_lock_t lock;
     struct qr_statistics qr_counter;
@@ -233,6 +233,7 @@ server_priv(xlator_t *this)
     };
     uint64_t total_read = 0;
     uint64_t total_write = 0;
+    int count = 0;
     int32_t ret = -1;
 
     GF_VALIDATE_OR_GOTO("server", this, out);
@@ -252,6 +253,46 @@ server_priv(xlator_t *this)
         {
             total_read += xprt->total_bytes_read;
             total_write += xprt->total_bytes_write;
+
+            gf_proc_dump_build_key(key, "server", "conn.%d.peer", count);
+            gf_proc_dump_write(key, "%s", xprt->peerinfo.identifier);
+            gf_proc_dump_build_key(key, "server", "conn.%d.rpc-outstanding",
+                                   count);
+            gf_proc_dump_write(key, "%d", xprt->outstanding_rpc_count);
+            gf_proc_dump_build_key(key, "server", "conn.%d.rpc-window",
+                                   count);
+            gf_proc_dump_write(key, "%d", xprt->rpc_window.size);
+
+            if ((xprt->zerocopy.sent == 0) && (xprt->zerocopy.fallback == 0)) {
+                count++;
+                continue;
+            }
+
+            /* Zero-copy sends of each connection, with the average and
+             * maximum time (in usecs) the kernel kept the buffers. */
+            gf_proc_dump_build_key(key, "server", "conn.%d.zerocopy-sent",
+                                   count);
+            gf_proc_dump_write(key, "%" PRIu64, xprt->zerocopy.sent);
+            gf_proc_dump_build_key(key, "server", "conn.%d.zerocopy-copied",
+                                   count);
+            gf_proc_dump_write(key, "%" PRIu64, xprt->zerocopy.copied);
+            gf_proc_dump_build_key(key, "server",
+                                   "conn.%d.zerocopy-fallback", count);
+            gf_proc_dump_write(key, "%" PRIu64, xprt->zerocopy.fallback);
+            gf_proc_dump_build_key(key, "server",
+                                   "conn.%d.zerocopy-completed", count);
+            gf_proc_dump_write(key, "%" PRIu64, xprt->zerocopy.completed);
+            gf_proc_dump_build_key(key, "server",
+                                   "conn.%d.zerocopy-lag-avg", count);
+            gf_proc_dump_write(key, "%" PRIu64,
+                               xprt->zerocopy.completed
+                                   ? xprt->zerocopy.lag_total /
+                                         xprt->zerocopy.completed
+                                   : 0);
+            gf_proc_dump_build_key(key, "server",
+                                   "conn.%d.zerocopy-lag-max", count);
+            gf_proc_dump_write(key, "%" PRIu64, xprt->zerocopy.lag_max);
+            count++;
         }
     }
     pthread_mutex_unlock(&conf->mutex);
@@ -1053,6 +1094,8 @@ server_dump_metrics(xlator_t *this, int fd)
                 client->client_uid, xprt->total_bytes_write);
         dprintf(fd, "%s.total.rpc.%s.outstanding %d\n", this->name,
                 client->client_uid, xprt->outstanding_rpc_count);
+        dprintf(fd, "%s.total.rpc.%s.window %d\n", this->name,
+                client->client_uid, xprt->rpc_window.size);
     }
 
     pthread_mutex_unlock(&conf->mutex);
@@ -1877,6 +1920,16 @@ struct volume_options server_options[] = {
                     "potentially run out of memory)",
      .op_version = {1},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_GLOBAL},
+    {.key = {"rpc.outstanding-rpc-adaptive"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "on",
+     .description = "Adapt the number of incoming RPC requests accepted "
+                    "from each client to the time its requests wait before "
+                    "being processed. The window shrinks when requests are "
+                    "delayed and grows up to rpc.outstanding-rpc-limit "
+                    "otherwise.",
+     .op_version = {GD_OP_VERSION_11_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"manage-gids"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "off",
@@ -656,7 +656,6 @@ posix_fdstat(xlator_t *this, inode_t *inode, int fd, struct iatt *stbuf_p,
 {
     int ret = 0;
     struct stat fstatbuf;
-    struct posix_private *priv = NULL;
 
     if (stbuf_p == NULL)
         goto out;
@@ -665,10 +664,26 @@ posix_fdstat(xlator_t *this, inode_t *inode, int fd, struct iatt *stbuf_p,
     if (ret != 0)
         goto out;
 
-    if (fstatbuf.st_nlink && !S_ISDIR(fstatbuf.st_mode))
-        fstatbuf.st_nlink--;
+    ret = posix_fdstat_fill(this, inode, fd, &fstatbuf, stbuf_p, fetch_time);
+
+out:
+    return ret;
+}
+
+/* Same as posix_fdstat(), but takes the result of an fstat() already done
+ * on 'fd' by the caller (for example through the I/O framework). */
+int
+posix_fdstat_fill(xlator_t *this, inode_t *inode, int fd,
+                  struct stat *fstatbuf, struct iatt *stbuf_p,
+                  gf_boolean_t fetch_time)
+{
+    int ret = 0;
+    struct posix_private *priv = NULL;
+
+    if (fstatbuf->st_nlink && !S_ISDIR(fstatbuf->st_mode))
+        fstatbuf->st_nlink--;
 
-    iatt_from_stat(stbuf_p, &fstatbuf);
+    iatt_from_stat(stbuf_p, fstatbuf);
 
     priv = this->private;
     if (inode && fetch_time && priv->ctime) {
@@ -13,14 +13,16 @@
 #include "posix-io-uring.h"
 #include "posix-handle.h"
 
-#ifdef HAVE_LIBURING
-#include <liburing.h>
+#ifdef HAVE_IO_URING
+#include <linux/stat.h>
+#include <glusterfs/gf-io.h>
+
+/* Attributes fetched by the statx requests chained to each fop. */
+#define POSIX_URING_STATX_MASK STATX_BASIC_STATS
 
 struct posix_uring_ctx;
-typedef void(fop_unwind_f)(struct posix_uring_ctx *, int32_t);
-typedef void(fop_prep_f)(struct io_uring_sqe *sqe, struct posix_uring_ctx *);
-static int
-posix_io_uring_submit(xlator_t *this, struct posix_uring_ctx *ctx);
+typedef void(fop_unwind_f)(struct posix_uring_ctx *);
+typedef void(fop_prep_f)(gf_io_request_t *req, struct posix_uring_ctx *);
 
 struct posix_uring_ctx {
     call_frame_t *frame;
@@ -30,21 +32,34 @@ struct posix_uring_ctx {
     int _fd;
     int op;
 
+    /* Number of requests of the chain that have not completed yet. */
+    uint32_t pending;
+
+    /* Results of the statx done before the fop (only for fops that need
+     * prebuf), the fop itself and the statx done after the fop. */
+    int32_t pre_res;
+    int32_t res;
+    int32_t post_res;
+    struct statx prestat;
+    struct statx poststat;
+
     union {
         struct {
             struct iovec *iov;
             int count;
             off_t offset;
+            int32_t buf;
         } write;
 
         struct {
             struct iobuf *iobuf;
             struct iovec iovec;
             off_t offset;
+            int32_t buf;
         } read;
 
         struct {
-            int32_t datasync;
+            uint32_t flags;
         } fsync;
     } fop;
 
@@ -72,7 +87,7 @@ posix_io_uring_ctx_free(struct posix_uring_ctx *ctx)
     GF_FREE(ctx);
 }
 
-struct posix_uring_ctx *
+static struct posix_uring_ctx *
 posix_io_uring_ctx_init(call_frame_t *frame, xlator_t *this, fd_t *fd, int op,
                         fop_prep_f prepare, fop_unwind_f unwind,
                         int32_t *op_errno, dict_t *xdata)
@@ -102,17 +117,6 @@ posix_io_uring_ctx_init(call_frame_t *frame, xlator_t *this, fd_t *fd, int op,
     }
     ctx->_fd = pfd->fd;
 
-    /* TODO: Explore filling up pre and post bufs using IOSQE_IO_LINK*/
-    if ((op == GF_FOP_WRITE) || (op == GF_FOP_FSYNC)) {
-        if (posix_fdstat(this, fd->inode, pfd->fd, &ctx->prebuf, _gf_true) !=
-            0) {
-            *op_errno = errno;
-            gf_msg(this->name, GF_LOG_ERROR, *op_errno, P_MSG_FSTAT_FAILED,
-                   "fstat failed on fd=%p", fd);
-            goto err;
-        }
-    }
-
     return ctx;
 
 err:
@@ -120,8 +124,165 @@ err:
     return NULL;
 }
 
+/* Convert the result of a statx request into an iatt, filling the
+ * remaining information the same way posix_fdstat() does. */
+static int
+posix_io_uring_iatt_fill(xlator_t *this, struct posix_uring_ctx *ctx,
+                         struct statx *stx, struct iatt *buf)
+{
+    struct stat fstatbuf = {
+        0,
+    };
+
+    fstatbuf.st_dev = makedev(stx->stx_dev_major, stx->stx_dev_minor);
+    fstatbuf.st_ino = stx->stx_ino;
+    fstatbuf.st_mode = stx->stx_mode;
+    fstatbuf.st_nlink = stx->stx_nlink;
+    fstatbuf.st_uid = stx->stx_uid;
+    fstatbuf.st_gid = stx->stx_gid;
+    fstatbuf.st_rdev = makedev(stx->stx_rdev_major, stx->stx_rdev_minor);
+    fstatbuf.st_size = stx->stx_size;
+    fstatbuf.st_blksize = stx->stx_blksize;
+    fstatbuf.st_blocks = stx->stx_blocks;
+    fstatbuf.st_atim.tv_sec = stx->stx_atime.tv_sec;
+    fstatbuf.st_atim.tv_nsec = stx->stx_atime.tv_nsec;
+    fstatbuf.st_mtim.tv_sec = stx->stx_mtime.tv_sec;
+    fstatbuf.st_mtim.tv_nsec = stx->stx_mtime.tv_nsec;
+    fstatbuf.st_ctim.tv_sec = stx->stx_ctime.tv_sec;
+    fstatbuf.st_ctim.tv_nsec = stx->stx_ctime.tv_nsec;
+
+    return posix_fdstat_fill(this, ctx->fd->inode, ctx->_fd, &fstatbuf, buf,
+                             _gf_true);
+}
+
+/* Called once for each request of the chain. The last one to complete
+ * unwinds the fop. */
 static void
-posix_io_uring_readv_complete(struct posix_uring_ctx *ctx, int32_t res)
+posix_io_uring_put(struct posix_uring_ctx *ctx)
+{
+    if (uatomic_sub_return(&ctx->pending, 1) == 0) {
+        THIS = ctx->frame->this;
+        ctx->unwind(ctx);
+    }
+}
+
+GF_IO_CBK(posix_io_uring_pre_cbk, op, res, static)
+{
+    struct posix_uring_ctx *ctx = op->data;
+
+    ctx->pre_res = res;
+    posix_io_uring_put(ctx);
+}
+
+GF_IO_CBK(posix_io_uring_fop_cbk, op, res, static)
+{
+    struct posix_uring_ctx *ctx = op->data;
+
+    ctx->res = res;
+    posix_io_uring_put(ctx);
+}
+
+GF_IO_CBK(posix_io_uring_post_cbk, op, res, static)
+{
+    struct posix_uring_ctx *ctx = op->data;
+
+    ctx->post_res = res;
+    posix_io_uring_put(ctx);
+}
+
+/* Check the result of the chained requests and build prebuf (if requested)
+ * and postbuf. On failure returns -1 and sets op_errno. */
+static int
+posix_io_uring_check(xlator_t *this, struct posix_uring_ctx *ctx,
+                     gf_boolean_t pre, struct iatt *postbuf, int32_t *op_errno,
+                     int32_t msgid, const char *name)
+{
+    int ret = 0;
+
+    if (pre && (ctx->pre_res < 0)) {
+        *op_errno = -ctx->pre_res;
+        gf_msg(this->name, GF_LOG_ERROR, *op_errno, P_MSG_FSTAT_FAILED,
+               "pre-operation fstat failed on fd=%d", ctx->_fd);
+        return -1;
+    }
+
+    if (ctx->res < 0) {
+        *op_errno = -ctx->res;
+        gf_msg(this->name, GF_LOG_ERROR, *op_errno, msgid,
+               "%s(async) failed fd=%d.", name, ctx->_fd);
+        return -1;
+    }
+
+    if (pre && (posix_io_uring_iatt_fill(this, ctx, &ctx->prestat,
+                                         &ctx->prebuf) != 0)) {
+        *op_errno = errno;
+        gf_msg(this->name, GF_LOG_ERROR, *op_errno, P_MSG_FSTAT_FAILED,
+               "fstat failed on fd=%d", ctx->_fd);
+        return -1;
+    }
+
+    if (ctx->post_res == -ECANCELED) {
+        /* A short read or write breaks the chain, so the post-op statx
+         * has not been executed. Get the attributes synchronously. */
+        ret = posix_fdstat(this, ctx->fd->inode, ctx->_fd, postbuf,
+                           _gf_true);
+    } else if (ctx->post_res < 0) {
+        errno = -ctx->post_res;
+        ret = -1;
+    } else {
+        ret = posix_io_uring_iatt_fill(this, ctx, &ctx->poststat, postbuf);
+    }
+    if (ret != 0) {
+        *op_errno = errno;
+        gf_msg(this->name, GF_LOG_ERROR, *op_errno, P_MSG_FSTAT_FAILED,
+               "fstat failed on fd=%d", ctx->_fd);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Submit the fop through the I/O framework. A statx request is linked
+ * after the fop to get the post-op attributes and, if 'pre' is set,
+ * another one before it to get the pre-op attributes. All of them are
+ * sent to the kernel in a single submission. */
+static void
+posix_io_uring_submit(struct posix_uring_ctx *ctx, gf_boolean_t pre)
+{
+    gf_io_request_t reqs[3];
+    gf_io_batch_t batch;
+    uint32_t count = 0;
+
+    gf_io_batch_init(&batch);
+
+    if (pre) {
+        gf_io_statx_prepare(&reqs[count], posix_io_uring_pre_cbk, ctx->_fd,
+                            "", AT_EMPTY_PATH, POSIX_URING_STATX_MASK,
+                            &ctx->prestat, ctx);
+        gf_io_batch_add(&batch, &reqs[count++], NULL);
+    }
+
+    ctx->prepare(&reqs[count], ctx);
+    gf_io_batch_add(&batch, &reqs[count++], NULL);
+
+    gf_io_statx_prepare(&reqs[count], posix_io_uring_post_cbk, ctx->_fd, "",
+                        AT_EMPTY_PATH, POSIX_URING_STATX_MASK, &ctx->poststat,
+                        ctx);
+    gf_io_batch_add(&batch, &reqs[count++], NULL);
+
+    if (pre) {
+        gf_io_request_chain(&reqs[0], &reqs[1]);
+    }
+    gf_io_request_chain(&reqs[count - 2], &reqs[count - 1]);
+
+    ctx->pending = count;
+
+    gf_io_batch_submit(&batch);
+    gf_io.engine.flush();
+}
+
+static void
+posix_io_uring_readv_complete(struct posix_uring_ctx *ctx)
 {
     call_frame_t *frame = NULL;
     xlator_t *this = NULL;
@@ -134,9 +295,6 @@ posix_io_uring_readv_complete(struct posix_uring_ctx *ctx, int32_t res)
     struct iovec iov = {
         0,
     };
-    fd_t *fd = NULL;
-    int _fd = -1;
-    int ret = 0;
     int op_ret = -1;
     int op_errno = 0;
     off_t offset = 0;
@@ -144,29 +302,15 @@ posix_io_uring_readv_complete(struct posix_uring_ctx *ctx, int32_t res)
     frame = ctx->frame;
     this = frame->this;
     priv = this->private;
-    fd = ctx->fd;
-    _fd = ctx->_fd;
     iobuf = ctx->fop.read.iobuf;
     offset = ctx->fop.read.offset;
 
-    if (res < 0) {
-        op_ret = -1;
-        op_errno = -res;
-        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_READV_FAILED,
-               "readv(async) failed fd=%d.", _fd);
-        goto out;
-    }
-
-    ret = posix_fdstat(this, fd->inode, _fd, &postbuf, _gf_true);
-    if (ret != 0) {
-        op_ret = -1;
-        op_errno = errno;
-        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
-               "fstat failed on fd=%d", _fd);
+    if (posix_io_uring_check(this, ctx, _gf_false, &postbuf, &op_errno,
+                             P_MSG_READV_FAILED, "readv") != 0) {
         goto out;
     }
 
-    op_ret = res;
+    op_ret = ctx->res;
     op_errno = 0;
 
     iobref = iobref_new();
@@ -196,11 +340,11 @@ out:
 }
 
 static void
-posix_prep_readv(struct io_uring_sqe *sqe, struct posix_uring_ctx *ctx)
+posix_prep_readv(gf_io_request_t *req, struct posix_uring_ctx *ctx)
 {
-    sqe->flags |= IOSQE_ASYNC;
-    io_uring_prep_readv(sqe, ctx->_fd, &ctx->fop.read.iovec, 1,
-                        ctx->fop.read.offset);
+    gf_io_read_fixed_prepare(req, posix_io_uring_fop_cbk, ctx->_fd,
+                             &ctx->fop.read.iovec, ctx->fop.read.offset,
+                             ctx->fop.read.buf, ctx);
 }
 
 static int
@@ -210,11 +354,11 @@ posix_io_uring_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     struct posix_uring_ctx *ctx = NULL;
     int32_t op_errno = ENOMEM;
     struct iobuf *iobuf = NULL;
-    int ret = 0;
 
-    ctx = posix_io_uring_ctx_init(
-        frame, this, fd, GF_FOP_READ, posix_prep_readv,
-        posix_io_uring_readv_complete, &op_errno, xdata);
+    ctx = posix_io_uring_ctx_init(frame, this, fd, GF_FOP_READ,
+                                  posix_prep_readv,
+                                  posix_io_uring_readv_complete, &op_errno,
+                                  xdata);
     if (!ctx) {
         goto err;
     }
@@ -228,18 +372,10 @@ posix_io_uring_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     ctx->fop.read.iovec.iov_base = iobuf_ptr(iobuf);
     ctx->fop.read.iovec.iov_len = size;
     ctx->fop.read.offset = offset;
+    ctx->fop.read.buf = iobuf_io_index(iobuf);
+
+    posix_io_uring_submit(ctx, _gf_false);
 
-    ret = posix_io_uring_submit(this, ctx);
-    if (ret < 0) {
-        gf_msg(this->name, GF_LOG_ERROR, -ret, P_MSG_POSIX_IO_URING,
-               "Failed to submit sqe");
-        op_errno = -ret;
-        goto err;
-    }
-    if (ret == 0) {
-        gf_msg(this->name, GF_LOG_WARNING, -ret, P_MSG_POSIX_IO_URING,
-               "submit sqe got zero");
-    }
     return 0;
 err:
     STACK_UNWIND_STRICT(readv, frame, -1, op_errno, NULL, 1, NULL, NULL, NULL);
@@ -262,7 +398,7 @@ posix_writev_fill_rsp_dict(struct posix_uring_ctx *ctx, xlator_t *this,
 }
 
 static void
-posix_io_uring_writev_complete(struct posix_uring_ctx *ctx, int32_t res)
+posix_io_uring_writev_complete(struct posix_uring_ctx *ctx)
 {
     call_frame_t *frame = NULL;
     xlator_t *this = NULL;
@@ -270,36 +406,20 @@ posix_io_uring_writev_complete(struct posix_uring_ctx *ctx, int32_t res)
     struct iatt postbuf = {
         0,
     };
-    fd_t *fd = NULL;
-    int _fd = -1;
-    int ret = 0;
     int op_ret = -1;
     int op_errno = 0;
     dict_t *rsp_xdata = NULL;
+
     frame = ctx->frame;
     this = frame->this;
     priv = this->private;
-    fd = ctx->fd;
-    _fd = ctx->_fd;
-
-    if (res < 0) {
-        op_ret = -1;
-        op_errno = -res;
-        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_WRITEV_FAILED,
-               "writev(async) failed fd=%d.", _fd);
-        goto out;
-    }
 
-    ret = posix_fdstat(this, fd->inode, _fd, &postbuf, _gf_true);
-    if (ret != 0) {
-        op_ret = -1;
-        op_errno = errno;
-        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
-               "fstat failed on fd=%d", _fd);
+    if (posix_io_uring_check(this, ctx, _gf_true, &postbuf, &op_errno,
+                             P_MSG_WRITEV_FAILED, "writev") != 0) {
         goto out;
     }
 
-    op_ret = res;
+    op_ret = ctx->res;
     op_errno = 0;
     posix_writev_fill_rsp_dict(ctx, this, &rsp_xdata);
     GF_ATOMIC_ADD(priv->write_value, op_ret);
@@ -312,10 +432,17 @@ out:
 }
 
 static void
-posix_prep_writev(struct io_uring_sqe *sqe, struct posix_uring_ctx *ctx)
+posix_prep_writev(gf_io_request_t *req, struct posix_uring_ctx *ctx)
 {
-    io_uring_prep_writev(sqe, ctx->_fd, ctx->fop.write.iov,
-                         ctx->fop.write.count, ctx->fop.write.offset);
+    if (ctx->fop.write.buf >= 0) {
+        gf_io_write_fixed_prepare(req, posix_io_uring_fop_cbk, ctx->_fd,
+                                  ctx->fop.write.iov, ctx->fop.write.offset,
+                                  ctx->fop.write.buf, ctx);
+    } else {
+        gf_io_writev_prepare(req, posix_io_uring_fop_cbk, ctx->_fd,
+                             ctx->fop.write.iov, ctx->fop.write.count,
+                             ctx->fop.write.offset, ctx);
+    }
 }
 
 static int
@@ -325,11 +452,11 @@ posix_io_uring_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
 {
     struct posix_uring_ctx *ctx = NULL;
     int32_t op_errno = ENOMEM;
-    int ret = 0;
 
-    ctx = posix_io_uring_ctx_init(
-        frame, this, fd, GF_FOP_WRITE, posix_prep_writev,
-        posix_io_uring_writev_complete, &op_errno, xdata);
+    ctx = posix_io_uring_ctx_init(frame, this, fd, GF_FOP_WRITE,
+                                  posix_prep_writev,
+                                  posix_io_uring_writev_complete, &op_errno,
+                                  xdata);
     if (!ctx) {
         goto err;
     }
@@ -337,18 +464,15 @@ posix_io_uring_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
     ctx->fop.write.iov = iov;
     ctx->fop.write.count = count;
     ctx->fop.write.offset = offset;
+    ctx->fop.write.buf = -1;
+
+    /* Data received from the network is usually stored in a single iobuf.
+     * If it comes from a registered arena, the kernel can use it directly. */
+    if ((count == 1) && iobref)
+        ctx->fop.write.buf = iobref_io_index(iobref, iov);
+
+    posix_io_uring_submit(ctx, _gf_true);
 
-    ret = posix_io_uring_submit(this, ctx);
-    if (ret < 0) {
-        gf_msg(this->name, GF_LOG_ERROR, -ret, P_MSG_POSIX_IO_URING,
-               "Failed to submit sqe");
-        op_errno = -ret;
-        goto err;
-    }
-    if (ret == 0) {
-        gf_msg(this->name, GF_LOG_WARNING, -ret, P_MSG_POSIX_IO_URING,
-               "submit sqe got zero");
-    }
     return 0;
 err:
     STACK_UNWIND_STRICT(writev, frame, -1, op_errno, 0, 0, 0);
@@ -357,7 +481,7 @@ err:
 }
 
 static void
-posix_io_uring_fsync_complete(struct posix_uring_ctx *ctx, int32_t res)
+posix_io_uring_fsync_complete(struct posix_uring_ctx *ctx)
 {
     call_frame_t *frame = NULL;
     xlator_t *this = NULL;
@@ -365,36 +489,19 @@ posix_io_uring_fsync_complete(struct posix_uring_ctx *ctx, int32_t res)
     struct iatt postbuf = {
         0,
     };
-    fd_t *fd = NULL;
-    int _fd = -1;
-    int ret = 0;
     int op_ret = -1;
     int op_errno = 0;
 
     frame = ctx->frame;
     this = frame->this;
     priv = this->private;
-    fd = ctx->fd;
-    _fd = ctx->_fd;
-
-    if (res < 0) {
-        op_ret = -1;
-        op_errno = -res;
-        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FSYNC_FAILED,
-               "writev(async) failed fd=%d.", _fd);
-        goto out;
-    }
 
-    ret = posix_fdstat(this, fd->inode, _fd, &postbuf, _gf_true);
-    if (ret != 0) {
-        op_ret = -1;
-        op_errno = errno;
-        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
-               "fstat failed on fd=%d", _fd);
+    if (posix_io_uring_check(this, ctx, _gf_true, &postbuf, &op_errno,
+                             P_MSG_FSYNC_FAILED, "fsync") != 0) {
         goto out;
     }
 
-    op_ret = res;
+    op_ret = ctx->res;
     op_errno = 0;
     GF_ATOMIC_ADD(priv->write_value, op_ret);
 out:
@@ -404,9 +511,10 @@ out:
 }
 
 static void
-posix_prep_fsync(struct io_uring_sqe *sqe, struct posix_uring_ctx *ctx)
+posix_prep_fsync(gf_io_request_t *req, struct posix_uring_ctx *ctx)
 {
-    io_uring_prep_fsync(sqe, ctx->_fd, ctx->fop.fsync.datasync);
+    gf_io_fsync_prepare(req, posix_io_uring_fop_cbk, ctx->_fd,
+                        ctx->fop.fsync.flags, ctx);
 }
 
 static int
@@ -415,29 +523,20 @@ posix_io_uring_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd,
 {
     struct posix_uring_ctx *ctx = NULL;
     int32_t op_errno = ENOMEM;
-    int ret = 0;
 
-    ctx = posix_io_uring_ctx_init(
-        frame, this, fd, GF_FOP_FSYNC, posix_prep_fsync,
-        posix_io_uring_fsync_complete, &op_errno, xdata);
+    ctx = posix_io_uring_ctx_init(frame, this, fd, GF_FOP_FSYNC,
+                                  posix_prep_fsync,
+                                  posix_io_uring_fsync_complete, &op_errno,
+                                  xdata);
     if (!ctx) {
         goto err;
     }
 
     if (datasync)
-        ctx->fop.fsync.datasync |= IORING_FSYNC_DATASYNC;
+        ctx->fop.fsync.flags |= GF_IO_FSYNC_DATASYNC;
+
+    posix_io_uring_submit(ctx, _gf_true);
 
-    ret = posix_io_uring_submit(this, ctx);
-    if (ret < 0) {
-        gf_msg(this->name, GF_LOG_ERROR, -ret, P_MSG_POSIX_IO_URING,
-               "Failed to submit sqe");
-        op_errno = -ret;
-        goto err;
-    }
-    if (ret == 0) {
-        gf_msg(this->name, GF_LOG_ERROR, -ret, P_MSG_POSIX_IO_URING,
-               "submit sqe got zero");
-    }
     return 0;
 err:
     posix_io_uring_ctx_free(ctx);
@@ -445,173 +544,37 @@ err:
     return 0;
 }
 
-static int
-posix_io_uring_submit(xlator_t *this, struct posix_uring_ctx *ctx)
-{
-    struct posix_private *priv = this->private;
-    struct io_uring_sqe *sqe = NULL;
-    int ret = 0;
-
-    pthread_mutex_lock(&priv->sq_mutex);
-    {
-        sqe = io_uring_get_sqe(&priv->ring);
-        if (!sqe) {
-            /*TODO: Retry until we get an sqe instead of failing. */
-            pthread_mutex_unlock(&priv->sq_mutex);
-            ret = -EAGAIN;
-            gf_msg(this->name, GF_LOG_ERROR, -ret, P_MSG_POSIX_IO_URING,
-                   "Failed to get sqe");
-            goto out;
-        }
-        ctx->prepare(sqe, ctx);
-        io_uring_sqe_set_data(sqe, ctx);
-        ret = io_uring_submit(&priv->ring);
-    }
-    pthread_mutex_unlock(&priv->sq_mutex);
-
-out:
-    return ret;
-}
-
-static void *
-posix_io_uring_thread(void *data)
-{
-    xlator_t *this = NULL;
-    struct posix_private *priv = NULL;
-    int ret = 0;
-    int32_t res = 0;
-    struct io_uring_cqe *cqe = NULL;
-    struct posix_uring_ctx *ctx = NULL;
-
-    this = data;
-    THIS = this;
-    priv = this->private;
-    while (1) {
-        pthread_mutex_lock(&priv->cq_mutex);
-        {
-            ret = io_uring_wait_cqe(&priv->ring, &cqe);
-        }
-        pthread_mutex_unlock(&priv->cq_mutex);
-        if (ret != 0) {
-            if (ret == -EINTR)
-                continue;
-            gf_msg(this->name, GF_LOG_WARNING, -ret, P_MSG_POSIX_IO_URING,
-                   "Unable to get cqe. Exiting.");
-            abort();
-        }
-
-        ctx = (struct posix_uring_ctx *)io_uring_cqe_get_data(cqe);
-        if (priv->uring_thread_exit == _gf_true && ctx == NULL)
-            pthread_exit(NULL);
-        res = cqe->res;
-        io_uring_cqe_seen(&priv->ring, cqe);
-        ctx->unwind(ctx, res);
-    }
-
-    return NULL;
-}
-
-int
-posix_io_uring_init(xlator_t *this)
-{
-    int ret = -1;
-    unsigned flags = 0;
-    struct posix_private *priv = this->private;
-
-    // TODO:Try-out flags |= IORING_SETUP_IOPOLL;
-    ret = io_uring_queue_init(POSIX_URING_MAX_ENTRIES, &priv->ring, flags);
-    if (ret == -1) {
-        gf_msg(this->name, GF_LOG_ERROR, 0, P_MSG_POSIX_IO_URING,
-               "io_uring init failed.");
-        goto out;
-    }
-
-    pthread_mutex_init(&priv->sq_mutex, NULL);
-    pthread_mutex_init(&priv->cq_mutex, NULL);
-    ret = gf_thread_create(&priv->uring_thread, NULL, posix_io_uring_thread,
-                           this, "posix-iouring");
-    if (ret != 0) {
-        io_uring_queue_exit(&priv->ring);
-        pthread_mutex_destroy(&priv->sq_mutex);
-        pthread_mutex_destroy(&priv->cq_mutex);
-        goto out;
-    }
-
-out:
-    return ret;
-}
-
-static int
-posix_io_uring_drain(struct posix_private *priv)
-{
-    struct io_uring_sqe *sqe = NULL;
-    int ret = -1;
-
-    priv->uring_thread_exit = _gf_true;
-    sqe = io_uring_get_sqe(&priv->ring);
-    if (!sqe)
-        return ret;
-
-    io_uring_sqe_set_flags(sqe, IOSQE_IO_DRAIN);
-    io_uring_sqe_set_data(sqe, NULL);
-    io_uring_prep_nop(sqe);
-    ret = io_uring_submit(&priv->ring);
-
-    return ret;
-}
-
-static void
-posix_io_uring_fini(struct posix_private *priv)
-{
-    posix_io_uring_drain(priv);
-    (void)pthread_join(priv->uring_thread, NULL);
-    io_uring_queue_exit(&priv->ring);
-    pthread_mutex_destroy(&priv->sq_mutex);
-    pthread_mutex_destroy(&priv->cq_mutex);
-}
-
 int
 posix_io_uring_on(xlator_t *this)
 {
-    struct posix_private *priv = NULL;
-    int ret = -1;
-
-    priv = this->private;
+    struct posix_private *priv = this->private;
 
-    if (!priv->io_uring_init_done) {
-        ret = posix_io_uring_init(this);
-        if (ret == 0)
-            priv->io_uring_capable = _gf_true;
-        else
-            priv->io_uring_capable = _gf_false;
-        priv->io_uring_init_done = _gf_true;
+    /* Requests are sent through the process-wide I/O framework, so all
+     * bricks of the process share the same rings and workers. This is
+     * only possible if the framework is running the io_uring engine. */
+    priv->io_uring_capable = (gf_io_mode() == GF_IO_MODE_IO_URING);
+    if (!priv->io_uring_capable) {
+        gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_POSIX_IO_URING,
+               "io_uring engine is not active in this process, falling "
+               "back to the previous IO mechanism.");
+        return -1;
     }
 
-    if (priv->io_uring_capable) {
-        this->fops->readv = posix_io_uring_readv;
-        this->fops->writev = posix_io_uring_writev;
-        this->fops->fsync = posix_io_uring_fsync;
-        ret = 0;
-    }
+    this->fops->readv = posix_io_uring_readv;
+    this->fops->writev = posix_io_uring_writev;
+    this->fops->fsync = posix_io_uring_fsync;
 
-    if (ret != 0) {
-        gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_POSIX_IO_URING,
-               "Posix io_uring init failed, falling back to the previous "
-               "IO mechanism.");
-    }
-    return ret;
+    return 0;
 }
 
 int
 posix_io_uring_off(xlator_t *this)
 {
-    struct posix_private *priv = this->private;
-
+    /* Requests already submitted complete through the I/O framework, so
+     * there's nothing to drain here. */
     this->fops->readv = posix_readv;
     this->fops->writev = posix_writev;
     this->fops->fsync = posix_fsync;
-    if (priv->io_uring_capable)
-        posix_io_uring_fini(priv);
 
     return 0;
 }
@@ -10,14 +10,13 @@
 #ifndef _POSIX_IO_URING_H
 #define _POSIX_IO_URING_H
 
-#define POSIX_URING_MAX_ENTRIES 512
 int
 posix_io_uring_on(xlator_t *this);
 
 int
 posix_io_uring_off(xlator_t *this);
 
-#ifdef HAVE_LIBURING
+#ifdef HAVE_IO_URING
 int
 posix_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
             off_t offset, uint32_t flags, dict_t *xdata);
@@ -38,8 +38,7 @@
 #include "posix-aio.h"
 #endif
 
-#ifdef HAVE_LIBURING
-#include <liburing.h>
+#ifdef HAVE_IO_URING
 #include "posix-io-uring.h"
 #endif
 
@@ -286,14 +285,8 @@ struct posix_private {
     gf_boolean_t io_uring_configured;
 
     /*io_uring related.*/
-#ifdef HAVE_LIBURING
-    gf_boolean_t io_uring_init_done;
+#ifdef HAVE_IO_URING
     gf_boolean_t io_uring_capable;
-    gf_boolean_t uring_thread_exit;
-    struct io_uring ring;
-    pthread_t uring_thread;
-    pthread_mutex_t sq_mutex;
-    pthread_mutex_t cq_mutex;
 #endif
     void *pxl;
 };
@@ -369,6 +362,10 @@ int
 posix_fdstat(xlator_t *this, inode_t *inode, int fd, struct iatt *stbuf_p,
              gf_boolean_t fetch_time);
 int
+posix_fdstat_fill(xlator_t *this, inode_t *inode, int fd,
+                  struct stat *fstatbuf, struct iatt *stbuf_p,
+                  gf_boolean_t fetch_time);
+int
 posix_istat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *basename,
             struct iatt *iatt, gf_boolean_t fetch_time);
 int